@@ -23,6 +23,8 @@
 
 #include <queue>
 #include <pthread.h>
+#include <errno.h>
+#include <time.h>
 #include <cstdio>
 
 // XXX pthread -> <mutex> and friends
@@ -74,6 +76,35 @@ public:
 
         return value;
     }
+
+    // As pop(), but waits at most timeout seconds for a value. Returns 
+    // false when none arrived in time.
+    bool pop(T& value, int timeout)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout;
+
+        pthread_mutex_lock(&m_mutex);
+
+        while (m_size == 0)
+        {
+            if (pthread_cond_timedwait(&m_cond_empty, &m_mutex, &deadline) == ETIMEDOUT && m_size == 0)
+            {
+                pthread_mutex_unlock(&m_mutex);
+                return false;
+            }
+        }
+
+        value = m_queue.front();
+        m_queue.pop();
+        m_size--;
+
+        pthread_mutex_unlock(&m_mutex);
+        pthread_cond_broadcast(&m_cond_full);
+
+        return true;
+    }
     
     // Peeking only works reliable if the thread that does the peek() is
     // *the only* thread that does a pop() on the same thread. Otherwise
@@ -1,3 +1,7 @@
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
 #include "bounding_mesh.h"
 #include "config.h"
 
@@ -89,10 +93,51 @@ BoundingMesh::bbox_from_instance(OSPInstance instance, bool edges_only)
     );
 }
 
+BoundingMesh*
+BoundingMesh::bbox_from_vertices(const float *vertices, int num_vertices, bool edges_only)
+{
+    float   min[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    for (int i = 0; i < num_vertices; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            min[j] = std::min(min[j], vertices[3*i+j]);
+            max[j] = std::max(max[j], vertices[3*i+j]);
+        }
+    }
+
+    if (num_vertices == 0)
+        min[0] = min[1] = min[2] = max[0] = max[1] = max[2] = 0.0f;
+
+    return BoundingMesh::bbox(min[0], min[1], min[2], max[0], max[1], max[2], edges_only);
+}
+
+BoundingMesh*
+BoundingMesh::from_triangles(const float *vertices, int num_vertices, const uint32_t *triangles, int num_triangles)
+{
+    BoundingMesh *bm = BoundingMesh::bbox_from_vertices(vertices, num_vertices, true);
+
+    bm->source_vertices.assign(vertices, vertices + 3*num_vertices);
+    bm->source_triangles.assign(triangles, triangles + 3*num_triangles);
+
+    return bm;
+}
+
 // https://github.com/sp4cerat/Fast-Quadric-Mesh-Simplification
 // https://lorensen.github.io/VTKExamples/site/Cxx/Meshes/QuadricDecimation/
 // https://vtk.org/doc/nightly/html/classvtkQuadricClustering.html
 
+bool
+BoundingMesh::can_simplify()
+{
+#ifdef VTK_QC_BOUND
+    return true;
+#else
+    return false;
+#endif
+}
+
 BoundingMesh*
 BoundingMesh::simplify_qc(const float *vertices, int num_vertices, const uint32_t *triangles, int num_triangles, int divisions)
 {
@@ -169,25 +214,7 @@ BoundingMesh::simplify_qc(const float *vertices, int num_vertices, const uint32_
     return bm;
 #else
     // VTK not available, return regular AABB
-    float   min[3] = {1e6, 1e6, 1e6}, max[3] = {-1e6, -1e6, -1e6};
-    float   x, y, z;
-
-    for (int i = 0; i < num_vertices; i++)
-    {
-        x = vertices[3*i+0];
-        y = vertices[3*i+1];
-        z = vertices[3*i+2];
-
-        min[0] = std::min(min[0], x);
-        min[1] = std::min(min[1], y);
-        min[2] = std::min(min[2], z);
-
-        max[0] = std::max(max[0], x);
-        max[1] = std::max(max[1], y);
-        max[2] = std::max(max[2], z);
-    }
-
-    return BoundingMesh::bbox(min[0], min[1], min[2], max[0], max[1], max[2], true);
+    return BoundingMesh::bbox_from_vertices(vertices, num_vertices, true);
 #endif
 }
 
@@ -199,10 +226,13 @@ BoundingMesh::~BoundingMesh()
 {
 }
 
-uint8_t*
-BoundingMesh::serialize(uint32_t &size) const
+// Serialized layout: 4 uint32 lengths (vertices, edges, faces, loops),
+// followed by the vertices, edges, faces, loop_start and loop_total arrays
+
+uint32_t
+BoundingMesh::serialized_size() const
 {
-    size = 
+    return 
         4*sizeof(uint32_t)
         + vertices.size()*sizeof(float)    
         + edges.size()*sizeof(uint32_t)  
@@ -210,105 +240,99 @@ BoundingMesh::serialize(uint32_t &size) const
         + loop_start.size()*sizeof(uint32_t)
         + loop_total.size()*sizeof(uint32_t)
         ;
+}
+
+// Appends the vector's contents at ptr, returns the position after it
+template<typename T>
+static uint8_t*
+serialize_vector(uint8_t *ptr, const std::vector<T>& v)
+{
+    if (!v.empty())
+        memcpy(ptr, v.data(), v.size()*sizeof(T));
+    return ptr + v.size()*sizeof(T);
+}
+
+void
+BoundingMesh::serialize(uint8_t *buffer) const
+{
+    const uint32_t lengths[4] = { 
+        (uint32_t)vertices.size(), (uint32_t)edges.size(), (uint32_t)faces.size(), 
+        (uint32_t)loop_start.size()     // loop_total has same length
+    };
+
+    memcpy(buffer, lengths, sizeof(lengths));
+
+    uint8_t *ptr = buffer + sizeof(lengths);
+
+    ptr = serialize_vector(ptr, vertices);
+    ptr = serialize_vector(ptr, edges);
+    ptr = serialize_vector(ptr, faces);
+    ptr = serialize_vector(ptr, loop_start);
+    serialize_vector(ptr, loop_total);
+}
+
+uint8_t*
+BoundingMesh::serialize(uint32_t &size) const
+{
+    size = serialized_size();
     
     uint8_t *buffer = new uint8_t[size];
-    
-    uint32_t *i;
-    float *f;
-    
-    i = (uint32_t*)buffer;    
-    
-    *i++ = vertices.size();
-    *i++ = edges.size();
-    *i++ = faces.size();
-    *i++ = loop_start.size();   // loop_total has same length
-    
-    f = (float*)i;
-    
-    for (const float &v : vertices)
-        *f++ = v;
-        
-    i = (uint32_t*)f;
-    
-    for (const uint32_t &vi : edges)
-        *i++ = vi;
-    
-    for (const uint32_t &vi : faces)
-        *i++ = vi;
-    
-    for (const uint32_t &vi : loop_start)
-        *i++ = vi;
-    
-    for (const uint32_t &vi : loop_total)
-        *i++ = vi;
+
+    serialize(buffer);
     
     return buffer;    
 }
 
+// Fills the vector from ptr, returns the position after the contents read
+template<typename T>
+static const uint8_t*
+deserialize_vector(const uint8_t *ptr, std::vector<T>& v, uint32_t n)
+{
+    v.resize(n);
+    if (n > 0)
+        memcpy(v.data(), ptr, n*sizeof(T));
+    return ptr + n*sizeof(T);
+}
+
 BoundingMesh*
 BoundingMesh::deserialize(const uint8_t *buffer, uint32_t size)
 {
-    // XXX actually check against the size value
-    
-    BoundingMesh *bm = new BoundingMesh;
-    
-    uint32_t *i, n;
-    float *f;
+    uint32_t lengths[4];
 
-    i = (uint32_t*)buffer;
-    
-    uint32_t    vertices_len = *i++;
-    uint32_t    edges_len = *i++;
-    uint32_t    faces_len = *i++;
-    uint32_t    loop_len = *i++;
-    
-    f = (float*)i;
-    
-    // Vertices
-    n = vertices_len;
-    std::vector<float> &vertices = bm->vertices;
-    while (n > 0)
+    if (size < sizeof(lengths))
     {
-        vertices.push_back(*f++);
-        n--;
+        printf("ERROR: serialized bounding mesh too small (%u bytes)\n", size);
+        return nullptr;
     }
 
-    // Edges
-    n = edges_len;
-    std::vector<uint32_t> &edges = bm->edges;
-    while (n > 0)
-    {
-        edges.push_back(*i++);
-        n--;
-    }
+    memcpy(lengths, buffer, sizeof(lengths));
+
+    const uint32_t vertices_len = lengths[0];
+    const uint32_t edges_len = lengths[1];
+    const uint32_t faces_len = lengths[2];
+    const uint32_t loop_len = lengths[3];
+
+    // In 64 bits, as the lengths come from the buffer
+    const uint64_t expected_size = sizeof(lengths) 
+        + (uint64_t)vertices_len*sizeof(float) 
+        + ((uint64_t)edges_len + faces_len + 2*(uint64_t)loop_len)*sizeof(uint32_t);
 
-    // Faces
-    n = faces_len;
-    std::vector<uint32_t> &faces = bm->faces;
-    while (n > 0)
+    if (expected_size != size)
     {
-        faces.push_back(*i++);
-        n--;
+        printf("ERROR: serialized bounding mesh has size %u, but its lengths imply %llu bytes\n", 
+            size, (unsigned long long)expected_size);
+        return nullptr;
     }
     
-    // Loop start
-    n = loop_len;
-    std::vector<uint32_t> &loop_start = bm->loop_start;
-    while (n > 0)
-    {
-        loop_start.push_back(*i++);
-        n--;
-    }    
-
-    // Loop total
-    n = loop_len;
-    std::vector<uint32_t> &loop_total = bm->loop_total;
-    while (n > 0)
-    {
-        loop_total.push_back(*i++);
-        n--;
-    }    
+    BoundingMesh *bm = new BoundingMesh;
+
+    const uint8_t *ptr = buffer + sizeof(lengths);
+
+    ptr = deserialize_vector(ptr, bm->vertices, vertices_len);
+    ptr = deserialize_vector(ptr, bm->edges, edges_len);
+    ptr = deserialize_vector(ptr, bm->faces, faces_len);
+    ptr = deserialize_vector(ptr, bm->loop_start, loop_len);
+    deserialize_vector(ptr, bm->loop_total, loop_len);
     
     return bm;
 }
-
@@ -17,24 +17,44 @@ struct BoundingMesh
     static BoundingMesh *bbox(float xmin, float ymin, float zmin, float xmax, float ymax, float zmax, bool edges_only=false);
     static BoundingMesh *bbox_from_group(OSPGroup group, bool edges_only=false);
     static BoundingMesh *bbox_from_instance(OSPInstance instance, bool edges_only=false);
+    static BoundingMesh *bbox_from_vertices(const float *vertices, int nv, bool edges_only=false);
 
     // Generates a simplified version of the given geometry using quadratic clustering (requires VTK)
     // If VTK support is not enabled it returns add bbox (edges) based on vertex positions.
     static BoundingMesh *simplify_qc(const float *vertices, int nv, const uint32_t *triangles, int nt, int divisions);
+    // False when built without VTK, simplify_qc() then only returns a bbox
+    static bool can_simplify();
+
+    // Returns the bbox (edges) of the given geometry, with a copy of the 
+    // geometry as source mesh. The server generates simplified versions 
+    // of the source in the background, after the plugin instance is 
+    // created. Preferable over simplify_qc() for large meshes.
+    static BoundingMesh *from_triangles(const float *vertices, int nv, const uint32_t *triangles, int nt);
     
-    // Deserialize
+    // Deserialize, returns nullptr if the buffer does not hold a valid mesh
     static BoundingMesh *deserialize(const uint8_t *buffer, uint32_t size);
     
     BoundingMesh();
     ~BoundingMesh();
     
+    // Size of the serialized mesh, in bytes
+    uint32_t serialized_size() const;
+    // Serializes into buffer, which must have room for serialized_size() bytes
+    void serialize(uint8_t *buffer) const;
+    // Returns a new[]-allocated buffer
     uint8_t *serialize(uint32_t &size) const;    
+
+    bool has_source() const { return !source_triangles.empty(); }
     
     std::vector<float>      vertices;       // x, y, z, ...
     std::vector<uint32_t>   edges;          // v0, v1, ...
     std::vector<uint32_t>   faces;          // i, j, k, l, ...
     std::vector<uint32_t>   loop_start;     
     std::vector<uint32_t>   loop_total;     
+
+    // Source mesh for simplification (see from_triangles()), not serialized
+    std::vector<float>      source_vertices;    // x, y, z, ...
+    std::vector<uint32_t>   source_triangles;   // v0, v1, v2, ...
 };
 
 #endif
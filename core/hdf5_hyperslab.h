@@ -0,0 +1,217 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Reading (parts of) HDF5 datasets, for use in plugins                     //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef HDF5_HYPERSLAB_H
+#define HDF5_HYPERSLAB_H
+
+/*
+Reads a (strided) hyperslab selection of a dataset into a contiguous
+buffer, so only the selected part of the dataset is read from the file.
+
+The selection is read in slabs along the first (slowest varying)
+dimension. For chunked datasets a slab covers whole chunks along that
+dimension, so each chunk is read (and decompressed) only once. When the
+HDF5 library is thread-safe the slabs are read by multiple threads, each
+with its own file handle. Note that a thread-safe HDF5 serializes most
+of its API calls, so this mostly helps to keep multiple I/O requests
+in flight on parallel file systems.
+
+Uses the HDF5 C API directly, as uhdf5 only reads complete datasets.
+*/
+
+#include <hdf5.h>
+#include <stdint.h>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+// Target size of a slab read when the dataset is not chunked
+const size_t HDF5_HYPERSLAB_SLAB_SIZE = 64*1024*1024;
+
+// Returns false if the dataset can't be opened
+inline bool
+hdf5_get_dimensions(const char *fname, const char *dataset_name, std::vector<hsize_t>& dims)
+{
+    hid_t file = H5Fopen(fname, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file < 0)
+        return false;
+
+    hid_t dset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
+    if (dset < 0)
+    {
+        H5Fclose(file);
+        return false;
+    }
+
+    hid_t space = H5Dget_space(dset);
+    const int rank = H5Sget_simple_extent_ndims(space);
+
+    dims.resize(rank);
+    H5Sget_simple_extent_dims(space, &dims[0], NULL);
+
+    H5Sclose(space);
+    H5Dclose(dset);
+    H5Fclose(file);
+
+    return true;
+}
+
+// Reads rows [row_begin, row_end) of the selection (rows being
+// positions along the first dimension, in selection coordinates)
+inline bool
+hdf5_read_hyperslab_rows(hid_t dset, hid_t mem_type,
+    const std::vector<hsize_t>& start, const std::vector<hsize_t>& stride, const std::vector<hsize_t>& count,
+    hsize_t row_begin, hsize_t row_end, void *buffer)
+{
+    const int rank = count.size();
+
+    std::vector<hsize_t> slab_start(start), slab_count(count);
+
+    slab_start[0] = start[0] + row_begin * stride[0];
+    slab_count[0] = row_end - row_begin;
+
+    hid_t file_space = H5Dget_space(dset);
+    hid_t mem_space = H5Screate_simple(rank, &slab_count[0], NULL);
+
+    bool ok = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, &slab_start[0], &stride[0], &slab_count[0], NULL) >= 0
+        && H5Dread(dset, mem_type, mem_space, file_space, H5P_DEFAULT, buffer) >= 0;
+
+    H5Sclose(mem_space);
+    H5Sclose(file_space);
+
+    return ok;
+}
+
+// Read count[i] elements along each dimension i, starting at start[i]
+// and taking every stride[i]-th element. The buffer must have room for
+// the product of count[] elements of mem_type.
+inline bool
+hdf5_read_hyperslab(const char *fname, const char *dataset_name, hid_t mem_type,
+    const std::vector<hsize_t>& start, const std::vector<hsize_t>& stride, const std::vector<hsize_t>& count,
+    void *buffer)
+{
+    const int rank = count.size();
+
+    hid_t file = H5Fopen(fname, H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file < 0)
+    {
+        fprintf(stderr, "... ERROR: could not open HDF5 file %s\n", fname);
+        return false;
+    }
+
+    hid_t dset = H5Dopen2(file, dataset_name, H5P_DEFAULT);
+    if (dset < 0)
+    {
+        fprintf(stderr, "... ERROR: could not open dataset %s in HDF5 file %s\n", dataset_name, fname);
+        H5Fclose(file);
+        return false;
+    }
+
+    // Size of one row of the selection, in bytes
+    const size_t element_size = H5Tget_size(mem_type);
+    size_t row_size = element_size;
+    for (int i = 1; i < rank; i++)
+        row_size *= count[i];
+
+    // Determine the number of rows per slab
+
+    hsize_t rows_per_slab;
+
+    hid_t dcpl = H5Dget_create_plist(dset);
+
+    if (H5Pget_layout(dcpl) == H5D_CHUNKED)
+    {
+        std::vector<hsize_t> chunk_dims(rank);
+        H5Pget_chunk(dcpl, rank, &chunk_dims[0]);
+        rows_per_slab = std::max<hsize_t>(1, chunk_dims[0] / stride[0]);
+    }
+    else
+        rows_per_slab = std::max<hsize_t>(1, HDF5_HYPERSLAB_SLAB_SIZE / row_size);
+
+    H5Pclose(dcpl);
+
+    const hsize_t num_slabs = (count[0] + rows_per_slab - 1) / rows_per_slab;
+
+    hbool_t threadsafe = false;
+    H5is_library_threadsafe(&threadsafe);
+
+    int num_threads = 1;
+    if (threadsafe)
+        num_threads = std::min<hsize_t>(num_slabs, std::max(1u, std::thread::hardware_concurrency()));
+
+    printf("... Reading HDF5 hyperslab in %d slab(s) of %d row(s), using %d thread(s)\n",
+        (int)num_slabs, (int)rows_per_slab, num_threads);
+
+    auto read_slabs = [&](hid_t thread_dset, int thread_index, bool& ok)
+    {
+        ok = true;
+
+        for (hsize_t s = thread_index; s < num_slabs && ok; s += num_threads)
+        {
+            const hsize_t row_begin = s * rows_per_slab;
+            const hsize_t row_end = std::min(count[0], row_begin + rows_per_slab);
+
+            ok = hdf5_read_hyperslab_rows(thread_dset, mem_type, start, stride, count,
+                row_begin, row_end, (uint8_t*)buffer + row_begin * row_size);
+        }
+    };
+
+    bool ok;
+
+    if (num_threads == 1)
+        read_slabs(dset, 0, ok);
+    else
+    {
+        std::vector<std::thread> threads;
+        std::vector<char> thread_ok(num_threads);
+
+        for (int t = 0; t < num_threads; t++)
+        {
+            threads.push_back(std::thread([&, t]() {
+                hid_t thread_file = H5Fopen(fname, H5F_ACC_RDONLY, H5P_DEFAULT);
+                hid_t thread_dset = H5Dopen2(thread_file, dataset_name, H5P_DEFAULT);
+                bool res = false;
+                if (thread_dset >= 0)
+                {
+                    read_slabs(thread_dset, t, res);
+                    H5Dclose(thread_dset);
+                }
+                thread_ok[t] = res;
+                H5Fclose(thread_file);
+            }));
+        }
+
+        for (auto& t : threads)
+            t.join();
+
+        ok = std::all_of(thread_ok.begin(), thread_ok.end(), [](char c) { return c != 0; });
+    }
+
+    H5Dclose(dset);
+    H5Fclose(file);
+
+    if (!ok)
+        fprintf(stderr, "... ERROR: reading hyperslab of dataset %s failed\n", dataset_name);
+
+    return ok;
+}
+
+#endif
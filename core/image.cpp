@@ -27,6 +27,13 @@
 #include <OpenEXR/ImfMatrixAttribute.h>
 #include <OpenEXR/ImfArray.h>
 #include <OpenEXR/ImfCompressionAttribute.h>
+#include <OpenEXR/ImfIO.h>
+#include <OpenEXR/ImfThreading.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <mutex>
 #include "image.h"
 
 using namespace OIIO;
@@ -193,6 +200,84 @@ writeFramebufferEXR(const char *fname, int width, int height, bool compress, con
     return true;
 }
 
+// Output stream writing to a (growing) memory buffer
+class MemoryOStream : public OStream
+{
+public:
+
+    MemoryOStream(std::vector<uint8_t>& data): OStream("<memory>"), data(data), pos(0)
+    {
+        data.clear();
+    }
+
+    virtual void write(const char c[], int n)
+    {
+        if (pos + n > data.size())
+            data.resize(pos + n);
+        memcpy(data.data() + pos, c, n);
+        pos += n;
+    }
+
+    // The line offset table gets written last, seeking back to just after the header
+    virtual uint64_t tellp()            { return pos; }
+    virtual void seekp(uint64_t p)      { pos = p; }
+
+protected:
+    std::vector<uint8_t>&   data;
+    uint64_t                pos;
+};
+
+// Writes the same file as writeFramebufferEXRColorOnly(), but without 
+// going through a file. Scanline blocks are compressed in parallel by the 
+// OpenEXR thread pool (using ZIP compression, i.e. blocks of 16 scanlines).
+bool
+encodeFramebufferEXR(std::vector<uint8_t>& output, int width, int height, bool compress, const float *color)
+{
+    static std::once_flag threads_initialized;
+
+    std::call_once(threads_initialized, []() {
+        setGlobalThreadCount(std::max(1u, std::thread::hardware_concurrency()));
+    });
+
+    Header header(width, height);
+
+    header.channels().insert("R", Channel(FLOAT));
+    header.channels().insert("G", Channel(FLOAT));
+    header.channels().insert("B", Channel(FLOAT));
+    header.channels().insert("A", Channel(FLOAT));
+
+    header.compression() = compress ? ZIP_COMPRESSION : NO_COMPRESSION;
+
+    // Avoid reallocating while writing, uncompressed size plus header
+    output.reserve(size_t(width)*height*4*sizeof(float) + 65536);
+
+    try
+    {
+        MemoryOStream stream(output);
+        OutputFile file(stream, header, globalThreadCount());
+
+        // Framebuffer pixels start at lower-left, see above
+        FrameBuffer framebuffer;
+
+        const size_t scanlinesize = size_t(width) * 4 * sizeof(float);
+        char *top = (char*)color + size_t(height-1)*scanlinesize;
+        const char *channels[] = { "R", "G", "B", "A" };
+
+        for (int c = 0; c < 4; c++)
+            framebuffer.insert(channels[c], Slice(FLOAT, top + c*sizeof(float), 4*sizeof(float), -(ptrdiff_t)scanlinesize));
+
+        file.setFrameBuffer(framebuffer);
+        file.writePixels(height);
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "ERROR: encoding framebuffer as EXR failed: %s\n", e.what());
+        return false;
+    }
+
+    return true;
+}
+
 void 
 writePPM(const char *fileName, int width, int height, const uint32_t *pixel)
 {
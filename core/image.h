@@ -22,6 +22,7 @@
 #define IMAGE_H
 
 #include <stdint.h>
+#include <vector>
 #include <ospray/ospray.h>
 
 bool    writePNG(const char *fileName, int width, int height, const uint32_t *pixel);
@@ -30,4 +31,7 @@ void    writePPM(const char *fileName, int width, int height, const uint32_t *pi
 bool    writeFramebufferEXR(const char *fileName, int width, int height, bool compress, const float *color, 
 			const float *depth=nullptr, const float *normal=nullptr, const float *albedo=nullptr);
 
+// Color only (RGBA, 4 floats per pixel), encoded as an OpenEXR file in memory
+bool    encodeFramebufferEXR(std::vector<uint8_t>& output, int width, int height, bool compress, const float *color);
+
 #endif
@@ -21,6 +21,7 @@
 #ifndef PLUGIN_H
 #define PLUGIN_H
 
+#include <mutex>
 #include <vector>
 #include <ospray/ospray.h>
 #include <ospray/ospray_util.h>
@@ -115,6 +116,19 @@ typedef std::pair<OSPGroup, glm::mat4>      GroupInstance;
 typedef std::vector<GroupInstance>          GroupInstances;
 typedef std::vector<OSPLight>               Lights;
 
+// For scene plugins with large numbers of instances of a few groups: 
+// the groups plus per-instance arrays, instead of a GroupInstance per
+// instance. Per-instance variation, e.g. in color, can be had by using
+// multiple groups sharing the same geometry, with different materials.
+struct InstanceArray
+{
+    std::vector<OSPGroup>   groups;         // Released by ~PluginState()
+    std::vector<glm::mat4>  transforms;     // Per instance
+    std::vector<uint32_t>   group_indices;  // Per instance, index into groups. May be empty when using a single group
+};
+
+typedef std::vector<InstanceArray>          InstanceArrays;
+
 //
 // Structures
 //
@@ -141,6 +155,33 @@ struct PluginState
     
     // Plugin-specific data for this instance, managed by the plugin
     void            *data;        
+
+    // Directory for persistent caching of this instance's data (see
+    // plugin_cache.h), set by the server. Empty if caching is disabled.
+    std::string     cache_path;
+
+    // Distributed rendering (server built with DISTRIBUTED): the data
+    // is split into num_domains parts, one per MPI rank, and this
+    // instance should only load part domain_index (see plugin_domain_range()).
+    // A plugin that does so sets domain_bounds to the object-space
+    // bounds of its part, excluding any ghost voxels. Set by the server,
+    // num_domains is 1 when not rendering distributed.
+    int             domain_index;
+    int             num_domains;
+    bool            has_domain_bounds;
+    float           domain_bounds[6];           // xmin, ymin, zmin, xmax, ymax, zmax
+
+    // Size in bytes of the instance's data (e.g. voxels), optionally
+    // set by the plugin. Used for the server's memory budget. When 0 
+    // the server uses its increase in memory usage during creation,
+    // except for instances created in the background (see thread_safe),
+    // which should set it.
+    size_t          memory_size;
+
+    // Set by the server while a thread_safe plugin's create_instance 
+    // function runs in the background, nullptr otherwise. OSPRay calls 
+    // must be made while holding it (see PluginOSPRayLock).
+    std::mutex      *ospray_mutex;
     
     // Depending on the type of plugin, one of these three must
     // be filled in by the plugin.
@@ -148,6 +189,9 @@ struct PluginState
     // Volume plugin:
     OSPVolume       volume;
     float           volume_data_range[2];
+    // Optional lower-resolution version of volume (see volume_lod.h),  
+    // used during the reduced-resolution part of interactive rendering
+    OSPVolume       volume_lod;
     // XXX could add optional TF
     
     // Geometry plugin:
@@ -155,6 +199,7 @@ struct PluginState
     
     // Scene plugin:
     GroupInstances  group_instances;    // Need a refcount of at least 1 to survive in the list
+    InstanceArrays  instance_arrays;
     Lights          lights;
 
     PluginState()
@@ -164,7 +209,13 @@ struct PluginState
         data = nullptr;
         volume = nullptr;
         volume_data_range[0] = volume_data_range[1] = 0.0f;
+        volume_lod = nullptr;
         geometry = nullptr;
+        domain_index = 0;
+        num_domains = 1;
+        has_domain_bounds = false;
+        memory_size = 0;
+        ospray_mutex = nullptr;
     }
 
     ~PluginState()
@@ -173,15 +224,64 @@ struct PluginState
             delete bound;
         if (volume != nullptr)
             ospRelease(volume);
+        if (volume_lod != nullptr)
+            ospRelease(volume_lod);
         if (geometry != nullptr)
             ospRelease(geometry);
         for (auto& gi : group_instances)
             ospRelease(gi.first);
+        for (auto& ia : instance_arrays)
+            for (auto& g : ia.groups)
+                ospRelease(g);
         for (auto& l : lights)     
             ospRelease(l);
     }
 };
 
+// For plugins that partition their data in distributed mode: the 
+// range [begin, end) of n elements (e.g. volume slices) that belongs 
+// to the instance's domain. Returns the full range when not distributed.
+inline void
+plugin_domain_range(const PluginState *state, int n, int &begin, int &end)
+{
+    begin = (int)((int64_t)n * state->domain_index / state->num_domains);
+    end = (int)((int64_t)n * (state->domain_index + 1) / state->num_domains);
+}
+
+inline void
+plugin_set_domain_bounds(PluginState *state, float xmin, float ymin, float zmin, float xmax, float ymax, float zmax)
+{
+    state->domain_bounds[0] = xmin;
+    state->domain_bounds[1] = ymin;
+    state->domain_bounds[2] = zmin;
+    state->domain_bounds[3] = xmax;
+    state->domain_bounds[4] = ymax;
+    state->domain_bounds[5] = zmax;
+    state->has_domain_bounds = true;
+}
+
+// Holds state->ospray_mutex (if set) during its lifetime. A thread_safe 
+// plugin prepares its data (reading, converting) without it and only 
+// takes it for the part that creates the OSPRay objects.
+class PluginOSPRayLock
+{
+public:
+    PluginOSPRayLock(const PluginState *state): m_mutex(state->ospray_mutex)
+    {
+        if (m_mutex != nullptr)
+            m_mutex->lock();
+    }
+
+    ~PluginOSPRayLock()
+    {
+        if (m_mutex != nullptr)
+            m_mutex->unlock();
+    }
+
+protected:
+    std::mutex  *m_mutex;
+};
+
 // XXX better name
 struct PluginResult
 {
@@ -226,6 +326,17 @@ typedef void (*clear_data_function_t)(
     PluginState *state
 );
 
+// Called when the parameters of an existing plugin instance changed, 
+// with state->parameters still set to old_parameters. Returns false if 
+// the change can't be handled in place, in which case the server deletes 
+// the instance and creates a new one from new_parameters. 
+typedef bool (*update_instance_function_t)(
+    PluginResult &result,
+    PluginState *state,
+    const json &old_parameters,
+    const json &new_parameters
+);
+
 typedef struct 
 {
     // One-time plugin loading/unloading. Both may be NULL.
@@ -242,13 +353,30 @@ typedef struct
     // May be NULL
     clear_data_function_t       clear_data_function;
     
-    // Optimization later: allow light-weight updating (if we can
-    // reliably detect what exactly changed)
-    // Properties were updated, update elements
-    //object_update_function_t    object_update_function;
+    // Light-weight update of an instance for changed parameters, e.g.
+    // reusing already loaded data. The scene elements in PluginState
+    // may be modified or replaced. May be NULL.
+    update_instance_function_t  update_instance_function;
 }
 PluginFunctions;
 
+// For use in a plugin's update_instance_function: returns true if the 
+// old and new parameters only differ in (a subset of) the given keys
+inline bool
+plugin_parameters_differ_only_in(const json &old_parameters, const json &new_parameters,
+    const std::vector<std::string> &keys)
+{
+    json a = old_parameters, b = new_parameters;
+
+    for (const std::string &key : keys)
+    {
+        a.erase(key);
+        b.erase(key);
+    }
+
+    return a == b;
+}
+
 //
 // Parameters
 //
@@ -326,6 +454,15 @@ typedef struct
     //PluginRenderer      renderer;
     bool                uses_renderer_type;
 
+    // The plugin's create_instance_function can be called for different
+    // plugin instances at the same time, from threads other than the 
+    // one handling the client connection (i.e. it uses no global state,
+    // makes its OSPRay calls under PluginOSPRayLock and sets memory_size).
+    // The server then creates instances in the background, so multiple 
+    // instances load in parallel.
+    // Set to false by the server before calling initialize().
+    bool                thread_safe;
+
     PluginParameter     *parameters;
     PluginFunctions     functions;    
 }
@@ -0,0 +1,285 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Persistent plugin instance cache                                         //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef PLUGIN_CACHE_H
+#define PLUGIN_CACHE_H
+
+/*
+On-disk cache for expensive intermediate results of a plugin instance
+(decoded voxel arrays, data ranges, bounding meshes, ...), so these
+survive server restarts.
+
+The server sets PluginState::cache_path to a directory unique for the plugin
+and its parameters (based on their SHA1), or leaves it empty when caching is
+disabled (the default, set BLOSPRAY_PLUGIN_CACHE_DIR to enable).
+
+An entry in the cache consists of any number of named arrays, stored
+as plain files so they can be memory-mapped, plus a JSON object with
+small values. The JSON object is written last and marks the entry as
+complete. Source files the data was derived from can be recorded, so
+the entry is ignored when one of them changes.
+
+Usage in a create_instance function:
+
+    json values;
+
+    if (plugin_cache_load(state, values, {fname}))
+    {
+        size_t size;
+        void *voxels = plugin_cache_map_array(state, "voxels", size);
+        ...
+    }
+    else
+    {
+        ... (expensive) loading ...
+        plugin_cache_store_array(state, "voxels", voxels, size);
+        values["data_range"] = { minval, maxval };
+        plugin_cache_save(state, values, {fname});
+    }
+*/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "json.hpp"
+#include "plugin.h"
+#include "bounding_mesh.h"
+
+using json = nlohmann::json;
+
+inline bool
+plugin_cache_enabled(const PluginState *state)
+{
+    return state->cache_path != "";
+}
+
+// Size and modification time, to detect changed source files
+inline json
+plugin_cache_file_info(const std::string& fname)
+{
+    struct stat st;
+
+    if (stat(fname.c_str(), &st) == -1)
+        return json();
+
+    return { st.st_size, st.st_mtime };
+}
+
+// Write to a temporary file first, so a crash (or another server
+// process) never leaves a partial file under the final name
+inline bool
+plugin_cache_write_file(const std::string& fname, const void *data, size_t size)
+{
+    const std::string tmpname = fname + ".tmp-" + std::to_string(getpid());
+
+    int fd = open(tmpname.c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        perror("plugin_cache_write_file(): open() failed");
+        return false;
+    }
+
+    const uint8_t *p = (const uint8_t*)data;
+    size_t left = size;
+
+    while (left > 0)
+    {
+        ssize_t n = write(fd, p, left);
+        if (n == -1)
+        {
+            perror("plugin_cache_write_file(): write() failed");
+            close(fd);
+            unlink(tmpname.c_str());
+            return false;
+        }
+        p += n;
+        left -= n;
+    }
+
+    close(fd);
+
+    if (rename(tmpname.c_str(), fname.c_str()) == -1)
+    {
+        perror("plugin_cache_write_file(): rename() failed");
+        unlink(tmpname.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Returns true if the cache has a complete entry for this plugin instance,
+// whose source files haven't changed since it was saved
+inline bool
+plugin_cache_load(const PluginState *state, json& values,
+    const std::vector<std::string>& source_files = std::vector<std::string>())
+{
+    if (!plugin_cache_enabled(state))
+        return false;
+
+    std::ifstream f(state->cache_path + "/values.json");
+
+    if (!f.is_open())
+        return false;
+
+    json entry;
+
+    try
+    {
+        f >> entry;
+    }
+    catch (const json::exception& e)
+    {
+        printf("... WARNING: ignoring unreadable plugin cache entry %s\n", state->cache_path.c_str());
+        return false;
+    }
+
+    for (auto& fname : source_files)
+    {
+        if (entry["sources"][fname] != plugin_cache_file_info(fname))
+        {
+            printf("... Source file %s changed, ignoring plugin cache entry\n", fname.c_str());
+            return false;
+        }
+    }
+
+    values = entry["values"];
+
+    printf("... Using plugin cache entry %s\n", state->cache_path.c_str());
+
+    return true;
+}
+
+// Store an array, must be called before plugin_cache_save()
+inline bool
+plugin_cache_store_array(const PluginState *state, const std::string& name, const void *data, size_t size)
+{
+    if (!plugin_cache_enabled(state))
+        return false;
+
+    mkdir(state->cache_path.c_str(), 0755);
+
+    return plugin_cache_write_file(state->cache_path + "/" + name + ".bin", data, size);
+}
+
+// Completes the cache entry
+inline bool
+plugin_cache_save(const PluginState *state, const json& values,
+    const std::vector<std::string>& source_files = std::vector<std::string>())
+{
+    if (!plugin_cache_enabled(state))
+        return false;
+
+    mkdir(state->cache_path.c_str(), 0755);
+
+    json entry;
+
+    entry["values"] = values;
+    entry["sources"] = json::object();
+    for (auto& fname : source_files)
+        entry["sources"][fname] = plugin_cache_file_info(fname);
+
+    const std::string s = entry.dump();
+
+    if (!plugin_cache_write_file(state->cache_path + "/values.json", s.c_str(), s.size()))
+        return false;
+
+    printf("... Saved plugin cache entry %s\n", state->cache_path.c_str());
+
+    return true;
+}
+
+// Read-only mapping of a cached array, or nullptr if not available.
+// Release with plugin_cache_unmap_array(), which the plugin's
+// clear_data_function is a good place for when the mapped memory is
+// used for OSPRay shared data.
+inline void *
+plugin_cache_map_array(const PluginState *state, const std::string& name, size_t& size)
+{
+    if (!plugin_cache_enabled(state))
+        return nullptr;
+
+    const std::string fname = state->cache_path + "/" + name + ".bin";
+
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    fstat(fd, &st);
+    size = st.st_size;
+
+    void *ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (ptr == MAP_FAILED)
+    {
+        perror("plugin_cache_map_array(): mmap() failed");
+        return nullptr;
+    }
+
+    return ptr;
+}
+
+inline void
+plugin_cache_unmap_array(void *ptr, size_t size)
+{
+    if (ptr != nullptr)
+        munmap(ptr, size);
+}
+
+inline bool
+plugin_cache_store_bound(const PluginState *state, const BoundingMesh *bound)
+{
+    uint32_t size;
+    uint8_t *buffer = bound->serialize(size);
+
+    bool res = plugin_cache_store_array(state, "bound", buffer, size);
+
+    delete [] buffer;
+
+    return res;
+}
+
+// Returns nullptr if not available
+inline BoundingMesh *
+plugin_cache_load_bound(const PluginState *state)
+{
+    size_t size;
+    void *buffer = plugin_cache_map_array(state, "bound", size);
+
+    if (buffer == nullptr)
+        return nullptr;
+
+    BoundingMesh *bound = BoundingMesh::deserialize((const uint8_t*)buffer, size);
+
+    plugin_cache_unmap_array(buffer, size);
+
+    return bound;
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <string>
 #include <ospray/ospray.h>
 
+#include "shared_objects.h"
+
 //#include "messages.pb.h"
 
 typedef std::vector<OSPInstance>    OSPInstanceList;
@@ -43,6 +45,7 @@ struct SceneObject
     //json            parameters;
 
     std::string     data_link;              // Name of linked scene data, may be ""
+    std::string     material_link;          // Name of linked material, may be "" (mesh and geometry only)
 
     SceneObject() {}
     virtual ~SceneObject() {}
@@ -53,11 +56,13 @@ struct SceneObjectMesh : SceneObject
 	OSPGeometricModel gmodel;
 	OSPGroup group;
 	OSPInstance instance;
+	OSPGeometry geometry;		// Used by gmodel, no reference held
 
 	SceneObjectMesh(): SceneObject()
 	{
 		type = SOT_MESH;
 		gmodel = nullptr;
+		geometry = nullptr;
 		group = ospNewGroup();
 		instance = ospNewInstance(group);
 	}           
@@ -97,12 +102,16 @@ struct SceneObjectVolume : SceneObject
 	OSPVolumetricModel vmodel;
 	OSPGroup group;
 	OSPInstance instance;
-	// XXX TF and material
+	// From the linked plugin instance's state (with a reference held)
+	OSPVolume volume;
+	OSPVolume volume_lod;		// May be NULL
+	SharedTransferFunction transfer_function;
 
 	SceneObjectVolume(): SceneObject()
 	{
 		type = SOT_VOLUME;
 		vmodel = nullptr;   
+		volume = volume_lod = nullptr;
 		group = ospNewGroup();
 		instance = ospNewInstance(group);
 	}           
@@ -111,6 +120,10 @@ struct SceneObjectVolume : SceneObject
 	{
 		if (vmodel)
 			ospRelease(vmodel);
+		if (volume)
+			ospRelease(volume);
+		if (volume_lod)
+			ospRelease(volume_lod);
 		ospRelease(instance);
 	}
 };
@@ -118,17 +131,17 @@ struct SceneObjectVolume : SceneObject
 
 struct SceneObjectIsosurfaces : SceneObject
 {
-	OSPVolumetricModel vmodel;
+	// Shared with other objects using the same volume and TF
+	SharedVolumetricModel vmodel;
+	SharedTransferFunction transfer_function;
 	OSPGeometry isosurfaces_geometry;
 	OSPGeometricModel gmodel;
 	OSPGroup group;
 	OSPInstance instance;
-	// XXX TF and material
 
 	SceneObjectIsosurfaces(): SceneObject()
 	{
 		type = SOT_ISOSURFACES;
-		vmodel = nullptr;
 		isosurfaces_geometry = ospNewGeometry("isosurfaces"); 
 		gmodel = ospNewGeometricModel(isosurfaces_geometry);
 		group = ospNewGroup();
@@ -140,8 +153,6 @@ struct SceneObjectIsosurfaces : SceneObject
 
 	virtual ~SceneObjectIsosurfaces()
 	{
-		if (vmodel)
-			ospRelease(vmodel);
 		ospRelease(instance);
 	}
 };
@@ -149,19 +160,20 @@ struct SceneObjectIsosurfaces : SceneObject
 
 struct SceneObjectSlice : SceneObject
 {
-	OSPVolumetricModel vmodel;
+	// Shared with other slices of the same volume and TF
+	SharedVolumetricModel vmodel;
+	SharedTransferFunction transfer_function;
+	SharedMaterial material;
 	OSPGeometry slice_geometry;
 	OSPGeometricModel gmodel;
 	OSPGroup group;
 	OSPInstance instance;
-	// XXX TF and material
 
 	std::vector<OSPObject>	objects_to_commit;
 
 	SceneObjectSlice(): SceneObject()
 	{
 		type = SOT_SLICE;
-		vmodel = nullptr;
 		slice_geometry = nullptr;
 		gmodel = ospNewGeometricModel(slice_geometry);
 		group = ospNewGroup();
@@ -180,8 +192,6 @@ struct SceneObjectSlice : SceneObject
 	{
 		if (gmodel)
 			ospRelease(gmodel);
-		if (vmodel)
-			ospRelease(vmodel);
 		ospRelease(instance);
 	}
 };
@@ -0,0 +1,140 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Registry of OSPRay objects shared by definition                          //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef SHARED_OBJECTS_H
+#define SHARED_OBJECTS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <ospray/ospray.h>
+
+/*
+Objects that are fully described by a definition (e.g. a transfer function
+or material) are registered under a key derived from that definition
+(typically a hash), so identical definitions map to a single (committed)
+OSPRay object. Users hold a SharedObject pointer, the registry only a weak
+reference, so an object is released when its last user goes away.
+
+A user that is the only one holding an object can rekey() it and change
+the object in place, instead of creating a new object.
+
+Not thread-safe, each session uses its own registries.
+*/
+
+template <typename T>
+struct SharedObject
+{
+    T               object;
+    std::string     key;
+
+    SharedObject(T object, const std::string& key): object(object), key(key) {}
+    ~SharedObject() { ospRelease(object); }
+};
+
+template <typename T>
+class SharedObjectRegistry
+{
+public:
+
+    typedef std::shared_ptr<SharedObject<T>>    Ptr;
+
+    // Returns nullptr if no object is registered under key
+    Ptr find(const std::string& key)
+    {
+        typename Map::iterator it = m_objects.find(key);
+
+        if (it == m_objects.end())
+            return nullptr;
+
+        Ptr p = it->second.lock();
+
+        if (p == nullptr)
+            m_objects.erase(it);
+
+        return p;
+    }
+
+    // Takes over the caller's reference to object
+    Ptr add(const std::string& key, T object)
+    {
+        Ptr p = std::make_shared<SharedObject<T>>(object, key);
+        m_objects[key] = p;
+        return p;
+    }
+
+    // Moves p to a new key, when the caller holds the only pointer to it
+    // and no (live) object is registered under the new key. Returns false
+    // otherwise.
+    bool rekey(Ptr& p, const std::string& key)
+    {
+        if (p == nullptr || p.use_count() > 1 || find(key) != nullptr)
+            return false;
+
+        typename Map::iterator it = m_objects.find(p->key);
+        if (it != m_objects.end() && it->second.lock() == p)
+            m_objects.erase(it);
+
+        p->key = key;
+        m_objects[key] = p;
+
+        return true;
+    }
+
+    // Number of live objects
+    size_t size()
+    {
+        purge();
+        return m_objects.size();
+    }
+
+    // Calls f(key, users) for each live object
+    template <typename F>
+    void foreach(F f)
+    {
+        purge();
+        for (auto& kv : m_objects)
+            f(kv.first, kv.second.use_count());
+    }
+
+protected:
+
+    void purge()
+    {
+        typename Map::iterator it = m_objects.begin();
+        while (it != m_objects.end())
+        {
+            if (it->second.expired())
+                it = m_objects.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    typedef std::map<std::string, std::weak_ptr<SharedObject<T>>>   Map;
+
+    Map     m_objects;
+};
+
+typedef SharedObjectRegistry<OSPTransferFunction>::Ptr  SharedTransferFunction;
+typedef SharedObjectRegistry<OSPVolumetricModel>::Ptr   SharedVolumetricModel;
+typedef SharedObjectRegistry<OSPMaterial>::Ptr          SharedMaterial;
+
+#endif
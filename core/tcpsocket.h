@@ -72,6 +72,9 @@ public:
 
     TCPSocket(int fd)
     {
+        verbose = false;
+        destination_addr = NULL;
+        errno_for_last_fail = 0;
         sock = fd;
     }
 
@@ -448,11 +451,16 @@ public:
         return res == 1;
     }
     
+    // Does nothing when already closed (the destructor closes as well)
     inline int close()
     {
+        if (sock == -1)
+            return 0;
+
         errno_for_last_fail = errno;
         
         int res = ::close(sock);
+        sock = -1;
         if (res == -1)
         {
             errno_for_last_fail = errno;
@@ -463,6 +471,12 @@ public:
         return 0;
     }
     
+    // For use with poll()/select() on multiple descriptors
+    inline int get_fd() const
+    {
+        return sock;
+    }
+
     // Result only valid directly after failing method call
     inline int get_errno() const
     {
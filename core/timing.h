@@ -0,0 +1,240 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Per-phase timing statistics and trace events                             //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef TIMING_H
+#define TIMING_H
+
+/*
+Timings collects the durations of named phases (e.g. "render" or
+"world commit"), keeping per-phase statistics. When tracing is enabled
+each measurement is also stored as an event, which can be written as a
+Chrome trace (JSON) file, for viewing in chrome://tracing or Perfetto.
+
+A measurement costs two clock reads and a short locked section, so
+timers are meant for phases (messages, commits, frames), not for
+inner loops.
+*/
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+typedef std::chrono::steady_clock   TimingClock;
+
+// Upper bound on the number of trace events kept
+const size_t TIMING_MAX_TRACE_EVENTS = 1<<20;
+
+struct TimingStats
+{
+    uint64_t    count;
+    double      total;          // Seconds
+    double      max;
+    double      last;
+
+    TimingStats(): count(0), total(0.0), max(0.0), last(0.0) {}
+};
+
+class Timings
+{
+public:
+
+    Timings(): m_start(TimingClock::now()), m_trace(false) {}
+
+    void set_trace(bool enabled)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_trace = enabled;
+    }
+
+    void add(const std::string& phase, TimingClock::time_point t0, TimingClock::time_point t1)
+    {
+        const double duration = std::chrono::duration<double>(t1 - t0).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        TimingStats& stats = m_stats[phase];
+
+        stats.count++;
+        stats.total += duration;
+        stats.last = duration;
+        if (duration > stats.max)
+            stats.max = duration;
+
+        if (!m_trace)
+            return;
+
+        if (m_events.size() == TIMING_MAX_TRACE_EVENTS)
+        {
+            printf("WARNING: maximum number of trace events (%d) reached, not recording more\n", (int)TIMING_MAX_TRACE_EVENTS);
+            m_trace = false;
+            return;
+        }
+
+        TraceEvent event;
+
+        event.phase = phase;
+        event.start = std::chrono::duration_cast<std::chrono::microseconds>(t0 - m_start).count();
+        event.duration = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        event.thread = thread_index();
+
+        m_events.push_back(event);
+    }
+
+    // Duration of the last measurement of the phase, in seconds.
+    // 0 if the phase was never measured.
+    double last(const std::string& phase)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::map<std::string, TimingStats>::const_iterator it = m_stats.find(phase);
+
+        return it == m_stats.end() ? 0.0 : it->second.last;
+    }
+
+    // Statistics per phase, as { phase: { count, total, mean, max, last } }
+    void get_json(json& j)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        j = json::object();
+
+        for (auto& kv : m_stats)
+        {
+            const TimingStats& s = kv.second;
+
+            j[kv.first] = {
+                {"count", s.count}, {"total", s.total}, {"mean", s.total / s.count},
+                {"max", s.max}, {"last", s.last}
+            };
+        }
+    }
+
+    // Writes the trace events collected so far, in Chrome's trace event
+    // format. Returns false if the file can't be written.
+    bool write_trace(const char *fname)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        FILE *f = fopen(fname, "wt");
+        if (f == NULL)
+            return false;
+
+        fprintf(f, "{\"traceEvents\":[\n");
+
+        for (size_t i = 0; i < m_events.size(); i++)
+        {
+            const TraceEvent& e = m_events[i];
+
+            fprintf(f, "{\"name\":%s,\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}%s\n",
+                json(e.phase).dump().c_str(), (long long)e.start, (long long)e.duration, e.thread,
+                i+1 < m_events.size() ? "," : "");
+        }
+
+        fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+
+        fclose(f);
+
+        return true;
+    }
+
+protected:
+
+    struct TraceEvent
+    {
+        std::string     phase;
+        int64_t         start;          // Microseconds since m_start
+        int64_t         duration;
+        int             thread;
+    };
+
+    // Small thread numbers read better in trace viewers than thread ids.
+    // Called with m_mutex held.
+    int thread_index()
+    {
+        const std::thread::id id = std::this_thread::get_id();
+
+        std::map<std::thread::id, int>::const_iterator it = m_threads.find(id);
+
+        if (it != m_threads.end())
+            return it->second;
+
+        const int index = m_threads.size();
+        m_threads[id] = index;
+
+        return index;
+    }
+
+    TimingClock::time_point             m_start;
+    bool                                m_trace;
+    std::map<std::string, TimingStats>  m_stats;
+    std::vector<TraceEvent>             m_events;
+    std::map<std::thread::id, int>      m_threads;
+    std::mutex                          m_mutex;
+};
+
+// Measures the time between construction and destruction (or stop())
+class ScopedTimer
+{
+public:
+
+    ScopedTimer(Timings& timings, const std::string& phase)
+        : m_timings(timings), m_phase(phase), m_start(TimingClock::now()), m_stopped(false)
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        stop();
+    }
+
+    // Returns the measured time, in seconds
+    double stop()
+    {
+        if (m_stopped)
+            return m_elapsed;
+
+        const TimingClock::time_point t1 = TimingClock::now();
+
+        m_timings.add(m_phase, m_start, t1);
+
+        m_elapsed = std::chrono::duration<double>(t1 - m_start).count();
+        m_stopped = true;
+
+        return m_elapsed;
+    }
+
+protected:
+    Timings&                    m_timings;
+    std::string                 m_phase;
+    TimingClock::time_point     m_start;
+    bool                        m_stopped;
+    double                      m_elapsed;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #define UTIL_H
 
 #include <sys/time.h>
+#include <stdint.h>
 #include <arpa/inet.h>
 #include <ospray/ospray.h>
 
@@ -70,4 +71,52 @@ float_swap(float value)
     return val.f;
 };
 
+// IEEE 754 single to half precision, round-to-nearest. 
+// Out-of-range values become +/-inf, NaNs are preserved.
+inline uint16_t
+float_to_half(float value)
+{
+    union v {
+        float       f;
+        uint32_t    i;
+    };
+
+    v val;
+    val.f = value;
+
+    const uint32_t  x = val.i;
+    const uint16_t  sign = (x >> 16) & 0x8000;
+    const int32_t   e = (x >> 23) & 0xff;
+    uint32_t        mantissa = x & 0x7fffff;
+
+    if (e == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+    const int32_t exponent = e - 127 + 15;
+
+    if (exponent >= 31)
+        return sign | 0x7c00;
+
+    if (exponent <= 0)
+    {
+        // Subnormal, or too small
+        if (exponent < -10)
+            return sign;
+
+        mantissa |= 0x800000;
+        const int shift = 14 - exponent;
+        uint32_t h = mantissa >> shift;
+        if ((mantissa >> (shift-1)) & 1)
+            h++;
+        return sign | h;
+    }
+
+    // Rounding may carry into the exponent, which gives the correct result
+    uint32_t h = (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        h++;
+
+    return sign | h;
+}
+
 #endif
@@ -24,6 +24,8 @@
 //#define DUMP_PROTOBUF_TRAFFIC
 
 #include <cstdlib>
+#include <string>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <boost/version.hpp>
@@ -116,6 +118,12 @@ affine3fv_from_mat4(float *xform, const glm::mat4 &mat)
 
 static uint8_t receive_buffer[1024];
 
+// While record_received_protobufs is set the (serialized) protobufs 
+// received by receive_protobuf() are appended to received_protobufs.
+// Used for replicating client messages in distributed mode.
+static thread_local bool                       record_received_protobufs = false;
+static thread_local std::vector<std::string>   received_protobufs;
+
 template<typename T>
 bool
 receive_protobuf(TCPSocket *sock, T& protobuf)
@@ -132,6 +140,9 @@ receive_protobuf(TCPSocket *sock, T& protobuf)
 
     protobuf.ParseFromArray(receive_buffer, message_size);
 
+    if (record_received_protobufs)
+        received_protobufs.push_back(std::string((const char*)receive_buffer, message_size));
+
 #ifdef DUMP_PROTOBUF_TRAFFIC    
     fprintf(stderr, "--- receive_protobuf() ---\n%s\n--------------------------\n", protobuf.DebugString().c_str());
 #endif
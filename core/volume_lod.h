@@ -0,0 +1,194 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Level-of-detail volumes, for interactive rendering                       //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef VOLUME_LOD_H
+#define VOLUME_LOD_H
+
+/*
+A volume plugin can provide a downsampled version of its volume in
+PluginState::volume_lod. The server uses it for the reduced-resolution
+frames at the start of interactive rendering (i.e. while the reduction
+factor is larger than 1, see framebuffer_initial_reduction_factor),
+and switches to the full-resolution volume for the remaining frames
+and for final renders.
+
+Creating the LOD volume reads every voxel of the full-resolution volume
+once. For memory-mapped voxels (e.g. volume_raw) this pages in the whole
+file at creation, so the LOD doesn't save I/O, only render time in the
+first interactive frames.
+
+Downsampling is done per output brick (a box of factor^3 input voxels),
+in parallel over output slices.
+*/
+
+#include <stdint.h>
+#include <cstdio>
+#include <ospray/ospray.h>
+
+#include "json.hpp"
+#include "util.h"
+#include "voxel_kernels.h"
+
+using json = nlohmann::json;
+
+// Returns the LOD factor from the plugin parameters ("lod_factor"),
+// or 1 when no LOD volume should be created
+inline int
+volume_lod_factor(const json& parameters)
+{
+    if (parameters.find("lod_factor") == parameters.end())
+        return 1;
+
+    int factor = parameters["lod_factor"].get<int>();
+
+    return factor > 1 ? factor : 1;
+}
+
+// Box-filter downsampling of a dims[0] x dims[1] x dims[2] grid by the given
+// factor. Each output voxel is the average of (up to) factor^3 input voxels.
+// Returns a new[] allocated array of lod_dims[0] x lod_dims[1] x lod_dims[2] values.
+template <typename T>
+T *
+volume_lod_downsample(const T *values, const int32_t *dims, int factor, int32_t *lod_dims)
+{
+    for (int i = 0; i < 3; i++)
+        lod_dims[i] = (dims[i] + factor - 1) / factor;
+
+    const size_t nx = lod_dims[0], ny = lod_dims[1];
+    T *lod_values = new T[nx * ny * lod_dims[2]];
+
+    voxel_parallel_for(lod_dims[2], [=](size_t begin, size_t end, int) {
+
+        std::vector<float> row(nx);
+        std::vector<int> counts(nx);
+
+        for (size_t K = begin; K < end; K++)
+        {
+            const int k0 = K * factor;
+            const int k1 = std::min<int>(k0 + factor, dims[2]);
+
+            for (size_t J = 0; J < ny; J++)
+            {
+                const int j0 = J * factor;
+                const int j1 = std::min<int>(j0 + factor, dims[1]);
+
+                std::fill(row.begin(), row.end(), 0.0f);
+                std::fill(counts.begin(), counts.end(), 0);
+
+                // Accumulate the input rows of this brick row in one pass each
+                for (int k = k0; k < k1; k++)
+                {
+                    for (int j = j0; j < j1; j++)
+                    {
+                        const T *input = values + ((size_t)k * dims[1] + j) * dims[0];
+
+                        for (int i = 0; i < dims[0]; i++)
+                        {
+                            row[i / factor] += (float)(input[i]);
+                            counts[i / factor]++;
+                        }
+                    }
+                }
+
+                T *output = lod_values + (K * ny + J) * nx;
+
+                for (size_t I = 0; I < nx; I++)
+                    output[I] = (T)(row[I] / counts[I]);
+            }
+        }
+    }, 2);
+
+    return lod_values;
+}
+
+// Downsamples the T values into a new (committed) data object, setting lod_dims
+template <typename T>
+OSPData
+volume_lod_data(const void *values, OSPDataType data_type, const int32_t *dims, int factor, int32_t *lod_dims)
+{
+    T *lod_values = volume_lod_downsample((const T*)values, dims, factor, lod_dims);
+
+    const size_t n = (size_t)lod_dims[0] * lod_dims[1] * lod_dims[2];
+
+    printf("... LOD volume %d x %d x %d (factor %d, %.1f MB)\n",
+        lod_dims[0], lod_dims[1], lod_dims[2], factor, n*sizeof(T)/1000000.0f);
+
+    OSPData data = ospNewCopiedData(n, data_type, lod_values);
+    ospCommit(data);
+
+    delete [] lod_values;
+
+    return data;
+}
+
+// Creates a structured_regular volume downsampled from the given voxels.
+// origin and spacing are those of the full-resolution volume, the
+// LOD volume covers the same extent. Returns NULL for unsupported types.
+inline OSPVolume
+volume_lod_create(const void *values, OSPDataType data_type, const int32_t *dims,
+    const float *origin, const float *spacing, int factor)
+{
+    int32_t lod_dims[3];
+    OSPData voxelData;
+
+    switch (data_type)
+    {
+    case OSP_UCHAR:
+        voxelData = volume_lod_data<uint8_t>(values, data_type, dims, factor, lod_dims);
+        break;
+    case OSP_USHORT:
+        voxelData = volume_lod_data<uint16_t>(values, data_type, dims, factor, lod_dims);
+        break;
+    case OSP_SHORT:
+        voxelData = volume_lod_data<int16_t>(values, data_type, dims, factor, lod_dims);
+        break;
+    case OSP_FLOAT:
+        voxelData = volume_lod_data<float>(values, data_type, dims, factor, lod_dims);
+        break;
+    case OSP_DOUBLE:
+        voxelData = volume_lod_data<double>(values, data_type, dims, factor, lod_dims);
+        break;
+    default:
+        fprintf(stderr, "... WARNING: can't create LOD volume for data type %d\n", data_type);
+        return NULL;
+    }
+
+    float lod_spacing[3];
+
+    for (int i = 0; i < 3; i++)
+        lod_spacing[i] = spacing[i] * dims[i] / lod_dims[i];
+
+    OSPVolume volume = ospNewVolume("structured_regular");
+
+        ospSetObject(volume, "data", voxelData);
+        ospRelease(voxelData);
+
+        ospSetInt(volume, "voxelType", data_type);
+        ospSetVec3i(volume, "dimensions", lod_dims[0], lod_dims[1], lod_dims[2]);
+
+        ospSetVec3f(volume, "gridOrigin", origin[0], origin[1], origin[2]);
+        ospSetVec3f(volume, "gridSpacing", lod_spacing[0], lod_spacing[1], lod_spacing[2]);
+
+    ospCommit(volume);
+
+    return volume;
+}
+
+#endif
@@ -0,0 +1,208 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Voxel preprocessing routines, for use in volume plugins                  //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef VOXEL_KERNELS_H
+#define VOXEL_KERNELS_H
+
+/*
+The routines below split the voxel array in large chunks that are
+processed in parallel by a set of threads. The inner loops are kept
+branch-free and on plain arrays, so the compiler can vectorize them
+(byte-swapping becomes a shuffle, min/max reductions use the SIMD
+min/max instructions).
+
+Small arrays are processed by the calling thread only.
+*/
+
+#include <stdint.h>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+// Below this number of values don't bother with threads
+const size_t VOXEL_KERNELS_PARALLEL_THRESHOLD = 1<<20;
+
+// Chunk boundaries of the voxel kernels are kept at a multiple of this 
+// number of values, which keeps chunks SIMD and cache-line friendly
+const size_t VOXEL_KERNELS_CHUNK_ALIGNMENT = 64;
+
+// Calls func(begin, end, chunk_index) for consecutive chunks of [0, n),
+// in parallel, with chunk boundaries at a multiple of alignment. 
+// Returns the number of chunks used.
+template <typename F>
+int
+voxel_parallel_for(size_t n, F func, size_t threshold=VOXEL_KERNELS_PARALLEL_THRESHOLD, size_t alignment=1)
+{
+    int num_chunks = 1;
+
+    if (n >= threshold)
+        num_chunks = std::max(1u, std::thread::hardware_concurrency());
+
+    if (num_chunks == 1)
+    {
+        func(0, n, 0);
+        return 1;
+    }
+
+    size_t chunk_size = (n + num_chunks - 1) / num_chunks;
+    chunk_size = (chunk_size + alignment - 1) / alignment * alignment;
+
+    std::vector<std::thread> threads;
+
+    for (int c = 0; c < num_chunks; c++)
+    {
+        const size_t begin = c * chunk_size;
+        const size_t end = std::min(n, begin + chunk_size);
+
+        if (begin >= end)
+        {
+            num_chunks = c;
+            break;
+        }
+
+        threads.push_back(std::thread(func, begin, end, c));
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    return num_chunks;
+}
+
+// Byte swapping
+
+inline void
+voxel_byte_swap_range(uint16_t * __restrict values, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+        values[i] = __builtin_bswap16(values[i]);
+}
+
+inline void
+voxel_byte_swap_range(uint32_t * __restrict values, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+        values[i] = __builtin_bswap32(values[i]);
+}
+
+inline void
+voxel_byte_swap_range(uint64_t * __restrict values, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+        values[i] = __builtin_bswap64(values[i]);
+}
+
+// In-place endian flip of n values of element_size bytes each
+// (2, 4 or 8). Returns false for unsupported element sizes.
+inline bool
+voxel_byte_swap(void *values, size_t n, int element_size)
+{
+    switch (element_size)
+    {
+    case 1:
+        return true;
+
+    case 2:
+        voxel_parallel_for(n, [values](size_t begin, size_t end, int) {
+            voxel_byte_swap_range((uint16_t*)values, begin, end);
+        }, VOXEL_KERNELS_PARALLEL_THRESHOLD, VOXEL_KERNELS_CHUNK_ALIGNMENT);
+        return true;
+
+    case 4:
+        voxel_parallel_for(n, [values](size_t begin, size_t end, int) {
+            voxel_byte_swap_range((uint32_t*)values, begin, end);
+        }, VOXEL_KERNELS_PARALLEL_THRESHOLD, VOXEL_KERNELS_CHUNK_ALIGNMENT);
+        return true;
+
+    case 8:
+        voxel_parallel_for(n, [values](size_t begin, size_t end, int) {
+            voxel_byte_swap_range((uint64_t*)values, begin, end);
+        }, VOXEL_KERNELS_PARALLEL_THRESHOLD, VOXEL_KERNELS_CHUNK_ALIGNMENT);
+        return true;
+    }
+
+    fprintf(stderr, "... WARNING: voxel_byte_swap(): unsupported element size %d\n", element_size);
+    return false;
+}
+
+// Conversion
+
+template <typename T>
+void
+voxel_convert_to_float(float * __restrict float_values, const T * __restrict values, size_t n)
+{
+    voxel_parallel_for(n, [float_values, values](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+            float_values[i] = (float)(values[i]);
+    }, VOXEL_KERNELS_PARALLEL_THRESHOLD, VOXEL_KERNELS_CHUNK_ALIGNMENT);
+}
+
+// In-place values[i] = values[i] * scale + offset
+
+template <typename T>
+void
+voxel_map_values(T * __restrict values, size_t n, float scale, float offset)
+{
+    voxel_parallel_for(n, [values, scale, offset](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+            values[i] = (T)((float)(values[i]) * scale + offset);
+    }, VOXEL_KERNELS_PARALLEL_THRESHOLD, VOXEL_KERNELS_CHUNK_ALIGNMENT);
+}
+
+// Minimum and maximum value
+
+template <typename T>
+void
+voxel_value_range_range(const T * __restrict values, size_t begin, size_t end, float& minval, float& maxval)
+{
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const float v = (float)(values[i]);
+        min = v < min ? v : min;
+        max = v > max ? v : max;
+    }
+
+    minval = min;
+    maxval = max;
+}
+
+template <typename T>
+void
+voxel_value_range(const T *values, size_t n, float& minval, float& maxval)
+{
+    const int max_chunks = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<float> mins(max_chunks), maxs(max_chunks);
+
+    int num_chunks = voxel_parallel_for(n, [values, &mins, &maxs](size_t begin, size_t end, int c) {
+        voxel_value_range_range(values, begin, end, mins[c], maxs[c]);
+    }, VOXEL_KERNELS_PARALLEL_THRESHOLD, VOXEL_KERNELS_CHUNK_ALIGNMENT);
+
+    minval = *std::min_element(mins.begin(), mins.begin()+num_chunks);
+    maxval = *std::max_element(maxs.begin(), maxs.begin()+num_chunks);
+}
+
+#endif
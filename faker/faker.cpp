@@ -4,11 +4,13 @@
 #include <cstdarg>
 #include <sys/time.h>       
 #include <map>
+#include <mutex>
 #include <stdint.h>
 //#include <sys/types.h>
 //#include <sys/socket.h>
 #include <ospray/ospray.h>
 #include <json.hpp>
+#include "recording.h"
 
 using json = nlohmann::json;
 
@@ -23,6 +25,39 @@ const int DUMP_VALUE_ARRAYS = 0x2;
 static int dump_arrays = getenv("FAKER_DUMP_ARRAYS") ? atol(getenv("FAKER_DUMP_ARRAYS")) : DUMP_REFERENCE_ARRAYS;
 static bool abort_on_ospray_error = getenv("FAKER_ABORT_ON_OSPRAY_ERROR") != nullptr;
 
+// Binary recording of the call stream, for blospray_replay. Written when
+// FAKER_RECORD is set to the output file name.
+static const char *record_file_name = getenv("FAKER_RECORD");
+static RecordingWriter  recording;
+// Plugins call OSPRay from multiple threads
+static std::mutex       recording_mutex;
+
+// Source layout of shared data objects, so their contents can be
+// recorded again when the application changes them
+struct SharedDataSource
+{
+    const void  *data;
+    OSPDataType type;
+    uint64_t    num_items[3];
+    int64_t     byte_stride[3];
+    uint64_t    hash;           // Of the contents last recorded
+    int         references;     // By the application, plus one per parameter of a SharedDataUser
+};
+
+static std::map<OSPObject, SharedDataSource>   shared_data_sources;
+
+// Objects (still referenced by the application) with shared data as
+// parameter. The application might change the shared memory and only
+// commit such an object, so the data contents get recorded on its commit
+// as well, and the source is tracked until the last of these is released.
+struct SharedDataUser
+{
+    int                                 references;     // By the application
+    std::map<std::string, OSPObject>    data;           // Parameter name -> shared data
+};
+
+static std::map<OSPObject, SharedDataUser>     shared_data_users;
+
 typedef std::map<std::string, void*>    PointerMap;
 
 static PointerMap           library_pointers;
@@ -35,6 +70,7 @@ static std::map<int,std::string>    osptextureformat_names;
 typedef OSPError            (*ospInit_ptr)          (int *argc, const char **argv);
 typedef OSPDevice           (*ospNewDevice_ptr)     (const char *type);
 typedef void                (*ospDeviceSetErrorFunc_ptr) (OSPDevice, OSPErrorFunc);
+typedef OSPError            (*ospLoadModule_ptr)    (const char *name);
 
 typedef OSPData             (*ospNewSharedData_ptr) (const void *sharedData, OSPDataType type, uint64_t numItems1, int64_t byteStride1, uint64_t numItems2, int64_t byteStride2, uint64_t numItems3, int64_t byteStride3);
 typedef OSPData             (*ospNewData_ptr)       (OSPDataType type, uint64_t numItems1, uint64_t numItems2, uint64_t numItems3);
@@ -48,6 +84,7 @@ typedef OSPFrameBuffer      (*ospNewFrameBuffer_ptr)(int x, int y, OSPFrameBuffe
 typedef OSPGeometricModel   (*ospNewGeometricModel_ptr) (OSPGeometry geometry);
 typedef OSPGeometry         (*ospNewGeometry_ptr)   (const char *type);
 typedef OSPGroup            (*ospNewGroup_ptr)      ();
+typedef OSPImageOperation   (*ospNewImageOperation_ptr) (const char *type);
 typedef OSPInstance         (*ospNewInstance_ptr)   (OSPGroup group);
 typedef OSPLight            (*ospNewLight_ptr)      (const char *type);
 typedef OSPMaterial         (*ospNewMaterial_ptr)   (const char *rendererType, const char *materialType);
@@ -60,6 +97,8 @@ typedef OSPWorld            (*ospNewWorld_ptr)      ();
 
 typedef void                (*ospCommit_ptr)        (OSPObject obj);
 typedef void                (*ospRelease_ptr)       (OSPObject obj);
+typedef void                (*ospRetain_ptr)        (OSPObject obj);
+typedef void                (*ospRemoveParam_ptr)   (OSPObject obj, const char *id);
 
 typedef void                (*ospSetBool_ptr)       (OSPObject obj, const char *id, int x);
 typedef void                (*ospSetFloat_ptr)      (OSPObject obj, const char *id, float x);
@@ -279,9 +318,176 @@ ospray_error(OSPError e, const char *error)
         abort();
 }
 
+//
+// Recording
+//
+
+// Called with recording_mutex held
+static bool
+ensure_recording()
+{
+    if (recording.is_open())
+        return true;
+
+    if (!recording.open(record_file_name))
+    {
+        printf("(FAKER) ERROR: could not open recording file %s, not recording\n", record_file_name);
+        record_file_name = nullptr;
+        return false;
+    }
+
+    printf("(FAKER) Recording OSPRay calls to %s\n", record_file_name);
+
+    return true;
+}
+
+// Writes a record, the statements given are executed with the
+// recording lock held. Does nothing when not recording.
+#define RECORD(...) \
+    if (record_file_name != nullptr) \
+    { \
+        std::lock_guard<std::mutex> lock(recording_mutex); \
+        if (ensure_recording()) \
+        { \
+            __VA_ARGS__ \
+        } \
+    }
+
+// Copies the (possibly strided) source array to a contiguous buffer.
+// Returns false for element types of unknown size.
+static bool
+compact_shared_data(std::vector<uint8_t>& contents, const SharedDataSource& source)
+{
+    const size_t item_size = recording_type_size(source.type);
+
+    if (item_size == 0)
+        return false;
+
+    // A stride of 0 means the items are packed (along that dimension)
+    const int64_t stride1 = source.byte_stride[0] != 0 ? source.byte_stride[0] : item_size;
+    const int64_t stride2 = source.byte_stride[1] != 0 ? source.byte_stride[1] : stride1 * source.num_items[0];
+    const int64_t stride3 = source.byte_stride[2] != 0 ? source.byte_stride[2] : stride2 * source.num_items[1];
+
+    contents.resize(item_size * source.num_items[0] * source.num_items[1] * source.num_items[2]);
+
+    const uint8_t *src = (const uint8_t*)source.data;
+    uint8_t *dst = contents.data();
+
+    if (stride1 == (int64_t)item_size
+        && (source.num_items[1] == 1 || stride2 == (int64_t)(item_size*source.num_items[0]))
+        && (source.num_items[2] == 1 || stride3 == (int64_t)(stride2*source.num_items[1])))
+    {
+        memcpy(dst, src, contents.size());
+        return true;
+    }
+
+    for (uint64_t k = 0; k < source.num_items[2]; k++)
+        for (uint64_t j = 0; j < source.num_items[1]; j++)
+            for (uint64_t i = 0; i < source.num_items[0]; i++)
+            {
+                memcpy(dst, src + k*stride3 + j*stride2 + i*stride1, item_size);
+                dst += item_size;
+            }
+
+    return true;
+}
+
+// FNV-1a
+static uint64_t
+contents_hash(const std::vector<uint8_t>& contents)
+{
+    uint64_t h = 14695981039346656037ULL;
+
+    for (uint8_t b : contents)
+    {
+        h ^= b;
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+// Records the contents of a shared data object, if they changed since
+// they were last recorded. Called with recording_mutex held.
+static void
+record_data_contents(OSPObject obj)
+{
+    std::map<OSPObject, SharedDataSource>::iterator it = shared_data_sources.find(obj);
+
+    if (it == shared_data_sources.end())
+        return;
+
+    std::vector<uint8_t> contents;
+
+    if (!compact_shared_data(contents, it->second))
+        return;
+
+    const uint64_t hash = contents_hash(contents);
+
+    if (hash == it->second.hash)
+        return;
+
+    recording.call(REC_DATA_CONTENTS);
+    recording.handle(obj);
+    recording.bytes(contents.data(), contents.size());
+
+    it->second.hash = hash;
+}
+
+// Drops a reference to a shared data object, it is no longer tracked
+// after the last one. Called with recording_mutex held.
+static void
+release_shared_data_source(OSPObject obj)
+{
+    std::map<OSPObject, SharedDataSource>::iterator it = shared_data_sources.find(obj);
+
+    if (it != shared_data_sources.end() && --it->second.references == 0)
+        shared_data_sources.erase(it);
+}
+
+// Tracks (or stops tracking) shared data set as parameter id of obj.
+// Called with recording_mutex held.
+static void
+set_shared_data_parameter(OSPObject obj, const char *id, OSPObject data)
+{
+    std::map<OSPObject, SharedDataUser>::iterator it = shared_data_users.find(obj);
+
+    if (it != shared_data_users.end())
+    {
+        std::map<std::string, OSPObject>::iterator p = it->second.data.find(id);
+
+        if (p != it->second.data.end())
+        {
+            release_shared_data_source(p->second);
+            it->second.data.erase(p);
+        }
+    }
+
+    std::map<OSPObject, SharedDataSource>::iterator source = shared_data_sources.find(data);
+
+    if (data == nullptr || source == shared_data_sources.end())
+        return;
+
+    if (it == shared_data_users.end())
+    {
+        // XXX misses references taken before the object got its first
+        // shared data parameter
+        it = shared_data_users.insert(std::make_pair(obj, SharedDataUser())).first;
+        it->second.references = 1;
+    }
+
+    it->second.data[id] = data;
+    source->second.references++;
+}
+
 // 
 // Intercepted functions
 //
+// Only the core API calls are recorded. The utility functions
+// (ospCopyData1D(), ospRenderFrameBlocking(), ospSetFloat(), ...) are
+// implemented in libospray in terms of those, and their nested calls
+// get intercepted (and recorded) as well.
+//
 
 extern "C"
 OSPError
@@ -352,8 +558,34 @@ ospDeviceSetErrorFunc(OSPDevice device, OSPErrorFunc error_func)
 
     log_json(j);
 }
+
+extern "C"
+OSPError
+ospLoadModule(const char *name)
+{
+    ospLoadModule_ptr libcall = GET_PTR(ospLoadModule);
+
+    json j;
+    j["timestamp"] = timestamp();
+    j["call"] = "ospLoadModule";
+    j["arguments"] = {
+        {"name", name},
+    };
+
+    OSPError res = libcall(name);
+
+    j["result"] = (size_t)res;
+    log_json(j);
+
+    RECORD(
+        recording.call(REC_LOAD_MODULE);
+        recording.string(name);
+    )
+
+    return res;
+}
     
-#define NEW_FUNCTION_1(TYPE) \
+#define NEW_FUNCTION_1(TYPE, RECORDED_CALL) \
     extern "C" \
     OSP ## TYPE \
     ospNew ## TYPE(const char *type) \
@@ -370,16 +602,23 @@ ospDeviceSetErrorFunc(OSPDevice device, OSPErrorFunc error_func)
         j["result"] = (size_t)res; \
         log_json(j); \
         \
+        RECORD( \
+            recording.call(RECORDED_CALL); \
+            recording.string(type); \
+            recording.handle(res); \
+        ) \
+        \
         return res; \
     }
 
-NEW_FUNCTION_1(Camera)
-NEW_FUNCTION_1(Geometry)
-NEW_FUNCTION_1(Light)
-NEW_FUNCTION_1(Renderer)
-NEW_FUNCTION_1(Texture)
-NEW_FUNCTION_1(TransferFunction)
-NEW_FUNCTION_1(Volume)
+NEW_FUNCTION_1(Camera, REC_NEW_CAMERA)
+NEW_FUNCTION_1(Geometry, REC_NEW_GEOMETRY)
+NEW_FUNCTION_1(ImageOperation, REC_NEW_IMAGE_OPERATION)
+NEW_FUNCTION_1(Light, REC_NEW_LIGHT)
+NEW_FUNCTION_1(Renderer, REC_NEW_RENDERER)
+NEW_FUNCTION_1(Texture, REC_NEW_TEXTURE)
+NEW_FUNCTION_1(TransferFunction, REC_NEW_TRANSFER_FUNCTION)
+NEW_FUNCTION_1(Volume, REC_NEW_VOLUME)
 
 static bool
 is_value_type(OSPDataType type)
@@ -562,6 +801,28 @@ ospNewSharedData(const void *sharedData, OSPDataType type, uint64_t numItems1, i
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        SharedDataSource source = {
+            sharedData, type, { numItems1, numItems2, numItems3 }, { byteStride1, byteStride2, byteStride3 }, 0
+        };
+
+        std::vector<uint8_t> contents;
+        if (!compact_shared_data(contents, source))
+            printf("(FAKER) WARNING: ospNewSharedData(): contents of type %d not recorded\n", type);
+
+        recording.call(REC_NEW_SHARED_DATA);
+        recording.u32(type);
+        recording.u64(numItems1);
+        recording.u64(numItems2);
+        recording.u64(numItems3);
+        recording.bytes(contents.data(), contents.size());
+        recording.handle(res);
+
+        source.hash = contents_hash(contents);
+        source.references = 1;
+        shared_data_sources[res] = source;
+    )
     
     return res;
 }
@@ -587,6 +848,15 @@ ospNewData(OSPDataType type, uint64_t numItems1, uint64_t numItems2, uint64_t nu
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_DATA);
+        recording.u32(type);
+        recording.u64(numItems1);
+        recording.u64(numItems2);
+        recording.u64(numItems3);
+        recording.handle(res);
+    )
     
     return res;
 }
@@ -638,6 +908,18 @@ ospCopyData(const OSPData source, OSPData destination, uint64_t destinationIndex
         {"destinationIndex3", destinationIndex3},
     };
 
+    // The copy reads the current source contents
+    RECORD(
+        record_data_contents(source);
+
+        recording.call(REC_COPY_DATA);
+        recording.handle(source);
+        recording.handle(destination);
+        recording.u64(destinationIndex1);
+        recording.u64(destinationIndex2);
+        recording.u64(destinationIndex3);
+    )
+
     libcall(source, destination, destinationIndex1, destinationIndex2, destinationIndex3);
 
     log_json(j); 
@@ -680,6 +962,15 @@ ospNewFrameBuffer(int x, int y, OSPFrameBufferFormat format, uint32_t frameBuffe
     j["result"] = (size_t)res;
     log_json(j);
 
+    RECORD(
+        recording.call(REC_NEW_FRAMEBUFFER);
+        recording.u32(x);
+        recording.u32(y);
+        recording.u32(format);
+        recording.u32(frameBufferChannels);
+        recording.handle(res);
+    )
+
     return res;
 }
 
@@ -700,6 +991,12 @@ ospNewGeometricModel(OSPGeometry geometry)
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_GEOMETRIC_MODEL);
+        recording.handle(geometry);
+        recording.handle(res);
+    )
     
     return res;
 }
@@ -719,6 +1016,11 @@ ospNewGroup()
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_GROUP);
+        recording.handle(res);
+    )
     
     return res;
 }
@@ -740,6 +1042,12 @@ ospNewInstance(OSPGroup group)
 
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_INSTANCE);
+        recording.handle(group);
+        recording.handle(res);
+    )
     
     return res;    
 }
@@ -761,6 +1069,13 @@ ospNewMaterial(const char *rendererType, const char *materialType)
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_MATERIAL);
+        recording.string(rendererType);
+        recording.string(materialType);
+        recording.handle(res);
+    )
     
     return res;
 }
@@ -782,6 +1097,12 @@ ospNewVolumetricModel(OSPVolume volume)
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_VOLUMETRIC_MODEL);
+        recording.handle(volume);
+        recording.handle(res);
+    )
     
     return res;
 }
@@ -801,6 +1122,11 @@ ospNewWorld()
     
     j["result"] = (size_t)res;
     log_json(j);
+
+    RECORD(
+        recording.call(REC_NEW_WORLD);
+        recording.handle(res);
+    )
     
     return res;
 }
@@ -820,6 +1146,20 @@ ospCommit(OSPObject obj)
 
     log_json(j);
 
+    RECORD(
+        record_data_contents(obj);
+
+        std::map<OSPObject, SharedDataUser>::iterator it = shared_data_users.find(obj);
+        if (it != shared_data_users.end())
+        {
+            for (auto& kv : it->second.data)
+                record_data_contents(kv.second);
+        }
+
+        recording.call(REC_COMMIT);
+        recording.handle(obj);
+    )
+
     libcall(obj);  
 }
 
@@ -835,12 +1175,88 @@ ospRelease(OSPObject obj)
     j["arguments"] = {
         {"obj", (size_t)obj}
     };
+
+    // Recorded before the object is actually released, as its pointer
+    // might get reused by an object created in another thread
+    RECORD(
+        recording.call(REC_RELEASE);
+        recording.handle(obj);
+
+        // Shared data is tracked until neither it nor an object using it
+        // is referenced by the application anymore
+        std::map<OSPObject, SharedDataUser>::iterator it = shared_data_users.find(obj);
+        if (it != shared_data_users.end() && --it->second.references == 0)
+        {
+            for (auto& kv : it->second.data)
+                release_shared_data_source(kv.second);
+            shared_data_users.erase(it);
+        }
+
+        release_shared_data_source(obj);
+    )
     
     libcall(obj);
 
     log_json(j);
 }
 
+extern "C"
+void
+ospRetain(OSPObject obj)
+{
+    ospRetain_ptr libcall = GET_PTR(ospRetain);
+
+    json j;
+    j["timestamp"] = timestamp();
+    j["call"] = "ospRetain";
+    j["arguments"] = {
+        {"obj", (size_t)obj}
+    };
+
+    RECORD(
+        recording.call(REC_RETAIN);
+        recording.handle(obj);
+
+        std::map<OSPObject, SharedDataSource>::iterator source = shared_data_sources.find(obj);
+        if (source != shared_data_sources.end())
+            source->second.references++;
+
+        std::map<OSPObject, SharedDataUser>::iterator user = shared_data_users.find(obj);
+        if (user != shared_data_users.end())
+            user->second.references++;
+    )
+
+    libcall(obj);
+
+    log_json(j);
+}
+
+extern "C"
+void
+ospRemoveParam(OSPObject obj, const char *id)
+{
+    ospRemoveParam_ptr libcall = GET_PTR(ospRemoveParam);
+
+    json j;
+    j["timestamp"] = timestamp();
+    j["call"] = "ospRemoveParam";
+    j["arguments"] = {
+        {"obj", (size_t)obj}, {"id", id}
+    };
+
+    RECORD(
+        recording.call(REC_REMOVE_PARAM);
+        recording.handle(obj);
+        recording.string(id);
+
+        set_shared_data_parameter(obj, id, nullptr);
+    )
+
+    libcall(obj, id);
+
+    log_json(j);
+}
+
 #if 0
 extern "C"
 void 
@@ -944,6 +1360,32 @@ ospSetParam(OSPObject obj, const char *id, OSPDataType type, const void *mem)
     default:
         printf("ospSetParam(): unhandled type %d\n", type);
     }    
+
+    RECORD(
+        if (type == OSP_STRING)
+        {
+            recording.call(REC_SET_PARAM);
+            recording.handle(obj);
+            recording.string(id);
+            recording.u32(type);
+            recording.bytes(mem, strlen((const char*)mem));
+        }
+        else if (type == OSP_VOID_PTR || recording_type_size(type) == 0)
+        {
+            // Pointers into the application can't be replayed
+            printf("(FAKER) WARNING: ospSetParam(): value of type %d not recorded\n", type);
+        }
+        else
+        {
+            recording.call(REC_SET_PARAM);
+            recording.handle(obj);
+            recording.string(id);
+            recording.u32(type);
+            recording.bytes(mem, recording_type_size(type));
+        }
+
+        set_shared_data_parameter(obj, id, type == OSP_DATA ? *(OSPObject*)mem : nullptr);
+    )
     
     libcall(obj, id, type, mem);
 
@@ -1325,6 +1767,18 @@ ospRenderFrame(OSPFrameBuffer framebuffer, OSPRenderer renderer, OSPCamera camer
     j["result"] = (size_t)res;
     log_json(j);
 
+    RECORD(
+        recording.call(REC_RENDER_FRAME);
+        recording.handle(framebuffer);
+        recording.handle(renderer);
+        recording.handle(camera);
+        recording.handle(world);
+        recording.handle(res);
+        // A recording up to the last frame is usable, even if the
+        // application doesn't exit cleanly
+        recording.flush();
+    )
+
     return res;
 }
 
@@ -1381,6 +1835,12 @@ ospWait(OSPFuture future, OSPSyncEvent event)
         {"event", (int)event}
     };
 
+    RECORD(
+        recording.call(REC_WAIT);
+        recording.handle(future);
+        recording.u32(event);
+    )
+
     libcall(future, event);
 
     log_json(j);
@@ -1441,6 +1901,11 @@ ospResetAccumulation(OSPFrameBuffer framebuffer)
         {"framebuffer", (size_t)framebuffer}, 
     };
 
+    RECORD(
+        recording.call(REC_RESET_ACCUMULATION);
+        recording.handle(framebuffer);
+    )
+
     libcall(framebuffer);
 
     log_json(j);
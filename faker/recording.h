@@ -0,0 +1,318 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Binary OSPRay call stream, written by faker and read by blospray_replay  //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+/*
+A recording starts with RECORDING_MAGIC, followed by a sequence of
+records. Each record is a uint8 RecordedCall, followed by the call's
+arguments in the order listed below. Integers are little-endian.
+
+    string      uint32 length + characters (no terminating 0)
+    handle      uint64, the object pointer as seen by the recorded process
+    bytes       uint64 size + contents
+
+Objects are referred to by their handle. The replay maps handles to the
+objects it creates, a handle returned by a later ospNew...() call replaces
+an earlier mapping (pointers get reused after objects are released).
+
+Array contents (shared data, ospSetParam() values) are stored compactly,
+i.e. without the strides of the original. Arrays of objects hold handles.
+The contents of shared data are stored at creation, and again on each
+commit of the data object, as the application might have changed the
+shared memory in between.
+*/
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <ospray/ospray.h>
+
+#define RECORDING_MAGIC     "BLOSREC1"
+
+enum RecordedCall
+{
+    REC_LOAD_MODULE = 1,            // string name
+
+    // string type, handle result
+    REC_NEW_CAMERA = 10,
+    REC_NEW_GEOMETRY,
+    REC_NEW_IMAGE_OPERATION,
+    REC_NEW_LIGHT,
+    REC_NEW_RENDERER,
+    REC_NEW_TEXTURE,
+    REC_NEW_TRANSFER_FUNCTION,
+    REC_NEW_VOLUME,
+
+    REC_NEW_MATERIAL = 30,          // string renderer_type, string material_type, handle result
+    REC_NEW_GEOMETRIC_MODEL,        // handle geometry, handle result
+    REC_NEW_VOLUMETRIC_MODEL,       // handle volume, handle result
+    REC_NEW_GROUP,                  // handle result
+    REC_NEW_INSTANCE,               // handle group, handle result
+    REC_NEW_WORLD,                  // handle result
+    REC_NEW_FRAMEBUFFER,            // uint32 width, uint32 height, uint32 format, uint32 channels, handle result
+
+    REC_NEW_SHARED_DATA = 50,       // uint32 type, uint64 n1, n2, n3, bytes contents, handle result
+    REC_NEW_DATA,                   // uint32 type, uint64 n1, n2, n3, handle result
+    REC_COPY_DATA,                  // handle source, handle destination, uint64 index1, index2, index3
+    REC_DATA_CONTENTS,              // handle data, bytes contents
+
+    REC_SET_PARAM = 70,             // handle object, string id, uint32 type, bytes value
+    REC_REMOVE_PARAM,               // handle object, string id
+    REC_COMMIT,                     // handle object
+    REC_RETAIN,                     // handle object
+    REC_RELEASE,                    // handle object
+
+    REC_RESET_ACCUMULATION = 90,    // handle framebuffer
+    REC_RENDER_FRAME,               // handle framebuffer, renderer, camera, world, handle result
+    REC_WAIT,                       // handle future, uint32 event
+};
+
+// Data types whose values are object references
+inline bool
+recording_is_object_type(OSPDataType type)
+{
+    switch (type)
+    {
+    case OSP_DEVICE:
+    case OSP_OBJECT:
+    case OSP_CAMERA:
+    case OSP_DATA:
+    case OSP_FRAMEBUFFER:
+    case OSP_FUTURE:
+    case OSP_GEOMETRIC_MODEL:
+    case OSP_GEOMETRY:
+    case OSP_GROUP:
+    case OSP_IMAGE_OPERATION:
+    case OSP_INSTANCE:
+    case OSP_LIGHT:
+    case OSP_MATERIAL:
+    case OSP_RENDERER:
+    case OSP_TEXTURE:
+    case OSP_TRANSFER_FUNCTION:
+    case OSP_VOLUME:
+    case OSP_VOLUMETRIC_MODEL:
+    case OSP_WORLD:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Size in bytes of a value of the given type, 0 if unknown.
+// OSP_STRING values are stored as string instead.
+inline size_t
+recording_type_size(OSPDataType type)
+{
+    if (recording_is_object_type(type))
+        return sizeof(OSPObject);
+
+    switch (type)
+    {
+    case OSP_BOOL:
+        return sizeof(int);
+
+    case OSP_CHAR:
+    case OSP_UCHAR:
+    case OSP_BYTE:
+    case OSP_RAW:
+        return 1;
+    case OSP_VEC2UC:
+        return 2;
+    case OSP_VEC3UC:
+        return 3;
+    case OSP_VEC4UC:
+        return 4;
+
+    case OSP_SHORT:
+    case OSP_USHORT:
+        return 2;
+
+    case OSP_INT:
+    case OSP_UINT:
+    case OSP_FLOAT:
+        return 4;
+    case OSP_VEC2I:
+    case OSP_VEC2UI:
+    case OSP_VEC2F:
+    case OSP_BOX1I:
+    case OSP_BOX1F:
+        return 8;
+    case OSP_VEC3I:
+    case OSP_VEC3UI:
+    case OSP_VEC3F:
+        return 12;
+    case OSP_VEC4I:
+    case OSP_VEC4UI:
+    case OSP_VEC4F:
+    case OSP_BOX2I:
+    case OSP_BOX2F:
+    case OSP_LINEAR2F:
+        return 16;
+
+    case OSP_LONG:
+    case OSP_ULONG:
+    case OSP_DOUBLE:
+        return 8;
+    case OSP_VEC2L:
+    case OSP_VEC2UL:
+        return 16;
+    case OSP_VEC3L:
+    case OSP_VEC3UL:
+    case OSP_BOX3I:
+    case OSP_BOX3F:
+    case OSP_AFFINE2F:
+        return 24;
+    case OSP_VEC4L:
+    case OSP_VEC4UL:
+    case OSP_BOX4I:
+    case OSP_BOX4F:
+        return 32;
+
+    case OSP_LINEAR3F:
+        return 36;
+    case OSP_AFFINE3F:
+        return 48;
+
+    default:
+        return 0;
+    }
+}
+
+class RecordingWriter
+{
+public:
+
+    RecordingWriter(): m_file(NULL) {}
+    ~RecordingWriter() { close(); }
+
+    bool open(const char *fname)
+    {
+        m_file = fopen(fname, "wb");
+        if (m_file == NULL)
+            return false;
+
+        fwrite(RECORDING_MAGIC, 1, 8, m_file);
+
+        return true;
+    }
+
+    void close()
+    {
+        if (m_file != NULL)
+            fclose(m_file);
+        m_file = NULL;
+    }
+
+    bool is_open() const { return m_file != NULL; }
+
+    void flush() { fflush(m_file); }
+
+    void call(RecordedCall c)           { uint8_t v = c; fwrite(&v, 1, 1, m_file); }
+    void u32(uint32_t v)                { fwrite(&v, sizeof(v), 1, m_file); }
+    void u64(uint64_t v)                { fwrite(&v, sizeof(v), 1, m_file); }
+    void handle(const void *object)     { u64((uint64_t)(uintptr_t)object); }
+
+    void string(const char *s)
+    {
+        const uint32_t len = s != NULL ? strlen(s) : 0;
+        u32(len);
+        fwrite(s, 1, len, m_file);
+    }
+
+    void bytes(const void *data, uint64_t size)
+    {
+        u64(size);
+        fwrite(data, 1, size, m_file);
+    }
+
+protected:
+    FILE    *m_file;
+};
+
+class RecordingReader
+{
+public:
+
+    RecordingReader(): m_file(NULL), m_ok(false) {}
+    ~RecordingReader() { if (m_file != NULL) fclose(m_file); }
+
+    // Returns false if the file can't be opened or isn't a recording
+    bool open(const char *fname)
+    {
+        char magic[8];
+
+        m_file = fopen(fname, "rb");
+        if (m_file == NULL)
+            return false;
+
+        m_ok = fread(magic, 1, 8, m_file) == 8 && memcmp(magic, RECORDING_MAGIC, 8) == 0;
+
+        return m_ok;
+    }
+
+    // False after a read past the end of the file (i.e. a truncated recording)
+    bool ok() const { return m_ok; }
+
+    // Returns false at the end of the recording
+    bool call(RecordedCall& c)
+    {
+        uint8_t v;
+        if (fread(&v, 1, 1, m_file) != 1)
+            return false;
+        c = (RecordedCall)v;
+        return true;
+    }
+
+    uint32_t u32()          { uint32_t v = 0; read(&v, sizeof(v)); return v; }
+    uint64_t u64()          { uint64_t v = 0; read(&v, sizeof(v)); return v; }
+    uint64_t handle()       { return u64(); }
+
+    std::string string()
+    {
+        std::string s(u32(), '\0');
+        if (s.size() > 0)
+            read(&s[0], s.size());
+        return s;
+    }
+
+    void bytes(std::vector<uint8_t>& data)
+    {
+        data.resize(u64());
+        if (data.size() > 0)
+            read(&data[0], data.size());
+    }
+
+protected:
+
+    void read(void *data, size_t size)
+    {
+        if (fread(data, 1, size, m_file) != size)
+            m_ok = false;
+    }
+
+    FILE    *m_file;
+    bool    m_ok;
+};
+
+#endif
@@ -0,0 +1,466 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Replays an OSPRay call stream recorded with faker (FAKER_RECORD)         //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*
+Headless benchmark: replays a recording, without Blender or the network,
+and reports per-frame render times, commit times and memory usage.
+
+Each ospRenderFrame() is waited on directly, so the render time reported
+is that of the complete frame. The recorded ospWait() calls are therefore
+skipped, as are ospCancel() calls (which aren't recorded).
+*/
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <ospray/ospray.h>
+
+#include "recording.h"
+#include "timing.h"
+
+typedef std::map<uint64_t, OSPObject>   ObjectMap;
+
+static ObjectMap                            objects;
+// Kind of object ("geometry", "world", ...), per handle
+static std::map<uint64_t, std::string>      object_kinds;
+
+// Memory shared with OSPRay through ospNewSharedData(), per handle.
+// XXX Buffers are kept until the end of the replay, as we don't track
+// when OSPRay no longer references them.
+static std::list<std::vector<uint8_t>>      shared_buffers;
+static std::map<uint64_t, std::pair<std::vector<uint8_t>*, OSPDataType>>   shared_buffer_of;
+
+static Timings  timings;
+
+// Return resident memory usage in megabytes
+static float
+memory_usage()
+{
+    uint64_t total = 0, resident = 0;
+    std::ifstream buffer("/proc/self/statm", std::ifstream::in);
+    buffer >> total >> resident;
+    buffer.close();
+
+    return resident * (1.0f * sysconf(_SC_PAGE_SIZE) / (1000*1000));
+}
+
+// Peak resident memory usage in megabytes
+static float
+peak_memory_usage()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    // ru_maxrss is in kilobytes
+    return usage.ru_maxrss * 1024.0f / (1000*1000);
+}
+
+static OSPObject
+lookup(uint64_t handle)
+{
+    if (handle == 0)
+        return NULL;
+
+    ObjectMap::const_iterator it = objects.find(handle);
+
+    if (it == objects.end())
+    {
+        printf("WARNING: unknown object handle 0x%016llx\n", (unsigned long long)handle);
+        return NULL;
+    }
+
+    return it->second;
+}
+
+static void
+add_object(uint64_t handle, OSPObject object, const char *kind)
+{
+    objects[handle] = object;
+    object_kinds[handle] = kind;
+}
+
+// Replaces object handles in an array of objects with the replayed objects
+static void
+translate_handles(std::vector<uint8_t>& contents)
+{
+    uint64_t *handles = (uint64_t*)contents.data();
+    OSPObject *ptrs = (OSPObject*)contents.data();
+
+    for (size_t i = 0; i < contents.size() / sizeof(uint64_t); i++)
+        ptrs[i] = lookup(handles[i]);
+}
+
+static bool
+replay(RecordingReader& reader)
+{
+    RecordedCall call;
+    std::vector<uint8_t> bytes;
+
+    int frame = 0;
+    int commits = 0;
+    double commit_time = 0.0;
+
+    while (reader.call(call))
+    {
+        switch (call)
+        {
+        case REC_LOAD_MODULE:
+        {
+            const std::string name = reader.string();
+            if (ospLoadModule(name.c_str()) != OSP_NO_ERROR)
+                printf("WARNING: could not load module '%s'\n", name.c_str());
+            break;
+        }
+
+        case REC_NEW_CAMERA:
+        case REC_NEW_GEOMETRY:
+        case REC_NEW_IMAGE_OPERATION:
+        case REC_NEW_LIGHT:
+        case REC_NEW_RENDERER:
+        case REC_NEW_TEXTURE:
+        case REC_NEW_TRANSFER_FUNCTION:
+        case REC_NEW_VOLUME:
+        {
+            const std::string type = reader.string();
+            const uint64_t handle = reader.handle();
+
+            switch (call)
+            {
+            case REC_NEW_CAMERA:
+                add_object(handle, ospNewCamera(type.c_str()), "camera");
+                break;
+            case REC_NEW_GEOMETRY:
+                add_object(handle, ospNewGeometry(type.c_str()), "geometry");
+                break;
+            case REC_NEW_IMAGE_OPERATION:
+                add_object(handle, ospNewImageOperation(type.c_str()), "image operation");
+                break;
+            case REC_NEW_LIGHT:
+                add_object(handle, ospNewLight(type.c_str()), "light");
+                break;
+            case REC_NEW_RENDERER:
+                add_object(handle, ospNewRenderer(type.c_str()), "renderer");
+                break;
+            case REC_NEW_TEXTURE:
+                add_object(handle, ospNewTexture(type.c_str()), "texture");
+                break;
+            case REC_NEW_TRANSFER_FUNCTION:
+                add_object(handle, ospNewTransferFunction(type.c_str()), "transfer function");
+                break;
+            default:
+                add_object(handle, ospNewVolume(type.c_str()), "volume");
+                break;
+            }
+
+            break;
+        }
+
+        case REC_NEW_MATERIAL:
+        {
+            const std::string renderer_type = reader.string();
+            const std::string material_type = reader.string();
+            add_object(reader.handle(), ospNewMaterial(renderer_type.c_str(), material_type.c_str()), "material");
+            break;
+        }
+
+        case REC_NEW_GEOMETRIC_MODEL:
+        {
+            OSPGeometry geometry = (OSPGeometry)lookup(reader.handle());
+            add_object(reader.handle(), ospNewGeometricModel(geometry), "geometric model");
+            break;
+        }
+
+        case REC_NEW_VOLUMETRIC_MODEL:
+        {
+            OSPVolume volume = (OSPVolume)lookup(reader.handle());
+            add_object(reader.handle(), ospNewVolumetricModel(volume), "volumetric model");
+            break;
+        }
+
+        case REC_NEW_GROUP:
+            add_object(reader.handle(), ospNewGroup(), "group");
+            break;
+
+        case REC_NEW_INSTANCE:
+        {
+            OSPGroup group = (OSPGroup)lookup(reader.handle());
+            add_object(reader.handle(), ospNewInstance(group), "instance");
+            break;
+        }
+
+        case REC_NEW_WORLD:
+            add_object(reader.handle(), ospNewWorld(), "world");
+            break;
+
+        case REC_NEW_FRAMEBUFFER:
+        {
+            const int width = reader.u32();
+            const int height = reader.u32();
+            const OSPFrameBufferFormat format = (OSPFrameBufferFormat)reader.u32();
+            const uint32_t channels = reader.u32();
+            add_object(reader.handle(), ospNewFrameBuffer(width, height, format, channels), "framebuffer");
+            break;
+        }
+
+        case REC_NEW_SHARED_DATA:
+        {
+            const OSPDataType type = (OSPDataType)reader.u32();
+            const uint64_t n1 = reader.u64();
+            const uint64_t n2 = reader.u64();
+            const uint64_t n3 = reader.u64();
+
+            shared_buffers.push_back(std::vector<uint8_t>());
+            std::vector<uint8_t>& contents = shared_buffers.back();
+
+            reader.bytes(contents);
+
+            const uint64_t handle = reader.handle();
+
+            if (contents.size() != recording_type_size(type)*n1*n2*n3)
+            {
+                printf("WARNING: shared data of type %d has no (or wrong size) contents, replaying as ospNewData()\n", type);
+                add_object(handle, ospNewData(type, n1, n2, n3), "data");
+                break;
+            }
+
+            if (recording_is_object_type(type))
+                translate_handles(contents);
+
+            add_object(handle, ospNewSharedData(contents.data(), type, n1, 0, n2, 0, n3, 0), "data");
+            shared_buffer_of[handle] = std::make_pair(&contents, type);
+
+            break;
+        }
+
+        case REC_DATA_CONTENTS:
+        {
+            const uint64_t handle = reader.handle();
+
+            reader.bytes(bytes);
+
+            auto it = shared_buffer_of.find(handle);
+
+            if (it == shared_buffer_of.end() || it->second.first->size() != bytes.size())
+            {
+                printf("WARNING: contents for unknown shared data 0x%016llx\n", (unsigned long long)handle);
+                break;
+            }
+
+            if (recording_is_object_type(it->second.second))
+                translate_handles(bytes);
+
+            // In place, as OSPRay references the buffer
+            memcpy(it->second.first->data(), bytes.data(), bytes.size());
+
+            break;
+        }
+
+        case REC_NEW_DATA:
+        {
+            const OSPDataType type = (OSPDataType)reader.u32();
+            const uint64_t n1 = reader.u64();
+            const uint64_t n2 = reader.u64();
+            const uint64_t n3 = reader.u64();
+            add_object(reader.handle(), ospNewData(type, n1, n2, n3), "data");
+            break;
+        }
+
+        case REC_COPY_DATA:
+        {
+            OSPData source = (OSPData)lookup(reader.handle());
+            OSPData destination = (OSPData)lookup(reader.handle());
+            const uint64_t i1 = reader.u64();
+            const uint64_t i2 = reader.u64();
+            const uint64_t i3 = reader.u64();
+            ospCopyData(source, destination, i1, i2, i3);
+            break;
+        }
+
+        case REC_SET_PARAM:
+        {
+            OSPObject obj = lookup(reader.handle());
+            const std::string id = reader.string();
+            const OSPDataType type = (OSPDataType)reader.u32();
+
+            reader.bytes(bytes);
+
+            if (type == OSP_STRING)
+            {
+                const std::string s(bytes.begin(), bytes.end());
+                ospSetParam(obj, id.c_str(), type, s.c_str());
+            }
+            else
+            {
+                if (recording_is_object_type(type))
+                    translate_handles(bytes);
+                ospSetParam(obj, id.c_str(), type, bytes.data());
+            }
+
+            break;
+        }
+
+        case REC_REMOVE_PARAM:
+        {
+            OSPObject obj = lookup(reader.handle());
+            ospRemoveParam(obj, reader.string().c_str());
+            break;
+        }
+
+        case REC_COMMIT:
+        {
+            const uint64_t handle = reader.handle();
+
+            auto it = object_kinds.find(handle);
+            ScopedTimer timer(timings, "commit " + (it != object_kinds.end() ? it->second : std::string("unknown")));
+            ospCommit(lookup(handle));
+
+            commit_time += timer.stop();
+            commits++;
+
+            break;
+        }
+
+        case REC_RETAIN:
+            ospRetain(lookup(reader.handle()));
+            break;
+
+        case REC_RELEASE:
+        {
+            const uint64_t handle = reader.handle();
+            ospRelease(lookup(handle));
+            objects.erase(handle);
+            object_kinds.erase(handle);
+            shared_buffer_of.erase(handle);
+            break;
+        }
+
+        case REC_RESET_ACCUMULATION:
+            ospResetAccumulation((OSPFrameBuffer)lookup(reader.handle()));
+            break;
+
+        case REC_RENDER_FRAME:
+        {
+            OSPFrameBuffer framebuffer = (OSPFrameBuffer)lookup(reader.handle());
+            OSPRenderer renderer = (OSPRenderer)lookup(reader.handle());
+            OSPCamera camera = (OSPCamera)lookup(reader.handle());
+            OSPWorld world = (OSPWorld)lookup(reader.handle());
+            const uint64_t handle = reader.handle();
+
+            ScopedTimer timer(timings, "render");
+
+            OSPFuture future = ospRenderFrame(framebuffer, renderer, camera, world);
+            ospWait(future, OSP_TASK_FINISHED);
+
+            const double render_time = timer.stop();
+
+            // Subsequent (recorded) calls on the future are mostly
+            // ospRelease() of it
+            add_object(handle, future, "future");
+
+            printf("frame %4d | render %8.3f ms | %5d commit(s) %8.3f ms | memory %.1f MB\n",
+                frame, render_time*1000, commits, commit_time*1000, memory_usage());
+
+            frame++;
+            commits = 0;
+            commit_time = 0.0;
+
+            break;
+        }
+
+        case REC_WAIT:
+            // Frames are already waited for in REC_RENDER_FRAME
+            reader.handle();
+            reader.u32();
+            break;
+
+        default:
+            printf("ERROR: unknown record type %d\n", call);
+            return false;
+        }
+
+        if (!reader.ok())
+        {
+            printf("ERROR: recording is truncated\n");
+            return false;
+        }
+    }
+
+    printf("%d frame(s) replayed\n", frame);
+
+    return true;
+}
+
+int
+main(int argc, const char **argv)
+{
+    // Handles OSPRay's own command-line options, e.g. --osp:debug
+    if (ospInit(&argc, argv) != OSP_NO_ERROR)
+    {
+        fprintf(stderr, "ERROR: could not initialize OSPRay\n");
+        return -1;
+    }
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s [ospray options] <recording>\n", argv[0]);
+        return -1;
+    }
+
+    RecordingReader reader;
+
+    if (!reader.open(argv[1]))
+    {
+        fprintf(stderr, "ERROR: %s is not a faker recording\n", argv[1]);
+        return -1;
+    }
+
+    const float memory_start = memory_usage();
+
+    bool ok = replay(reader);
+
+    printf("\n");
+    printf("%-32s %8s %12s %12s %12s\n", "Phase", "Count", "Total (ms)", "Mean (ms)", "Max (ms)");
+
+    json stats;
+    timings.get_json(stats);
+
+    for (auto& kv : stats.items())
+    {
+        const json& s = kv.value();
+        printf("%-32s %8d %12.3f %12.3f %12.3f\n", kv.key().c_str(), s["count"].get<int>(),
+            s["total"].get<double>()*1000, s["mean"].get<double>()*1000, s["max"].get<double>()*1000);
+    }
+
+    printf("\n");
+    printf("Memory: %.1f MB at start, %.1f MB at end, %.1f MB peak\n",
+        memory_start, memory_usage(), peak_memory_usage());
+
+    ospShutdown();
+
+    return ok ? 0 : -1;
+}
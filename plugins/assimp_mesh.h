@@ -0,0 +1,171 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Assimp mesh conversion, shared by the assimp plugins                     //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef ASSIMP_MESH_H
+#define ASSIMP_MESH_H
+
+#include <assimp/scene.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#include <ospray/ospray.h>
+
+#include "util.h"               // ospNewCopiedData
+#include "voxel_kernels.h"      // voxel_parallel_for()
+
+// The vertex attributes are passed to OSPRay straight from the aiMesh arrays
+static_assert(sizeof(aiVector3D) == 3*sizeof(float), "Assimp must be built with single precision (ai_real = float)");
+static_assert(sizeof(aiColor4D) == 4*sizeof(float), "Unexpected aiColor4D layout");
+
+// The parts of a mesh that need conversion before they can be passed to
+// OSPRay. Filled in by assimp_convert_mesh(), which makes no OSPRay calls,
+// so it can be used for multiple meshes in parallel.
+struct AssimpMeshData
+{
+    std::vector<uint32_t>   triangles;
+    float                   bbox[6];        // xmin, ymin, zmin, xmax, ymax, zmax
+};
+
+// Faces are converted by multiple threads for meshes with at least
+// parallel_threshold faces (pass SIZE_MAX when already running in parallel)
+inline void
+assimp_convert_mesh(AssimpMeshData& data, const aiMesh *mesh, size_t parallel_threshold=VOXEL_KERNELS_PARALLEL_THRESHOLD)
+{
+    const unsigned int nvertices = mesh->mNumVertices;
+    const aiVector3D *mv = mesh->mVertices;
+
+    float *bbox = data.bbox;
+
+    bbox[0] = bbox[1] = bbox[2] = FLT_MAX;
+    bbox[3] = bbox[4] = bbox[5] = -FLT_MAX;
+
+    for (unsigned int i = 0; i < nvertices; i++)
+    {
+        bbox[0] = std::min(bbox[0], mv[i].x);
+        bbox[1] = std::min(bbox[1], mv[i].y);
+        bbox[2] = std::min(bbox[2], mv[i].z);
+        bbox[3] = std::max(bbox[3], mv[i].x);
+        bbox[4] = std::max(bbox[4], mv[i].y);
+        bbox[5] = std::max(bbox[5], mv[i].z);
+    }
+
+    const aiFace *ff = mesh->mFaces;
+    const unsigned int nfaces = mesh->mNumFaces;
+
+    std::vector<uint32_t>& triangles = data.triangles;
+
+    if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+    {
+        // Only triangles (the usual case after aiProcess_Triangulate),
+        // so the output index of each face is known
+        triangles.resize(3*(size_t)nfaces);
+
+        uint32_t *tt = triangles.data();
+
+        voxel_parallel_for(nfaces, [ff, tt](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++)
+            {
+                const unsigned int *indices = ff[i].mIndices;
+                tt[3*i+0] = indices[0];
+                tt[3*i+1] = indices[1];
+                tt[3*i+2] = indices[2];
+            }
+        }, parallel_threshold);
+    }
+    else
+    {
+        // Skip points and lines
+        triangles.clear();
+        triangles.reserve(3*(size_t)nfaces);
+
+        for (unsigned int i = 0; i < nfaces; i++)
+        {
+            if (ff[i].mNumIndices != 3)
+                continue;
+
+            triangles.push_back(ff[i].mIndices[0]);
+            triangles.push_back(ff[i].mIndices[1]);
+            triangles.push_back(ff[i].mIndices[2]);
+        }
+    }
+}
+
+// Returns a new (committed) triangle mesh. The vertex attributes are
+// copied as a whole from the aiMesh. Adds the size of the arrays passed
+// to OSPRay to data_size.
+inline OSPGeometry
+assimp_mesh_geometry(const aiMesh *mesh, const AssimpMeshData& data, size_t& data_size)
+{
+    const unsigned int nvertices = mesh->mNumVertices;
+    OSPData d;
+
+    OSPGeometry geometry = ospNewGeometry("mesh");
+
+        d = ospNewCopiedData(nvertices, OSP_VEC3F, mesh->mVertices);
+        ospCommit(d);
+        ospSetObject(geometry, "vertex.position", d);
+        ospRelease(d);
+        data_size += nvertices * 3 * sizeof(float);
+
+        d = ospNewCopiedData(data.triangles.size()/3, OSP_VEC3UI, data.triangles.data());
+        ospCommit(d);
+        ospSetObject(geometry, "index", d);
+        ospRelease(d);
+        data_size += data.triangles.size() * sizeof(uint32_t);
+
+        if (mesh->HasNormals())
+        {
+            d = ospNewCopiedData(nvertices, OSP_VEC3F, mesh->mNormals);
+            ospCommit(d);
+            ospSetObject(geometry, "vertex.normal", d);
+            ospRelease(d);
+            data_size += nvertices * 3 * sizeof(float);
+        }
+
+        if (mesh->HasVertexColors(0))
+        {
+            d = ospNewCopiedData(nvertices, OSP_VEC4F, mesh->mColors[0]);
+            ospCommit(d);
+            ospSetObject(geometry, "vertex.color", d);
+            ospRelease(d);
+            data_size += nvertices * 4 * sizeof(float);
+        }
+
+        if (mesh->HasTextureCoords(0))
+        {
+            // Assimp stores 3 components per texture coordinate, of which
+            // OSPRay uses the first 2, so copy with a stride
+            OSPData src = ospNewSharedData(mesh->mTextureCoords[0], OSP_VEC2F, nvertices, sizeof(aiVector3D));
+            d = ospNewData(OSP_VEC2F, nvertices);
+            ospCopyData(src, d);
+            ospRelease(src);
+            ospCommit(d);
+            ospSetObject(geometry, "vertex.texcoord", d);
+            ospRelease(d);
+            data_size += nvertices * 2 * sizeof(float);
+        }
+
+    ospCommit(geometry);
+
+    return geometry;
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <cstdio>
 #include <vector>
 #include "plugin.h"
+#include "assimp_mesh.h"
 
 extern "C"
 void
@@ -54,7 +55,7 @@ load_file(PluginResult &result, PluginState *state)
     }
 
     if (scene->mNumMeshes > 1)
-        printf("WARNING: scene contains %d meshes, only using first!\n", scene->mNumMeshes);
+        printf("WARNING: scene contains %d meshes, only using first (use scene_assimp for the whole scene)!\n", scene->mNumMeshes);
 
     aiMesh *mesh = scene->mMeshes[0];
 
@@ -65,165 +66,29 @@ load_file(PluginResult &result, PluginState *state)
         return;
     }
 
-    const int&  nvertices = mesh->mNumVertices;
-    float       min[3] = {1e6, 1e6, 1e6}, max[3] = {-1e6, -1e6, -1e6};
-    float       x, y, z;
+    printf("... %d vertices, %d faces\n", mesh->mNumVertices, mesh->mNumFaces);
 
-    std::vector<float> vertices;
-    std::vector<uint32_t> triangles;
+    AssimpMeshData data;
+    assimp_convert_mesh(data, mesh);
 
-    // Triangle mesh
-    OSPGeometry geometry = ospNewGeometry("mesh");
+    if (data.triangles.size() == 0)
     {
-        printf("... %d vertices\n", nvertices);
-
-        // Vertices
-        auto& mv = mesh->mVertices;
-
-        for (int i = 0; i < nvertices; i++)
-        {
-            x = mv[i].x;
-            y = mv[i].y;
-            z = mv[i].z;
-
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            min[0] = std::min(min[0], x);
-            min[1] = std::min(min[1], y);
-            min[2] = std::min(min[2], z);
-
-            max[0] = std::max(max[0], x);
-            max[1] = std::max(max[1], y);
-            max[2] = std::max(max[2], z);
-        }
-
-        OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, vertices.data());
-        ospCommit(data);
-        ospSetObject(geometry, "vertex.position", data);
-        //ospRelease(data);
-    }
-
-    if (mesh->HasFaces())
-    {
-        printf("... %d triangles\n",  mesh->mNumFaces);
-
-        // Triangles
-        auto& ff = mesh->mFaces;
-
-        for (int i = 0; i < mesh->mNumFaces; i++)
-        {
-            triangles.push_back(ff[i].mIndices[0]);
-            triangles.push_back(ff[i].mIndices[1]);
-            triangles.push_back(ff[i].mIndices[2]);
-        }
-
-        // XXX check /3
-        OSPData data = ospNewCopiedData(triangles.size()/3, OSP_VEC3UI, triangles.data());
-        ospCommit(data);
-        ospSetObject(geometry, "index", data);
-        //ospRelease(data);
-    }
-    else
-        printf("... Mesh has no faces?\n");
-
-    if (mesh->HasVertexColors(0))
-    {
-        printf("... Mesh has vertex colors\n");
-
-        std::vector<float>  colors;
-        auto& vc = mesh->mColors[0];
-
-        for (int i = 0; i < nvertices; i++)
-        {
-            colors.push_back(vc[i].r);
-            colors.push_back(vc[i].g);
-            colors.push_back(vc[i].b);
-            colors.push_back(vc[i].a);
-        }
-
-        OSPData data = ospNewCopiedData(nvertices, OSP_VEC4F, colors.data());
-        ospCommit(data);
-        ospSetObject(geometry, "vertex.color", data);
-    }
-
-    if (mesh->HasNormals())
-    {
-        printf("... Mesh has normals\n");
-
-        std::vector<float>  normals;
-        auto& nn = mesh->mNormals;
-
-        for (int i = 0; i < nvertices; i++)
-        {
-            normals.push_back(nn[i].x);
-            normals.push_back(nn[i].y);
-            normals.push_back(nn[i].z);
-        }
-
-        OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, normals.data());
-        ospCommit(data);
-        ospSetObject(geometry, "vertex.normal", data);
-    }
-
-    if (mesh->HasTextureCoords(0))
-    {
-        printf("... Mesh has texture coordinates\n");
-
-        std::vector<float>  texcoords;
-        auto& tc = mesh->mTextureCoords[0];
-
-        for (int i = 0; i < nvertices; i++)
-        {
-            texcoords.push_back(tc[i].x);
-            texcoords.push_back(tc[i].y);
-            texcoords.push_back(tc[i].z);
-        }
-
-        OSPData data = ospNewCopiedData(nvertices, OSP_VEC2F, texcoords.data());
-        ospCommit(data);
-        ospSetObject(geometry, "vertex.texcoord", data); 
+        result.set_success(false);
+        result.set_message("WARNING: mesh does not have any triangles");
+        return;
     }
-    
-    ospCommit(geometry);
 
-    /*
     {
-        // XXX opt
-        geometry = ospNewGeometry("subdivision");
-
-            //ospSetFloat(geometry, "level", 1.0f);
-
-            OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, vertices.data());
-            ospCommit(data);
-            ospSetObject(geometry, "vertex.position", data);
-
-            //data = ospNewCopiedData(num_vertices, OSP_VEC4F, colors);
-            //ospCommit(data);
-            //ospSetObject(mesh, "vertex.color", data);
+        PluginOSPRayLock lock(state);
 
-            // XXX check /3
-            data = ospNewCopiedData(faces.size()/3, OSP_VEC3UI, faces.data());
-            ospCommit(data);
-            ospSetObject(geometry, "index", data);
-
-            data = ospNewCopiedData(face_lengths.size(), OSP_UINT, face_lengths.data());
-            ospCommit(data);
-            ospSetObject(geometry, "face", data);
-
-        ospCommit(geometry);
+        state->memory_size = 0;
+        state->geometry = assimp_mesh_geometry(mesh, data, state->memory_size);
     }
 
-
-    */
-
-    state->geometry = geometry;
-
-    state->bound = BoundingMesh::simplify_qc(
-        vertices.data(), vertices.size()/3,
-        triangles.data(), triangles.size()/3, 
-        10
+    // Simplified versions are generated by the server, in the background
+    state->bound = BoundingMesh::from_triangles(
+        &(mesh->mVertices[0].x), mesh->mNumVertices,
+        data.triangles.data(), data.triangles.size()/3
         );
 }
 
@@ -252,6 +117,7 @@ initialize(PluginDefinition *def)
 {
     def->type = PT_GEOMETRY;
     def->uses_renderer_type = false;
+    def->thread_safe = true;
     def->parameters = parameters;
     def->functions = functions;
     
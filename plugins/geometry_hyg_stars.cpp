@@ -18,28 +18,170 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <cstdio>
+#include <cstring>
+#include <cmath>
 #include <stdint.h>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <algorithm>
 #include <ospray/ospray.h>
 
 #include "plugin.h"
+#include "voxel_kernels.h"      // voxel_parallel_for()
 
-void
-create_spheres(PluginState *state, json& j, bool project, float scale, float radius, int bound_subsampling=10)
+/*
+Binary star catalog format, as written by scripts/hyg2bin.py:
+
+    char        magic[8]            "BLSTARS1"
+    uint32_t    num_stars
+    uint32_t    flags               STAR_CATALOG_SORTED_BY_MAGNITUDE
+    float       positions[num_stars][3]
+    float       magnitudes[num_stars]
+    float       colors[num_stars][3]    linear RGB
+
+All values little-endian. When the stars are sorted on increasing
+magnitude (i.e. brightest first) a magnitude cutoff selects a prefix
+of the arrays, so only that part of the file gets read.
+*/
+
+const char      STAR_CATALOG_MAGIC[8] = { 'B', 'L', 'S', 'T', 'A', 'R', 'S', '1' };
+const uint32_t  STAR_CATALOG_SORTED_BY_MAGNITUDE = 0x1;
+
+struct StarCatalogHeader
 {
-    std::vector<float> positions;
-    std::vector<float> radii;
+    char        magic[8];
+    uint32_t    num_stars;
+    uint32_t    flags;
+};
+
+struct MappedCatalog
+{
+    void        *ptr;
+    size_t      size;
+
+    // The positions shared with the geometry
+    const float *positions;
+    size_t      num_positions;
+};
+
+// Faintest stars naked to the visible eye are around +6.5 magnitude.
+// A magnitude of 5 units higher means 100 times dimmer
+// Magnitude 0 maps to radius.
+static inline float
+star_radius(float mag, float radius)
+{
+    float brightness = 1.0f;
+    if (mag >= 0.0f)
+        brightness = 1.0f / (powf(2.512f, mag));
+
+    return radius*sqrt(brightness);
+}
+
+// Sets the sphere geometry and bound in the state. When share_positions
+// is true the positions need to stay alive as long as the geometry is used.
+static void
+create_spheres(PluginState *state, const float *positions, const float *radii, size_t n, 
+    bool share_positions, int bound_subsampling=10)
+{
+    // Bounds, per chunk of stars in parallel
+
+    const int max_chunks = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<float> chunk_bounds(6*max_chunks);
+
+    int num_chunks = voxel_parallel_for(n, [&](size_t begin, size_t end, int c) {
+        float *b = &chunk_bounds[6*c];
+        b[0] = b[1] = b[2] = std::numeric_limits<float>::max();
+        b[3] = b[4] = b[5] = std::numeric_limits<float>::lowest();
+        for (size_t i = begin; i < end; i++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                b[k] = std::min(b[k], positions[3*i+k]);
+                b[3+k] = std::max(b[3+k], positions[3*i+k]);
+            }
+        }
+    }, 65536);
+
+    float min[3], max[3];
+
+    for (int k = 0; k < 3; k++)
+    {
+        min[k] = std::numeric_limits<float>::max();
+        max[k] = std::numeric_limits<float>::lowest();
+
+        for (int c = 0; c < num_chunks; c++)
+        {
+            min[k] = std::min(min[k], chunk_bounds[6*c+k]);
+            max[k] = std::max(max[k], chunk_bounds[6*c+3+k]);
+        }
+    }
+
+    printf("... Bounds %.6f %.6f %.6f; %.6f %.6f %.6f\n", 
+        min[0], min[1], min[2], max[0], max[1], max[2]);
+
+    if (n > 0)
+    {
+        const float *minr = std::min_element(radii, radii+n);
+        const float *maxr = std::max_element(radii, radii+n);
+
+        printf("... Radius range %.6f %.6f\n", *minr, *maxr);
+    }
 
     BoundingMesh *bound = new BoundingMesh;
     std::vector<float>& bound_vertices = bound->vertices;
 
+    for (size_t i = 0; i < n; i += bound_subsampling)
+    {
+        bound_vertices.push_back(positions[3*i+0]);
+        bound_vertices.push_back(positions[3*i+1]);
+        bound_vertices.push_back(positions[3*i+2]);
+    }
+
+    OSPData data;
+
+    OSPGeometry spheres = ospNewGeometry("spheres");
+    
+        if (share_positions)
+            data = ospNewSharedData(positions, OSP_VEC3F, n);
+        else
+            data = ospNewCopiedData(n, OSP_VEC3F, positions);
+        ospCommit(data);
+        ospSetObject(spheres, "sphere.position", data);
+        ospRelease(data);
+
+        //ospSetFloat(spheres, "radius", radius);
+        data = ospNewCopiedData(n, OSP_FLOAT, radii);
+        ospCommit(data);
+        ospSetObject(spheres, "sphere.radius", data);
+        ospRelease(data);
+
+        //data = ospNewCopiedData(num_vertices, OSP_VEC4F, colors);
+        //ospCommit(data);
+        //ospSetData(mesh, "vertex.color", data);
+      
+    ospCommit(spheres);
+  
+    state->geometry = spheres;
+    state->bound = bound;
+}
+
+// JSON catalog, as produced by scripts/hygcsv2json.py
+static void
+load_json_catalog(PluginState *state, json& j, bool project, float scale, float radius, float max_magnitude)
+{
+    std::vector<float> positions;
+    std::vector<float> radii;
+
     float x, y, z;
-    float mag, brightness;
-    float min[3] = {1e6, 1e6, 1e6}, max[3] = {-1e6, -1e6, -1e6};    // XXX use float min/max
+    float mag;
     float minmag = 1e6, maxmag = -1e6;
-    int idx = 0;
 
     for (json::iterator it = j.begin(); it != j.end(); ++it) 
     {
@@ -47,6 +189,11 @@ create_spheres(PluginState *state, json& j, bool project, float scale, float rad
 
         //printf("%s\n", e["x"].dump().c_str());
 
+        mag = e["mag"].get<float>();
+
+        if (mag > max_magnitude)
+            continue;
+
         x = e["x"].get<float>();
         y = e["y"].get<float>();
         z = e["z"].get<float>();
@@ -62,70 +209,165 @@ create_spheres(PluginState *state, json& j, bool project, float scale, float rad
         positions.push_back(y);
         positions.push_back(z);
 
-        // Faintest stars naked to the visible eye are around +6.5 magnitude.
-        // A magnitude of 5 units higher means 100 times dimmer
-        // Magnitude 0 maps to radius.
-        mag = e["mag"].get<float>();
+        radii.push_back(star_radius(mag, radius));
+
+        minmag = std::min(minmag, mag);
+        maxmag = std::max(maxmag, mag);
+    }
 
-        brightness = 1.0f;
-        if (mag >= 0.0f)
-            brightness = 1.0f / (powf(2.512f, mag));
+    printf("... Magnitude range %.6f %.6f\n", minmag, maxmag);
 
-        radii.push_back(radius*sqrt(brightness));
+    create_spheres(state, positions.data(), radii.data(), radii.size(), false);
+}
 
-        min[0] = std::min(min[0], x);
-        min[1] = std::min(min[1], y);
-        min[2] = std::min(min[2], z);
+// Returns false if the file isn't a binary catalog
+static bool
+is_binary_catalog(const std::string& file)
+{
+    char magic[8];
 
-        max[0] = std::max(max[0], x);
-        max[1] = std::max(max[1], y);
-        max[2] = std::max(max[2], z);
+    FILE *f = fopen(file.c_str(), "rb");
+    if (!f)
+        return false;
 
-        minmag = std::min(minmag, mag);
-        maxmag = std::max(maxmag, mag);
+    bool is_binary = fread(magic, 1, 8, f) == 8 && memcmp(magic, STAR_CATALOG_MAGIC, 8) == 0;
+
+    fclose(f);
+
+    return is_binary;
+}
+
+static void
+load_binary_catalog(PluginResult &result, PluginState *state, const std::string& file, 
+    bool project, float scale, float radius, float max_magnitude)
+{
+    char msg[1024];
 
-        if (idx % bound_subsampling == 0)
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        sprintf(msg, "Could not open file '%s'", file.c_str());
+        result.set_success(false);
+        result.set_message(msg);
+        return;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+
+    MappedCatalog *mapped = new MappedCatalog;
+
+    mapped->size = st.st_size;
+    mapped->ptr = mmap(nullptr, mapped->size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (mapped->ptr == MAP_FAILED)
+    {
+        delete mapped;
+        sprintf(msg, "Could not memory-map file '%s'", file.c_str());
+        result.set_success(false);
+        result.set_message(msg);
+        return;
+    }
+
+    if (mapped->size < sizeof(StarCatalogHeader))
+    {
+        munmap(mapped->ptr, mapped->size);
+        delete mapped;
+        sprintf(msg, "File '%s' too small for a catalog header", file.c_str());
+        result.set_success(false);
+        result.set_message(msg);
+        return;
+    }
+
+    const StarCatalogHeader *header = (const StarCatalogHeader*)mapped->ptr;
+    const size_t num_stars = header->num_stars;
+
+    // Compared this way to avoid overflow for a bogus num_stars
+    if (num_stars > (mapped->size - sizeof(StarCatalogHeader)) / (7*sizeof(float)))
+    {
+        munmap(mapped->ptr, mapped->size);
+        delete mapped;
+        sprintf(msg, "File '%s' too small for %ld stars", file.c_str(), (long)num_stars);
+        result.set_success(false);
+        result.set_message(msg);
+        return;
+    }
+
+    const float *positions = (const float*)(header + 1);
+    const float *magnitudes = positions + 3*num_stars;
+
+    printf("... Binary catalog with %ld stars\n", (long)num_stars);
+
+    // Select the stars to use. For a sorted catalog that's a prefix,
+    // otherwise the selected stars are copied.
+
+    size_t n = num_stars;
+    std::vector<size_t> selection;
+
+    if (max_magnitude < std::numeric_limits<float>::max())
+    {
+        if (header->flags & STAR_CATALOG_SORTED_BY_MAGNITUDE)
+            n = std::upper_bound(magnitudes, magnitudes + num_stars, max_magnitude) - magnitudes;
+        else
         {
-            bound_vertices.push_back(x);
-            bound_vertices.push_back(y);
-            bound_vertices.push_back(z);
+            printf("... WARNING: catalog not sorted by magnitude, selecting stars one by one\n");
+            for (size_t i = 0; i < num_stars; i++)
+                if (magnitudes[i] <= max_magnitude)
+                    selection.push_back(i);
+            n = selection.size();
         }
 
-        idx++;
+        printf("... %ld stars with magnitude <= %.3f\n", (long)n, max_magnitude);
     }
 
-    printf("... Bounds %.6f %.6f %.6f; %.6f %.6f %.6f\n", 
-        min[0], min[1], min[2], max[0], max[1], max[2]);
-    printf("... Magnitude range %.6f %.6f\n", minmag, maxmag);
+    const bool use_selection = selection.size() > 0 || n == 0;
+    const bool share_positions = !project && scale == 1.0f && !use_selection;
 
-    std::vector<float>::iterator minr, maxr;
+    std::vector<float> new_positions;
+    std::vector<float> radii(n);
 
-    minr = std::min_element(radii.begin(), radii.end());
-    maxr = std::max_element(radii.begin(), radii.end());
+    float *r = radii.data();
+    const size_t *sel = selection.data();
+    
+    if (!share_positions)
+        new_positions.resize(3*n);
 
-    printf("... Radius range %.6f %.6f\n", *minr, *maxr);
+    float *p = new_positions.data();
 
-    OSPData data;
+    voxel_parallel_for(n, [=](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const size_t s = use_selection ? sel[i] : i;
 
-    OSPGeometry spheres = ospNewGeometry("spheres");
-    
-        data = ospNewCopiedData(positions.size()/3, OSP_VEC3F, positions.data());
-        ospCommit(data);
-        ospSetObject(spheres, "sphere.position", data);
+            r[i] = star_radius(magnitudes[s], radius);
 
-        //ospSetFloat(spheres, "radius", radius);
-        data = ospNewCopiedData(radii.size(), OSP_FLOAT, radii.data());
-        ospCommit(data);
-        ospSetObject(spheres, "sphere.radius", data);
+            if (share_positions)
+                continue;
 
-        //data = ospNewCopiedData(num_vertices, OSP_VEC4F, colors);
-        //ospCommit(data);
-        //ospSetData(mesh, "vertex.color", data);
-      
-    ospCommit(spheres);
-  
-    state->geometry = spheres;
-    state->bound = bound;
+            const float x = positions[3*s+0], y = positions[3*s+1], z = positions[3*s+2];
+            const float f = project ? 1.0f / sqrt(x*x + y*y + z*z) : scale;
+
+            p[3*i+0] = x * f;
+            p[3*i+1] = y * f;
+            p[3*i+2] = z * f;
+        }
+    }, 65536);
+
+    if (share_positions)
+    {
+        create_spheres(state, positions, r, n, true);
+        mapped->positions = positions;
+        mapped->num_positions = n;
+        state->data = mapped;
+    }
+    else
+    {
+        create_spheres(state, p, r, n, false);
+        munmap(mapped->ptr, mapped->size);
+        delete mapped;
+    }
 }
 
 extern "C"
@@ -137,6 +379,17 @@ create_geometry(PluginResult &result, PluginState *state)
     const int project = state->parameters["project"];
     const std::string& file = state->parameters["file"];
 
+    float max_magnitude = std::numeric_limits<float>::max();
+
+    if (state->parameters.find("max_magnitude") != state->parameters.end())
+        max_magnitude = state->parameters["max_magnitude"].get<float>();
+
+    if (is_binary_catalog(file))
+    {
+        load_binary_catalog(result, state, file, project, scale, radius, max_magnitude);
+        return;
+    }
+
     std::ifstream fs;
     json j;
 
@@ -154,16 +407,43 @@ create_geometry(PluginResult &result, PluginState *state)
     fs >> j;
     fs.close();
 
-    create_spheres(state, j, project, scale, radius);
+    load_json_catalog(state, j, project, scale, radius, max_magnitude);
+}
+
+static void
+clear_data(PluginState *state)
+{
+    MappedCatalog *mapped = (MappedCatalog*)state->data;
+
+    // The geometry uses the mapped positions, but scene objects (of any
+    // session) might still hold it after we release our reference. So
+    // first give it a copy of the positions, which outlives the mapping.
+    if (state->geometry != nullptr)
+    {
+        OSPData data = ospNewCopiedData(mapped->num_positions, OSP_VEC3F, mapped->positions);
+        ospCommit(data);
+        ospSetObject(state->geometry, "sphere.position", data);
+        ospRelease(data);
+        ospCommit(state->geometry);
+
+        ospRelease(state->geometry);
+        state->geometry = nullptr;
+    }
+
+    munmap(mapped->ptr, mapped->size);
+    delete mapped;
+
+    state->data = nullptr;
 }
 
 static PluginParameters 
 parameters = {
     
-    {"file",    PARAM_STRING,   1, FLAG_NONE, "File to load"},
+    {"file",    PARAM_STRING,   1, FLAG_NONE, "File to load (JSON, or binary catalog made with hyg2bin.py)"},
     {"scale",   PARAM_FLOAT,    1, FLAG_NONE, "Scale factor to apply during reading"},
     {"radius",  PARAM_FLOAT,    1, FLAG_NONE, "Base sphere radius (unscaled by magnitude)"},
     {"project",  PARAM_INT,    1, FLAG_NONE, "Project positions on a unit sphere"},
+    {"max_magnitude",  PARAM_FLOAT,    1, FLAG_OPTIONAL, "Only use stars up to this magnitude"},
         
     PARAMETERS_DONE         // Sentinel (signals end of list)
 };
@@ -175,7 +455,7 @@ functions = {
     NULL,               // Plugin unload
     
     create_geometry,    // Generate    
-    NULL,               // Clear data
+    clear_data,         // Clear data
 };
 
 
@@ -191,5 +471,3 @@ initialize(PluginDefinition *def)
     
     return true;
 }
-
-
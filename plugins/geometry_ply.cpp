@@ -20,38 +20,442 @@
 
 // Uses RPly (http://w3.impa.br/~diego/software/rply/) by Diego Nehab
 #include <rply.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <stdint.h>
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <sstream>
 #include <vector>
 #include "plugin.h"
+#include "voxel_kernels.h"      // voxel_parallel_for()
 
-static std::vector<float> vertices;
-static int      next_vertex_element_index;
+// Mesh data read from a PLY file. All state is kept in here (and not
+// in globals), so multiple files can be loaded at the same time.
+struct PlyMesh
+{
+    std::vector<float>      vertices;
+
+    // Either triangles (when all faces are triangles or quads), or
+    // general polygons as face_indices + face_lengths
+    std::vector<uint32_t>   triangles;
+    std::vector<uint32_t>   face_indices;
+    std::vector<uint32_t>   face_lengths;
+
+    std::vector<float>      vertex_normals;
+    std::vector<float>      vertex_colors;
+    float                   vertex_color_scale_factor;
+    std::vector<float>      vertex_texcoords;
+};
+
+// Turn faces with 3 or 4 vertices into triangles. The quads are split
+// along their first diagonal.
+static void
+triangulate_faces(PlyMesh &mesh)
+{
+    const size_t nfaces = mesh.face_lengths.size();
+
+    // Offsets of each face's first index and first triangle
+    std::vector<size_t> index_offsets(nfaces), triangle_offsets(nfaces);
+    size_t num_indices = 0, num_triangles = 0;
+
+    for (size_t f = 0; f < nfaces; f++)
+    {
+        index_offsets[f] = num_indices;
+        triangle_offsets[f] = num_triangles;
+        num_indices += mesh.face_lengths[f];
+        num_triangles += mesh.face_lengths[f] - 2;
+    }
+
+    mesh.triangles.resize(num_triangles*3);
+
+    const uint32_t *indices = mesh.face_indices.data();
+    const uint32_t *lengths = mesh.face_lengths.data();
+    uint32_t *triangles = mesh.triangles.data();
+
+    voxel_parallel_for(nfaces, [=, &index_offsets, &triangle_offsets](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; f++)
+        {
+            const uint32_t *face = indices + index_offsets[f];
+            uint32_t *tri = triangles + 3*triangle_offsets[f];
+
+            tri[0] = face[0];
+            tri[1] = face[1];
+            tri[2] = face[2];
+
+            if (lengths[f] == 4)
+            {
+                tri[3] = face[0];
+                tri[4] = face[2];
+                tri[5] = face[3];
+            }
+        }
+    });
+
+    mesh.face_indices.clear();
+    mesh.face_lengths.clear();
+}
+
+//
+// Fast path for binary little-endian files, with the vertex and face
+// data used directly from the memory-mapped file
+//
+
+static int
+ply_type_size(const std::string& type)
+{
+    if (type == "char" || type == "uchar" || type == "int8" || type == "uint8")
+        return 1;
+    if (type == "short" || type == "ushort" || type == "int16" || type == "uint16")
+        return 2;
+    if (type == "int" || type == "uint" || type == "int32" || type == "uint32" || type == "float" || type == "float32")
+        return 4;
+    if (type == "double" || type == "float64")
+        return 8;
+    return 0;
+}
+
+static inline float
+ply_read_coordinate(const uint8_t *p, bool is_double)
+{
+    if (is_double)
+    {
+        double d;
+        memcpy(&d, p, 8);
+        return d;
+    }
 
-static std::vector<uint32_t> faces;          // XXX vertex_indices
-static std::vector<uint32_t> face_lengths;
-static int      face_indices_size;
-static int      next_face_offset;
-static int      next_face_element_index;
-static int      num_triangles, num_quads;
+    float f;
+    memcpy(&f, p, 4);
+    return f;
+}
+
+static inline uint32_t
+ply_read_count(const uint8_t *p, int size)
+{
+    switch (size)
+    {
+    case 1:
+        return *p;
+    case 2:
+    {
+        uint16_t v;
+        memcpy(&v, p, 2);
+        return v;
+    }
+    default:
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+    }
+}
+
+// Returns false when the file is not suited for the fast path (in
+// which case the regular rply-based reading should be used), or fails
+// to read.
+static bool
+read_ply_binary_fast(const std::string& fname, PlyMesh &mesh)
+{
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    fstat(fd, &st);
+    const size_t file_size = st.st_size;
 
-static std::vector<float> vertex_normals;
-static int      next_vertex_normal_element_index;
+    // Parse the header. We only handle the common layout of a vertex
+    // element with scalar properties, followed by a face element with
+    // only a vertex index list. Any other element or property type 
+    // means the offsets below can't be derived, so leave those to rply.
 
-static std::vector<float> vertex_colors;
-static int      next_vertex_color_element_index;
-static float    vertex_color_scale_factor;
+    const size_t max_header = std::min<size_t>(file_size, 64*1024);
+    std::string header(max_header, '\0');
 
-static std::vector<float>    vertex_texcoords;
-static int      next_vertex_texcoord_element_index;
+    if (pread(fd, &header[0], max_header, 0) != (ssize_t)max_header)
+    {
+        close(fd);
+        return false;
+    }
+
+    const size_t header_end = header.find("end_header\n");
+    if (header.compare(0, 4, "ply\n") != 0 || header_end == std::string::npos)
+    {
+        close(fd);
+        return false;
+    }
+
+    std::istringstream lines(header.substr(0, header_end));
+    std::string line, keyword;
+
+    bool binary_le = false;
+    std::string element;
+    int num_elements = 0;
+    size_t nvertices = 0, nfaces = 0;
+    int vertex_stride = 0;
+    int xyz_offsets[3] = { -1, -1, -1 };
+    bool xyz_double = false;
+    int face_count_size = 0, face_index_size = 0, face_properties = 0;
+    bool layout_ok = true;
+
+    while (std::getline(lines, line))
+    {
+        std::istringstream words(line);
+        words >> keyword;
+
+        if (keyword == "format")
+        {
+            std::string format;
+            words >> format;
+            binary_le = format == "binary_little_endian";
+        }
+        else if (keyword == "element")
+        {
+            size_t count = 0;
+            words >> element >> count;
+            num_elements++;
+
+            if (element == "vertex" && num_elements == 1)
+                nvertices = count;
+            else if (element == "face" && num_elements == 2)
+                nfaces = count;
+            else
+                layout_ok = false;      // Other element, or out of order
+        }
+        else if (keyword == "property")
+        {
+            std::string type, name;
+            words >> type;
+
+            if (element == "vertex")
+            {
+                if (type == "list")
+                {
+                    layout_ok = false;
+                    continue;
+                }
+
+                words >> name;
+
+                const int size = ply_type_size(type);
+
+                if (size == 0)
+                {
+                    layout_ok = false;      // Unknown type
+                    continue;
+                }
+
+                const int axis = name == "x" ? 0 : (name == "y" ? 1 : (name == "z" ? 2 : -1));
+
+                if (axis >= 0)
+                {
+                    if (size == 4 && type.compare(0, 5, "float") == 0)
+                        xyz_double = false;
+                    else if (size == 8)
+                        xyz_double = true;
+                    else
+                        layout_ok = false;
+                    xyz_offsets[axis] = vertex_stride;
+                }
+
+                vertex_stride += size;
+            }
+            else if (element == "face")
+            {
+                face_properties++;
+
+                std::string count_type, index_type;
+                words >> count_type >> index_type >> name;
+
+                if (type != "list" || (name != "vertex_indices" && name != "vertex_index"))
+                    layout_ok = false;
+
+                face_count_size = ply_type_size(count_type);
+                face_index_size = ply_type_size(index_type);
+            }
+        }
+    }
+
+    // XYZ needs to use the same type
+    if (xyz_double && (xyz_offsets[1] - xyz_offsets[0] != 8 || xyz_offsets[2] - xyz_offsets[1] != 8))
+        layout_ok = false;
+
+    if (!binary_le || !layout_ok || nvertices == 0 || nfaces == 0
+        || xyz_offsets[0] < 0 || xyz_offsets[1] < 0 || xyz_offsets[2] < 0
+        || face_properties != 1 || face_count_size == 0 || face_count_size == 8 || face_index_size != 4)
+    {
+        close(fd);
+        return false;
+    }
+
+    const size_t vertex_data_start = header_end + strlen("end_header\n");
+
+    // Also guards the multiplication below against overflow
+    if (nvertices > (file_size - vertex_data_start) / vertex_stride)
+    {
+        close(fd);
+        return false;
+    }
+
+    const size_t face_data_start = vertex_data_start + nvertices * vertex_stride;
+
+    if (face_data_start >= file_size)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *ptr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (ptr == MAP_FAILED)
+    {
+        perror("mmap() of PLY file failed");
+        return false;
+    }
+
+    madvise(ptr, file_size, MADV_SEQUENTIAL);
+
+    printf("... Using binary PLY fast path: %ld vertices, %ld faces\n", (long)nvertices, (long)nfaces);
+
+    const uint8_t *data = (const uint8_t*)ptr;
+
+    // Vertices
+
+    mesh.vertices.resize(nvertices*3);
+    float *vertices = mesh.vertices.data();
+
+    voxel_parallel_for(nvertices, [=](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; v++)
+        {
+            const uint8_t *p = data + vertex_data_start + v*vertex_stride;
+            vertices[3*v+0] = ply_read_coordinate(p + xyz_offsets[0], xyz_double);
+            vertices[3*v+1] = ply_read_coordinate(p + xyz_offsets[1], xyz_double);
+            vertices[3*v+2] = ply_read_coordinate(p + xyz_offsets[2], xyz_double);
+        }
+    }, 1<<16);
+
+    // Faces. When all faces have the same number of vertices (the first
+    // face's length) the records have a fixed size and can be processed
+    // in parallel directly.
+
+    bool ok = true;
+    const uint32_t first_length = ply_read_count(data + face_data_start, face_count_size);
+    const size_t record_size = face_count_size + first_length*face_index_size;
+    const bool fixed_size = face_data_start + nfaces*record_size <= file_size
+        && (first_length == 3 || first_length == 4);
+
+    if (fixed_size)
+    {
+        const int tris_per_face = first_length - 2;
+        std::vector<char> chunk_ok(std::max(1u, std::thread::hardware_concurrency()), 1);
+
+        mesh.triangles.resize(nfaces*tris_per_face*3);
+        uint32_t *triangles = mesh.triangles.data();
+
+        voxel_parallel_for(nfaces, [=, &chunk_ok](size_t begin, size_t end, int c) {
+            for (size_t f = begin; f < end; f++)
+            {
+                const uint8_t *p = data + face_data_start + f*record_size;
+
+                if (ply_read_count(p, face_count_size) != first_length)
+                {
+                    chunk_ok[c] = 0;
+                    return;
+                }
+
+                uint32_t face[4];
+                memcpy(face, p + face_count_size, first_length*sizeof(uint32_t));
+
+                uint32_t *tri = triangles + 3*tris_per_face*f;
+                tri[0] = face[0];
+                tri[1] = face[1];
+                tri[2] = face[2];
+
+                if (first_length == 4)
+                {
+                    tri[3] = face[0];
+                    tri[4] = face[2];
+                    tri[5] = face[3];
+                }
+            }
+        }, 1<<16);
+
+        for (char c : chunk_ok)
+            ok = ok && c;
+
+        if (!ok)
+        {
+            // Not all faces have the same length after all
+            mesh.triangles.clear();
+        }
+    }
+
+    if (!fixed_size || !ok)
+    {
+        // Variable-length face records, need to scan them in sequence
+
+        mesh.face_lengths.resize(nfaces);
+        mesh.face_indices.clear();
+        mesh.face_indices.reserve(nfaces*4);
+
+        const uint8_t *p = data + face_data_start;
+        const uint8_t *data_end = data + file_size;
+        ok = true;
+
+        for (size_t f = 0; f < nfaces; f++)
+        {
+            if (p + face_count_size > data_end)
+            {
+                ok = false;
+                break;
+            }
+
+            const uint32_t length = ply_read_count(p, face_count_size);
+            p += face_count_size;
+
+            if (p + length*sizeof(uint32_t) > data_end)
+            {
+                ok = false;
+                break;
+            }
+
+            const size_t offset = mesh.face_indices.size();
+            mesh.face_indices.resize(offset + length);
+            memcpy(&mesh.face_indices[offset], p, length*sizeof(uint32_t));
+            p += length*sizeof(uint32_t);
+
+            mesh.face_lengths[f] = length;
+        }
+
+        if (!ok)
+            fprintf(stderr, "... ERROR: PLY file %s is truncated\n", fname.c_str());
+    }
+
+    munmap(ptr, file_size);
+
+    return ok;
+}
+
+//
+// Generic reading with rply, for ASCII and big-endian files
+//
 
 // Vertex callbacks
 
 static int
 vertex_cb(p_ply_argument argument)
 {
-    vertices.push_back(ply_get_argument_value(argument));
-    next_vertex_element_index++;
+    PlyMesh *mesh;
+    ply_get_argument_user_data(argument, (void**)&mesh, NULL);
+
+    mesh->vertices.push_back(ply_get_argument_value(argument));
 
     return 1;
 }
@@ -59,8 +463,10 @@ vertex_cb(p_ply_argument argument)
 static int
 vertex_color_cb(p_ply_argument argument)
 {
-    vertex_colors.push_back(ply_get_argument_value(argument) * vertex_color_scale_factor);
-    next_vertex_color_element_index++;
+    PlyMesh *mesh;
+    ply_get_argument_user_data(argument, (void**)&mesh, NULL);
+
+    mesh->vertex_colors.push_back(ply_get_argument_value(argument) * mesh->vertex_color_scale_factor);
 
     return 1;
 }
@@ -68,8 +474,10 @@ vertex_color_cb(p_ply_argument argument)
 static int
 vertex_normal_cb(p_ply_argument argument)
 {
-    vertex_normals.push_back(ply_get_argument_value(argument));
-    next_vertex_normal_element_index++;
+    PlyMesh *mesh;
+    ply_get_argument_user_data(argument, (void**)&mesh, NULL);
+
+    mesh->vertex_normals.push_back(ply_get_argument_value(argument));
 
     return 1;
 }
@@ -77,8 +485,10 @@ vertex_normal_cb(p_ply_argument argument)
 static int
 vertex_texcoord_cb(p_ply_argument argument)
 {
-    vertex_texcoords.push_back(ply_get_argument_value(argument));
-    next_vertex_texcoord_element_index++;
+    PlyMesh *mesh;
+    ply_get_argument_user_data(argument, (void**)&mesh, NULL);
+
+    mesh->vertex_texcoords.push_back(ply_get_argument_value(argument));
 
     return 1;
 }
@@ -88,53 +498,41 @@ vertex_texcoord_cb(p_ply_argument argument)
 static int
 face_cb(p_ply_argument argument)
 {
+    PlyMesh *mesh;
     long    length, value_index;
-    int     vertex_index;
 
+    ply_get_argument_user_data(argument, (void**)&mesh, NULL);
     ply_get_argument_property(argument, NULL, &length, &value_index);
 
     if (value_index == -1)
     {
-        // First value of a list property, the one that gives the 
+        // First value of a list property, the one that gives the
         // number of entries, i.e. start of new face
-        next_face_offset++;
+        mesh->face_lengths.push_back(length);
 
-        face_lengths.push_back(length);
-        
         return 1;
     }
-    
-    faces.push_back(ply_get_argument_value(argument));
+
+    mesh->face_indices.push_back(ply_get_argument_value(argument));
 
     return 1;
 }
 
-extern "C"
-void
-load_ply_file(PluginResult &result, PluginState *state)
+static bool
+read_ply_rply(const std::string& plyfile, PlyMesh& mesh, char *msg)
 {
-    const std::string& plyfile = state->parameters["file"];
-    char        msg[1024];
-    int         vertex_values_per_loop = 1;
-
     p_ply ply = ply_open(plyfile.c_str(), NULL, 0, NULL);
     if (!ply)
     {
-        
         sprintf(msg, "Could not open PLY file %s", plyfile.c_str());
-        result.set_success(false);
-        result.set_message(msg);
-        printf("%s\n", msg);
-        return;
+        return false;
     }
 
     if (!ply_read_header(ply))
     {
         strcpy(msg, "Could not read PLY header");
-        result.set_success(false);
-        result.set_message(msg);
-        printf("%s\n", msg);
-        return;
+        ply_close(ply);
+        return false;
     }
 
     // Check elements
@@ -155,21 +553,22 @@ load_ply_file(PluginResult &result, PluginState *state)
         element = ply_get_next_element(ply, element);
     }
 
-    // XXX turn into actual checks
-    assert(vertex_element && "Don't have a vertex element");
-    assert(face_element && "Don't have a face element");
+    if (!vertex_element || !face_element)
+    {
+        strcpy(msg, "PLY file doesn't have both a vertex and face element");
+        ply_close(ply);
+        return false;
+    }
 
     // Set vertex and face property callbacks
-    
-    long nvertices, nfaces;
 
-    nvertices = ply_set_read_cb(ply, "vertex", "x", vertex_cb, NULL, 0);
-    ply_set_read_cb(ply, "vertex", "y", vertex_cb, NULL, 0);
-    ply_set_read_cb(ply, "vertex", "z", vertex_cb, NULL, 1);
+    long nvertices, nfaces;
 
-    nfaces = ply_set_read_cb(ply, "face", "vertex_indices", face_cb, NULL, 0);
+    nvertices = ply_set_read_cb(ply, "vertex", "x", vertex_cb, &mesh, 0);
+    ply_set_read_cb(ply, "vertex", "y", vertex_cb, &mesh, 0);
+    ply_set_read_cb(ply, "vertex", "z", vertex_cb, &mesh, 1);
 
-    //printf("%ld vertices\n%ld faces\n", nvertices, nfaces);
+    nfaces = ply_set_read_cb(ply, "face", "vertex_indices", face_cb, &mesh, 0);
 
     // Set optional per-vertex callbacks
 
@@ -179,7 +578,7 @@ load_ply_file(PluginResult &result, PluginState *state)
 
     p_ply_property  prop;
     e_ply_type      ptype, plength_type, pvalue_type;
-    
+
     // XXX check ply_set_read_cb() return values below
 
     prop = ply_get_next_property(vertex_element, NULL);
@@ -187,8 +586,6 @@ load_ply_file(PluginResult &result, PluginState *state)
     {
         ply_get_property_info(prop, &name, &ptype, &plength_type, &pvalue_type);
 
-        //printf("property '%s'\n", name);
-
         if (strcmp(name, "red") == 0)
         {
             // Assumes green and blue properties are also available
@@ -196,184 +593,220 @@ load_ply_file(PluginResult &result, PluginState *state)
             have_vertex_colors = 1;
 
             if (ptype == PLY_UCHAR)
-                vertex_color_scale_factor = 1.0f / 255;
+                mesh.vertex_color_scale_factor = 1.0f / 255;
             else if (ptype == PLY_FLOAT)
-                vertex_color_scale_factor = 1.0f;
+                mesh.vertex_color_scale_factor = 1.0f;
             else
                 fprintf(stderr, "Warning: vertex color value type is %d, don't know how to handle!\n", ptype);
 
-            ply_set_read_cb(ply, "vertex", "red", vertex_color_cb, NULL, 0);
-            ply_set_read_cb(ply, "vertex", "green", vertex_color_cb, NULL, 0);
-            ply_set_read_cb(ply, "vertex", "blue", vertex_color_cb, NULL, 1);
+            ply_set_read_cb(ply, "vertex", "red", vertex_color_cb, &mesh, 0);
+            ply_set_read_cb(ply, "vertex", "green", vertex_color_cb, &mesh, 0);
+            ply_set_read_cb(ply, "vertex", "blue", vertex_color_cb, &mesh, 1);
         }
         else if (strcmp(name, "nx") == 0)
         {
             // Assumes ny and nz properties are also available
             have_vertex_normals = 1;
 
-            ply_set_read_cb(ply, "vertex", "nx", vertex_normal_cb, NULL, 0);
-            ply_set_read_cb(ply, "vertex", "ny", vertex_normal_cb, NULL, 0);
-            ply_set_read_cb(ply, "vertex", "nz", vertex_normal_cb, NULL, 1);
+            ply_set_read_cb(ply, "vertex", "nx", vertex_normal_cb, &mesh, 0);
+            ply_set_read_cb(ply, "vertex", "ny", vertex_normal_cb, &mesh, 0);
+            ply_set_read_cb(ply, "vertex", "nz", vertex_normal_cb, &mesh, 1);
         }
         else if (strcmp(name, "s") == 0 && !have_vertex_texcoords)
         {
             // Assumes t property is also available
             have_vertex_texcoords = 1;
 
-            ply_set_read_cb(ply, "vertex", "s", vertex_texcoord_cb, NULL, 0);
-            ply_set_read_cb(ply, "vertex", "t", vertex_texcoord_cb, NULL, 1);
+            ply_set_read_cb(ply, "vertex", "s", vertex_texcoord_cb, &mesh, 0);
+            ply_set_read_cb(ply, "vertex", "t", vertex_texcoord_cb, &mesh, 1);
         }
         else if (strcmp(name, "u") == 0 && !have_vertex_texcoords)
         {
             // Assumes v property is also available
             have_vertex_texcoords = 1;
 
-            ply_set_read_cb(ply, "vertex", "u", vertex_texcoord_cb, NULL, 0);
-            ply_set_read_cb(ply, "vertex", "v", vertex_texcoord_cb, NULL, 1);
+            ply_set_read_cb(ply, "vertex", "u", vertex_texcoord_cb, &mesh, 0);
+            ply_set_read_cb(ply, "vertex", "v", vertex_texcoord_cb, &mesh, 1);
         }
 
         prop = ply_get_next_property(vertex_element, prop);
     }
 
-    // Allocate memory and initialize some values
-
-    next_vertex_element_index = 0;
+    // Pre-size arrays from the counts in the header. We don't know the
+    // number of indices needed in advance, so assume quads.
 
-    // As we don't know the number of indices needed in advance we assume
-    // quads. For a pure-triangle mesh this will overallocate by 1/4th,
-    // but for a mesh with general n-gons we might have to reallocate
-    // later on.
-    
-    next_face_offset = 0;
-    next_face_element_index = 0;
-    
-    face_indices_size = nfaces > 128 ? nfaces*4 : 512;
+    mesh.vertices.reserve(nvertices*3);
+    mesh.face_lengths.reserve(nfaces);
+    mesh.face_indices.reserve(nfaces*4);
 
     if (have_vertex_normals)
-    {
-        next_vertex_normal_element_index = 0;
-    }
-
+        mesh.vertex_normals.reserve(nvertices*3);
     if (have_vertex_colors)
+        mesh.vertex_colors.reserve(nvertices*3);
+    if (have_vertex_texcoords)
+        mesh.vertex_texcoords.reserve(nvertices*2);
+
+    // Let rply process the file using the callbacks we set above
+
+    if (!ply_read(ply))
     {
-        next_vertex_color_element_index = 0;
+        strcpy(msg, "Could not read PLY data!");
+        ply_close(ply);
+        return false;
     }
 
-    if (have_vertex_texcoords)
+    // Clean up PLY reader
+
+    ply_close(ply);
+
+    return true;
+}
+
+extern "C"
+void
+load_ply_file(PluginResult &result, PluginState *state)
+{
+    const std::string& plyfile = state->parameters["file"];
+    char        msg[1024];
+
+    PlyMesh     mesh;
+
+    mesh.vertex_color_scale_factor = 1.0f;
+
+    if (!read_ply_binary_fast(plyfile, mesh))
     {
-        next_vertex_texcoord_element_index = 0;
-    }
+        mesh = PlyMesh();
+        mesh.vertex_color_scale_factor = 1.0f;
 
-    // Let rply process the file using the callbacks we set above
+        if (!read_ply_rply(plyfile, mesh, msg))
+        {
+            result.set_success(false);
+            result.set_message(msg);
+            printf("%s\n", msg);
+            return;
+        }
+    }
 
-    num_triangles = num_quads = 0;
+    const size_t nvertices = mesh.vertices.size() / 3;
 
-    if (!ply_read(ply))
+    if (mesh.triangles.size() == 0)
     {
-        // Failed!
-        printf("Could not read PLY data!\n");
+        int min_gon=1000, max_gon=0;
 
-        ply_close(ply);
+        for (int l : mesh.face_lengths)
+        {
+            min_gon = std::min(min_gon, l);
+            max_gon = std::max(max_gon, l);
+        }
 
-        return;
+        printf("n-gon sizes in [%d, %d]\n", min_gon,  max_gon);
+
+        if (min_gon >= 3 && max_gon <= 4)
+            triangulate_faces(mesh);
     }
 
-    // Clean up PLY reader
+    // Bounding box edges based on vertices
 
-    ply_close(ply);
+    const int max_chunks = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<float> chunk_bounds(6*max_chunks);
+    const float *vertices = mesh.vertices.data();
 
-    // Create geometry
+    int num_chunks = voxel_parallel_for(nvertices, [=, &chunk_bounds](size_t begin, size_t end, int c) {
+        float *b = &chunk_bounds[6*c];
 
-    int min_gon=1000, max_gon=0;
+        b[0] = b[1] = b[2] = std::numeric_limits<float>::max();
+        b[3] = b[4] = b[5] = std::numeric_limits<float>::lowest();
 
-    for (int l : face_lengths)
+        for (size_t v = begin; v < end; v++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                b[j] = std::min(b[j], vertices[3*v+j]);
+                b[3+j] = std::max(b[3+j], vertices[3*v+j]);
+            }
+        }
+    }, 1<<16);
+
+    float min[3], max[3];
+
+    for (int j = 0; j < 3; j++)
     {
-        min_gon = std::min(min_gon, l);
-        max_gon = std::max(max_gon, l);
+        min[j] = chunk_bounds[j];
+        max[j] = chunk_bounds[3+j];
+
+        for (int c = 1; c < num_chunks; c++)
+        {
+            min[j] = std::min(min[j], chunk_bounds[6*c+j]);
+            max[j] = std::max(max[j], chunk_bounds[6*c+3+j]);
+        }
     }
 
-    printf("n-gon sizes in [%d, %d]\n", min_gon,  max_gon);
+    state->bound = BoundingMesh::bbox(
+        min[0], min[1], min[2],
+        max[0], max[1], max[2],
+        true
+    );
+
+    // Create geometry, holding the OSPRay lock when created in the background
+
+    PluginOSPRayLock lock(state);
 
     OSPGeometry geometry;
 
-    if (max_gon == 3)
+    if (mesh.triangles.size() > 0)
     {
-        // Triangle mesh
-        geometry = ospNewGeometry("triangles");
+        printf("Triangle mesh: %ld vertices, %ld triangles\n", (long)nvertices, (long)mesh.triangles.size()/3);
 
-            //ospSetFloat(geometry, "level", 1.0f);
+        geometry = ospNewGeometry("triangles");
 
-            OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, vertices.data());
+            OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, mesh.vertices.data());
             ospCommit(data);
             ospSetObject(geometry, "vertex.position", data);
+            ospRelease(data);
 
-            //data = ospNewCopiedData(num_vertices, OSP_VEC4F, colors);
-            //ospCommit(data);
-            //ospSetObject(mesh, "vertex.color", data);
-
-            // XXX check /3
-            data = ospNewCopiedData(faces.size()/3, OSP_VEC3UI, faces.data());
+            data = ospNewCopiedData(mesh.triangles.size()/3, OSP_VEC3UI, mesh.triangles.data());
             ospCommit(data);
             ospSetObject(geometry, "index", data);
+            ospRelease(data);
 
         ospCommit(geometry);
+
+        state->memory_size = mesh.vertices.size()*sizeof(float) + mesh.triangles.size()*sizeof(uint32_t);
     }
     else
     {
         // XXX opt
         geometry = ospNewGeometry("subdivision");
 
-            //ospSetFloat(geometry, "level", 1.0f);
-
-            OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, vertices.data());
+            OSPData data = ospNewCopiedData(nvertices, OSP_VEC3F, mesh.vertices.data());
             ospCommit(data);
             ospSetObject(geometry, "vertex.position", data);
+            ospRelease(data);
 
-            //data = ospNewCopiedData(num_vertices, OSP_VEC4F, colors);
-            //ospCommit(data);
-            //ospSetData(mesh, "vertex.color", data);
-
-            // XXX check /3
-            data = ospNewCopiedData(faces.size()/3, OSP_VEC3UI, faces.data());
+            data = ospNewCopiedData(mesh.face_indices.size(), OSP_UINT, mesh.face_indices.data());
             ospCommit(data);
             ospSetObject(geometry, "index", data);
+            ospRelease(data);
 
-            data = ospNewCopiedData(face_lengths.size(), OSP_UINT, face_lengths.data());
+            data = ospNewCopiedData(mesh.face_lengths.size(), OSP_UINT, mesh.face_lengths.data());
             ospCommit(data);
             ospSetObject(geometry, "face", data);
+            ospRelease(data);
 
         ospCommit(geometry);
-    }
 
-    state->geometry = geometry;
-
-    // Bounding box edges based on vertices
-
-    float min[3] = {1e6, 1e6, 1e6}, max[3] = {-1e6, -1e6, -1e6};
-    int i;
-
-    i = 0;
-    while (i < vertices.size())
-    {
-        for (int j = 0; j < 3; j++)
-            min[j] = std::min(min[j], vertices[i+j]);
-        for (int j = 0; j < 3; j++)
-            max[j] = std::max(max[j], vertices[i+j]);
-        i += 3;
+        state->memory_size = mesh.vertices.size()*sizeof(float) 
+            + (mesh.face_indices.size() + mesh.face_lengths.size())*sizeof(uint32_t);
     }
 
-    state->bound = BoundingMesh::bbox(
-        min[0], min[1], min[2], 
-        max[0], max[1], max[2],
-        true
-    );
+    state->geometry = geometry;
 }
 
-static PluginParameters 
+static PluginParameters
 parameters = {
-    
+
     {"file",          PARAM_STRING,    1, FLAG_NONE, "PLY file to load"},
-        
+
     PARAMETERS_DONE         // Sentinel (signals end of list)
 };
 
@@ -382,8 +815,8 @@ functions = {
 
     NULL,               // Plugin load
     NULL,               // Plugin unload
-    
-    load_ply_file,      // Generate    
+
+    load_ply_file,      // Generate
     NULL,               // Clear data
 };
 
@@ -393,12 +826,11 @@ initialize(PluginDefinition *def)
 {
     def->type = PT_GEOMETRY;
     def->uses_renderer_type = false;
+    def->thread_safe = true;
     def->parameters = parameters;
     def->functions = functions;
-    
+
     // Do any other plugin-specific initialization here
-    
+
     return true;
 }
-
-
@@ -0,0 +1,283 @@
+// ======================================================================== //
+// BLOSPRAY - OSPRay as a Blender render engine                             //
+// Paul Melis, SURFsara <paul.melis@surfsara.nl>                            //
+// Assimp scene plugin, keeping the file's mesh instancing                  //
+// ======================================================================== //
+// Copyright 2018-2019 SURFsara                                             //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Loads a complete scene file with Assimp. Each aiMesh becomes a single
+// OSPGroup, which is instanced once for every node referencing the mesh,
+// with the node's accumulated transform. Files with a lot of part reuse
+// (e.g. architectural or CAD models) therefore don't get their meshes
+// duplicated.
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <stdint.h>
+#include <cstdio>
+#include <cfloat>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <glm/matrix.hpp>
+
+#include "plugin.h"
+#include "assimp_mesh.h"
+
+using json = nlohmann::json;
+
+// Creates one OBJ material per Assimp material, using its colors
+static OSPMaterial
+create_material(const aiMaterial *material, const std::string& renderer_type)
+{
+    OSPMaterial m = ospNewMaterial(renderer_type.c_str(), "obj");
+
+    aiColor3D   color;
+    float       value;
+
+    if (material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS)
+        ospSetVec3f(m, "kd", color.r, color.g, color.b);
+    if (material->Get(AI_MATKEY_COLOR_SPECULAR, color) == AI_SUCCESS)
+        ospSetVec3f(m, "ks", color.r, color.g, color.b);
+    if (material->Get(AI_MATKEY_SHININESS, value) == AI_SUCCESS)
+        ospSetFloat(m, "ns", value);
+    if (material->Get(AI_MATKEY_OPACITY, value) == AI_SUCCESS)
+        ospSetFloat(m, "d", value);
+
+    ospCommit(m);
+
+    return m;
+}
+
+// Adds an instance for each mesh of the node and its children. The bound
+// (xmin, ymin, zmin, xmax, ymax, zmax) is extended with the transformed
+// mesh bounds.
+static void
+add_node_instances(GroupInstances& instances, float *bound, const aiNode *node, const glm::mat4& parent_xform,
+    const std::vector<OSPGroup>& mesh_groups, const std::vector<AssimpMeshData>& mesh_data)
+{
+    // aiMatrix4x4 is row-major, glm takes the columns
+    const aiMatrix4x4& m = node->mTransformation;
+    const glm::mat4 local(
+        m.a1, m.b1, m.c1, m.d1,
+        m.a2, m.b2, m.c2, m.d2,
+        m.a3, m.b3, m.c3, m.d3,
+        m.a4, m.b4, m.c4, m.d4);
+
+    const glm::mat4 xform = parent_xform * local;
+
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    {
+        const unsigned int mesh_index = node->mMeshes[i];
+        OSPGroup group = mesh_groups[mesh_index];
+
+        if (group == nullptr)
+            continue;
+
+        // Each entry holds a reference, released by ~PluginState()
+        ospRetain(group);
+        instances.push_back(std::make_pair(group, xform));
+
+        const float *bbox = mesh_data[mesh_index].bbox;
+
+        for (int c = 0; c < 8; c++)
+        {
+            const glm::vec4 corner = xform * glm::vec4(
+                bbox[c & 1 ? 3 : 0], bbox[c & 2 ? 4 : 1], bbox[c & 4 ? 5 : 2], 1.0f);
+
+            for (int j = 0; j < 3; j++)
+            {
+                bound[j] = std::min(bound[j], corner[j]);
+                bound[3+j] = std::max(bound[3+j], corner[j]);
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        add_node_instances(instances, bound, node->mChildren[i], xform, mesh_groups, mesh_data);
+}
+
+extern "C"
+void
+load_file(PluginResult &result, PluginState *state)
+{
+    const json& parameters = state->parameters;
+    const std::string& file = parameters["file"];
+    char        msg[1024];
+
+    bool use_materials = true;
+    if (parameters.find("materials") != parameters.end())
+        use_materials = parameters["materials"].get<int>() != 0;
+
+    printf("... Loading %s\n", file.c_str());
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(file.c_str(), aiProcess_Triangulate);
+
+    if (!scene || scene->mRootNode == nullptr)
+    {
+        sprintf(msg, "Assimp could not open file '%s': %s", file.c_str(), importer.GetErrorString());
+        result.set_success(false);
+        result.set_message(msg);
+        return;
+    }
+
+    const unsigned int num_meshes = scene->mNumMeshes;
+
+    if (num_meshes == 0)
+    {
+        result.set_success(false);
+        result.set_message("WARNING: no meshes found in scene!\n");
+        return;
+    }
+
+    // Convert the meshes in parallel, each mesh by a single thread.
+    // Threads pick the next mesh when done, as mesh sizes vary a lot.
+
+    std::vector<AssimpMeshData> mesh_data(num_meshes);
+    std::atomic<unsigned int> next_mesh(0);
+
+    const unsigned int num_threads = std::min(num_meshes, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 0; t < num_threads; t++)
+    {
+        threads.push_back(std::thread([&]() {
+            unsigned int m;
+            while ((m = next_mesh++) < num_meshes)
+            {
+                if (scene->mMeshes[m]->HasPositions())
+                    assimp_convert_mesh(mesh_data[m], scene->mMeshes[m], SIZE_MAX);
+            }
+        }));
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    // OSPRay objects, one group per mesh. OSPRay calls from here on are
+    // made holding the OSPRay lock, when created in the background.
+
+    PluginOSPRayLock lock(state);
+
+    std::vector<OSPMaterial> materials(scene->mNumMaterials, nullptr);
+    std::vector<OSPGroup> mesh_groups(num_meshes, nullptr);
+    size_t num_triangles = 0;
+
+    state->memory_size = 0;
+
+    for (unsigned int m = 0; m < num_meshes; m++)
+    {
+        const aiMesh *mesh = scene->mMeshes[m];
+        const AssimpMeshData& data = mesh_data[m];
+
+        if (data.triangles.size() == 0)
+        {
+            printf("... WARNING: mesh %d ('%s') has no triangles, ignoring\n", m, mesh->mName.C_Str());
+            continue;
+        }
+
+        num_triangles += data.triangles.size()/3;
+
+        OSPGeometry geometry = assimp_mesh_geometry(mesh, data, state->memory_size);
+
+        OSPGeometricModel gmodel = ospNewGeometricModel(geometry);
+
+            if (use_materials && mesh->mMaterialIndex < scene->mNumMaterials)
+            {
+                OSPMaterial& material = materials[mesh->mMaterialIndex];
+                if (material == nullptr)
+                    material = create_material(scene->mMaterials[mesh->mMaterialIndex], state->renderer);
+                ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, material);
+            }
+
+        ospCommit(gmodel);
+        ospRelease(geometry);
+
+        OSPGroup group = ospNewGroup();
+            ospSetObjectAsData(group, "geometry", OSP_GEOMETRIC_MODEL, gmodel);
+        ospCommit(group);
+        ospRelease(gmodel);
+
+        mesh_groups[m] = group;
+    }
+
+    for (auto& material : materials)
+    {
+        if (material != nullptr)
+            ospRelease(material);
+    }
+
+    // Instances, following the node hierarchy
+
+    float bound[6] = { FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    add_node_instances(state->group_instances, bound, scene->mRootNode, glm::mat4(1.0f), mesh_groups, mesh_data);
+
+    // The instances hold the references now, unreferenced meshes get freed
+    for (auto& group : mesh_groups)
+    {
+        if (group != nullptr)
+            ospRelease(group);
+    }
+
+    printf("... %d meshes (%d triangles), %d instances\n",
+        num_meshes, (int)num_triangles, (int)state->group_instances.size());
+
+    if (state->group_instances.size() == 0)
+    {
+        result.set_success(false);
+        result.set_message("WARNING: no mesh instances in scene!\n");
+        return;
+    }
+
+    state->bound = BoundingMesh::bbox(bound[0], bound[1], bound[2], bound[3], bound[4], bound[5], true);
+}
+
+static PluginParameters
+parameters = {
+
+    {"file",          PARAM_STRING,     1, FLAG_NONE,       "Scene file to load"},
+    {"materials",     PARAM_INT,        1, FLAG_OPTIONAL,   "Use the file's material colors (default 1)"},
+
+    PARAMETERS_DONE         // Sentinel (signals end of list)
+};
+
+static PluginFunctions
+functions = {
+
+    NULL,               // Plugin load
+    NULL,               // Plugin unload
+
+    load_file,          // Generate
+    NULL,               // Clear data
+};
+
+
+extern "C" bool
+initialize(PluginDefinition *def)
+{
+    def->type = PT_SCENE;
+    def->uses_renderer_type = true;
+    def->thread_safe = true;
+    def->parameters = parameters;
+    def->functions = functions;
+
+    // Do any other plugin-specific initialization here
+
+    return true;
+}
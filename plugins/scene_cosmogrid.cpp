@@ -20,17 +20,56 @@
 
 #include <cstdio>
 #include <stdint.h>
+#include <vector>
+#include <algorithm>
 #include "uhdf5.h"
 
 #include "plugin.h"
+#include "hdf5_hyperslab.h"
 
 std::string         data_file;
 OSPGeometricModel   model;
 
+// Positions are read in blocks of this many points in distributed mode
+const hsize_t       DOMAIN_BLOCK_SIZE = 4*1024*1024;
+
+// Distributed rendering: reads the positions of the selected points in 
+// blocks, keeping only the points whose sphere overlaps the domain's
+// slab z0 <= z < z1 of the unit cube. Returns false on read errors.
+static bool
+read_domain_positions(const char *fname, int point_stride, uint32_t num_points, hsize_t num_components,
+    float z0, float z1, float sphere_radius, std::vector<float>& domain_positions)
+{
+    std::vector<float> block;
+
+    for (hsize_t b = 0; b < num_points; b += DOMAIN_BLOCK_SIZE)
+    {
+        const hsize_t count = std::min<hsize_t>(DOMAIN_BLOCK_SIZE, num_points - b);
+
+        block.resize(count*num_components);
+
+        if (!hdf5_read_hyperslab(fname, "/positions", H5T_NATIVE_FLOAT,
+                { b*point_stride, 0 }, { (hsize_t)point_stride, 1 }, { count, num_components }, &block[0]))
+            return false;
+
+        for (hsize_t i = 0; i < count; i++)
+        {
+            const float *p = &block[i*num_components];
+
+            if (p[2] >= z0 - sphere_radius && p[2] < z1 + sphere_radius)
+                domain_positions.insert(domain_positions.end(), p, p+3);
+        }
+    }
+
+    return true;
+}
+
 bool
-load_points(const char *renderer_type, const char *fname, int max_points, float sphere_radius, float sphere_opacity)
+load_points(PluginState *state, const char *fname, int max_points, int point_stride, float sphere_radius, float sphere_opacity)
 {
-    printf("Loading %d points from %s\n", max_points, fname);
+    const char *renderer_type = state->renderer.c_str();
+
+    printf("Loading %d points (stride %d) from %s\n", max_points, point_stride, fname);
 
     uint32_t  num_points;
     float     *colors;  
@@ -48,7 +87,6 @@ load_points(const char *renderer_type, const char *fname, int max_points, float
     file.open(fname);
     
     // Positions
-    // XXX we actually load ALL the points, regardless of max_points
 
     dset = file.open_dataset("/positions");
 
@@ -56,7 +94,13 @@ load_points(const char *renderer_type, const char *fname, int max_points, float
     dset->get_dimensions(dims);
     printf("N=%d: %d, %d\n", dims.size(), dims[0], dims[1]);
     
-    num_points = dims[0];
+    // Only read the points we're going to use, i.e. every point_stride-th
+    // point, up to max_points
+    num_points = (dims[0] + point_stride - 1) / point_stride;
+    if (max_points > 0 && (uint32_t)max_points < num_points)
+        num_points = max_points;
+
+    printf("Reading %d of %d points\n", num_points, (int)dims[0]);
 
     type = dset->get_type();
     printf("Dataset data class = %d, order = %d, size = %d, precision = %d, signed = %d\n",
@@ -71,10 +115,42 @@ load_points(const char *renderer_type, const char *fname, int max_points, float
 
     delete type;
 
-    positions = new float[dims[0]*dims[1]];
-    dset->read<float>(positions);
-    
     delete dset;
+
+    uint32_t num_spheres = num_points;
+
+    if (state->num_domains == 1)
+    {
+        positions = new float[num_points*dims[1]];
+
+        if (!hdf5_read_hyperslab(fname, "/positions", H5T_NATIVE_FLOAT,
+                { 0, 0 }, { (hsize_t)point_stride, 1 }, { num_points, dims[1] }, positions))
+        {
+            delete [] positions;
+            return false;
+        }
+    }
+    else
+    {
+        // The domains are slabs along Z of the unit cube
+        const float z0 = (float)state->domain_index / state->num_domains;
+        const float z1 = (float)(state->domain_index + 1) / state->num_domains;
+
+        std::vector<float> domain_positions;
+
+        if (!read_domain_positions(fname, point_stride, num_points, dims[1], z0, z1, sphere_radius, domain_positions))
+            return false;
+
+        num_spheres = domain_positions.size() / 3;
+
+        printf("Domain %d of %d: %d of %d points within %.6f <= z < %.6f\n", 
+            state->domain_index, state->num_domains, num_spheres, num_points, z0, z1);
+
+        positions = new float[3*num_spheres];
+        std::copy(domain_positions.begin(), domain_positions.end(), positions);
+
+        plugin_set_domain_bounds(state, 0.0f, 0.0f, z0, 1.0f, 1.0f, z1);
+    }
     
     // Counts
 
@@ -93,10 +169,17 @@ load_points(const char *renderer_type, const char *fname, int max_points, float
 
     delete type;
 
-    nbcounts = new uint32_t[num_points];
-    
-    dset->read<uint32_t>(nbcounts);
     delete dset;
+
+    nbcounts = new uint32_t[num_points];
+
+    if (!hdf5_read_hyperslab(fname, "/nbcounts", H5T_NATIVE_UINT32,
+            { 0 }, { (hsize_t)point_stride }, { num_points }, nbcounts))
+    {
+        delete [] positions;
+        delete [] nbcounts;
+        return false;
+    }
     
     file.close();
     
@@ -118,7 +201,7 @@ load_points(const char *renderer_type, const char *fname, int max_points, float
     
     OSPGeometry spheres = ospNewGeometry("spheres");
     
-      OSPData data = ospNewCopiedData(num_points, OSP_VEC3F, positions);
+      OSPData data = ospNewCopiedData(num_spheres, OSP_VEC3F, positions);
       ospSetObject(spheres, "sphere.position", data);
       //ospSetInt(spheres, "bytes_per_sphere", 3*sizeof(float));
       ospSetFloat(spheres, "radius", sphere_radius);
@@ -171,11 +254,14 @@ generate(PluginResult &result, PluginState *state)
     printf("data_file = %s\n", data_file.c_str());
     
     int max_points = -1;
+    int point_stride = 1;
     float sphere_radius = 0.01f;
     float sphere_opacity = 1.0f;
     
     if (parameters.find("max_points") != parameters.end())
         max_points = parameters["max_points"].get<int>();
+    if (parameters.find("point_stride") != parameters.end())
+        point_stride = std::max(1, parameters["point_stride"].get<int>());
     
     if (parameters.find("sphere_radius") != parameters.end())
         sphere_radius = parameters["sphere_radius"].get<float>();
@@ -185,7 +271,7 @@ generate(PluginResult &result, PluginState *state)
     GroupInstances &instances = state->group_instances;
     
 #if 1
-    if (!load_points(state->renderer.c_str(), data_file.c_str(), max_points, sphere_radius, sphere_opacity))
+    if (!load_points(state, data_file.c_str(), max_points, point_stride, sphere_radius, sphere_opacity))
     {
         result.set_success(false);
         result.set_message("Failed to load points from HDF5 file");
@@ -246,6 +332,9 @@ parameters = {
         
     {"max_points",        PARAM_INT,      1, FLAG_NONE, 
         "Maximum number of points to load"},
+
+    {"point_stride",        PARAM_INT,      1, FLAG_OPTIONAL, 
+        "Only load every n-th point"},
         
     {"sphere_radius",        PARAM_FLOAT,      1, FLAG_NONE, 
         "Radius of each sphere"},
@@ -19,6 +19,7 @@
 // ======================================================================== //
 
 #include <cstdio>
+#include <algorithm>
 #include <stdint.h>
 #include <ospray/ospray.h>
 #include <glm/matrix.hpp>
@@ -27,6 +28,7 @@
 
 //#include "util.h"       // XXX for ...?
 #include "plugin.h"
+#include "voxel_kernels.h"      // voxel_parallel_for()
 
 using json = nlohmann::json;
 
@@ -269,6 +271,113 @@ add_ground_plane()
 }
 */
 
+// Transform of a cell, from its position and rotation (in degrees)
+static inline glm::mat4
+cell_transform(const float *cell)
+{
+    glm::mat4 R = glm::mat4(1.0f);
+    R = glm::translate(R, glm::vec3(cell[0], cell[1], cell[2]));
+    R = glm::rotate(R, glm::radians(cell[3]), glm::vec3(1,0,0));
+    R = glm::rotate(R, glm::radians(cell[4]), glm::vec3(0,1,0));
+    R = glm::rotate(R, glm::radians(cell[5]), glm::vec3(0,0,1));
+    return R;
+}
+
+// Sets the RBC and PLT instances from the cell positions file in 
+// state->instance_arrays, using the already loaded cell models.
+// The file contains a header of 3 uint32's (number of RBCs, PLTs and 
+// WBCs), followed by 6 floats per cell (position and rotation), RBCs first.
+bool
+read_cell_instances(PluginResult &result, PluginState *state, const json &parameters)
+{
+    int max_rbcs = -1;
+    int max_plts = -1;
+    
+    if (parameters.find("num_rbcs") != parameters.end())
+        max_rbcs = parameters["num_rbcs"].get<int>();
+    if (parameters.find("num_plts") != parameters.end())
+        max_plts = parameters["num_plts"].get<int>();
+
+    std::string cells_file = "cells.bin";
+
+    if (parameters.find("cells_file") != parameters.end())
+        cells_file = parameters["cells_file"].get<std::string>();
+    
+    uint32_t    header[3];
+
+    char fname[1024];
+    sprintf(fname, "%s/%s", rbc_data_path.c_str(), cells_file.c_str());
+    FILE *p = fopen(fname, "rb");
+    
+    if (!p)
+    {
+        fprintf(stderr, "ERROR: could not open %s!\n", fname);
+        result.set_success(false);
+        result.set_message("could not open " + cells_file);
+        return false;
+    }
+    
+    if (fread(header, sizeof(uint32_t), 3, p) != 3)
+    {
+        fclose(p);
+        result.set_success(false);
+        result.set_message("could not read header of " + cells_file);
+        return false;
+    }
+
+    const uint32_t num_rbc = header[0], num_plt = header[1], num_wbc = header[2];
+    printf("On-disk scene: %u rbc, %u plt, %u wbc\n", num_rbc, num_plt, num_wbc);
+
+    // A negative count (the default) means all cells of that type
+    const size_t num_rbcs = max_rbcs < 0 ? num_rbc : std::min<size_t>(max_rbcs, num_rbc);
+    const size_t num_plts = max_plts < 0 ? num_plt : std::min<size_t>(max_plts, num_plt);
+    
+    printf("Adding %zu RBCs\n", num_rbcs);    
+    printf("Adding %zu PLTs\n", num_plts);
+
+    // Read the cell records as two blocks, skipping the unused RBCs
+
+    const size_t CELL_SIZE = 6*sizeof(float);
+    const size_t num_cells = num_rbcs + num_plts;
+
+    std::vector<float> cells(6*num_cells);
+
+    bool ok = fread(cells.data(), CELL_SIZE, num_rbcs, p) == num_rbcs
+        && fseek(p, long((num_rbc - num_rbcs)*CELL_SIZE), SEEK_CUR) == 0
+        && fread(cells.data() + 6*num_rbcs, CELL_SIZE, num_plts, p) == num_plts;
+
+    fclose(p);
+
+    if (!ok)
+    {
+        result.set_success(false);
+        result.set_message("could not read cells from " + cells_file);
+        return false;
+    }
+
+    // Instantiate RBCs & PLTs
+    
+    InstanceArray &cell_instances = state->instance_arrays[0];
+
+    cell_instances.transforms.resize(num_cells);
+    cell_instances.group_indices.resize(num_cells);
+
+    glm::mat4 *transforms = cell_instances.transforms.data();
+    uint32_t *group_indices = cell_instances.group_indices.data();
+    const float *cell_data = cells.data();
+    const size_t first_plt = num_rbcs;
+
+    voxel_parallel_for(num_cells, [=](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+        {
+            transforms[i] = cell_transform(cell_data + 6*i);
+            group_indices[i] = i < first_plt ? 0 : 1;
+        }
+    }, 65536);
+
+    return true;
+}
+
 extern "C" 
 void
 generate(PluginResult &result, PluginState *state)
@@ -292,14 +401,6 @@ generate(PluginResult &result, PluginState *state)
     
     printf("rbc_data_path = %s\n", rbc_data_path.c_str());
     
-    int max_rbcs = -1;
-    int max_plts = -1;
-    
-    if (parameters.find("num_rbcs") != parameters.end())
-        max_rbcs = parameters["num_rbcs"].get<int>();
-    if (parameters.find("num_plts") != parameters.end())
-        max_plts = parameters["num_plts"].get<int>();
-    
     if (!load_cell_models(state->renderer.c_str()))
     {
         result.set_success(false);
@@ -307,96 +408,14 @@ generate(PluginResult &result, PluginState *state)
         return;
     }
     
-    uint32_t    num_rbc, num_plt, num_wbc;
-    float       tx, ty, tz, rx, ry, rz;
-    glm::mat4   R;
+    // The cell models, referenced by index from the instances
+    InstanceArray cell_instances;
+    cell_instances.groups.push_back(rbc_group);
+    cell_instances.groups.push_back(plt_group);
+    state->instance_arrays.push_back(cell_instances);
 
-    char fname[1024];
-    sprintf(fname, "%s/cells.bin", rbc_data_path.c_str());
-    FILE *p = fopen(fname, "rb");
-    
-    if (!p)
-    {
-        fprintf(stderr, "ERROR: could not open %s!\n", fname);
-        result.set_success(false);
-        result.set_message("could not open cells.bin");
+    if (!read_cell_instances(result, state, parameters))
         return;
-    }
-    
-    fread(&num_rbc, sizeof(uint32_t), 1, p);
-    fread(&num_plt, sizeof(uint32_t), 1, p);
-    fread(&num_wbc, sizeof(uint32_t), 1, p);    
-    printf("On-disk scene: %d rbc, %d plt, %d wbc\n", num_rbc, num_plt, num_wbc);
-
-    // Instantiate RBCs & PLTs
-    
-    GroupInstances &instances = state->group_instances;
-    
-    if (max_rbcs == -1)
-        max_rbcs = num_rbc;
-    
-    printf("Adding %d RBCs\n", max_rbcs);    
-      
-    for (int i = 0; i < max_rbcs; i++)
-    {      
-        fread(&tx, sizeof(float), 1, p);
-        fread(&ty, sizeof(float), 1, p);
-        fread(&tz, sizeof(float), 1, p);
-        fread(&rx, sizeof(float), 1, p);
-        fread(&ry, sizeof(float), 1, p);
-        fread(&rz, sizeof(float), 1, p);
-        
-        R = glm::mat4(1.0f);
-        R = glm::translate(R, glm::vec3(tx,ty,tz));        
-        R = glm::rotate(R, glm::radians(rx), glm::vec3(1,0,0));
-        R = glm::rotate(R, glm::radians(ry), glm::vec3(0,1,0));
-        R = glm::rotate(R, glm::radians(rz), glm::vec3(0,0,1));   
-        
-        // Add instance
-        instances.push_back(std::make_pair(rbc_group, R));
-    }    
-    
-    // Skip remaining RBCs in scene file
-    
-    for (int i = 0; i < num_rbc-max_rbcs; i++)
-    {      
-        fread(&tx, sizeof(float), 1, p);
-        fread(&ty, sizeof(float), 1, p);
-        fread(&tz, sizeof(float), 1, p);
-        fread(&rx, sizeof(float), 1, p);
-        fread(&ry, sizeof(float), 1, p);
-        fread(&rz, sizeof(float), 1, p);
-    }
-    
-    if (max_plts == -1)
-        max_plts = num_plt;
-    
-    printf("Adding %d PLTs\n", max_plts);
-      
-    for (int i = 0; i < max_plts; i++)
-    {      
-        fread(&tx, sizeof(float), 1, p);
-        fread(&ty, sizeof(float), 1, p);
-        fread(&tz, sizeof(float), 1, p);
-        fread(&rx, sizeof(float), 1, p);
-        fread(&ry, sizeof(float), 1, p);
-        fread(&rz, sizeof(float), 1, p);
-
-        R = glm::mat4(1.0f);
-        R = glm::translate(R, glm::vec3(tx,ty,tz));
-        R = glm::rotate(R, glm::radians(rx), glm::vec3(1,0,0));
-        R = glm::rotate(R, glm::radians(ry), glm::vec3(0,1,0));
-        R = glm::rotate(R, glm::radians(rz), glm::vec3(0,0,1));
-        
-        /*glm::mat4 T = glm::translate(
-        glm::mat4(1.0f), glm::vec3(tx, ty, tz)
-        );*/
-        
-        // Add instance
-        instances.push_back(std::make_pair(plt_group, R));
-    }        
-    
-    fclose(p);        
     
     printf("Data loaded...\n");
     
@@ -406,6 +425,19 @@ generate(PluginResult &result, PluginState *state)
     );
 }
 
+// A different cell positions file (e.g. another time step) or number of 
+// cells only needs the instances to be re-read, not the cell models
+bool
+update(PluginResult &result, PluginState *state, const json &old_parameters, const json &new_parameters)
+{
+    if (!plugin_parameters_differ_only_in(old_parameters, new_parameters, {"num_rbcs", "num_plts", "cells_file"}))
+        return false;
+
+    read_cell_instances(result, state, new_parameters);
+
+    return true;
+}
+
 static PluginParameters 
 parameters = {
     
@@ -417,6 +449,9 @@ parameters = {
         
     {"num_plts",        PARAM_INT,      1, FLAG_NONE, 
         "Limit number of PLTs"},
+
+    {"cells_file",      PARAM_STRING,   1, FLAG_OPTIONAL, 
+        "Cell positions file, relative to rbc_data_path (default cells.bin)"},
         
     PARAMETERS_DONE         // Sentinel (signals end of list)
 };
@@ -429,6 +464,7 @@ functions = {
     
     generate,       // Generate    
     NULL,           // Clear data
+    update,         // Update
 };
 
 
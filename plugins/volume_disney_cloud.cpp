@@ -25,6 +25,7 @@
 #include <openvdb/tools/Interpolation.h>
 #include "json.hpp"
 #include "plugin.h"
+#include "voxel_kernels.h"
 
 using json = nlohmann::json;
 
@@ -249,14 +250,9 @@ generate(PluginResult &result, PluginState *state)
         }    
     }
     
-    float min = std::numeric_limits<float>::max();
-    float max = std::numeric_limits<float>::min();
+    float min, max;
 
-    for (size_t i = 0; i < datalen; i++)
-    {
-        min = std::min(min, (float)(data[i]));
-        max = std::max(max, (float)(data[i]));
-    }    
+    voxel_value_range(data, datalen, min, max);
 
     printf("... Data range %.6f, %.6f\n", min, max);
 
@@ -23,6 +23,9 @@
 #include "uhdf5.h"
 
 #include "plugin.h"
+#include "voxel_kernels.h"
+#include "hdf5_hyperslab.h"
+#include "volume_lod.h"
 
 extern "C" 
 void
@@ -90,60 +93,182 @@ generate(PluginResult &result, PluginState *state)
     }
 
     delete type;
+    delete dset;
+    file.close();
 
-    const int n = dims[0]*dims[1]*dims[2];
+    // Optional region of interest and subsampling, both in X,Y,Z order
+
+    int roi[6] = { 0, 0, 0, (int)dims[0], (int)dims[1], (int)dims[2] };
+    int stride[3] = { 1, 1, 1 };
+
+    if (parameters.find("roi") != parameters.end())
+    {
+        const json &p_roi = parameters["roi"];
+
+        for (int i = 0; i < 3; i++)
+        {
+            roi[i] = std::max(0, p_roi[i].get<int>());
+            roi[3+i] = std::min((int)dims[i], p_roi[3+i].get<int>());
+        }
+    }
+
+    if (parameters.find("stride") != parameters.end())
+    {
+        const json &p_stride = parameters["stride"];
+
+        for (int i = 0; i < 3; i++)
+            stride[i] = std::max(1, p_stride[i].get<int>());
+    }
+
+    int32_t grid_dims[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (roi[3+i] <= roi[i])
+        {
+            fprintf(stderr, "ERROR: empty region of interest!\n");
+            result.set_success(false);
+            result.set_message("ERROR: empty region of interest!");
+            return;
+        }
+
+        grid_dims[i] = (roi[3+i] - roi[i] + stride[i] - 1) / stride[i];
+    }
+
+    // Distributed rendering: only read the domain's slab of Z slices,
+    // plus one ghost slice above it
+    const int32_t full_dims_z = grid_dims[2];
+    int k0, k1;
+
+    plugin_domain_range(state, full_dims_z, k0, k1);
+
+    if (state->num_domains > 1)
+    {
+        grid_dims[2] = std::min(full_dims_z, k1 + 1) - k0;
+
+        printf("... Domain %d of %d: slices %d-%d (plus %d ghost)\n", 
+            state->domain_index, state->num_domains, k0, k1-1, grid_dims[2] - (k1 - k0));
+
+        if (parameters.find("value_range") == parameters.end())
+            printf("... WARNING: no value_range provided, the derived range will differ per domain\n");
+    }
+
+    printf("... Reading %d x %d x %d voxels (region %d,%d,%d - %d,%d,%d, stride %d,%d,%d)\n",
+        grid_dims[0], grid_dims[1], grid_dims[2],
+        roi[0], roi[1], roi[2], roi[3], roi[4], roi[5], stride[0], stride[1], stride[2]);
+
+    const size_t n = (size_t)grid_dims[0] * grid_dims[1] * grid_dims[2];
     float *grid_field_values = new float[n];
     float minval, maxval;
 
-    dset->read<float>(grid_field_values);
-    
-    minval = std::numeric_limits<float>::max();
-    maxval = std::numeric_limits<float>::min();
+    // File order is Z,Y,X
+    const std::vector<hsize_t> h_start = { (hsize_t)(roi[2] + k0*stride[2]), (hsize_t)roi[1], (hsize_t)roi[0] };
+    const std::vector<hsize_t> h_stride = { (hsize_t)stride[2], (hsize_t)stride[1], (hsize_t)stride[0] };
+    const std::vector<hsize_t> h_count = { (hsize_t)grid_dims[2], (hsize_t)grid_dims[1], (hsize_t)grid_dims[0] };
 
-    for (int i = 0; i < n; i++)
+    if (!hdf5_read_hyperslab(hdf5_file.c_str(), dataset.c_str(), H5T_NATIVE_FLOAT,
+            h_start, h_stride, h_count, grid_field_values))
     {
-        minval = std::min(minval, grid_field_values[i]);
-        maxval = std::max(maxval, grid_field_values[i]);
+        delete [] grid_field_values;
+        result.set_success(false);
+        result.set_message("ERROR: failed to read dataset!");
+        return;
     }
+    
+    voxel_value_range(grid_field_values, n, minval, maxval);
 
     printf("... Data range: %.6f, %.6f\n", minval, maxval);
     
     if (parameters.find("fill") != parameters.end())
     {
+        // Indices are in terms of the voxels read, clamped to the grid.
+        // In distributed mode the Z indices are shifted to the domain's 
+        // slab (which includes the ghost slice), a range outside the slab
+        // fills nothing.
         const json &fill = parameters["fill"];
+        char msg[1024];
+
+        if (fill.size() != 4)
+        {
+            delete [] grid_field_values;
+            result.set_success(false);
+            result.set_message("ERROR: fill needs 4 values (axis, minindex, maxindex, value)");
+            return;
+        }
         
         const int axis = fill[0].get<int>();
-        const int min_index = fill[1].get<int>();
-        const int max_index = fill[2].get<int>();
+        const int begin = fill[1].get<int>();
+        const int end = fill[2].get<int>();
+
+        if (axis < 0 || axis > 2)
+        {
+            delete [] grid_field_values;
+            result.set_success(false);
+            result.set_message("ERROR: fill axis must be 0, 1 or 2");
+            return;
+        }
+
+        const int full_dim = axis == 2 ? full_dims_z : grid_dims[axis];
+
+        if (begin > end || end < 0 || begin >= full_dim)
+        {
+            snprintf(msg, 1024, "ERROR: fill range %d..%d is empty or outside 0..%d", begin, end, full_dim-1);
+            delete [] grid_field_values;
+            result.set_success(false);
+            result.set_message(msg);
+            return;
+        }
+
+        const int offset = axis == 2 ? k0 : 0;
+        const int min_index = std::max(0, begin - offset);
+        const int max_index = std::min(grid_dims[axis]-1, end - offset);
         const float value = fill[3].get<float>();
         
-        printf("... Filling %c=%d..%d with %.6f\n", 'X'+axis, min_index, max_index, value);
-        
-        int i, j, k;
+        printf("... Filling %c=%d..%d with %.6f\n", 'X'+axis, min_index+offset, max_index+offset, value);
         
-        // XXX oh, the horror....
-        switch (axis)
+        const size_t ystep = grid_dims[0];
+        const size_t zstep = ystep * grid_dims[1];
+
+        if (min_index <= max_index)
         {
-        case 2:
-            for (k = min_index; k <= max_index; k++)
+            switch (axis)
             {
-                for (j = 0; j < dims[1]; j++)
-                {
-                    for (i = 0;  i < dims[0]; i++)
-                    {
-                        grid_field_values[(k*dims[1] + j)*dims[0] + i] = value;
-                    }
-                }
+            case 0:
+                for (size_t row = 0; row < (size_t)grid_dims[1]*grid_dims[2]; row++)
+                    std::fill(grid_field_values + row*ystep + min_index, grid_field_values + row*ystep + max_index + 1, value);
+                break;
+            case 1:
+                for (int k = 0; k < grid_dims[2]; k++)
+                    std::fill(grid_field_values + k*zstep + min_index*ystep, grid_field_values + k*zstep + (max_index+1)*ystep, value);
+                break;
+            case 2:
+                // Slices are contiguous
+                std::fill(grid_field_values + min_index*zstep, grid_field_values + (max_index+1)*zstep, value);
+                break;
             }
-            break;
         }
     }
 
     const json& p_origin = parameters["origin"];
     const json& p_spacing = parameters["spacing"];
 
-    float origin[3] = {p_origin[0], p_origin[1], p_origin[2]};
-    float spacing[3] = {p_spacing[0], p_spacing[1], p_spacing[2]};
+    float origin[3], spacing[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        // Of the voxels read
+        origin[i] = p_origin[i].get<float>() + roi[i] * p_spacing[i].get<float>();
+        spacing[i] = stride[i] * p_spacing[i].get<float>();
+    }
+
+    origin[2] += k0 * spacing[2];
+
+    if (state->num_domains > 1)
+    {
+        plugin_set_domain_bounds(state,
+            origin[0], origin[1], origin[2],
+            origin[0]+spacing[0]*grid_dims[0], origin[1]+spacing[1]*grid_dims[1], origin[2]+spacing[2]*(k1-k0));
+    }
 
     OSPDataType dataType = OSP_FLOAT;
 
@@ -156,7 +281,7 @@ generate(PluginResult &result, PluginState *state)
         ospRelease(voxelData);
 
         ospSetInt(volume, "voxelType", dataType);
-        ospSetVec3i(volume, "dimensions", dims[0], dims[1], dims[2]);
+        ospSetVec3i(volume, "dimensions", grid_dims[0], grid_dims[1], grid_dims[2]);
     
         ospSetParam(volume, "gridOrigin", OSP_VEC3F, origin);
         ospSetParam(volume, "gridSpacing", OSP_VEC3F, spacing);
@@ -164,6 +289,12 @@ generate(PluginResult &result, PluginState *state)
     ospCommit(volume);
 
     state->volume = volume;
+
+    const int lod_factor = volume_lod_factor(parameters);
+    if (lod_factor > 1)
+        state->volume_lod = volume_lod_create(grid_field_values, dataType, grid_dims, origin, spacing, lod_factor);
+
+    delete [] grid_field_values;
     
     if (parameters.find("value_range") != parameters.end())
     {
@@ -177,14 +308,16 @@ generate(PluginResult &result, PluginState *state)
         state->volume_data_range[1] = maxval;
     }
     
+    // Of the complete volume, also when distributed
+    const float z0 = origin[2] - k0 * spacing[2];
+
     state->bound = BoundingMesh::bbox(
-        origin[0], origin[1], origin[2],
-        origin[0]+spacing[0]*dims[0], origin[1]+spacing[1]*dims[1], origin[2]+spacing[2]*dims[2],
+        origin[0], origin[1], z0,
+        origin[0]+spacing[0]*grid_dims[0], origin[1]+spacing[1]*grid_dims[1], z0+spacing[2]*full_dims_z,
         true
     ); 
 }
 
-
 static PluginParameters 
 parameters = {
     
@@ -200,12 +333,21 @@ parameters = {
     {"spacing",     PARAM_FLOAT,    3, FLAG_NONE, 
         "Spacing of the volume"},
 
-    {"fill",        PARAM_INT,      3, FLAG_OPTIONAL, 
+    {"roi",         PARAM_INT,      6, FLAG_OPTIONAL, 
+        "Region of interest to read, in voxels (xmin, ymin, zmin, xmax, ymax, zmax), max exclusive"},
+
+    {"stride",      PARAM_INT,      3, FLAG_OPTIONAL, 
+        "Read only every n-th voxel per axis"},
+
+    {"fill",        PARAM_INT,      4, FLAG_OPTIONAL, 
         "Fill (overwrite) part of the volume (axis, minindex, maxindex, value)"},
         
     {"value_range", PARAM_FLOAT,    2, FLAG_OPTIONAL, 
         "Data range of the volume (derived from the data if not specified)"},        
 
+    {"lod_factor",  PARAM_INT,      1, FLAG_OPTIONAL, 
+        "Downsampling factor of the lower-resolution volume used for interactive rendering (default: none)"},
+
     PARAMETERS_DONE         // Sentinel (signals end of list)
 };
 
@@ -20,11 +20,22 @@
 
 #include <cstdio>
 #include <stdint.h>
+#include <cstring>
 #include <limits>
+#include <list>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <ospray/ospray.h>
 #include "json.hpp"
 #include "plugin.h"
-#include "util.h"       // float_swap()
+#include "plugin_cache.h"
+#include "util.h"
+#include "voxel_kernels.h"
+#include "volume_lod.h"
 
 using json = nlohmann::json;
 
@@ -40,7 +51,7 @@ load_as_structured(float *bbox, PluginResult &result,
     OSPVolume volume = ospNewVolume("structured_regular");
     
     // XXX shared
-    OSPData voxelData = ospNewCopiedData(dims[0]*dims[1]*dims[2], dataType, grid_field_values);   
+    OSPData voxelData = ospNewCopiedData((size_t)dims[0]*dims[1]*dims[2], dataType, grid_field_values);   
     ospCommit(voxelData);
     
     ospSetObject(volume, "data", voxelData);
@@ -90,97 +101,184 @@ load_as_structured(float *bbox, PluginResult &result,
     return volume_model;
 }
 
-static OSPVolumetricModel
-load_as_unstructured(
-    float *bbox, PluginResult &result,
-    const json &parameters, const glm::mat4 &object2world, 
-    const int32_t *dims, const std::string &voxelType, OSPDataType dataType, void *grid_field_values)
-{    
-    if (voxelType != "float")
-    {
-        fprintf(stderr, "... ERROR: OSPRay currently only supports unstructured volumes of 'float', not '%s'\n", voxelType.c_str());
-        return NULL;
-    }
-    
-    uint32_t num_grid_points = dims[0] * dims[1] * dims[2];
-    uint32_t num_hexahedrons = (dims[0]-1) * (dims[1]-1) * (dims[2]-1);
-        
-    // Set (transformed) vertices
-    
-    float       *vertices = new float[num_grid_points*3];
-    float       *v;
-    float       x, y, z;
-    glm::vec4   p;
-    
-    v = vertices;
-    for (int k = 0; k < dims[2]; k++)
-    {
-        z = k;
-        
-        for (int j = 0; j < dims[1]; j++)
+// Hexahedral cell indices only depend on the grid dimensions, so they're 
+// generated once and shared between all unstructured volumes (and time
+// steps) with the same dimensions. The cache owns the index arrays, which 
+// are passed to OSPRay as shared data. As volumes can outlive the plugin 
+// instance that created them, cached arrays are kept until the server 
+// exits, for at most HEX_TOPOLOGY_CACHE_SIZE different dimensions. Volumes 
+// of other dimensions get a copy of their indices.
+
+const int HEX_TOPOLOGY_CACHE_SIZE = 4;
+
+struct HexTopology
+{
+    int32_t                 dims[3];
+    std::vector<uint32_t>   indices;
+    OSPData                 data;
+};
+
+static std::list<HexTopology>   hex_topology_cache;
+static std::mutex               hex_topology_mutex;
+
+// Fills indices with the VTK_HEXAHEDRON ordered cell indices for a grid
+// of the given dimensions. The caller checks that the vertex indices fit
+// in 32 bits.
+static void
+generate_hex_topology(std::vector<uint32_t>& indices, const int32_t *dims)
+{
+    const size_t nx = dims[0]-1, ny = dims[1]-1, nz = dims[2]-1;
+    const size_t num_hexahedrons = nx * ny * nz;
+
+    printf("... Generating hexahedral topology (%zu cells)\n", num_hexahedrons);
+
+    indices.resize(num_hexahedrons*8);
+    uint32_t *hex_indices = indices.data();
+
+    const size_t ystep = dims[0];
+    const size_t zstep = (size_t)dims[0] * dims[1];
+
+    voxel_parallel_for(nz, [=](size_t begin, size_t end, int) {
+        for (size_t k = begin; k < end; k++)
         {
-            y = j;
-            
-            for (int i = 0; i < dims[0]; i++)
+            uint32_t *hex = hex_indices + k * ny * nx * 8;
+
+            for (size_t j = 0; j < ny; j++)
             {
-                x = i;
-                
-                p = object2world * glm::vec4(x, y, z, 1);
-                
-                v[0] = p[0];
-                v[1] = p[1];
-                v[2] = p[2];
-                
-                v += 3;
+                const size_t rowidx = k * zstep + j * ystep;
+
+                for (size_t i = 0; i < nx; i++)
+                {
+                    // VTK_HEXAHEDRON ordering
+
+                    const uint32_t baseidx = rowidx + i;
+
+                    hex[0] = baseidx;
+                    hex[1] = baseidx + 1;
+                    hex[2] = baseidx + ystep + 1;
+                    hex[3] = baseidx + ystep;
+
+                    hex[4] = baseidx + zstep;
+                    hex[5] = baseidx + zstep + 1;
+                    hex[6] = baseidx + zstep + ystep + 1;
+                    hex[7] = baseidx + zstep + ystep;
+
+                    hex += 8;
+                }
             }
         }
+    }, 2);
+}
+
+// Returns a new reference to the (committed) cell indices for a grid of 
+// the given dimensions
+static OSPData
+get_hex_topology(const int32_t *dims)
+{
+    std::lock_guard<std::mutex> lock(hex_topology_mutex);
+
+    for (HexTopology& topology : hex_topology_cache)
+    {
+        if (topology.dims[0] == dims[0] && topology.dims[1] == dims[1] && topology.dims[2] == dims[2])
+        {
+            printf("... Using cached hexahedral topology\n");
+            ospRetain(topology.data);
+            return topology.data;
+        }
     }
-    
-    // Set up hexahedral cells
-    
-    int     *indices = new int[num_hexahedrons*8];   
-    int     *hex = indices;
-    
-    const int ystep = dims[0];
-    const int zstep = dims[0] * dims[1];
-    
-    for (int k = 0; k < dims[2]-1; k++)
+
+    if (hex_topology_cache.size() == HEX_TOPOLOGY_CACHE_SIZE)
     {
-        for (int j = 0; j < dims[1]-1; j++)
+        std::vector<uint32_t> indices;
+        generate_hex_topology(indices, dims);
+
+        OSPData data = ospNewCopiedData(indices.size()/4, OSP_VEC4UI, indices.data());
+        ospCommit(data);
+
+        return data;
+    }
+
+    hex_topology_cache.push_back(HexTopology());
+
+    HexTopology& topology = hex_topology_cache.back();
+    memcpy(topology.dims, dims, 3*sizeof(int32_t));
+    generate_hex_topology(topology.indices, dims);
+
+    topology.data = ospNewSharedData(topology.indices.data(), OSP_VEC4UI, topology.indices.size()/4);
+    ospCommit(topology.data);
+
+    // One reference for the cache, one for the caller
+    ospRetain(topology.data);
+
+    return topology.data;
+}
+
+// Unstructured (hexahedral) volume of float values, with the grid vertices
+// transformed by grid2world. When share_values is true the values need to
+// stay alive as long as the volume is used. We support using an unstructured volume for 
+// now, as we can transform its vertices, as volumes currently don't support 
+// affine transformations in ospray themselves.
+static OSPVolume
+create_unstructured_volume(const int32_t *dims, OSPDataType dataType, const void *grid_field_values, 
+    const glm::mat4 &grid2world, bool share_values=false)
+{
+    const size_t num_grid_points = (size_t)dims[0] * dims[1] * dims[2];
+
+    // The cell indices are 32-bit
+    if (num_grid_points > UINT32_MAX)
+    {
+        fprintf(stderr, "... ERROR: too many grid points (%zu) for an unstructured volume\n", num_grid_points);
+        return nullptr;
+    }
+        
+    // Set transformed vertices. Per grid row the vertices are a start 
+    // point plus a multiple of the transformed i axis, which vectorizes well.
+    
+    float *vertices = new float[num_grid_points*3];
+
+    const glm::vec4 ci = grid2world[0], cj = grid2world[1], ck = grid2world[2], ct = grid2world[3];
+    const int nx = dims[0], ny = dims[1];
+
+    voxel_parallel_for(dims[2], [=](size_t begin, size_t end, int) {
+        for (size_t k = begin; k < end; k++)
         {
-            for (int i = 0; i < dims[0]-1; i++)
+            for (int j = 0; j < ny; j++)
             {
-                // VTK_HEXAHEDRON ordering
-                
-                int baseidx = k * zstep + j * ystep + i;
-                
-                hex[0] = baseidx;
-                hex[1] = baseidx + 1;
-                hex[2] = baseidx + ystep + 1;
-                hex[3] = baseidx + ystep;
-                
-                baseidx += zstep;
-                hex[4] = baseidx;
-                hex[5] = baseidx + 1;
-                hex[6] = baseidx + ystep + 1;
-                hex[7] = baseidx + ystep;
-                
-                hex += 8;
+                float *v = vertices + ((k * ny + j) * nx) * 3;
+
+                const float x0 = ct[0] + j*cj[0] + k*ck[0];
+                const float y0 = ct[1] + j*cj[1] + k*ck[1];
+                const float z0 = ct[2] + j*cj[2] + k*ck[2];
+
+                const float dx = ci[0], dy = ci[1], dz = ci[2];
+
+                for (int i = 0; i < nx; i++)
+                {
+                    v[3*i+0] = x0 + i*dx;
+                    v[3*i+1] = y0 + i*dy;
+                    v[3*i+2] = z0 + i*dz;
+                }
             }
         }
-    }
+    }, 2);
 
     // Set up volume object
     
     // XXX need to look closer at the specific alignment requirements of using OSP_FLOAT3A
     OSPData verticesData = ospNewCopiedData(num_grid_points, OSP_VEC3F, vertices);       
     ospCommit(verticesData);
+
+    delete [] vertices;
     
-    OSPData fieldData = ospNewCopiedData(num_grid_points, dataType, grid_field_values);   
+    OSPData fieldData;
+    
+    if (share_values)
+        fieldData = ospNewSharedData(grid_field_values, dataType, num_grid_points);
+    else
+        fieldData = ospNewCopiedData(num_grid_points, dataType, grid_field_values);   
     ospCommit(fieldData);
     
-    OSPData indicesData = ospNewCopiedData(num_hexahedrons*2, OSP_VEC4I, indices);
-    ospCommit(indicesData);
+    OSPData indicesData = get_hex_topology(dims);
     
     OSPVolume volume = ospNewVolume("unstructured_volume"); // XXX has been renamed?
     
@@ -196,6 +294,26 @@ load_as_unstructured(
         ospSetString(volume, "hexMethod", "planar");
 
     ospCommit(volume);
+
+    return volume;
+}
+
+static OSPVolumetricModel
+load_as_unstructured(
+    float *bbox, PluginResult &result,
+    const json &parameters, const glm::mat4 &object2world, 
+    const int32_t *dims, const std::string &voxelType, OSPDataType dataType, void *grid_field_values)
+{    
+    if (voxelType != "float")
+    {
+        fprintf(stderr, "... ERROR: OSPRay currently only supports unstructured volumes of 'float', not '%s'\n", voxelType.c_str());
+        return NULL;
+    }
+
+    OSPVolume volume = create_unstructured_volume(dims, dataType, grid_field_values, object2world);
+
+    if (volume == nullptr)
+        return NULL;
     
     OSPVolumetricModel volume_model = ospNewVolumetricModel(volume);
     ospCommit(volume_model);
@@ -229,13 +347,13 @@ load(float *bbox, float *data_range, PluginResult &result, const json &parameter
     // Dimensions
     
     int32_t dims[3];            // XXX why int and not uint?
-    uint32_t num_grid_points;
+    size_t num_grid_points;
     
     dims[0] = parameters["dimensions"][0];
     dims[1] = parameters["dimensions"][1];
     dims[2] = parameters["dimensions"][2];
     
-    num_grid_points = dims[0] * dims[1] * dims[2];
+    num_grid_points = (size_t)dims[0] * dims[1] * dims[2];
     
     // Open file
     
@@ -302,13 +420,13 @@ load(float *bbox, float *data_range, PluginResult &result, const json &parameter
         if (voxelType == "float")
         {
             float *falues = (float*)grid_field_values;
-            for (int i = 0; i < num_grid_points; i++)
+            for (size_t i = 0; i < num_grid_points; i++)
                 falues[i] = float_swap(falues[i]);        
         }
         else if (voxelType == "ushort")
         {
             uint16_t *falues = (uint16_t*)grid_field_values;
-            for (int i = 0; i < num_grid_points; i++)
+            for (size_t i = 0; i < num_grid_points; i++)
                 falues[i] = uint16_swap(falues[i]);    
         }
         else
@@ -366,13 +484,24 @@ load(float *bbox, float *data_range, PluginResult &result, const json &parameter
     return volume_model;
 }
 
-static OSPVolume
-create_volume(float *bbox, 
-    const json &parameters, const int32_t *dims, OSPDataType dataType, 
-    void *grid_field_values)
+// Voxel data mapped from the volume file or plugin cache, used directly by OSPRay
+struct MappedVoxels
 {
-    float origin[3] = { 0.0f, 0.0f, 0.0f };
-    float spacing[3] = { 1.0f, 1.0f, 1.0f };
+    void        *ptr;
+    size_t      size;
+
+    // The voxels within the mapping, for use by update()
+    void        *voxels;
+    size_t      num_voxels;
+    OSPDataType data_type;
+    float       bbox[6];
+};
+
+static void
+get_grid_placement(const json &parameters, float *origin, float *spacing)
+{
+    origin[0] = origin[1] = origin[2] = 0.0f;
+    spacing[0] = spacing[1] = spacing[2] = 1.0f;
     
     if (parameters.find("grid_origin") != parameters.end())
     {
@@ -389,10 +518,27 @@ create_volume(float *bbox,
         spacing[1] = s[1];
         spacing[2] = s[2];
     }
+}
+
+// If share_values is true grid_field_values needs to stay alive 
+// as long as the volume is used
+static OSPVolume
+create_volume(float *bbox, 
+    const json &parameters, const int32_t *dims, OSPDataType dataType, 
+    void *grid_field_values, bool share_values=false)
+{
+    float origin[3], spacing[3];
+
+    get_grid_placement(parameters, origin, spacing);
     
     OSPVolume volume = ospNewVolume("structured_regular");
     
-        OSPData voxelData = ospNewCopiedData(dims[0]*dims[1]*dims[2], dataType, grid_field_values);   
+        OSPData voxelData;
+        
+        if (share_values)
+            voxelData = ospNewSharedData(grid_field_values, dataType, (size_t)dims[0]*dims[1]*dims[2]);
+        else
+            voxelData = ospNewCopiedData((size_t)dims[0]*dims[1]*dims[2], dataType, grid_field_values);   
         ospCommit(voxelData);
     
         ospSetObject(volume, "data", voxelData);
@@ -421,163 +567,398 @@ create_volume(float *bbox,
 
 
 
-template <typename T>
-void get_value_range(const T* values, int n, float& minval, float& maxval)
+// Structured volume, or an unstructured one when requested with
+// make_unstructured (which needs float voxels). Returns nullptr on failure.
+static OSPVolume
+create_grid_volume(float *bbox, 
+    const json &parameters, const int32_t *dims, OSPDataType dataType, 
+    void *grid_field_values, bool share_values=false)
 {
-    float min = std::numeric_limits<float>::max();
-    float max = std::numeric_limits<float>::min();
+    if (parameters.find("make_unstructured") == parameters.end() || !parameters["make_unstructured"].get<int>())
+        return create_volume(bbox, parameters, dims, dataType, grid_field_values, share_values);
 
-    for (int i = 0; i < n; i++)
+    if (dataType != OSP_FLOAT)
     {
-        min = std::min(min, (float)(values[i]));
-        max = std::max(max, (float)(values[i]));
-    }    
+        fprintf(stderr, "... WARNING: OSPRay currently only supports unstructured volumes of 'float', creating structured volume\n");
+        return create_volume(bbox, parameters, dims, dataType, grid_field_values, share_values);
+    }
 
-    minval = min;
-    maxval = max;
-}
+    float origin[3], spacing[3];
 
-template <typename T>
-void convert_to_float(float *float_values, const T* values, int n)
-{
-    for (int i = 0; i < n; i++)
-        float_values[i] = (float)(values[i]);
+    get_grid_placement(parameters, origin, spacing);
+
+    glm::mat4 grid2world(1.0f);
+
+    for (int i = 0; i < 3; i++)
+    {
+        grid2world[i][i] = spacing[i];
+        grid2world[3][i] = origin[i];
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        bbox[i] = origin[i];
+        bbox[3+i] = origin[i] + dims[i] * spacing[i];
+    }
+
+    return create_unstructured_volume(dims, dataType, grid_field_values, grid2world, share_values);
 }
 
-template <typename T>
-void map_values(T* values, int n, float scale, float offset)
+// Sets state->volume_lod, if requested in the parameters
+static void
+add_lod_volume(PluginState *state, const json &parameters, const int32_t *dims, 
+    OSPDataType dataType, const void *voxels, const float *bbox)
 {
-    float m;
-    for (int i = 0; i < n; i++)
+    const int factor = volume_lod_factor(parameters);
+    
+    if (factor == 1)
+        return;
+    
+    float origin[3], spacing[3];
+    
+    for (int i = 0; i < 3; i++)
     {
-        m = (float)(values[i]) * scale + offset;
-        values[i] = (T)m;
+        origin[i] = bbox[i];
+        spacing[i] = (bbox[3+i] - bbox[i]) / dims[i];
     }
+    
+    state->volume_lod = volume_lod_create(voxels, dataType, dims, origin, spacing, factor);
 }
 
-extern "C"
-void
-generate(PluginResult &result, PluginState *state)
+// Distributed rendering: restricts the parameters to the domain's slab
+// of z slices, plus one ghost slice above it so the slabs of neighbouring
+// ranks interpolate across their shared boundary. Sets the domain bounds
+// (without the ghost slice).
+static json
+get_domain_parameters(PluginState *state, const json& parameters)
+{
+    json domain_parameters = parameters;
+
+    const std::string voxelType = parameters["voxel_type"].get<std::string>();
+    off_t voxel_size;
+
+    if (voxelType == "uchar")
+        voxel_size = 1;
+    else if (voxelType == "ushort" || voxelType == "short")
+        voxel_size = 2;
+    else if (voxelType == "float")
+        voxel_size = 4;
+    else if (voxelType == "double")
+        voxel_size = 8;
+    else
+        // Reported by generate_volume()
+        return domain_parameters;
+
+    const int32_t nx = parameters["dimensions"][0];
+    const int32_t ny = parameters["dimensions"][1];
+    const int32_t nz = parameters["dimensions"][2];
+
+    int k0, k1;
+    plugin_domain_range(state, nz, k0, k1);
+
+    const int k1_ghost = std::min(nz, k1 + 1);
+
+    float origin[3], spacing[3];
+    get_grid_placement(parameters, origin, spacing);
+
+    domain_parameters["dimensions"][2] = k1_ghost - k0;
+    domain_parameters["header_skip"] = parameters["header_skip"].get<off_t>() + (off_t)k0 * nx * ny * voxel_size;
+    domain_parameters["grid_origin"] = { origin[0], origin[1], origin[2] + k0 * spacing[2] };
+
+    plugin_set_domain_bounds(state, 
+        origin[0], origin[1], origin[2] + k0 * spacing[2],
+        origin[0] + nx * spacing[0], origin[1] + ny * spacing[1], origin[2] + k1 * spacing[2]);
+
+    printf("... Domain %d of %d: slices %d-%d (plus %d ghost)\n", 
+        state->domain_index, state->num_domains, k0, k1-1, k1_ghost - k1);
+
+    if (parameters.find("data_range") == parameters.end())
+        printf("... WARNING: no data_range provided, the derived range will differ per domain\n");
+
+    return domain_parameters;
+}
+
+static void
+generate_volume(PluginResult &result, PluginState *state, const json& parameters)
 {
-    const json& parameters = state->parameters;
-    
     char msg[1024];
         
     // Dimensions
     
     int32_t dims[3];            // XXX why int and not uint?
-    uint32_t num_grid_points;
+    size_t num_grid_points;
     
     dims[0] = parameters["dimensions"][0];
     dims[1] = parameters["dimensions"][1];
     dims[2] = parameters["dimensions"][2];
     
-    num_grid_points = dims[0] * dims[1] * dims[2];
+    num_grid_points = (size_t)dims[0] * dims[1] * dims[2];
 
-    printf("... %d x %d x %d (%d values)\n", dims[0], dims[1], dims[2], num_grid_points);
-    
-    // Open file
+    printf("... %d x %d x %d (%zu values)\n", dims[0], dims[1], dims[2], num_grid_points);
     
     std::string fname = parameters["file"].get<std::string>();
-    
-    FILE *f = fopen(fname.c_str(), "rb");
-    if (!f)
+
+    float bbox[6];
+
+    // Use the voxels from the plugin cache, if available. These are 
+    // stored after endian-flipping and value mapping.
+
+    json cached;
+
+    if (plugin_cache_load(state, cached, {fname}))
     {
-        snprintf(msg, 1024, "Could not open file '%s'", fname.c_str());
-        result.set_success(false);
-        result.set_message(msg);
-        fprintf(stderr, "... ERROR: %s\n", msg);
-        return;
-    }
+        MappedVoxels *mapped = new MappedVoxels;
 
-    // XXX check return value
-    fseek(f, parameters["header_skip"].get<int>(), SEEK_SET);
-    
-    // Prepare data array and read data from file
+        mapped->ptr = plugin_cache_map_array(state, "voxels", mapped->size);
+
+        if (mapped->ptr != nullptr && mapped->size == cached["size"].get<size_t>())
+        {
+            PluginOSPRayLock lock(state);
+
+            OSPVolume volume = create_grid_volume(bbox, parameters, dims, 
+                (OSPDataType)cached["data_type"].get<int>(), mapped->ptr, true);
+
+            if (volume == nullptr)
+            {
+                plugin_cache_unmap_array(mapped->ptr, mapped->size);
+                delete mapped;
+                result.set_success(false);
+                result.set_message("Volume preparation failed");
+                return;
+            }
+
+            mapped->voxels = mapped->ptr;
+            mapped->num_voxels = num_grid_points;
+            mapped->data_type = (OSPDataType)cached["data_type"].get<int>();
+            memcpy(mapped->bbox, bbox, 6*sizeof(float));
+
+            state->data = mapped;
+            state->volume = volume;
+            state->volume_data_range[0] = cached["data_range"][0];
+            state->volume_data_range[1] = cached["data_range"][1];
+            state->memory_size = mapped->size;
+
+            add_lod_volume(state, parameters, dims, 
+                (OSPDataType)cached["data_type"].get<int>(), mapped->ptr, bbox);
+
+            state->bound = BoundingMesh::bbox(
+                bbox[0], bbox[1], bbox[2],
+                bbox[3], bbox[4], bbox[5],
+                true
+            );
+
+            return;
+        }
+
+        printf("... WARNING: cached voxel data not usable, reading from file\n");
+        plugin_cache_unmap_array(mapped->ptr, mapped->size);
+        delete mapped;
+    }
     
+    // Determine voxel type
+
     OSPDataType dataType;
-    void *grid_field_values;
-    uint32_t read_size;
-    
+    int voxel_size;
+
     std::string voxelType = parameters["voxel_type"].get<std::string>();    // XXX rename parameter?
-    
+
     if (voxelType == "uchar")
     {
-        grid_field_values = new uint8_t[num_grid_points];
         dataType = OSP_UCHAR;
-        read_size = num_grid_points;
+        voxel_size = 1;
     }
     else if (voxelType == "ushort")
     {
-        grid_field_values = new uint16_t[num_grid_points];
         dataType = OSP_USHORT;
-        read_size = num_grid_points*sizeof(uint16_t);
-    } 
+        voxel_size = sizeof(uint16_t);
+    }
     else if (voxelType == "short")
     {
-        grid_field_values = new int16_t[num_grid_points];
         dataType = OSP_SHORT;
-        read_size = num_grid_points*sizeof(int16_t);
-    }        
+        voxel_size = sizeof(int16_t);
+    }
     else if (voxelType == "float")
     {
-        grid_field_values = new float[num_grid_points];
         dataType = OSP_FLOAT;
-        read_size = num_grid_points*sizeof(float);
+        voxel_size = sizeof(float);
     }
     else if (voxelType == "double")
     {
-        grid_field_values = new double[num_grid_points];
         dataType = OSP_DOUBLE;
-        read_size = num_grid_points*sizeof(double);
+        voxel_size = sizeof(double);
     }
-    else 
+    else
     {
         snprintf(msg, 1024, "ERROR: unhandled voxel data type '%s'!\n", voxelType.c_str());
         result.set_success(false);
         result.set_message(msg);
         fprintf(stderr, "... %s\n", msg);
-        fclose(f);
         return;
     }
-    
-    // Read the actual voxel data
 
-    // XXX check bytes read
-    int actual_size = fread(grid_field_values, 1, read_size, f);
-    
-    fclose(f);
+    const size_t read_size = (size_t)num_grid_points * voxel_size;
+    const off_t header_skip = parameters["header_skip"].get<off_t>();
 
-    if (actual_size != read_size)
-        printf("... WARNING: expected to read %d bytes from file, got only %d!\n", read_size, actual_size);
-    
-    // Endian-flip if needed
+    const bool endian_flip = parameters.find("endian_flip") != parameters.end() && parameters["endian_flip"].get<int>();
+    const bool map_data = parameters.find("value_scale") != parameters.end() || parameters.find("value_offset") != parameters.end();
 
-    if (parameters.find("endian_flip") != parameters.end() && parameters["endian_flip"].get<int>())
+    // When the voxels can be used as stored in the file we map the
+    // file and let OSPRay use the mapped pages directly. This avoids
+    // holding the volume in memory twice, and only needs to read
+    // (the parts of) the file that actually get used.
+
+    bool use_mmap = !endian_flip && !map_data && (header_skip % voxel_size) == 0;
+
+    if (parameters.find("mmap") != parameters.end() && !parameters["mmap"].get<int>())
+        use_mmap = false;
+
+    if (use_mmap)
     {
-        if (voxelType == "float")
+        int fd = open(fname.c_str(), O_RDONLY);
+        if (fd == -1)
         {
-            float *falues = (float*)grid_field_values;
-            for (int i = 0; i < num_grid_points; i++)
-                falues[i] = float_swap(falues[i]);        
+            snprintf(msg, 1024, "Could not open file '%s'", fname.c_str());
+            result.set_success(false);
+            result.set_message(msg);
+            fprintf(stderr, "... ERROR: %s\n", msg);
+            return;
         }
-        // XXX handle double swap
-        else if (voxelType == "ushort")
+
+        struct stat st;
+        fstat(fd, &st);
+
+        if (st.st_size < header_skip + (off_t)read_size)
         {
-            uint16_t *falues = (uint16_t*)grid_field_values;
-            for (int i = 0; i < num_grid_points; i++)
-                falues[i] = uint16_swap(falues[i]);    
+            close(fd);
+            snprintf(msg, 1024, "File '%s' is too small (%ld bytes) for %ld header bytes plus %ld bytes of voxel data",
+                fname.c_str(), (long)st.st_size, (long)header_skip, (long)read_size);
+            result.set_success(false);
+            result.set_message(msg);
+            fprintf(stderr, "... ERROR: %s\n", msg);
+            return;
         }
-        else if (voxelType == "short")
+
+        // The mapping offset needs to be page-aligned, so simply
+        // map (part of) the header as well
+        const off_t page_size = sysconf(_SC_PAGESIZE);
+        const off_t map_offset = header_skip - header_skip % page_size;
+
+        MappedVoxels *mapped = new MappedVoxels;
+
+        mapped->size = header_skip - map_offset + read_size;
+        mapped->ptr = mmap(nullptr, mapped->size, PROT_READ, MAP_SHARED, fd, map_offset);
+
+        close(fd);
+
+        if (mapped->ptr == MAP_FAILED)
         {
-            int16_t *falues = (int16_t*)grid_field_values;
-            for (int i = 0; i < num_grid_points; i++)
-                falues[i] = int16_swap(falues[i]);  
+            perror("mmap() of volume file failed");
+            delete mapped;
+            snprintf(msg, 1024, "Could not memory-map file '%s'", fname.c_str());
+            result.set_success(false);
+            result.set_message(msg);
+            fprintf(stderr, "... ERROR: %s\n", msg);
+            return;
+        }
+
+        void *voxels = (uint8_t*)mapped->ptr + (header_skip - map_offset);
+
+        printf("... Memory-mapped %ld bytes of voxel data\n", (long)read_size);
+
+        float minval, maxval;
+
+        if (parameters.find("data_range") != parameters.end())
+        {
+            minval = parameters["data_range"][0];
+            maxval = parameters["data_range"][1];
+
+            printf("... User-provided input data range %.6f, %.6f\n", minval, maxval);
         }
         else
-            fprintf(stderr, "... WARNING: no endian flip available for data type '%s'!\n", voxelType.c_str());
+        {
+            // Note: this touches all pages (once)
+            printf("... No data range, provided, deriving from voxel data\n");
+
+            if (voxelType == "uchar")
+                voxel_value_range((uint8_t*)voxels, num_grid_points, minval, maxval);
+            else if (voxelType == "ushort")
+                voxel_value_range((uint16_t*)voxels, num_grid_points, minval, maxval);
+            else if (voxelType == "short")
+                voxel_value_range((int16_t*)voxels, num_grid_points, minval, maxval);
+            else if (voxelType == "float")
+                voxel_value_range((float*)voxels, num_grid_points, minval, maxval);
+            else if (voxelType == "double")
+                voxel_value_range((double*)voxels, num_grid_points, minval, maxval);
+
+            printf("... Input data range derived from data %.6f, %.6f\n", minval, maxval);
+        }
+
+        PluginOSPRayLock lock(state);
+
+        OSPVolume volume = create_grid_volume(bbox, parameters, dims, dataType, voxels, true);
+
+        if (volume == nullptr)
+        {
+            munmap(mapped->ptr, mapped->size);
+            delete mapped;
+            result.set_success(false);
+            result.set_message("Volume preparation failed");
+            return;
+        }
+
+        mapped->voxels = voxels;
+        mapped->num_voxels = num_grid_points;
+        mapped->data_type = dataType;
+        memcpy(mapped->bbox, bbox, 6*sizeof(float));
+
+        state->data = mapped;
+        state->volume = volume;
+        state->volume_data_range[0] = minval;
+        state->volume_data_range[1] = maxval;
+        state->memory_size = read_size;
+        
+        add_lod_volume(state, parameters, dims, dataType, voxels, bbox);
+
+        state->bound = BoundingMesh::bbox(
+            bbox[0], bbox[1], bbox[2],
+            bbox[3], bbox[4], bbox[5],
+            true
+        );
+
+        return;
+    }
+
+    // Open file
+
+    FILE *f = fopen(fname.c_str(), "rb");
+    if (!f)
+    {
+        snprintf(msg, 1024, "Could not open file '%s'", fname.c_str());
+        result.set_success(false);
+        result.set_message(msg);
+        fprintf(stderr, "... ERROR: %s\n", msg);
+        return;
     }
 
+    // XXX check return value
+    fseek(f, header_skip, SEEK_SET);
+
+    // Read the actual voxel data
+
+    void *grid_field_values = new uint8_t[read_size];
+
+    size_t actual_size = fread(grid_field_values, 1, read_size, f);
+
+    fclose(f);
+
+    if (actual_size != read_size)
+        printf("... WARNING: expected to read %ld bytes from file, got only %ld!\n", (long)read_size, (long)actual_size);
+
+    // Endian-flip if needed
+
+    if (endian_flip)
+        voxel_byte_swap(grid_field_values, num_grid_points, voxel_size);
+
 #if 0
     // XXX for now, convert to floats, as it seems not all types works well
     if (voxelType != "float")        
@@ -589,22 +970,22 @@ generate(PluginResult &result, PluginState *state)
         // XXX really need to look into a better (templated) way of doing this
         if (voxelType == "uchar")
         {
-            convert_to_float(new_values, (uint8_t*)grid_field_values, num_grid_points);
+            voxel_convert_to_float(new_values, (uint8_t*)grid_field_values, num_grid_points);
             delete [] (uint8_t*)grid_field_values;
         }
         else if (voxelType == "ushort") 
         {           
-            convert_to_float(new_values, (uint16_t*)grid_field_values, num_grid_points);
+            voxel_convert_to_float(new_values, (uint16_t*)grid_field_values, num_grid_points);
             delete [] (uint16_t*)grid_field_values;
         }
         else if (voxelType == "float")            
         {
-            convert_to_float(new_values, (float*)grid_field_values, num_grid_points);
+            voxel_convert_to_float(new_values, (float*)grid_field_values, num_grid_points);
             delete [] (float*)grid_field_values;
         }
         else if (voxelType == "double")            
         {
-            convert_to_float(new_values, (double*)grid_field_values, num_grid_points);    
+            voxel_convert_to_float(new_values, (double*)grid_field_values, num_grid_points);    
             delete [] (double*)grid_field_values;
         }
 
@@ -631,48 +1012,42 @@ generate(PluginResult &result, PluginState *state)
         
         // XXX really need to look into a better (templated) way of doing this
         if (voxelType == "uchar")
-            get_value_range((uint8_t*)grid_field_values, num_grid_points, minval, maxval);
+            voxel_value_range((uint8_t*)grid_field_values, num_grid_points, minval, maxval);
         else if (voxelType == "ushort")            
-            get_value_range((uint16_t*)grid_field_values, num_grid_points, minval, maxval);
+            voxel_value_range((uint16_t*)grid_field_values, num_grid_points, minval, maxval);
         else if (voxelType == "short")            
-            get_value_range((int16_t*)grid_field_values, num_grid_points, minval, maxval);
+            voxel_value_range((int16_t*)grid_field_values, num_grid_points, minval, maxval);
         else if (voxelType == "float")            
-            get_value_range((float*)grid_field_values, num_grid_points, minval, maxval);
+            voxel_value_range((float*)grid_field_values, num_grid_points, minval, maxval);
         else if (voxelType == "double")            
-            get_value_range((double*)grid_field_values, num_grid_points, minval, maxval);
+            voxel_value_range((double*)grid_field_values, num_grid_points, minval, maxval);
         
         printf("... Input data range derived from data %.6f, %.6f\n", minval, maxval);
     }
     
     float value_scale = 1.0f;
     float value_offset = 0.0f;
-    bool map_data = false;
     
     if (parameters.find("value_scale") != parameters.end())
-    {
         value_scale = parameters["value_scale"].get<float>();    
-        map_data = true;
-    }
     
     if (parameters.find("value_offset") != parameters.end())
-    {
         value_offset = parameters["value_offset"].get<float>();
-        map_data = true;
-    }
     
     if (map_data)
     {
         printf("... Mapping values with scale %.6f, offset %.6f\n", value_scale, value_offset);
         
         if (voxelType == "uchar")
-            map_values((uint8_t*)grid_field_values, num_grid_points, value_scale, value_offset);
+            voxel_map_values((uint8_t*)grid_field_values, num_grid_points, value_scale, value_offset);
         else if (voxelType == "ushort")            
-            map_values((uint16_t*)grid_field_values, num_grid_points, value_scale, value_offset);
+            voxel_map_values((uint16_t*)grid_field_values, num_grid_points, value_scale, value_offset);
         else if (voxelType == "short")           
-            map_values((int16_t*)grid_field_values, num_grid_points, value_scale, value_offset);
+            voxel_map_values((int16_t*)grid_field_values, num_grid_points, value_scale, value_offset);
         else if (voxelType == "float")            
-            map_values((float*)grid_field_values, num_grid_points, value_scale, value_offset);
-        //else if (voxelType == "double")    
+            voxel_map_values((float*)grid_field_values, num_grid_points, value_scale, value_offset);
+        else if (voxelType == "double")
+            voxel_map_values((double*)grid_field_values, num_grid_points, value_scale, value_offset);
         
         // XXX will be in wrong order when value_scale < 0
         printf("... Mapped range %.6f %.6f\n", minval*value_scale+value_offset, maxval*value_scale+value_offset);
@@ -686,7 +1061,7 @@ generate(PluginResult &result, PluginState *state)
         uint16_t *unsigned_values = new uint16_t[num_grid_points];
         
         // XXX should clamp here
-        for (int i = 0; i < num_grid_points; i++)
+        for (size_t i = 0; i < num_grid_points; i++)
             unsigned_values[i] = (uint16_t)signed_values[i];
         
         delete [] signed_values;
@@ -694,47 +1069,46 @@ generate(PluginResult &result, PluginState *state)
     }
 #endif    
 
+    // Store in the plugin cache (if enabled), for next time
+
+    if (plugin_cache_store_array(state, "voxels", grid_field_values, read_size))
+    {
+        json values;
+        values["size"] = read_size;
+        values["data_type"] = (int)dataType;
+        values["data_range"] = { minval, maxval };
+        plugin_cache_save(state, values, {fname});
+    }
+
     // Set up volume object
     
+    PluginOSPRayLock lock(state);
+
     OSPVolume volume;
     
-    float bbox[6];
-    
-    /*
-    if (parameters.find("make_unstructured") != parameters.end() && parameters["make_unstructured"].get<int>())
-    {
-        // We support using an unstructured volume for now, as we can transform its
-        // vertices with the object2world matrix, as volumes currently don't
-        // support affine transformations in ospray themselves.
-        volume_model = load_as_unstructured(  
-                    bbox, result,
-                    parameters, object2world, 
-                    dims, voxelType, dataType, grid_field_values);
-    }
-    else
-    {
-        volume_model = load_as_structured(
-                    bbox, result,
-                    parameters, object2world, 
-                    dims, voxelType, dataType, grid_field_values);
-    }
-    */
-    
-    volume = create_volume(bbox, parameters, dims, dataType, grid_field_values);
+    volume = create_grid_volume(bbox, parameters, dims, dataType, grid_field_values);
     
     if (!volume)
     {
         fprintf(stderr, "... ERROR: volume preparation failed!\n");
+        delete [] (uint8_t*)grid_field_values;
+        result.set_success(false);
+        result.set_message("Volume preparation failed");
         return;
     }
     
     ospCommit(volume);
     
-    // XXX delete grid values array
+    add_lod_volume(state, parameters, dims, dataType, grid_field_values, bbox);
+    
+    // Values were copied by OSPRay
+    delete [] (uint8_t*)grid_field_values;
     
     state->volume = volume;
     state->volume_data_range[0] = minval;
     state->volume_data_range[1] = maxval;    
+    // The copy held by OSPRay
+    state->memory_size = read_size;
     
     state->bound = BoundingMesh::bbox(
         bbox[0], bbox[1], bbox[2],
@@ -743,6 +1117,39 @@ generate(PluginResult &result, PluginState *state)
     );
 }
 
+extern "C"
+void
+generate(PluginResult &result, PluginState *state)
+{
+    const json& parameters = state->parameters;
+
+    if (state->num_domains == 1)
+    {
+        generate_volume(result, state, parameters);
+        return;
+    }
+
+    generate_volume(result, state, get_domain_parameters(state, parameters));
+
+    if (!result.success || state->bound == nullptr)
+        return;
+
+    // The bound is that of the complete volume, as shown in Blender
+
+    float origin[3], spacing[3];
+    get_grid_placement(parameters, origin, spacing);
+
+    delete state->bound;
+
+    state->bound = BoundingMesh::bbox(
+        origin[0], origin[1], origin[2],
+        origin[0] + parameters["dimensions"][0].get<int>() * spacing[0],
+        origin[1] + parameters["dimensions"][1].get<int>() * spacing[1],
+        origin[2] + parameters["dimensions"][2].get<int>() * spacing[2],
+        true
+    );
+}
+
 
 // XXX header_skip -> header-skip?
 static PluginParameters 
@@ -782,9 +1189,131 @@ parameters = {
     {"value_offset",         PARAM_FLOAT,    1, FLAG_OPTIONAL, 
         "Offset to apply to values"},
         
+    {"mmap",                /*PARAM_BOOL*/ PARAM_INT,     1, FLAG_OPTIONAL, 
+        "Memory-map the file instead of reading it, when no endian flip or value mapping is needed (default 1)"},
+        
+    {"lod_factor",          PARAM_INT,      1, FLAG_OPTIONAL, 
+        "Downsampling factor of the lower-resolution volume used for interactive rendering (default: none)"},
+        
     PARAMETERS_DONE         // Sentinel (signals end of list)
 };
 
+static void
+clear_data(PluginState *state)
+{
+    MappedVoxels *mapped = (MappedVoxels*)state->data;
+
+    // The volume uses the mapped voxels, but releasing our reference 
+    // doesn't mean it goes away: scene objects (of any session) might 
+    // still hold it. So first give it a copy of the voxels, which 
+    // outlives the mapping. When nothing else holds the volume the copy
+    // is freed by the release below. The LOD volume always holds its 
+    // own copy.
+    if (state->volume != nullptr)
+    {
+        const json& parameters = state->parameters;
+        const bool unstructured = parameters.find("make_unstructured") != parameters.end() 
+            && parameters["make_unstructured"].get<int>() && mapped->data_type == OSP_FLOAT;
+
+        OSPData voxelData = ospNewCopiedData(mapped->num_voxels, mapped->data_type, mapped->voxels);
+        ospCommit(voxelData);
+        ospSetObject(state->volume, unstructured ? "field" : "data", voxelData);
+        ospRelease(voxelData);
+        ospCommit(state->volume);
+
+        ospRelease(state->volume);
+        state->volume = nullptr;
+    }
+
+    plugin_cache_unmap_array(mapped->ptr, mapped->size);
+    delete mapped;
+
+    state->data = nullptr;
+}
+
+// Changes in data range and LOD factor are handled in place. Deriving
+// the data range or a LOD volume needs the voxels, which we only still
+// have when they're mapped.
+static bool
+update(PluginResult &result, PluginState *state, const json &old_parameters, const json &new_parameters)
+{
+    if (!plugin_parameters_differ_only_in(old_parameters, new_parameters, {"data_range", "lod_factor"}))
+        return false;
+
+    MappedVoxels *mapped = (MappedVoxels*)state->data;
+
+    const bool derive_range = new_parameters.find("data_range") == new_parameters.end() 
+        && old_parameters.find("data_range") != old_parameters.end();
+    const bool new_lod = volume_lod_factor(new_parameters) != volume_lod_factor(old_parameters);
+
+    if ((derive_range || new_lod) && mapped == nullptr)
+        return false;
+
+    // In distributed mode the mapping only holds the domain's slab, which
+    // generate() handles, so do a full reload for anything touching voxels
+    if ((derive_range || new_lod) && state->num_domains > 1)
+        return false;
+
+    int32_t dims[3];
+
+    dims[0] = new_parameters["dimensions"][0];
+    dims[1] = new_parameters["dimensions"][1];
+    dims[2] = new_parameters["dimensions"][2];
+
+    const size_t num_grid_points = (size_t)dims[0] * dims[1] * dims[2];
+
+    if (new_parameters.find("data_range") != new_parameters.end())
+    {
+        state->volume_data_range[0] = new_parameters["data_range"][0];
+        state->volume_data_range[1] = new_parameters["data_range"][1];
+
+        printf("... User-provided input data range %.6f, %.6f\n", state->volume_data_range[0], state->volume_data_range[1]);
+    }
+    else if (derive_range)
+    {
+        float minval, maxval;
+
+        switch (mapped->data_type)
+        {
+        case OSP_UCHAR:
+            voxel_value_range((uint8_t*)mapped->voxels, num_grid_points, minval, maxval);
+            break;
+        case OSP_USHORT:
+            voxel_value_range((uint16_t*)mapped->voxels, num_grid_points, minval, maxval);
+            break;
+        case OSP_SHORT:
+            voxel_value_range((int16_t*)mapped->voxels, num_grid_points, minval, maxval);
+            break;
+        case OSP_FLOAT:
+            voxel_value_range((float*)mapped->voxels, num_grid_points, minval, maxval);
+            break;
+        case OSP_DOUBLE:
+            voxel_value_range((double*)mapped->voxels, num_grid_points, minval, maxval);
+            break;
+        default:
+            return false;
+        }
+
+        state->volume_data_range[0] = minval;
+        state->volume_data_range[1] = maxval;
+
+        printf("... Input data range derived from data %.6f, %.6f\n", minval, maxval);
+    }
+
+    if (new_lod)
+    {
+        if (state->volume_lod != nullptr)
+        {
+            ospRelease(state->volume_lod);
+            state->volume_lod = nullptr;
+        }
+
+        add_lod_volume(state, new_parameters, dims, mapped->data_type, mapped->voxels, mapped->bbox);
+    }
+
+    return true;
+}
+
 static PluginFunctions
 functions = {
 
@@ -792,13 +1321,15 @@ functions = {
     NULL,           // Plugin unload
     
     generate,       // Generate    
-    NULL,           // Clear data
+    clear_data,     // Clear data
+    update,         // Update
 };
 
 extern "C" bool
 initialize(PluginDefinition *def)
 {
     def->type = PT_VOLUME;
+    def->thread_safe = true;
     def->uses_renderer_type = false;
     def->parameters = parameters;
     def->functions = functions;
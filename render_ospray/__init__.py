@@ -48,7 +48,7 @@ from struct import unpack
 import bpy, bgl
 import numpy
 
-from .common import send_protobuf, receive_protobuf, OSP_FB_RGBA32F
+from .common import send_protobuf, receive_protobuf, OSP_FB_RGBA32F, OSP_FB_SRGBA
 from .sync import BlenderCamera, sync_view
 from .connection import Connection
 from .messages_pb2 import (
@@ -57,6 +57,16 @@ from .messages_pb2 import (
     WorldSettings, CameraSettings, LightSettings, RenderSettings,
 )
 
+# Optional framebuffer decompression
+try:
+    import lz4.block
+except ImportError:
+    lz4 = None
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
 # bpy.app.background
 
 HOST = 'localhost'
@@ -91,6 +101,107 @@ def setup_logging(logger_name, logfile, console=True):
 setup_logging('blospray', 'blospray.log')
 
 
+def interactive_framebuffer_settings(ospray, log):
+    """
+    Returns (OSPFrameBufferFormat, RenderResult.Encoding flags, tile threshold) 
+    for interactive rendering
+    """
+
+    format = OSP_FB_RGBA32F
+    encoding = RenderResult.RAW
+
+    if ospray.viewport_pixel_format == 'RGBA16F':
+        encoding |= RenderResult.HALF_FLOAT
+    elif ospray.viewport_pixel_format == 'SRGBA':
+        format = OSP_FB_SRGBA
+
+    if ospray.viewport_compression == 'LZ4':
+        if lz4 is not None:
+            encoding |= RenderResult.LZ4
+        else:
+            log.warning('LZ4 compression requested, but the lz4 module is not available')
+    elif ospray.viewport_compression == 'ZSTD':
+        if zstandard is not None:
+            encoding |= RenderResult.ZSTD
+        else:
+            log.warning('Zstandard compression requested, but the zstandard module is not available')
+
+    if ospray.viewport_tiles:
+        encoding |= RenderResult.TILES
+
+    return format, encoding, ospray.viewport_tile_threshold
+
+
+# sRGB 8-bit -> linear float
+SRGB_TO_LINEAR = numpy.arange(256, dtype=numpy.float32) / 255.0
+SRGB_TO_LINEAR = numpy.where(SRGB_TO_LINEAR <= 0.04045, 
+    SRGB_TO_LINEAR / 12.92, ((SRGB_TO_LINEAR + 0.055) / 1.055) ** 2.4).astype(numpy.float32)
+
+def decompress_framebuffer(render_result, data):
+    """Undo compression of received framebuffer data (uint8 array), if any"""
+
+    encoding = render_result.encoding
+
+    if encoding & RenderResult.LZ4:
+        data = lz4.block.decompress(data.tobytes(), uncompressed_size=render_result.pixels_size)
+        data = numpy.frombuffer(data, dtype=numpy.uint8)
+    elif encoding & RenderResult.ZSTD:
+        data = zstandard.ZstdDecompressor().decompress(data.tobytes(), max_output_size=render_result.pixels_size)
+        data = numpy.frombuffer(data, dtype=numpy.uint8)
+
+    return data
+
+def decode_pixels(render_result, data):
+    """
+    Turn (decompressed) pixel data (as uint8 array) into linear 
+    RGBA float32 pixels, based on the format and encoding in the 
+    RenderResult
+    """
+
+    encoding = render_result.encoding
+
+    if render_result.format == OSP_FB_RGBA32F:
+        if encoding & RenderResult.HALF_FLOAT:
+            return data.view(numpy.float16).astype(numpy.float32)
+        return data.view(numpy.float32)
+
+    # 8-bit formats    
+    pixels = numpy.empty(data.shape[0], dtype=numpy.float32)
+    if render_result.format == OSP_FB_SRGBA:
+        pixels[:] = SRGB_TO_LINEAR[data]
+    else:
+        pixels[:] = data / 255.0
+    # Alpha is always linear
+    pixels[3::4] = data[3::4] / 255.0
+
+    return pixels
+
+def patch_tiles(render_result, data, framebuffer):
+    """
+    Update framebuffer (float32 RGBA array, modified in-place) with 
+    the changed tiles in the received data (RenderResult.TILES)
+    """
+
+    width, height = render_result.width, render_result.height
+    tile_size = render_result.tile_size
+    num_tiles = render_result.num_tiles
+    tiles_x = (width + tile_size - 1) // tile_size
+
+    indices = data[:4*num_tiles].view(numpy.uint32)
+    pixels = decode_pixels(render_result, data[4*num_tiles:])
+    image = framebuffer.reshape((height, width, 4))
+
+    offset = 0
+    for t in indices:
+        x0 = (t % tiles_x) * tile_size
+        y0 = (t // tiles_x) * tile_size
+        x1 = min(x0 + tile_size, width)
+        y1 = min(y0 + tile_size, height)
+        n = (x1-x0) * (y1-y0) * 4
+        image[y0:y1, x0:x1] = pixels[offset:offset+n].reshape((y1-y0, x1-x0, 4))
+        offset += n
+
+
 class ReceiveRenderResultThread(threading.Thread):
 
     """
@@ -133,6 +244,8 @@ class ReceiveRenderResultThread(threading.Thread):
 
         framebuffer = None
         fbview = None
+        # Last complete frame, for applying tile updates
+        current_framebuffer = None
 
         # h = receive protobuf length header
         # r = receive RenderResult protobuf
@@ -234,6 +347,25 @@ class ReceiveRenderResultThread(threading.Thread):
                 mode = 'h'
                 bytes_left = 4
 
+                if render_result.encoding != RenderResult.RAW or render_result.format != OSP_FB_RGBA32F:
+                    data = decompress_framebuffer(render_result, framebuffer)
+
+                    if render_result.encoding & RenderResult.TILES:
+                        # Patch changed tiles into a copy of the previous frame, 
+                        # as view_draw() might still be using that one
+                        assert current_framebuffer is not None
+                        framebuffer = current_framebuffer.copy()
+                        patch_tiles(render_result, data, framebuffer)
+                    else:
+                        framebuffer = decode_pixels(render_result, data)
+                else:
+                    # Raw RGBA32F pixels, only needs a different view of 
+                    # the received bytes
+                    framebuffer = framebuffer.view(numpy.float32)
+
+                # Always float32 RGBA from here
+                current_framebuffer = framebuffer
+
                 # Got complete frame buffer, let engine know
                 self.result_queue.put((render_result, framebuffer))   
 
@@ -302,11 +434,11 @@ class OsprayRenderEngine(bpy.types.RenderEngine):
         if hasattr(self, 'connection') and self.connection is not None:        
             self.connection.close()
 
-    def connect(self, depsgraph):
+    def connect(self, depsgraph, shared_memory=False):
         assert self.connection is None
         ospray = depsgraph.scene.ospray        
         self.connection = Connection(self, ospray.host, ospray.port)        
-        return self.connection.connect()
+        return self.connection.connect(shared_memory)
 
     def connect_render_output(self, depsgraph):
         assert self.render_output_connection is None
@@ -349,7 +481,8 @@ class OsprayRenderEngine(bpy.types.RenderEngine):
 
         self.update_succeeded = False
         
-        if not self.connect(depsgraph):        
+        # Final render, can use shared memory for receiving framebuffers
+        if not self.connect(depsgraph, shared_memory=True):        
             self.report({'ERROR'}, 'Failed to connect to server')
             return 
 
@@ -429,6 +562,18 @@ class OsprayRenderEngine(bpy.types.RenderEngine):
             elif isinstance(datablock, bpy.types.Object):                
                 if datablock.type == 'LIGHT':
                     self.connection.send_updated_light(None, depsgraph, datablock)
+                elif datablock.type == 'MESH':
+                    if update.is_updated_geometry and not datablock.data.ospray.plugin_enabled:
+                        # E.g. a deforming mesh when changing frames. If the
+                        # topology didn't change only the modified vertex 
+                        # attributes are sent
+                        self.connection.mesh_data_exported.discard(datablock.data.name)
+                        self.connection.update_blender_mesh(None, depsgraph, datablock.data)
+                    if update.is_updated_transform:
+                        # Moved object. The server updates the existing 
+                        # instance, without rebuilding the world's instance list
+                        self.connection.send_updated_mesh_object(None, depsgraph, datablock, datablock.data, 
+                            datablock.matrix_world, False, 0)
 
     # For viewport renders, this method gets called once at the start and
     # whenever the scene or 3D viewport changes. This method is where data
@@ -474,6 +619,8 @@ class OsprayRenderEngine(bpy.types.RenderEngine):
                 render_settings.roulette_depth = scene.ospray.roulette_depth
                 render_settings.max_contribution = scene.ospray.max_contribution
                 render_settings.geometry_lights = scene.ospray.geometry_lights
+            render_settings.denoise_final = scene.ospray.denoise_final
+            render_settings.denoise_interactive_interval = scene.ospray.denoise_interactive_interval
 
             self.connection.send_updated_render_settings(render_settings)          
 
@@ -482,7 +629,9 @@ class OsprayRenderEngine(bpy.types.RenderEngine):
             self.viewport_width = viewport_width
             self.viewport_height = viewport_height
             # Reduction factor is passed with START_RENDERING
-            self.connection.send_updated_framebuffer_settings('interactive', viewport_width, viewport_height, OSP_FB_RGBA32F)
+            format, encoding, tile_threshold = interactive_framebuffer_settings(ospray, self.log)
+            self.connection.send_updated_framebuffer_settings('interactive', viewport_width, viewport_height, 
+                format, encoding, tile_threshold)
 
             # Send complete (visible) scene
             # XXX put exception handler around whole block above
@@ -565,7 +714,9 @@ class OsprayRenderEngine(bpy.types.RenderEngine):
             self.viewport_width = viewport_width
             self.viewport_height = viewport_height
             # Reduction factor is passed with START_RENDERING
-            self.connection.send_updated_framebuffer_settings('interactive', viewport_width, viewport_height, OSP_FB_RGBA32F)        
+            format, encoding, tile_threshold = interactive_framebuffer_settings(ospray, self.log)
+            self.connection.send_updated_framebuffer_settings('interactive', viewport_width, viewport_height, 
+                format, encoding, tile_threshold)
             restart_rendering = True
             update_camera = True
 
@@ -1,8 +1,8 @@
-import os, re
+import getpass, os, re, socket
 from struct import pack, unpack
 from logging import getLogger
 
-PROTOCOL_VERSION = 2
+PROTOCOL_VERSION = 4
 
 VERBOSE_PROTOBUF = False
 
@@ -12,6 +12,13 @@ OSP_FB_RGBA8 = 1    # one dword per pixel: rgb+alpha, each one byte
 OSP_FB_SRGBA = 2    # one dword per pixel: rgb (in sRGB space) + alpha, each one byte
 OSP_FB_RGBA32F = 3  # one float4 per pixel: rgb+alpha, each one float
 
+def session_name():
+    """
+    Name of the session passed in HELLO. Scene state on the server is 
+    per session, we use one per Blender instance.
+    """
+    return '%s@%s:%d' % (getpass.getuser(), socket.gethostname(), os.getpid())
+
 def send_protobuf(sock, pb, sendall=True):
     """Serialize a protobuf object and send it on the socket"""
     if VERBOSE_PROTOBUF:
@@ -57,7 +64,7 @@ def receive_buffer(sock, n):
     parts = []
     left = n
     while left > 0:
-        d = sock.recv(min(n,4096))
+        d = sock.recv(min(left,65536))
         left -= len(d)
         parts.append(d)
         
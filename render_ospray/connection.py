@@ -24,7 +24,7 @@ import bpy, bmesh
 #from bgl import *
 from mathutils import Vector, Matrix
 
-import sys, array, json, os, select, socket, time, weakref
+import sys, array, hashlib, json, mmap, os, select, socket, time, weakref
 from math import tan, atan, degrees, radians, sqrt
 from struct import pack, unpack
 
@@ -32,14 +32,16 @@ import numpy
 
 sys.path.insert(0, os.path.split(__file__)[0])
 
-from .common import PROTOCOL_VERSION, OSP_FB_RGBA32F, send_protobuf, receive_protobuf, substitute_values
+from .common import PROTOCOL_VERSION, OSP_FB_RGBA32F, send_protobuf, receive_protobuf, substitute_values, session_name
 from .messages_pb2 import (
     HelloResult,
     ClientMessage,
     WorldSettings, CameraSettings, LightSettings, RenderSettings,
     UpdateObject, UpdatePluginInstance,
-    MeshData,
+    MeshData, MeshCacheResult,
     GenerateFunctionResult, RenderResult,    
+    SceneUpdateBatch, SceneUpdateBatchResult,
+    AnimationJob, AnimationJobResult,
     Volume, Slices, Slice, Color,
     MaterialUpdate, 
     AlloySettings, CarPaintSettings, GlassSettings, LuminousSettings, MetalSettings,
@@ -95,7 +97,30 @@ class Connection:
 
         self.framebuffer_width = self.framebuffer_height = None
 
-    def connect(self):
+        # Shared memory framebuffer transport, if negotiated
+        self.shm_name = None
+
+        # Per Blender mesh sent: (num vertices, num triangles, digests of 
+        # the attributes sent). Used to only send what changed for 
+        # meshes with constant topology (i.e. deforming meshes).
+        # Blender meshes get removed on the server on CLEAR_SCENE, so this
+        # is reset then.
+        self.blender_mesh_cache = {}
+
+        # Scene updates collected while sending the scene, sent in one 
+        # UPDATE_SCENE_BATCH message (None when not batching)
+        self.scene_batch = None
+
+    def is_local(self):
+        """Is the server on this host?"""
+        return self.host in ['localhost', '127.0.0.1', socket.gethostname(), socket.getfqdn()]
+
+    def connect(self, shared_memory=False, session=None):
+        """
+        If shared_memory is True and the server is on the same host
+        request final render framebuffers to be passed through shared memory.
+        session overrides the default session name.
+        """
         self.engine().update_stats('', 'Connecting')
 
         try:            
@@ -107,6 +132,9 @@ class Connection:
         client_message = ClientMessage()
         client_message.type = ClientMessage.HELLO
         client_message.uint_value = PROTOCOL_VERSION
+        if shared_memory and self.is_local():
+            client_message.string_value = 'shm'
+        client_message.string_value2 = session if session is not None else session_name()
         send_protobuf(self.sock, client_message)
 
         result = HelloResult()
@@ -117,6 +145,10 @@ class Connection:
             print(result.message)
             return False
 
+        if result.shm_name != '':
+            print('Using shared memory framebuffer transport (%s)' % result.shm_name)
+            self.shm_name = result.shm_name
+
         return True
 
     def request_render_output(self):
@@ -167,6 +199,8 @@ class Connection:
             render_settings.roulette_path_length = scene.ospray.roulette_path_length
             render_settings.max_contribution = scene.ospray.max_contribution
             render_settings.geometry_lights = scene.ospray.geometry_lights
+        render_settings.denoise_final = scene.ospray.denoise_final
+        render_settings.denoise_interactive_interval = scene.ospray.denoise_interactive_interval
 
         self.send_updated_render_settings(render_settings)  
 
@@ -283,14 +317,58 @@ class Connection:
                 
         return properties, plugin_parameters
         
+    def _send_scene_update(self, client_message, *messages):
+        """Send a scene update (client message plus the messages following it),
+        or add it to the current batch"""
+
+        if self.scene_batch is None:
+            send_protobuf(self.sock, client_message)
+            for msg in messages:
+                send_protobuf(self.sock, msg)
+            return
+
+        scene_update = self.scene_batch.updates.add()
+        scene_update.type = client_message.type
+        scene_update.messages.extend([msg.SerializeToString() for msg in messages])
+
+    def _begin_scene_batch(self):
+        self.scene_batch = SceneUpdateBatch()
+
+    def _flush_scene_batch(self):
+        """Send the batched scene updates and wait for the server to apply them"""
+
+        batch = self.scene_batch
+        self.scene_batch = None
+
+        if len(batch.updates) == 0:
+            return
+
+        s = batch.SerializeToString()
+        print('Sending batch of %d scene updates (%d bytes)' % (len(batch.updates), len(s)))
+
+        client_message = ClientMessage()
+        client_message.type = ClientMessage.UPDATE_SCENE_BATCH
+        client_message.uint_value = len(s)
+        send_protobuf(self.sock, client_message)
+        self.sock.sendall(s)
+
+        result = SceneUpdateBatchResult()
+        receive_protobuf(self.sock, result)
+
+        if not result.success:
+            print('ERROR: %d of %d scene updates failed:' % (len(result.errors), result.num_updates))
+            for error in result.errors:
+                print(error)
+
     def send_clear_scene(self, keep_plugin_instances=True):
         client_message = ClientMessage()
         client_message.type = ClientMessage.CLEAR_SCENE
         client_message.string_value = 'keep_plugin_instances' if keep_plugin_instances else 'all'
         send_protobuf(self.sock, client_message)    
         # XXX flags to pick which scene items are cleared    
+        self.blender_mesh_cache = {}
 
-    def send_updated_framebuffer_settings(self, mode, width, height, format):
+    def send_updated_framebuffer_settings(self, mode, width, height, format, encoding=RenderResult.RAW, tile_threshold=0.0):
 
         client_message = ClientMessage()
         client_message.type = ClientMessage.UPDATE_FRAMEBUFFER_SETTINGS
@@ -298,6 +376,8 @@ class Connection:
         client_message.uint_value = format
         client_message.uint_value2 = width
         client_message.uint_value3 = height
+        client_message.uint_value4 = encoding
+        client_message.float_value = tile_threshold
         send_protobuf(self.sock, client_message)
                 
     def _film_dimensions(self, camdata, aspect_ratio, zoom):
@@ -514,6 +594,16 @@ class Connection:
     def send_updated_camera(self, cam_obj, border=None):
         # Final render from a camera. 
         # Note: not usable for a camera view in interactive render mode
+
+        camera_settings = self._camera_settings(cam_obj, border)
+            
+        client_message = ClientMessage()
+        client_message.type = ClientMessage.UPDATE_CAMERA
+
+        send_protobuf(self.sock, client_message)
+        send_protobuf(self.sock, camera_settings)
+
+    def _camera_settings(self, cam_obj, border=None):
         
         cam_xform = cam_obj.matrix_world
         cam_data = cam_obj.data
@@ -563,12 +653,8 @@ class Connection:
 
         if border is not None:
             camera_settings.border[:] = border
-            
-        client_message = ClientMessage()
-        client_message.type = ClientMessage.UPDATE_CAMERA
 
-        send_protobuf(self.sock, client_message)
-        send_protobuf(self.sock, camera_settings)
+        return camera_settings
 
     def send_updated_renderer_type(self, type):
         client_message = ClientMessage()
@@ -608,6 +694,21 @@ class Connection:
 
         print('DEPSGRAPH STATS:', depsgraph.debug_stats())
 
+        # Send plugin instances first. The server creates instances of
+        # thread-safe plugins in the background, so this gets them
+        # loading in parallel, while we send the rest of the scene.
+        for instance in depsgraph.object_instances:
+
+            obj = instance.object
+
+            if obj.type == 'MESH' and obj.data.ospray.plugin_enabled:
+                self.send_updated_mesh_data(blend_data, depsgraph, obj.data)
+
+        # Batch the remaining object, light and material updates, which 
+        # saves a round trip for each of them (blender mesh data still gets
+        # sent directly, as it needs the server's mesh cache reply)
+        self._begin_scene_batch()
+
         for instance in depsgraph.object_instances:
 
             obj = instance.object
@@ -622,6 +723,81 @@ class Connection:
             elif obj.type not in ['CAMERA']:
                 print('Warning: not exporting object of type "%s"' % obj.type)
 
+        self._flush_scene_batch()
+
+    def submit_animation_job(self, context, frame_start, frame_end, output_directory):
+        """
+        Submit frames frame_start-frame_end (inclusive) as an animation job, 
+        to be rendered by the server after this connection is closed.
+        The scene needs to have been sent with update() first. 
+
+        Per frame the plugin instances, mesh objects, lights and camera 
+        are captured. Blender mesh data is not, i.e. deforming meshes 
+        keep the geometry from the initial scene.
+        """
+
+        scene = context.scene
+        ospray = scene.ospray
+
+        camera = scene.camera
+
+        job = AnimationJob()
+        job.output_directory = output_directory
+        job.width = self.framebuffer_width
+        job.height = self.framebuffer_height
+        job.samples = ospray.render_samples
+        job.variance_target = ospray.render_variance_target
+        job.time_budget = ospray.render_time_budget
+
+        current_frame = scene.frame_current
+
+        for f in range(frame_start, frame_end+1):
+
+            self.engine().update_stats('', 'Capturing frame %d' % f)
+            scene.frame_set(f)
+            depsgraph = context.evaluated_depsgraph_get()
+
+            # Plugin instances are (re)created for each frame, their
+            # parameters may depend on the frame number
+            for instance in depsgraph.object_instances:
+                obj = instance.object
+                if obj.type == 'MESH' and obj.data.ospray.plugin_enabled:
+                    self.mesh_data_exported.discard(obj.data.name)
+
+            self._begin_scene_batch()
+
+            for instance in depsgraph.object_instances:
+
+                obj = instance.object
+
+                if obj.type == 'LIGHT':
+                    self.send_updated_light(None, depsgraph, obj)
+                elif obj.type == 'MESH':
+                    self.send_updated_mesh_object(None, depsgraph, obj, obj.data, instance.matrix_world, instance.is_instance, instance.random_id)
+
+            frame = job.frames.add()
+            frame.frame = f
+            frame.updates.extend(self.scene_batch.updates)
+            frame.camera.CopyFrom(self._camera_settings(camera, self.render_border))
+
+            self.scene_batch = None
+
+        scene.frame_set(current_frame)
+
+        s = job.SerializeToString()
+        print('Submitting animation job of %d frames (%d bytes)' % (len(job.frames), len(s)))
+
+        client_message = ClientMessage()
+        client_message.type = ClientMessage.SUBMIT_ANIMATION_JOB
+        client_message.uint_value = len(s)
+        send_protobuf(self.sock, client_message)
+        self.sock.sendall(s)
+
+        result = AnimationJobResult()
+        receive_protobuf(self.sock, result)
+
+        return result
+
     def send_updated_light(self, blend_data, depsgraph, obj):
 
         self.engine().update_stats('', 'Light %s' % obj.name)
@@ -699,9 +875,7 @@ class Connection:
         update.custom_properties = json.dumps(custom_properties)  
 
         # XXX using three messages :-/
-        send_protobuf(self.sock, client_message)
-        send_protobuf(self.sock, update)
-        send_protobuf(self.sock, light_settings)
+        self._send_scene_update(client_message, update, light_settings)
 
     def send_updated_material(self, blend_data, depsgraph, material, force_update=False):
 
@@ -868,9 +1042,7 @@ class Connection:
             return
 
         # XXX three messages
-        send_protobuf(self.sock, client_message)
-        send_protobuf(self.sock, update)
-        send_protobuf(self.sock, settings)
+        self._send_scene_update(client_message, update, settings)
 
         self.materials_exported.add(name)
 
@@ -957,8 +1129,7 @@ class Connection:
                 update.material_link = material.name
 
             # Send object itself            
-            send_protobuf(self.sock, client_message)
-            send_protobuf(self.sock, update)                    
+            self._send_scene_update(client_message, update)
 
         else:        
 
@@ -1096,10 +1267,7 @@ class Connection:
                     # Isosurface values are read from the custom property 'isovalue'
                     update.type = UpdateObject.ISOSURFACES
                                     
-            send_protobuf(self.sock, client_message)
-            send_protobuf(self.sock, update)
-            for msg in extra:
-                send_protobuf(self.sock, msg)
+            self._send_scene_update(client_message, update, *extra)
     
 
     def send_updated_mesh_data(self, blend_data, depsgraph, mesh):
@@ -1159,6 +1327,11 @@ class Connection:
         update.plugin_name = plugin_name
         update.plugin_parameters = json.dumps(plugin_parameters)
         update.custom_properties = json.dumps(custom_properties)
+
+        if self.scene_batch is not None:
+            # Result is part of the batch result
+            self._send_scene_update(client_message, update)
+            return
         
         send_protobuf(self.sock, client_message)
         send_protobuf(self.sock, update)
@@ -1205,20 +1378,6 @@ class Connection:
             self.mesh_data_exported.add(mesh.name)
             return        
 
-        # Send client message
-        
-        client_message = ClientMessage()
-        client_message.type = ClientMessage.UPDATE_BLENDER_MESH       
-        client_message.string_value = mesh.name
-        
-        send_protobuf(self.sock, client_message)
-        
-        # Send the actual mesh geometry
-        
-        mesh_data = MeshData()
-        mesh_data.num_vertices = nv
-        mesh_data.num_triangles = nt
-
         flags = 0    
 
         # Check if any faces use smooth shading
@@ -1238,13 +1397,7 @@ class Connection:
         if mesh.vertex_colors:
             flags |= MeshData.VERTEX_COLORS
 
-        # Send mesh data
-
-        mesh_data.flags = flags
-
-        send_protobuf(self.sock, mesh_data)
-
-        # Send vertices
+        # Vertices
 
         vertices = numpy.empty(nv*3, dtype=numpy.float32)
 
@@ -1259,9 +1412,9 @@ class Connection:
             
         #print(vertices)
 
-        self.sock.send(vertices.tobytes())
+        # Vertex normals (if set)
 
-        # Send vertex normals (if set)
+        normals = None
 
         if use_smooth:
             normals = numpy.empty(nv*3, dtype=numpy.float32)
@@ -1273,9 +1426,9 @@ class Connection:
                 normals[3*idx+1] = n.y
                 normals[3*idx+2] = n.z
 
-            self.sock.send(normals.tobytes())
+        # Vertex colors (if set)
 
-        # Send vertex colors (if set)
+        vertex_colors = None
 
         if mesh.vertex_colors:
             vcol_layer = mesh.vertex_colors.active
@@ -1293,9 +1446,7 @@ class Connection:
                     vertex_colors[4*loop_vert_index+2] = color[2]
                     vertex_colors[4*loop_vert_index+3] = 1.0
 
-            self.sock.send(vertex_colors.tobytes())
-
-        # Send triangles
+        # Triangles
 
         triangles = numpy.empty(nt*3, dtype=numpy.uint32)   # XXX opt possible with <64k vertices ;-)
 
@@ -1306,7 +1457,83 @@ class Connection:
             
         #print(triangles)
 
-        self.sock.send(triangles.tobytes())
+        # Compare against what we previously sent for this mesh, if the
+        # topology is the same only send the attributes that changed
+
+        def digest(a):
+            if a is None:
+                return None
+            return hashlib.blake2b(a.tobytes(), digest_size=16).digest()
+
+        digests = (digest(vertices), digest(normals), digest(vertex_colors), digest(triangles))
+
+        # Hash of the complete mesh content, the server might still have 
+        # the mesh from an earlier scene sync
+        content_hash = hashlib.blake2b(pack('<III', nv, nt, flags), digest_size=20)
+        for d in digests:
+            if d is not None:
+                content_hash.update(d)
+        content_hash = content_hash.hexdigest()
+
+        send_vertices = send_normals = send_vertex_colors = send_triangles = True
+
+        previous = self.blender_mesh_cache.get(mesh.name)
+        if previous is not None and previous[0] == nv and previous[1] == nt and previous[2][3] == digests[3]:
+            prev_digests = previous[2]
+            flags |= MeshData.TOPOLOGY_UNCHANGED
+            send_triangles = False
+            if prev_digests[0] == digests[0]:
+                flags |= MeshData.POSITIONS_UNCHANGED
+                send_vertices = False
+            if normals is not None and prev_digests[1] == digests[1]:
+                flags |= MeshData.NORMALS_UNCHANGED
+                send_normals = False
+            if vertex_colors is not None and prev_digests[2] == digests[2]:
+                flags |= MeshData.VERTEX_COLORS_UNCHANGED
+                send_vertex_colors = False
+            print('... Topology unchanged, sending only changed vertex attributes')
+
+        # Send client message
+        
+        client_message = ClientMessage()
+        client_message.type = ClientMessage.UPDATE_BLENDER_MESH       
+        client_message.string_value = mesh.name
+        
+        send_protobuf(self.sock, client_message)
+        
+        # Send mesh data
+
+        mesh_data = MeshData()
+        mesh_data.num_vertices = nv
+        mesh_data.num_triangles = nt
+        mesh_data.flags = flags
+        mesh_data.content_hash = content_hash
+
+        send_protobuf(self.sock, mesh_data)
+
+        self.blender_mesh_cache[mesh.name] = (nv, nt, digests)
+
+        result = MeshCacheResult()
+        receive_protobuf(self.sock, result)
+
+        if result.cached:
+            print('... Server already has mesh content %s, not sending data' % content_hash)
+            self.mesh_data_exported.add(mesh.name)
+            return
+
+        # Send the actual mesh geometry
+
+        if send_vertices:
+            self.sock.send(vertices.tobytes())
+
+        if normals is not None and send_normals:
+            self.sock.send(normals.tobytes())
+
+        if vertex_colors is not None and send_vertex_colors:
+            self.sock.send(vertex_colors.tobytes())
+
+        if send_triangles:
+            self.sock.send(triangles.tobytes())
 
         self.mesh_data_exported.add(mesh.name)
 
@@ -1335,6 +1562,8 @@ class Connection:
         client_message.string_value = "final"
         self.render_samples = client_message.uint_value = ospray.render_samples
         client_message.uint_value2 = ospray.framebuffer_update_rate
+        client_message.float_value = ospray.render_variance_target
+        client_message.uint_value3 = ospray.render_time_budget
         send_protobuf(self.sock, client_message)
 
         # Read back successive framebuffer samples
@@ -1356,6 +1585,11 @@ class Connection:
         sample = 1
         cancel_sent = False
 
+        # Shared memory mapping, set up on first use and redone when the
+        # framebuffer size changes (the server then resizes the segment)
+        shm = None
+        shm_dims = None
+
         self.engine().update_stats('', 'Rendering sample %d/%d' % (sample, self.render_samples))
 
         # XXX this loop blocks too often, might need to move it to a separate thread,
@@ -1376,7 +1610,29 @@ class Connection:
 
                     # New framebuffer (for a single pixel sample) is available
                     
-                    if render_result.file_size > 0:
+                    if render_result.file_name == '<shm>':
+
+                        dims = (render_result.width, render_result.height)
+
+                        if shm is None or dims != shm_dims or not self._shm_slot_fits(shm, render_result):
+                            if shm is not None:
+                                shm.close()
+                            fd = os.open('/dev/shm' + self.shm_name, os.O_RDONLY)
+                            shm = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ)
+                            os.close(fd)
+                            shm_dims = dims
+
+                        if self._shm_slot_fits(shm, render_result):
+                            pixels = self._read_framebuffer_from_shm(shm, render_result)
+                        else:
+                            print('WARNING: shared memory segment too small for %d x %d framebuffer, ignoring frame' % dims)
+                            pixels = None
+
+                        if pixels is not None:
+                            result.layers[0].passes['Combined'].rect = pixels
+                            self.engine().update_result(result)
+
+                    elif render_result.file_size > 0:
 
                         """
                         # XXX Slow: get as raw block of floats
@@ -1427,7 +1683,9 @@ class Connection:
                     
                     self.engine().update_stats(
                         'Server %.1fM (peak %.1fM)' % (render_result.memory_usage, render_result.peak_memory_usage),
-                        'Variance %.3f | Rendering sample %d/%d' % (render_result.variance, sample, self.render_samples))                
+                        'Variance %.3f | Rendering sample %d/%d | Frame %.3fs (copy %.3fs, encode %.3fs)' % (
+                            render_result.variance, sample, self.render_samples,
+                            render_result.render_time, render_result.framebuffer_copy_time, render_result.encode_time))
 
                 elif render_result.type == RenderResult.CANCELED:
                     print('Rendering CANCELED!')
@@ -1437,8 +1695,8 @@ class Connection:
 
                 elif render_result.type == RenderResult.DONE:
                     # XXX this message is never really shown, the final timing stats get shown instead
-                    self.engine().update_stats('', 'Variance %.3f | Rendering done' % render_result.variance)
-                    print('Rendering done!')
+                    self.engine().update_stats('', 'Variance %.3f | Rendering done (%d samples)' % (render_result.variance, render_result.sample))
+                    print('Rendering done after %d samples!' % render_result.sample)
                     break
 
             # Check if render was canceled
@@ -1451,6 +1709,9 @@ class Connection:
 
             time.sleep(0.001)
 
+        if shm is not None:
+            shm.close()
+
         self.engine().end_result(result)
 
         print('Done with render loop')
@@ -1478,6 +1739,42 @@ class Connection:
             #self.update_stats('%d bytes left' % bytes_left, 'Reading back framebuffer')
     """
     
+    def _shm_slot_fits(self, shm, render_result):
+        """
+        Whether the slot in render_result holds a full framebuffer
+        (64-byte header, then width x height RGBA floats) and lies
+        within the mapped segment
+        """
+
+        needed = 64 + render_result.width * render_result.height * 16
+        end = (render_result.shm_slot + 1) * render_result.shm_slot_size
+
+        return render_result.shm_slot_size >= needed and end <= len(shm)
+
+    def _read_framebuffer_from_shm(self, shm, render_result):
+        """
+        Returns the pixels (as N x 4 float array) from the shared memory
+        slot in render_result, or None if the server overwrote the slot 
+        while we were reading it (SharedFramebufferSlot in the server)
+        """
+
+        offset = render_result.shm_slot * render_result.shm_slot_size
+        num_pixels = render_result.width * render_result.height
+        expected_sequence = 2 * render_result.sample
+
+        sequence = numpy.frombuffer(shm, dtype=numpy.uint64, count=1, offset=offset)[0]
+        if sequence != expected_sequence:
+            return None
+
+        pixels = numpy.frombuffer(shm, dtype=numpy.float32, count=num_pixels*4, offset=offset+64)
+        pixels = pixels.reshape((num_pixels, 4)).copy()
+
+        sequence = numpy.frombuffer(shm, dtype=numpy.uint64, count=1, offset=offset)[0]
+        if sequence != expected_sequence:
+            return None
+
+        return pixels
+
     def _read_framebuffer_to_file(self, fname, size):
 
         #print('_read_framebuffer_to_file(%s, %d)' % (fname, size))
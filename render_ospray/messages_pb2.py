@@ -1,10 +1,10 @@
 # -*- coding: utf-8 -*-
 # Generated by the protocol buffer compiler.  DO NOT EDIT!
 # source: messages.proto
-
+"""Generated protocol buffer code."""
+from google.protobuf.internal import builder as _builder
 from google.protobuf import descriptor as _descriptor
-from google.protobuf import message as _message
-from google.protobuf import reflection as _reflection
+from google.protobuf import descriptor_pool as _descriptor_pool
 from google.protobuf import symbol_database as _symbol_database
 # @@protoc_insertion_point(imports)
 
@@ -13,2379 +13,97 @@ _sym_db = _symbol_database.Default()
 
 
 
-DESCRIPTOR = _descriptor.FileDescriptor(
-  name='messages.proto',
-  package='',
-  syntax='proto3',
-  serialized_options=None,
-  serialized_pb=b'\n\x0emessages.proto\"\xea\x04\n\rClientMessage\x12!\n\x04type\x18\x01 \x01(\x0e\x32\x13.ClientMessage.Type\x12\x12\n\nuint_value\x18\x14 \x01(\r\x12\x13\n\x0buint_value2\x18\x15 \x01(\r\x12\x13\n\x0buint_value3\x18\x16 \x01(\r\x12\x14\n\x0cstring_value\x18( \x01(\t\"\xe1\x03\n\x04Type\x12\t\n\x05HELLO\x10\x00\x12\x07\n\x03\x42YE\x10\x01\x12\x0f\n\x0b\x43LEAR_SCENE\x10\x0b\x12\x18\n\x14UPDATE_RENDERER_TYPE\x10\x14\x12\x19\n\x15UPDATE_WORLD_SETTINGS\x10\x15\x12\x1a\n\x16UPDATE_RENDER_SETTINGS\x10\x16\x12\x1f\n\x1bUPDATE_FRAMEBUFFER_SETTINGS\x10\x17\x12\x17\n\x13UPDATE_BLENDER_MESH\x10\x18\x12\x1a\n\x16UPDATE_PLUGIN_INSTANCE\x10\x19\x12\x11\n\rUPDATE_CAMERA\x10\x1a\x12\x13\n\x0fUPDATE_MATERIAL\x10\x1b\x12\x11\n\rUPDATE_OBJECT\x10\x1c\x12\x11\n\rDELETE_OBJECT\x10\x1e\x12\x17\n\x13\x44\x45LETE_BLENDER_MESH\x10\x1f\x12\x1a\n\x16\x44\x45LETE_PLUGIN_INSTANCE\x10 \x12\x13\n\x0fSTART_RENDERING\x10(\x12\x13\n\x0fPAUSE_RENDERING\x10)\x12\x14\n\x10\x43\x41NCEL_RENDERING\x10*\x12\x19\n\x15REQUEST_RENDER_OUTPUT\x10\x31\x12\x14\n\x10GET_SERVER_STATE\x10\x32\x12\x0f\n\x0bQUERY_BOUND\x10\x33\x12\x08\n\x04QUIT\x10\x63\"/\n\x0bHelloResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\"\"\n\x11ServerStateResult\x12\r\n\x05state\x18\x01 \x01(\t\"I\n\x10QueryBoundResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x13\n\x0bresult_size\x18\x03 \x01(\r\"\x8d\x02\n\x0cRenderResult\x12 \n\x04type\x18\x01 \x01(\x0e\x32\x12.RenderResult.Type\x12\x0e\n\x06sample\x18\x02 \x01(\r\x12\x18\n\x10reduction_factor\x18\x03 \x01(\r\x12\r\n\x05width\x18\x04 \x01(\r\x12\x0e\n\x06height\x18\x05 \x01(\r\x12\x10\n\x08variance\x18\n \x01(\x02\x12\x11\n\tfile_name\x18\x14 \x01(\t\x12\x11\n\tfile_size\x18\x15 \x01(\r\x12\x14\n\x0cmemory_usage\x18\x1e \x01(\x02\x12\x19\n\x11peak_memory_usage\x18\x1f \x01(\x02\")\n\x04Type\x12\t\n\x05\x46RAME\x10\x00\x12\x0c\n\x08\x43\x41NCELED\x10\x01\x12\x08\n\x04\x44ONE\x10\x02\"\xc6\x01\n\x14UpdatePluginInstance\x12(\n\x04type\x18\x01 \x01(\x0e\x32\x1a.UpdatePluginInstance.Type\x12\x0c\n\x04name\x18\x02 \x01(\t\x12\x13\n\x0bplugin_name\x18\x03 \x01(\t\x12\x19\n\x11plugin_parameters\x18\x04 \x01(\t\x12\x19\n\x11\x63ustom_properties\x18\x05 \x01(\t\"+\n\x04Type\x12\x0c\n\x08GEOMETRY\x10\x00\x12\n\n\x06VOLUME\x10\x01\x12\t\n\x05SCENE\x10\x02\"\xf8\x01\n\x0cUpdateObject\x12 \n\x04type\x18\x01 \x01(\x0e\x32\x12.UpdateObject.Type\x12\x0c\n\x04name\x18\x02 \x01(\t\x12\x19\n\x11\x63ustom_properties\x18\x03 \x01(\t\x12\x14\n\x0cobject2world\x18\n \x03(\x02\x12\x11\n\tdata_link\x18\x0b \x01(\t\x12\x15\n\rmaterial_link\x18\x0c \x01(\t\"]\n\x04Type\x12\x08\n\x04MESH\x10\x00\x12\x0c\n\x08GEOMETRY\x10\n\x12\n\n\x06VOLUME\x10\x14\x12\x0f\n\x0bISOSURFACES\x10\x1e\x12\n\n\x06SLICES\x10(\x12\t\n\x05SCENE\x10\x32\x12\t\n\x05LIGHT\x10<\"3\n\x05\x43olor\x12\t\n\x01r\x18\x01 \x01(\x02\x12\t\n\x01g\x18\x02 \x01(\x02\x12\t\n\x01\x62\x18\x03 \x01(\x02\x12\t\n\x01\x61\x18\x04 \x01(\x02\"d\n\x06Volume\x12\x14\n\x0ctf_positions\x18\x01 \x03(\x02\x12\x19\n\ttf_colors\x18\x02 \x03(\x0b\x32\x06.Color\x12\x15\n\rdensity_scale\x18\n \x01(\x02\x12\x12\n\nanisotropy\x18\x0b \x01(\x02\">\n\x05Slice\x12\x0c\n\x04name\x18\x01 \x01(\t\x12\x11\n\tmesh_link\x18\x02 \x01(\t\x12\x14\n\x0cobject2world\x18\x03 \x03(\x02\" \n\x06Slices\x12\x16\n\x06slices\x18\x01 \x03(\x0b\x32\x06.Slice\"y\n\x08MeshData\x12\r\n\x05\x66lags\x18\x01 \x01(\r\x12\x14\n\x0cnum_vertices\x18\n \x01(\r\x12\x15\n\rnum_triangles\x18\x0b \x01(\r\"1\n\x05\x46lags\x12\x08\n\x04NONE\x10\x00\x12\x0b\n\x07NORMALS\x10\x01\x12\x11\n\rVERTEX_COLORS\x10\x02\"[\n\rWorldSettings\x12\x15\n\rambient_color\x18\x01 \x03(\x02\x12\x19\n\x11\x61mbient_intensity\x18\x02 \x01(\x02\x12\x18\n\x10\x62\x61\x63kground_color\x18\n \x03(\x02\"\xd1\x02\n\x0e\x43\x61meraSettings\x12\"\n\x04type\x18\x01 \x01(\x0e\x32\x14.CameraSettings.Type\x12\x13\n\x0bobject_name\x18\x02 \x01(\t\x12\x13\n\x0b\x63\x61mera_name\x18\x03 \x01(\t\x12\x0e\n\x06\x62order\x18\x04 \x03(\x02\x12\x10\n\x08position\x18\n \x03(\x02\x12\x10\n\x08view_dir\x18\x0b \x03(\x02\x12\x0e\n\x06up_dir\x18\x0c \x03(\x02\x12\r\n\x05\x66ov_y\x18\x14 \x01(\x02\x12\x0e\n\x06height\x18\x1e \x01(\x02\x12\x0e\n\x06\x61spect\x18( \x01(\x02\x12\x12\n\nclip_start\x18\x32 \x01(\x02\x12\x1a\n\x12\x64of_focus_distance\x18< \x01(\x02\x12\x14\n\x0c\x64of_aperture\x18= \x01(\x02\"8\n\x04Type\x12\x0f\n\x0bPERSPECTIVE\x10\x00\x12\x10\n\x0cORTHOGRAPHIC\x10\x01\x12\r\n\tPANORAMIC\x10\x02\"\x9d\x02\n\x0eRenderSettings\x12\x10\n\x08renderer\x18\x01 \x01(\t\x12\x17\n\x0fmax_path_length\x18\x04 \x01(\r\x12\x18\n\x10min_contribution\x18\x05 \x01(\x02\x12\x1a\n\x12variance_threshold\x18\x06 \x01(\x02\x12\x12\n\nao_samples\x18\x14 \x01(\r\x12\x11\n\tao_radius\x18\x15 \x01(\x02\x12\x14\n\x0c\x61o_intensity\x18\x16 \x01(\x02\x12\x1c\n\x14volume_sampling_rate\x18\x17 \x01(\x02\x12\x1c\n\x14roulette_path_length\x18\x1e \x01(\r\x12\x18\n\x10max_contribution\x18\x1f \x01(\x02\x12\x17\n\x0fgeometry_lights\x18  \x01(\x08\"\xfd\x02\n\rLightSettings\x12!\n\x04type\x18\x01 \x01(\x0e\x32\x13.LightSettings.Type\x12\x14\n\x0cobject2world\x18\x02 \x03(\x02\x12\x13\n\x0bobject_name\x18\x03 \x01(\t\x12\x12\n\nlight_name\x18\x04 \x01(\t\x12\r\n\x05\x63olor\x18\n \x03(\x02\x12\x11\n\tintensity\x18\x0b \x01(\x02\x12\x0f\n\x07visible\x18\x0c \x01(\x08\x12\x11\n\tdirection\x18\x14 \x03(\x02\x12\x18\n\x10\x61ngular_diameter\x18\x15 \x01(\x02\x12\x10\n\x08position\x18\x16 \x03(\x02\x12\x0e\n\x06radius\x18\x17 \x01(\x02\x12\x15\n\ropening_angle\x18\x18 \x01(\x02\x12\x16\n\x0epenumbra_angle\x18\x19 \x01(\x02\x12\r\n\x05\x65\x64ge1\x18\x1a \x03(\x02\x12\r\n\x05\x65\x64ge2\x18\x1b \x03(\x02\";\n\x04Type\x12\x0b\n\x07\x41MBIENT\x10\x00\x12\t\n\x05POINT\x10\x01\x12\x07\n\x03SUN\x10\x02\x12\x08\n\x04SPOT\x10\x03\x12\x08\n\x04\x41REA\x10\x04\"\xce\x01\n\x0eMaterialUpdate\x12\"\n\x04type\x18\x01 \x01(\x0e\x32\x14.MaterialUpdate.Type\x12\x0c\n\x04name\x18\x02 \x01(\t\"\x89\x01\n\x04Type\x12\t\n\x05\x41LLOY\x10\x00\x12\r\n\tCAR_PAINT\x10\x01\x12\t\n\x05GLASS\x10\x02\x12\x0c\n\x08LUMINOUS\x10\x03\x12\t\n\x05METAL\x10\x04\x12\x12\n\x0eMETALLIC_PAINT\x10\x05\x12\x0f\n\x0bOBJMATERIAL\x10\x06\x12\x0e\n\nPRINCIPLED\x10\x07\x12\x0e\n\nTHIN_GLASS\x10\x08\"E\n\rAlloySettings\x12\r\n\x05\x63olor\x18\x01 \x03(\x02\x12\x12\n\nedge_color\x18\x02 \x03(\x02\x12\x11\n\troughness\x18\x03 \x01(\x02\"\xe5\x02\n\x10\x43\x61rPaintSettings\x12\x12\n\nbase_color\x18\x01 \x03(\x02\x12\x11\n\troughness\x18\x02 \x01(\x02\x12\x0e\n\x06normal\x18\x03 \x01(\x02\x12\x15\n\rflake_density\x18\x04 \x01(\x02\x12\x13\n\x0b\x66lake_scale\x18\x05 \x01(\x02\x12\x14\n\x0c\x66lake_spread\x18\x06 \x01(\x02\x12\x14\n\x0c\x66lake_jitter\x18\x07 \x01(\x02\x12\x17\n\x0f\x66lake_roughness\x18\x08 \x01(\x02\x12\x0c\n\x04\x63oat\x18\t \x01(\x02\x12\x10\n\x08\x63oat_ior\x18\n \x01(\x02\x12\x12\n\ncoat_color\x18\x0b \x03(\x02\x12\x16\n\x0e\x63oat_thickness\x18\x0c \x01(\x02\x12\x16\n\x0e\x63oat_roughness\x18\r \x01(\x02\x12\x13\n\x0b\x63oat_normal\x18\x0e \x01(\x02\x12\x16\n\x0e\x66lipflop_color\x18\x0f \x03(\x02\x12\x18\n\x10\x66lipflop_falloff\x18\x10 \x01(\x02\"U\n\rGlassSettings\x12\x0b\n\x03\x65ta\x18\x01 \x01(\x02\x12\x19\n\x11\x61ttenuation_color\x18\x02 \x03(\x02\x12\x1c\n\x14\x61ttenuation_distance\x18\x03 \x01(\x02\"J\n\x10LuminousSettings\x12\r\n\x05\x63olor\x18\x01 \x03(\x02\x12\x11\n\tintensity\x18\x02 \x01(\x02\x12\x14\n\x0ctransparency\x18\x03 \x01(\x02\"1\n\rMetalSettings\x12\r\n\x05metal\x18\x01 \x01(\r\x12\x11\n\troughness\x18\x02 \x01(\x02\"y\n\x15MetallicPaintSettings\x12\x12\n\nbase_color\x18\x01 \x03(\x02\x12\x14\n\x0c\x66lake_amount\x18\x02 \x01(\x02\x12\x13\n\x0b\x66lake_color\x18\x03 \x03(\x02\x12\x14\n\x0c\x66lake_spread\x18\x04 \x01(\x02\x12\x0b\n\x03\x65ta\x18\x05 \x01(\x02\"P\n\x13OBJMaterialSettings\x12\n\n\x02kd\x18\x01 \x03(\x02\x12\n\n\x02ks\x18\x02 \x03(\x02\x12\n\n\x02ns\x18\x03 \x01(\x02\x12\t\n\x01\x64\x18\x04 \x01(\x02\x12\n\n\x02tf\x18\x05 \x03(\x02\"\xb9\x04\n\x12PrincipledSettings\x12\x12\n\nbase_color\x18\x01 \x03(\x02\x12\x12\n\nedge_color\x18\x02 \x03(\x02\x12\x10\n\x08metallic\x18\x03 \x01(\x02\x12\x0f\n\x07\x64iffuse\x18\x04 \x01(\x02\x12\x10\n\x08specular\x18\x05 \x01(\x02\x12\x0b\n\x03ior\x18\x06 \x01(\x02\x12\x14\n\x0ctransmission\x18\x07 \x01(\x02\x12\x1a\n\x12transmission_color\x18\x08 \x03(\x02\x12\x1a\n\x12transmission_depth\x18\t \x01(\x02\x12\x11\n\troughness\x18\n \x01(\x02\x12\x12\n\nanisotropy\x18\x0b \x01(\x02\x12\x10\n\x08rotation\x18\x0c \x01(\x02\x12\x0e\n\x06normal\x18\r \x01(\x02\x12\x13\n\x0b\x62\x61se_normal\x18\x0e \x01(\x02\x12\x0c\n\x04thin\x18\x0f \x01(\x08\x12\x11\n\tthickness\x18\x10 \x01(\x02\x12\x11\n\tbacklight\x18\x11 \x01(\x02\x12\x0c\n\x04\x63oat\x18\x12 \x01(\x02\x12\x10\n\x08\x63oat_ior\x18\x13 \x01(\x02\x12\x12\n\ncoat_color\x18\x14 \x03(\x02\x12\x16\n\x0e\x63oat_thickness\x18\x15 \x01(\x02\x12\x16\n\x0e\x63oat_roughness\x18\x16 \x01(\x02\x12\x13\n\x0b\x63oat_normal\x18\x17 \x01(\x02\x12\r\n\x05sheen\x18\x18 \x01(\x02\x12\x13\n\x0bsheen_color\x18\x19 \x03(\x02\x12\x12\n\nsheen_tint\x18\x1a \x01(\x02\x12\x17\n\x0fsheen_roughness\x18\x1b \x01(\x02\x12\x0f\n\x07opacity\x18\x1c \x01(\x02\"l\n\x11ThinGlassSettings\x12\x0b\n\x03\x65ta\x18\x01 \x01(\x02\x12\x19\n\x11\x61ttenuation_color\x18\x02 \x03(\x02\x12\x1c\n\x14\x61ttenuation_distance\x18\x03 \x01(\x02\x12\x11\n\tthickness\x18\x04 \x01(\x02\"H\n\x16GenerateFunctionResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0c\n\x04hash\x18\x03 \x01(\tb\x06proto3'
-)
-
-
-
-_CLIENTMESSAGE_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='ClientMessage.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='HELLO', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='BYE', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='CLEAR_SCENE', index=2, number=11,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_RENDERER_TYPE', index=3, number=20,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_WORLD_SETTINGS', index=4, number=21,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_RENDER_SETTINGS', index=5, number=22,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_FRAMEBUFFER_SETTINGS', index=6, number=23,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_BLENDER_MESH', index=7, number=24,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_PLUGIN_INSTANCE', index=8, number=25,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_CAMERA', index=9, number=26,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_MATERIAL', index=10, number=27,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='UPDATE_OBJECT', index=11, number=28,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='DELETE_OBJECT', index=12, number=30,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='DELETE_BLENDER_MESH', index=13, number=31,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='DELETE_PLUGIN_INSTANCE', index=14, number=32,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='START_RENDERING', index=15, number=40,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='PAUSE_RENDERING', index=16, number=41,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='CANCEL_RENDERING', index=17, number=42,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='REQUEST_RENDER_OUTPUT', index=18, number=49,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='GET_SERVER_STATE', index=19, number=50,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='QUERY_BOUND', index=20, number=51,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='QUIT', index=21, number=99,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=156,
-  serialized_end=637,
-)
-_sym_db.RegisterEnumDescriptor(_CLIENTMESSAGE_TYPE)
-
-_RENDERRESULT_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='RenderResult.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='FRAME', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='CANCELED', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='DONE', index=2, number=2,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=1028,
-  serialized_end=1069,
-)
-_sym_db.RegisterEnumDescriptor(_RENDERRESULT_TYPE)
-
-_UPDATEPLUGININSTANCE_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='UpdatePluginInstance.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='GEOMETRY', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='VOLUME', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='SCENE', index=2, number=2,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=1227,
-  serialized_end=1270,
-)
-_sym_db.RegisterEnumDescriptor(_UPDATEPLUGININSTANCE_TYPE)
-
-_UPDATEOBJECT_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='UpdateObject.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='MESH', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='GEOMETRY', index=1, number=10,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='VOLUME', index=2, number=20,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='ISOSURFACES', index=3, number=30,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='SLICES', index=4, number=40,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='SCENE', index=5, number=50,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='LIGHT', index=6, number=60,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=1428,
-  serialized_end=1521,
-)
-_sym_db.RegisterEnumDescriptor(_UPDATEOBJECT_TYPE)
-
-_MESHDATA_FLAGS = _descriptor.EnumDescriptor(
-  name='Flags',
-  full_name='MeshData.Flags',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='NONE', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='NORMALS', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='VERTEX_COLORS', index=2, number=2,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=1848,
-  serialized_end=1897,
-)
-_sym_db.RegisterEnumDescriptor(_MESHDATA_FLAGS)
-
-_CAMERASETTINGS_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='CameraSettings.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='PERSPECTIVE', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='ORTHOGRAPHIC', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='PANORAMIC', index=2, number=2,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=2274,
-  serialized_end=2330,
-)
-_sym_db.RegisterEnumDescriptor(_CAMERASETTINGS_TYPE)
-
-_LIGHTSETTINGS_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='LightSettings.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='AMBIENT', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='POINT', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='SUN', index=2, number=2,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='SPOT', index=3, number=3,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='AREA', index=4, number=4,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=2943,
-  serialized_end=3002,
-)
-_sym_db.RegisterEnumDescriptor(_LIGHTSETTINGS_TYPE)
-
-_MATERIALUPDATE_TYPE = _descriptor.EnumDescriptor(
-  name='Type',
-  full_name='MaterialUpdate.Type',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='ALLOY', index=0, number=0,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='CAR_PAINT', index=1, number=1,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='GLASS', index=2, number=2,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='LUMINOUS', index=3, number=3,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='METAL', index=4, number=4,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='METALLIC_PAINT', index=5, number=5,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='OBJMATERIAL', index=6, number=6,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='PRINCIPLED', index=7, number=7,
-      serialized_options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='THIN_GLASS', index=8, number=8,
-      serialized_options=None,
-      type=None),
-  ],
-  containing_type=None,
-  serialized_options=None,
-  serialized_start=3074,
-  serialized_end=3211,
-)
-_sym_db.RegisterEnumDescriptor(_MATERIALUPDATE_TYPE)
-
-
-_CLIENTMESSAGE = _descriptor.Descriptor(
-  name='ClientMessage',
-  full_name='ClientMessage',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='ClientMessage.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='uint_value', full_name='ClientMessage.uint_value', index=1,
-      number=20, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='uint_value2', full_name='ClientMessage.uint_value2', index=2,
-      number=21, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='uint_value3', full_name='ClientMessage.uint_value3', index=3,
-      number=22, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='string_value', full_name='ClientMessage.string_value', index=4,
-      number=40, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _CLIENTMESSAGE_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=19,
-  serialized_end=637,
-)
-
-
-_HELLORESULT = _descriptor.Descriptor(
-  name='HelloResult',
-  full_name='HelloResult',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='success', full_name='HelloResult.success', index=0,
-      number=1, type=8, cpp_type=7, label=1,
-      has_default_value=False, default_value=False,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='message', full_name='HelloResult.message', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=639,
-  serialized_end=686,
-)
-
-
-_SERVERSTATERESULT = _descriptor.Descriptor(
-  name='ServerStateResult',
-  full_name='ServerStateResult',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='state', full_name='ServerStateResult.state', index=0,
-      number=1, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=688,
-  serialized_end=722,
-)
-
-
-_QUERYBOUNDRESULT = _descriptor.Descriptor(
-  name='QueryBoundResult',
-  full_name='QueryBoundResult',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='success', full_name='QueryBoundResult.success', index=0,
-      number=1, type=8, cpp_type=7, label=1,
-      has_default_value=False, default_value=False,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='message', full_name='QueryBoundResult.message', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='result_size', full_name='QueryBoundResult.result_size', index=2,
-      number=3, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=724,
-  serialized_end=797,
-)
-
-
-_RENDERRESULT = _descriptor.Descriptor(
-  name='RenderResult',
-  full_name='RenderResult',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='RenderResult.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='sample', full_name='RenderResult.sample', index=1,
-      number=2, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='reduction_factor', full_name='RenderResult.reduction_factor', index=2,
-      number=3, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='width', full_name='RenderResult.width', index=3,
-      number=4, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='height', full_name='RenderResult.height', index=4,
-      number=5, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='variance', full_name='RenderResult.variance', index=5,
-      number=10, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='file_name', full_name='RenderResult.file_name', index=6,
-      number=20, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='file_size', full_name='RenderResult.file_size', index=7,
-      number=21, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='memory_usage', full_name='RenderResult.memory_usage', index=8,
-      number=30, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='peak_memory_usage', full_name='RenderResult.peak_memory_usage', index=9,
-      number=31, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _RENDERRESULT_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=800,
-  serialized_end=1069,
-)
-
-
-_UPDATEPLUGININSTANCE = _descriptor.Descriptor(
-  name='UpdatePluginInstance',
-  full_name='UpdatePluginInstance',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='UpdatePluginInstance.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='name', full_name='UpdatePluginInstance.name', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='plugin_name', full_name='UpdatePluginInstance.plugin_name', index=2,
-      number=3, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='plugin_parameters', full_name='UpdatePluginInstance.plugin_parameters', index=3,
-      number=4, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='custom_properties', full_name='UpdatePluginInstance.custom_properties', index=4,
-      number=5, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _UPDATEPLUGININSTANCE_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1072,
-  serialized_end=1270,
-)
-
-
-_UPDATEOBJECT = _descriptor.Descriptor(
-  name='UpdateObject',
-  full_name='UpdateObject',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='UpdateObject.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='name', full_name='UpdateObject.name', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='custom_properties', full_name='UpdateObject.custom_properties', index=2,
-      number=3, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='object2world', full_name='UpdateObject.object2world', index=3,
-      number=10, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='data_link', full_name='UpdateObject.data_link', index=4,
-      number=11, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='material_link', full_name='UpdateObject.material_link', index=5,
-      number=12, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _UPDATEOBJECT_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1273,
-  serialized_end=1521,
-)
-
-
-_COLOR = _descriptor.Descriptor(
-  name='Color',
-  full_name='Color',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='r', full_name='Color.r', index=0,
-      number=1, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='g', full_name='Color.g', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='b', full_name='Color.b', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='a', full_name='Color.a', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1523,
-  serialized_end=1574,
-)
-
-
-_VOLUME = _descriptor.Descriptor(
-  name='Volume',
-  full_name='Volume',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='tf_positions', full_name='Volume.tf_positions', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='tf_colors', full_name='Volume.tf_colors', index=1,
-      number=2, type=11, cpp_type=10, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='density_scale', full_name='Volume.density_scale', index=2,
-      number=10, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='anisotropy', full_name='Volume.anisotropy', index=3,
-      number=11, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1576,
-  serialized_end=1676,
-)
-
-
-_SLICE = _descriptor.Descriptor(
-  name='Slice',
-  full_name='Slice',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='name', full_name='Slice.name', index=0,
-      number=1, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='mesh_link', full_name='Slice.mesh_link', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='object2world', full_name='Slice.object2world', index=2,
-      number=3, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1678,
-  serialized_end=1740,
-)
-
-
-_SLICES = _descriptor.Descriptor(
-  name='Slices',
-  full_name='Slices',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='slices', full_name='Slices.slices', index=0,
-      number=1, type=11, cpp_type=10, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1742,
-  serialized_end=1774,
-)
-
-
-_MESHDATA = _descriptor.Descriptor(
-  name='MeshData',
-  full_name='MeshData',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='flags', full_name='MeshData.flags', index=0,
-      number=1, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='num_vertices', full_name='MeshData.num_vertices', index=1,
-      number=10, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='num_triangles', full_name='MeshData.num_triangles', index=2,
-      number=11, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _MESHDATA_FLAGS,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1776,
-  serialized_end=1897,
-)
-
-
-_WORLDSETTINGS = _descriptor.Descriptor(
-  name='WorldSettings',
-  full_name='WorldSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='ambient_color', full_name='WorldSettings.ambient_color', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ambient_intensity', full_name='WorldSettings.ambient_intensity', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='background_color', full_name='WorldSettings.background_color', index=2,
-      number=10, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1899,
-  serialized_end=1990,
-)
-
-
-_CAMERASETTINGS = _descriptor.Descriptor(
-  name='CameraSettings',
-  full_name='CameraSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='CameraSettings.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='object_name', full_name='CameraSettings.object_name', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='camera_name', full_name='CameraSettings.camera_name', index=2,
-      number=3, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='border', full_name='CameraSettings.border', index=3,
-      number=4, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='position', full_name='CameraSettings.position', index=4,
-      number=10, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='view_dir', full_name='CameraSettings.view_dir', index=5,
-      number=11, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='up_dir', full_name='CameraSettings.up_dir', index=6,
-      number=12, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='fov_y', full_name='CameraSettings.fov_y', index=7,
-      number=20, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='height', full_name='CameraSettings.height', index=8,
-      number=30, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='aspect', full_name='CameraSettings.aspect', index=9,
-      number=40, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='clip_start', full_name='CameraSettings.clip_start', index=10,
-      number=50, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='dof_focus_distance', full_name='CameraSettings.dof_focus_distance', index=11,
-      number=60, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='dof_aperture', full_name='CameraSettings.dof_aperture', index=12,
-      number=61, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _CAMERASETTINGS_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=1993,
-  serialized_end=2330,
-)
-
-
-_RENDERSETTINGS = _descriptor.Descriptor(
-  name='RenderSettings',
-  full_name='RenderSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='renderer', full_name='RenderSettings.renderer', index=0,
-      number=1, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='max_path_length', full_name='RenderSettings.max_path_length', index=1,
-      number=4, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='min_contribution', full_name='RenderSettings.min_contribution', index=2,
-      number=5, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='variance_threshold', full_name='RenderSettings.variance_threshold', index=3,
-      number=6, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ao_samples', full_name='RenderSettings.ao_samples', index=4,
-      number=20, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ao_radius', full_name='RenderSettings.ao_radius', index=5,
-      number=21, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ao_intensity', full_name='RenderSettings.ao_intensity', index=6,
-      number=22, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='volume_sampling_rate', full_name='RenderSettings.volume_sampling_rate', index=7,
-      number=23, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='roulette_path_length', full_name='RenderSettings.roulette_path_length', index=8,
-      number=30, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='max_contribution', full_name='RenderSettings.max_contribution', index=9,
-      number=31, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='geometry_lights', full_name='RenderSettings.geometry_lights', index=10,
-      number=32, type=8, cpp_type=7, label=1,
-      has_default_value=False, default_value=False,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=2333,
-  serialized_end=2618,
-)
-
-
-_LIGHTSETTINGS = _descriptor.Descriptor(
-  name='LightSettings',
-  full_name='LightSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='LightSettings.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='object2world', full_name='LightSettings.object2world', index=1,
-      number=2, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='object_name', full_name='LightSettings.object_name', index=2,
-      number=3, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='light_name', full_name='LightSettings.light_name', index=3,
-      number=4, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='color', full_name='LightSettings.color', index=4,
-      number=10, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='intensity', full_name='LightSettings.intensity', index=5,
-      number=11, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='visible', full_name='LightSettings.visible', index=6,
-      number=12, type=8, cpp_type=7, label=1,
-      has_default_value=False, default_value=False,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='direction', full_name='LightSettings.direction', index=7,
-      number=20, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='angular_diameter', full_name='LightSettings.angular_diameter', index=8,
-      number=21, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='position', full_name='LightSettings.position', index=9,
-      number=22, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='radius', full_name='LightSettings.radius', index=10,
-      number=23, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='opening_angle', full_name='LightSettings.opening_angle', index=11,
-      number=24, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='penumbra_angle', full_name='LightSettings.penumbra_angle', index=12,
-      number=25, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='edge1', full_name='LightSettings.edge1', index=13,
-      number=26, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='edge2', full_name='LightSettings.edge2', index=14,
-      number=27, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _LIGHTSETTINGS_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=2621,
-  serialized_end=3002,
-)
-
-
-_MATERIALUPDATE = _descriptor.Descriptor(
-  name='MaterialUpdate',
-  full_name='MaterialUpdate',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='type', full_name='MaterialUpdate.type', index=0,
-      number=1, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='name', full_name='MaterialUpdate.name', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-    _MATERIALUPDATE_TYPE,
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3005,
-  serialized_end=3211,
-)
-
-
-_ALLOYSETTINGS = _descriptor.Descriptor(
-  name='AlloySettings',
-  full_name='AlloySettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='color', full_name='AlloySettings.color', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='edge_color', full_name='AlloySettings.edge_color', index=1,
-      number=2, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='roughness', full_name='AlloySettings.roughness', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3213,
-  serialized_end=3282,
-)
-
-
-_CARPAINTSETTINGS = _descriptor.Descriptor(
-  name='CarPaintSettings',
-  full_name='CarPaintSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='base_color', full_name='CarPaintSettings.base_color', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='roughness', full_name='CarPaintSettings.roughness', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='normal', full_name='CarPaintSettings.normal', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_density', full_name='CarPaintSettings.flake_density', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_scale', full_name='CarPaintSettings.flake_scale', index=4,
-      number=5, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_spread', full_name='CarPaintSettings.flake_spread', index=5,
-      number=6, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_jitter', full_name='CarPaintSettings.flake_jitter', index=6,
-      number=7, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_roughness', full_name='CarPaintSettings.flake_roughness', index=7,
-      number=8, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat', full_name='CarPaintSettings.coat', index=8,
-      number=9, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_ior', full_name='CarPaintSettings.coat_ior', index=9,
-      number=10, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_color', full_name='CarPaintSettings.coat_color', index=10,
-      number=11, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_thickness', full_name='CarPaintSettings.coat_thickness', index=11,
-      number=12, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_roughness', full_name='CarPaintSettings.coat_roughness', index=12,
-      number=13, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_normal', full_name='CarPaintSettings.coat_normal', index=13,
-      number=14, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flipflop_color', full_name='CarPaintSettings.flipflop_color', index=14,
-      number=15, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flipflop_falloff', full_name='CarPaintSettings.flipflop_falloff', index=15,
-      number=16, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3285,
-  serialized_end=3642,
-)
-
-
-_GLASSSETTINGS = _descriptor.Descriptor(
-  name='GlassSettings',
-  full_name='GlassSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='eta', full_name='GlassSettings.eta', index=0,
-      number=1, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='attenuation_color', full_name='GlassSettings.attenuation_color', index=1,
-      number=2, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='attenuation_distance', full_name='GlassSettings.attenuation_distance', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3644,
-  serialized_end=3729,
-)
-
-
-_LUMINOUSSETTINGS = _descriptor.Descriptor(
-  name='LuminousSettings',
-  full_name='LuminousSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='color', full_name='LuminousSettings.color', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='intensity', full_name='LuminousSettings.intensity', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='transparency', full_name='LuminousSettings.transparency', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3731,
-  serialized_end=3805,
-)
-
-
-_METALSETTINGS = _descriptor.Descriptor(
-  name='MetalSettings',
-  full_name='MetalSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='metal', full_name='MetalSettings.metal', index=0,
-      number=1, type=13, cpp_type=3, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='roughness', full_name='MetalSettings.roughness', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3807,
-  serialized_end=3856,
-)
-
-
-_METALLICPAINTSETTINGS = _descriptor.Descriptor(
-  name='MetallicPaintSettings',
-  full_name='MetallicPaintSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='base_color', full_name='MetallicPaintSettings.base_color', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_amount', full_name='MetallicPaintSettings.flake_amount', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_color', full_name='MetallicPaintSettings.flake_color', index=2,
-      number=3, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='flake_spread', full_name='MetallicPaintSettings.flake_spread', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='eta', full_name='MetallicPaintSettings.eta', index=4,
-      number=5, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3858,
-  serialized_end=3979,
-)
-
-
-_OBJMATERIALSETTINGS = _descriptor.Descriptor(
-  name='OBJMaterialSettings',
-  full_name='OBJMaterialSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='kd', full_name='OBJMaterialSettings.kd', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ks', full_name='OBJMaterialSettings.ks', index=1,
-      number=2, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ns', full_name='OBJMaterialSettings.ns', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='d', full_name='OBJMaterialSettings.d', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='tf', full_name='OBJMaterialSettings.tf', index=4,
-      number=5, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=3981,
-  serialized_end=4061,
-)
-
-
-_PRINCIPLEDSETTINGS = _descriptor.Descriptor(
-  name='PrincipledSettings',
-  full_name='PrincipledSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='base_color', full_name='PrincipledSettings.base_color', index=0,
-      number=1, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='edge_color', full_name='PrincipledSettings.edge_color', index=1,
-      number=2, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='metallic', full_name='PrincipledSettings.metallic', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='diffuse', full_name='PrincipledSettings.diffuse', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='specular', full_name='PrincipledSettings.specular', index=4,
-      number=5, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='ior', full_name='PrincipledSettings.ior', index=5,
-      number=6, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='transmission', full_name='PrincipledSettings.transmission', index=6,
-      number=7, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='transmission_color', full_name='PrincipledSettings.transmission_color', index=7,
-      number=8, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='transmission_depth', full_name='PrincipledSettings.transmission_depth', index=8,
-      number=9, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='roughness', full_name='PrincipledSettings.roughness', index=9,
-      number=10, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='anisotropy', full_name='PrincipledSettings.anisotropy', index=10,
-      number=11, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='rotation', full_name='PrincipledSettings.rotation', index=11,
-      number=12, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='normal', full_name='PrincipledSettings.normal', index=12,
-      number=13, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='base_normal', full_name='PrincipledSettings.base_normal', index=13,
-      number=14, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='thin', full_name='PrincipledSettings.thin', index=14,
-      number=15, type=8, cpp_type=7, label=1,
-      has_default_value=False, default_value=False,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='thickness', full_name='PrincipledSettings.thickness', index=15,
-      number=16, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='backlight', full_name='PrincipledSettings.backlight', index=16,
-      number=17, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat', full_name='PrincipledSettings.coat', index=17,
-      number=18, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_ior', full_name='PrincipledSettings.coat_ior', index=18,
-      number=19, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_color', full_name='PrincipledSettings.coat_color', index=19,
-      number=20, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_thickness', full_name='PrincipledSettings.coat_thickness', index=20,
-      number=21, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_roughness', full_name='PrincipledSettings.coat_roughness', index=21,
-      number=22, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='coat_normal', full_name='PrincipledSettings.coat_normal', index=22,
-      number=23, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='sheen', full_name='PrincipledSettings.sheen', index=23,
-      number=24, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='sheen_color', full_name='PrincipledSettings.sheen_color', index=24,
-      number=25, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='sheen_tint', full_name='PrincipledSettings.sheen_tint', index=25,
-      number=26, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='sheen_roughness', full_name='PrincipledSettings.sheen_roughness', index=26,
-      number=27, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='opacity', full_name='PrincipledSettings.opacity', index=27,
-      number=28, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=4064,
-  serialized_end=4633,
-)
-
-
-_THINGLASSSETTINGS = _descriptor.Descriptor(
-  name='ThinGlassSettings',
-  full_name='ThinGlassSettings',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='eta', full_name='ThinGlassSettings.eta', index=0,
-      number=1, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='attenuation_color', full_name='ThinGlassSettings.attenuation_color', index=1,
-      number=2, type=2, cpp_type=6, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='attenuation_distance', full_name='ThinGlassSettings.attenuation_distance', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='thickness', full_name='ThinGlassSettings.thickness', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=4635,
-  serialized_end=4743,
-)
-
-
-_GENERATEFUNCTIONRESULT = _descriptor.Descriptor(
-  name='GenerateFunctionResult',
-  full_name='GenerateFunctionResult',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='success', full_name='GenerateFunctionResult.success', index=0,
-      number=1, type=8, cpp_type=7, label=1,
-      has_default_value=False, default_value=False,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='message', full_name='GenerateFunctionResult.message', index=1,
-      number=2, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-    _descriptor.FieldDescriptor(
-      name='hash', full_name='GenerateFunctionResult.hash', index=2,
-      number=3, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=b"".decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      serialized_options=None, file=DESCRIPTOR),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  serialized_options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=4745,
-  serialized_end=4817,
-)
-
-_CLIENTMESSAGE.fields_by_name['type'].enum_type = _CLIENTMESSAGE_TYPE
-_CLIENTMESSAGE_TYPE.containing_type = _CLIENTMESSAGE
-_RENDERRESULT.fields_by_name['type'].enum_type = _RENDERRESULT_TYPE
-_RENDERRESULT_TYPE.containing_type = _RENDERRESULT
-_UPDATEPLUGININSTANCE.fields_by_name['type'].enum_type = _UPDATEPLUGININSTANCE_TYPE
-_UPDATEPLUGININSTANCE_TYPE.containing_type = _UPDATEPLUGININSTANCE
-_UPDATEOBJECT.fields_by_name['type'].enum_type = _UPDATEOBJECT_TYPE
-_UPDATEOBJECT_TYPE.containing_type = _UPDATEOBJECT
-_VOLUME.fields_by_name['tf_colors'].message_type = _COLOR
-_SLICES.fields_by_name['slices'].message_type = _SLICE
-_MESHDATA_FLAGS.containing_type = _MESHDATA
-_CAMERASETTINGS.fields_by_name['type'].enum_type = _CAMERASETTINGS_TYPE
-_CAMERASETTINGS_TYPE.containing_type = _CAMERASETTINGS
-_LIGHTSETTINGS.fields_by_name['type'].enum_type = _LIGHTSETTINGS_TYPE
-_LIGHTSETTINGS_TYPE.containing_type = _LIGHTSETTINGS
-_MATERIALUPDATE.fields_by_name['type'].enum_type = _MATERIALUPDATE_TYPE
-_MATERIALUPDATE_TYPE.containing_type = _MATERIALUPDATE
-DESCRIPTOR.message_types_by_name['ClientMessage'] = _CLIENTMESSAGE
-DESCRIPTOR.message_types_by_name['HelloResult'] = _HELLORESULT
-DESCRIPTOR.message_types_by_name['ServerStateResult'] = _SERVERSTATERESULT
-DESCRIPTOR.message_types_by_name['QueryBoundResult'] = _QUERYBOUNDRESULT
-DESCRIPTOR.message_types_by_name['RenderResult'] = _RENDERRESULT
-DESCRIPTOR.message_types_by_name['UpdatePluginInstance'] = _UPDATEPLUGININSTANCE
-DESCRIPTOR.message_types_by_name['UpdateObject'] = _UPDATEOBJECT
-DESCRIPTOR.message_types_by_name['Color'] = _COLOR
-DESCRIPTOR.message_types_by_name['Volume'] = _VOLUME
-DESCRIPTOR.message_types_by_name['Slice'] = _SLICE
-DESCRIPTOR.message_types_by_name['Slices'] = _SLICES
-DESCRIPTOR.message_types_by_name['MeshData'] = _MESHDATA
-DESCRIPTOR.message_types_by_name['WorldSettings'] = _WORLDSETTINGS
-DESCRIPTOR.message_types_by_name['CameraSettings'] = _CAMERASETTINGS
-DESCRIPTOR.message_types_by_name['RenderSettings'] = _RENDERSETTINGS
-DESCRIPTOR.message_types_by_name['LightSettings'] = _LIGHTSETTINGS
-DESCRIPTOR.message_types_by_name['MaterialUpdate'] = _MATERIALUPDATE
-DESCRIPTOR.message_types_by_name['AlloySettings'] = _ALLOYSETTINGS
-DESCRIPTOR.message_types_by_name['CarPaintSettings'] = _CARPAINTSETTINGS
-DESCRIPTOR.message_types_by_name['GlassSettings'] = _GLASSSETTINGS
-DESCRIPTOR.message_types_by_name['LuminousSettings'] = _LUMINOUSSETTINGS
-DESCRIPTOR.message_types_by_name['MetalSettings'] = _METALSETTINGS
-DESCRIPTOR.message_types_by_name['MetallicPaintSettings'] = _METALLICPAINTSETTINGS
-DESCRIPTOR.message_types_by_name['OBJMaterialSettings'] = _OBJMATERIALSETTINGS
-DESCRIPTOR.message_types_by_name['PrincipledSettings'] = _PRINCIPLEDSETTINGS
-DESCRIPTOR.message_types_by_name['ThinGlassSettings'] = _THINGLASSSETTINGS
-DESCRIPTOR.message_types_by_name['GenerateFunctionResult'] = _GENERATEFUNCTIONRESULT
-_sym_db.RegisterFileDescriptor(DESCRIPTOR)
-
-ClientMessage = _reflection.GeneratedProtocolMessageType('ClientMessage', (_message.Message,), {
-  'DESCRIPTOR' : _CLIENTMESSAGE,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:ClientMessage)
-  })
-_sym_db.RegisterMessage(ClientMessage)
-
-HelloResult = _reflection.GeneratedProtocolMessageType('HelloResult', (_message.Message,), {
-  'DESCRIPTOR' : _HELLORESULT,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:HelloResult)
-  })
-_sym_db.RegisterMessage(HelloResult)
-
-ServerStateResult = _reflection.GeneratedProtocolMessageType('ServerStateResult', (_message.Message,), {
-  'DESCRIPTOR' : _SERVERSTATERESULT,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:ServerStateResult)
-  })
-_sym_db.RegisterMessage(ServerStateResult)
-
-QueryBoundResult = _reflection.GeneratedProtocolMessageType('QueryBoundResult', (_message.Message,), {
-  'DESCRIPTOR' : _QUERYBOUNDRESULT,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:QueryBoundResult)
-  })
-_sym_db.RegisterMessage(QueryBoundResult)
-
-RenderResult = _reflection.GeneratedProtocolMessageType('RenderResult', (_message.Message,), {
-  'DESCRIPTOR' : _RENDERRESULT,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:RenderResult)
-  })
-_sym_db.RegisterMessage(RenderResult)
-
-UpdatePluginInstance = _reflection.GeneratedProtocolMessageType('UpdatePluginInstance', (_message.Message,), {
-  'DESCRIPTOR' : _UPDATEPLUGININSTANCE,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:UpdatePluginInstance)
-  })
-_sym_db.RegisterMessage(UpdatePluginInstance)
-
-UpdateObject = _reflection.GeneratedProtocolMessageType('UpdateObject', (_message.Message,), {
-  'DESCRIPTOR' : _UPDATEOBJECT,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:UpdateObject)
-  })
-_sym_db.RegisterMessage(UpdateObject)
-
-Color = _reflection.GeneratedProtocolMessageType('Color', (_message.Message,), {
-  'DESCRIPTOR' : _COLOR,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Color)
-  })
-_sym_db.RegisterMessage(Color)
-
-Volume = _reflection.GeneratedProtocolMessageType('Volume', (_message.Message,), {
-  'DESCRIPTOR' : _VOLUME,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Volume)
-  })
-_sym_db.RegisterMessage(Volume)
-
-Slice = _reflection.GeneratedProtocolMessageType('Slice', (_message.Message,), {
-  'DESCRIPTOR' : _SLICE,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Slice)
-  })
-_sym_db.RegisterMessage(Slice)
-
-Slices = _reflection.GeneratedProtocolMessageType('Slices', (_message.Message,), {
-  'DESCRIPTOR' : _SLICES,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Slices)
-  })
-_sym_db.RegisterMessage(Slices)
-
-MeshData = _reflection.GeneratedProtocolMessageType('MeshData', (_message.Message,), {
-  'DESCRIPTOR' : _MESHDATA,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:MeshData)
-  })
-_sym_db.RegisterMessage(MeshData)
-
-WorldSettings = _reflection.GeneratedProtocolMessageType('WorldSettings', (_message.Message,), {
-  'DESCRIPTOR' : _WORLDSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:WorldSettings)
-  })
-_sym_db.RegisterMessage(WorldSettings)
-
-CameraSettings = _reflection.GeneratedProtocolMessageType('CameraSettings', (_message.Message,), {
-  'DESCRIPTOR' : _CAMERASETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:CameraSettings)
-  })
-_sym_db.RegisterMessage(CameraSettings)
-
-RenderSettings = _reflection.GeneratedProtocolMessageType('RenderSettings', (_message.Message,), {
-  'DESCRIPTOR' : _RENDERSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:RenderSettings)
-  })
-_sym_db.RegisterMessage(RenderSettings)
-
-LightSettings = _reflection.GeneratedProtocolMessageType('LightSettings', (_message.Message,), {
-  'DESCRIPTOR' : _LIGHTSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:LightSettings)
-  })
-_sym_db.RegisterMessage(LightSettings)
-
-MaterialUpdate = _reflection.GeneratedProtocolMessageType('MaterialUpdate', (_message.Message,), {
-  'DESCRIPTOR' : _MATERIALUPDATE,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:MaterialUpdate)
-  })
-_sym_db.RegisterMessage(MaterialUpdate)
-
-AlloySettings = _reflection.GeneratedProtocolMessageType('AlloySettings', (_message.Message,), {
-  'DESCRIPTOR' : _ALLOYSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:AlloySettings)
-  })
-_sym_db.RegisterMessage(AlloySettings)
-
-CarPaintSettings = _reflection.GeneratedProtocolMessageType('CarPaintSettings', (_message.Message,), {
-  'DESCRIPTOR' : _CARPAINTSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:CarPaintSettings)
-  })
-_sym_db.RegisterMessage(CarPaintSettings)
-
-GlassSettings = _reflection.GeneratedProtocolMessageType('GlassSettings', (_message.Message,), {
-  'DESCRIPTOR' : _GLASSSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:GlassSettings)
-  })
-_sym_db.RegisterMessage(GlassSettings)
-
-LuminousSettings = _reflection.GeneratedProtocolMessageType('LuminousSettings', (_message.Message,), {
-  'DESCRIPTOR' : _LUMINOUSSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:LuminousSettings)
-  })
-_sym_db.RegisterMessage(LuminousSettings)
-
-MetalSettings = _reflection.GeneratedProtocolMessageType('MetalSettings', (_message.Message,), {
-  'DESCRIPTOR' : _METALSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:MetalSettings)
-  })
-_sym_db.RegisterMessage(MetalSettings)
-
-MetallicPaintSettings = _reflection.GeneratedProtocolMessageType('MetallicPaintSettings', (_message.Message,), {
-  'DESCRIPTOR' : _METALLICPAINTSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:MetallicPaintSettings)
-  })
-_sym_db.RegisterMessage(MetallicPaintSettings)
-
-OBJMaterialSettings = _reflection.GeneratedProtocolMessageType('OBJMaterialSettings', (_message.Message,), {
-  'DESCRIPTOR' : _OBJMATERIALSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:OBJMaterialSettings)
-  })
-_sym_db.RegisterMessage(OBJMaterialSettings)
-
-PrincipledSettings = _reflection.GeneratedProtocolMessageType('PrincipledSettings', (_message.Message,), {
-  'DESCRIPTOR' : _PRINCIPLEDSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:PrincipledSettings)
-  })
-_sym_db.RegisterMessage(PrincipledSettings)
-
-ThinGlassSettings = _reflection.GeneratedProtocolMessageType('ThinGlassSettings', (_message.Message,), {
-  'DESCRIPTOR' : _THINGLASSSETTINGS,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:ThinGlassSettings)
-  })
-_sym_db.RegisterMessage(ThinGlassSettings)
-
-GenerateFunctionResult = _reflection.GeneratedProtocolMessageType('GenerateFunctionResult', (_message.Message,), {
-  'DESCRIPTOR' : _GENERATEFUNCTIONRESULT,
-  '__module__' : 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:GenerateFunctionResult)
-  })
-_sym_db.RegisterMessage(GenerateFunctionResult)
-
-
+DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0emessages.proto\"\xfb\x05\n\rClientMessage\x12!\n\x04type\x18\x01 \x01(\x0e\x32\x13.ClientMessage.Type\x12\x12\n\nuint_value\x18\x14 \x01(\r\x12\x13\n\x0buint_value2\x18\x15 \x01(\r\x12\x13\n\x0buint_value3\x18\x16 \x01(\r\x12\x13\n\x0buint_value4\x18\x17 \x01(\r\x12\x13\n\x0b\x66loat_value\x18\x1e \x01(\x02\x12\x14\n\x0cstring_value\x18( \x01(\t\x12\x15\n\rstring_value2\x18) \x01(\t\"\xb1\x04\n\x04Type\x12\t\n\x05HELLO\x10\x00\x12\x07\n\x03\x42YE\x10\x01\x12\x0f\n\x0b\x43LEAR_SCENE\x10\x0b\x12\x18\n\x14UPDATE_RENDERER_TYPE\x10\x14\x12\x19\n\x15UPDATE_WORLD_SETTINGS\x10\x15\x12\x1a\n\x16UPDATE_RENDER_SETTINGS\x10\x16\x12\x1f\n\x1bUPDATE_FRAMEBUFFER_SETTINGS\x10\x17\x12\x17\n\x13UPDATE_BLENDER_MESH\x10\x18\x12\x1a\n\x16UPDATE_PLUGIN_INSTANCE\x10\x19\x12\x11\n\rUPDATE_CAMERA\x10\x1a\x12\x13\n\x0fUPDATE_MATERIAL\x10\x1b\x12\x11\n\rUPDATE_OBJECT\x10\x1c\x12\x16\n\x12UPDATE_SCENE_BATCH\x10\x1d\x12\x11\n\rDELETE_OBJECT\x10\x1e\x12\x17\n\x13\x44\x45LETE_BLENDER_MESH\x10\x1f\x12\x1a\n\x16\x44\x45LETE_PLUGIN_INSTANCE\x10 \x12\x13\n\x0fSTART_RENDERING\x10(\x12\x13\n\x0fPAUSE_RENDERING\x10)\x12\x14\n\x10\x43\x41NCEL_RENDERING\x10*\x12\x19\n\x15REQUEST_RENDER_OUTPUT\x10\x31\x12\x14\n\x10GET_SERVER_STATE\x10\x32\x12\x0f\n\x0bQUERY_BOUND\x10\x33\x12\x18\n\x14SUBMIT_ANIMATION_JOB\x10<\x12\x1c\n\x18\x44ISTRIBUTED_RENDER_FRAME\x10\x46\x12\x08\n\x04QUIT\x10\x63\"A\n\x0bHelloResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x10\n\x08shm_name\x18\x03 \x01(\t\"\"\n\x11ServerStateResult\x12\r\n\x05state\x18\x01 \x01(\t\"\xa7\x01\n\x0c\x41nimationJob\x12\x18\n\x10output_directory\x18\x01 \x01(\t\x12\r\n\x05width\x18\x02 \x01(\r\x12\x0e\n\x06height\x18\x03 \x01(\r\x12\x0f\n\x07samples\x18\x04 \x01(\r\x12\x17\n\x0fvariance_target\x18\x05 \x01(\x02\x12\x13\n\x0btime_budget\x18\x06 \x01(\r\x12\x1f\n\x06\x66rames\x18\x07 \x03(\x0b\x32\x0f.AnimationFrame\"_\n\x0e\x41nimationFrame\x12\r\n\x05\x66rame\x18\x01 \x01(\r\x12\x1f\n\x06\x63\x61mera\x18\x02 \x01(\x0b\x32\x0f.CameraSettings\x12\x1d\n\x07updates\x18\x03 \x03(\x0b\x32\x0c.SceneUpdate\"L\n\x12\x41nimationJobResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x14\n\x0cqueue_length\x18\x03 \x01(\r\"\x8f\x01\n\x10QueryBoundResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x13\n\x0bresult_size\x18\x03 \x01(\r\x12\x19\n\x11uncompressed_size\x18\x04 \x01(\r\x12\x10\n\x08\x65ncoding\x18\x05 \x01(\r\x12\x17\n\x0flevel_of_detail\x18\x06 \x01(\r\"\xc8\x04\n\x0cRenderResult\x12 \n\x04type\x18\x01 \x01(\x0e\x32\x12.RenderResult.Type\x12\x0e\n\x06sample\x18\x02 \x01(\r\x12\x18\n\x10reduction_factor\x18\x03 \x01(\r\x12\r\n\x05width\x18\x04 \x01(\r\x12\x0e\n\x06height\x18\x05 \x01(\r\x12\x10\n\x08variance\x18\n \x01(\x02\x12\x11\n\tfile_name\x18\x14 \x01(\t\x12\x11\n\tfile_size\x18\x15 \x01(\r\x12\x0e\n\x06\x66ormat\x18\x16 \x01(\r\x12\x10\n\x08\x65ncoding\x18\x17 \x01(\r\x12\x13\n\x0bpixels_size\x18\x18 \x01(\r\x12\x11\n\ttile_size\x18\x19 \x01(\r\x12\x11\n\tnum_tiles\x18\x1a \x01(\r\x12\x10\n\x08shm_slot\x18\x1b \x01(\r\x12\x15\n\rshm_slot_size\x18\x1c \x01(\x04\x12\x14\n\x0cmemory_usage\x18\x1e \x01(\x02\x12\x19\n\x11peak_memory_usage\x18\x1f \x01(\x02\x12\x13\n\x0brender_time\x18( \x01(\x02\x12\x14\n\x0cprepare_time\x18) \x01(\x02\x12\x1d\n\x15\x66ramebuffer_copy_time\x18* \x01(\x02\x12\x13\n\x0b\x65ncode_time\x18+ \x01(\x02\x12\x11\n\tsend_time\x18, \x01(\x02\")\n\x04Type\x12\t\n\x05\x46RAME\x10\x00\x12\x0c\n\x08\x43\x41NCELED\x10\x01\x12\x08\n\x04\x44ONE\x10\x02\"A\n\x08\x45ncoding\x12\x07\n\x03RAW\x10\x00\x12\x0e\n\nHALF_FLOAT\x10\x01\x12\x07\n\x03LZ4\x10\x02\x12\x08\n\x04ZSTD\x10\x04\x12\t\n\x05TILES\x10\x08\"1\n\x10SceneUpdateBatch\x12\x1d\n\x07updates\x18\x01 \x03(\x0b\x32\x0c.SceneUpdate\"B\n\x0bSceneUpdate\x12!\n\x04type\x18\x01 \x01(\x0e\x32\x13.ClientMessage.Type\x12\x10\n\x08messages\x18\x02 \x03(\x0c\"N\n\x16SceneUpdateBatchResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x13\n\x0bnum_updates\x18\x02 \x01(\r\x12\x0e\n\x06\x65rrors\x18\x03 \x03(\t\"\xc6\x01\n\x14UpdatePluginInstance\x12(\n\x04type\x18\x01 \x01(\x0e\x32\x1a.UpdatePluginInstance.Type\x12\x0c\n\x04name\x18\x02 \x01(\t\x12\x13\n\x0bplugin_name\x18\x03 \x01(\t\x12\x19\n\x11plugin_parameters\x18\x04 \x01(\t\x12\x19\n\x11\x63ustom_properties\x18\x05 \x01(\t\"+\n\x04Type\x12\x0c\n\x08GEOMETRY\x10\x00\x12\n\n\x06VOLUME\x10\x01\x12\t\n\x05SCENE\x10\x02\"\xf8\x01\n\x0cUpdateObject\x12 \n\x04type\x18\x01 \x01(\x0e\x32\x12.UpdateObject.Type\x12\x0c\n\x04name\x18\x02 \x01(\t\x12\x19\n\x11\x63ustom_properties\x18\x03 \x01(\t\x12\x14\n\x0cobject2world\x18\n \x03(\x02\x12\x11\n\tdata_link\x18\x0b \x01(\t\x12\x15\n\rmaterial_link\x18\x0c \x01(\t\"]\n\x04Type\x12\x08\n\x04MESH\x10\x00\x12\x0c\n\x08GEOMETRY\x10\n\x12\n\n\x06VOLUME\x10\x14\x12\x0f\n\x0bISOSURFACES\x10\x1e\x12\n\n\x06SLICES\x10(\x12\t\n\x05SCENE\x10\x32\x12\t\n\x05LIGHT\x10<\"3\n\x05\x43olor\x12\t\n\x01r\x18\x01 \x01(\x02\x12\t\n\x01g\x18\x02 \x01(\x02\x12\t\n\x01\x62\x18\x03 \x01(\x02\x12\t\n\x01\x61\x18\x04 \x01(\x02\"d\n\x06Volume\x12\x14\n\x0ctf_positions\x18\x01 \x03(\x02\x12\x19\n\ttf_colors\x18\x02 \x03(\x0b\x32\x06.Color\x12\x15\n\rdensity_scale\x18\n \x01(\x02\x12\x12\n\nanisotropy\x18\x0b \x01(\x02\">\n\x05Slice\x12\x0c\n\x04name\x18\x01 \x01(\t\x12\x11\n\tmesh_link\x18\x02 \x01(\t\x12\x14\n\x0cobject2world\x18\x03 \x03(\x02\" \n\x06Slices\x12\x16\n\x06slices\x18\x01 \x03(\x0b\x32\x06.Slice\"\xf6\x01\n\x08MeshData\x12\r\n\x05\x66lags\x18\x01 \x01(\r\x12\x14\n\x0cnum_vertices\x18\n \x01(\r\x12\x15\n\rnum_triangles\x18\x0b \x01(\r\x12\x14\n\x0c\x63ontent_hash\x18\x0c \x01(\t\"\x97\x01\n\x05\x46lags\x12\x08\n\x04NONE\x10\x00\x12\x0b\n\x07NORMALS\x10\x01\x12\x11\n\rVERTEX_COLORS\x10\x02\x12\x16\n\x12TOPOLOGY_UNCHANGED\x10\x10\x12\x17\n\x13POSITIONS_UNCHANGED\x10 \x12\x15\n\x11NORMALS_UNCHANGED\x10@\x12\x1c\n\x17VERTEX_COLORS_UNCHANGED\x10\x80\x01\"!\n\x0fMeshCacheResult\x12\x0e\n\x06\x63\x61\x63hed\x18\x01 \x01(\x08\"[\n\rWorldSettings\x12\x15\n\rambient_color\x18\x01 \x03(\x02\x12\x19\n\x11\x61mbient_intensity\x18\x02 \x01(\x02\x12\x18\n\x10\x62\x61\x63kground_color\x18\n \x03(\x02\"\xd1\x02\n\x0e\x43\x61meraSettings\x12\"\n\x04type\x18\x01 \x01(\x0e\x32\x14.CameraSettings.Type\x12\x13\n\x0bobject_name\x18\x02 \x01(\t\x12\x13\n\x0b\x63\x61mera_name\x18\x03 \x01(\t\x12\x0e\n\x06\x62order\x18\x04 \x03(\x02\x12\x10\n\x08position\x18\n \x03(\x02\x12\x10\n\x08view_dir\x18\x0b \x03(\x02\x12\x0e\n\x06up_dir\x18\x0c \x03(\x02\x12\r\n\x05\x66ov_y\x18\x14 \x01(\x02\x12\x0e\n\x06height\x18\x1e \x01(\x02\x12\x0e\n\x06\x61spect\x18( \x01(\x02\x12\x12\n\nclip_start\x18\x32 \x01(\x02\x12\x1a\n\x12\x64of_focus_distance\x18< \x01(\x02\x12\x14\n\x0c\x64of_aperture\x18= \x01(\x02\"8\n\x04Type\x12\x0f\n\x0bPERSPECTIVE\x10\x00\x12\x10\n\x0cORTHOGRAPHIC\x10\x01\x12\r\n\tPANORAMIC\x10\x02\"\xda\x02\n\x0eRenderSettings\x12\x10\n\x08renderer\x18\x01 \x01(\t\x12\x17\n\x0fmax_path_length\x18\x04 \x01(\r\x12\x18\n\x10min_contribution\x18\x05 \x01(\x02\x12\x1a\n\x12variance_threshold\x18\x06 \x01(\x02\x12\x12\n\nao_samples\x18\x14 \x01(\r\x12\x11\n\tao_radius\x18\x15 \x01(\x02\x12\x14\n\x0c\x61o_intensity\x18\x16 \x01(\x02\x12\x1c\n\x14volume_sampling_rate\x18\x17 \x01(\x02\x12\x1c\n\x14roulette_path_length\x18\x1e \x01(\r\x12\x18\n\x10max_contribution\x18\x1f \x01(\x02\x12\x17\n\x0fgeometry_lights\x18  \x01(\x08\x12$\n\x1c\x64\x65noise_interactive_interval\x18( \x01(\r\x12\x15\n\rdenoise_final\x18) \x01(\x08\"\xfd\x02\n\rLightSettings\x12!\n\x04type\x18\x01 \x01(\x0e\x32\x13.LightSettings.Type\x12\x14\n\x0cobject2world\x18\x02 \x03(\x02\x12\x13\n\x0bobject_name\x18\x03 \x01(\t\x12\x12\n\nlight_name\x18\x04 \x01(\t\x12\r\n\x05\x63olor\x18\n \x03(\x02\x12\x11\n\tintensity\x18\x0b \x01(\x02\x12\x0f\n\x07visible\x18\x0c \x01(\x08\x12\x11\n\tdirection\x18\x14 \x03(\x02\x12\x18\n\x10\x61ngular_diameter\x18\x15 \x01(\x02\x12\x10\n\x08position\x18\x16 \x03(\x02\x12\x0e\n\x06radius\x18\x17 \x01(\x02\x12\x15\n\ropening_angle\x18\x18 \x01(\x02\x12\x16\n\x0epenumbra_angle\x18\x19 \x01(\x02\x12\r\n\x05\x65\x64ge1\x18\x1a \x03(\x02\x12\r\n\x05\x65\x64ge2\x18\x1b \x03(\x02\";\n\x04Type\x12\x0b\n\x07\x41MBIENT\x10\x00\x12\t\n\x05POINT\x10\x01\x12\x07\n\x03SUN\x10\x02\x12\x08\n\x04SPOT\x10\x03\x12\x08\n\x04\x41REA\x10\x04\"\xce\x01\n\x0eMaterialUpdate\x12\"\n\x04type\x18\x01 \x01(\x0e\x32\x14.MaterialUpdate.Type\x12\x0c\n\x04name\x18\x02 \x01(\t\"\x89\x01\n\x04Type\x12\t\n\x05\x41LLOY\x10\x00\x12\r\n\tCAR_PAINT\x10\x01\x12\t\n\x05GLASS\x10\x02\x12\x0c\n\x08LUMINOUS\x10\x03\x12\t\n\x05METAL\x10\x04\x12\x12\n\x0eMETALLIC_PAINT\x10\x05\x12\x0f\n\x0bOBJMATERIAL\x10\x06\x12\x0e\n\nPRINCIPLED\x10\x07\x12\x0e\n\nTHIN_GLASS\x10\x08\"E\n\rAlloySettings\x12\r\n\x05\x63olor\x18\x01 \x03(\x02\x12\x12\n\nedge_color\x18\x02 \x03(\x02\x12\x11\n\troughness\x18\x03 \x01(\x02\"\xe5\x02\n\x10\x43\x61rPaintSettings\x12\x12\n\nbase_color\x18\x01 \x03(\x02\x12\x11\n\troughness\x18\x02 \x01(\x02\x12\x0e\n\x06normal\x18\x03 \x01(\x02\x12\x15\n\rflake_density\x18\x04 \x01(\x02\x12\x13\n\x0b\x66lake_scale\x18\x05 \x01(\x02\x12\x14\n\x0c\x66lake_spread\x18\x06 \x01(\x02\x12\x14\n\x0c\x66lake_jitter\x18\x07 \x01(\x02\x12\x17\n\x0f\x66lake_roughness\x18\x08 \x01(\x02\x12\x0c\n\x04\x63oat\x18\t \x01(\x02\x12\x10\n\x08\x63oat_ior\x18\n \x01(\x02\x12\x12\n\ncoat_color\x18\x0b \x03(\x02\x12\x16\n\x0e\x63oat_thickness\x18\x0c \x01(\x02\x12\x16\n\x0e\x63oat_roughness\x18\r \x01(\x02\x12\x13\n\x0b\x63oat_normal\x18\x0e \x01(\x02\x12\x16\n\x0e\x66lipflop_color\x18\x0f \x03(\x02\x12\x18\n\x10\x66lipflop_falloff\x18\x10 \x01(\x02\"U\n\rGlassSettings\x12\x0b\n\x03\x65ta\x18\x01 \x01(\x02\x12\x19\n\x11\x61ttenuation_color\x18\x02 \x03(\x02\x12\x1c\n\x14\x61ttenuation_distance\x18\x03 \x01(\x02\"J\n\x10LuminousSettings\x12\r\n\x05\x63olor\x18\x01 \x03(\x02\x12\x11\n\tintensity\x18\x02 \x01(\x02\x12\x14\n\x0ctransparency\x18\x03 \x01(\x02\"1\n\rMetalSettings\x12\r\n\x05metal\x18\x01 \x01(\r\x12\x11\n\troughness\x18\x02 \x01(\x02\"y\n\x15MetallicPaintSettings\x12\x12\n\nbase_color\x18\x01 \x03(\x02\x12\x14\n\x0c\x66lake_amount\x18\x02 \x01(\x02\x12\x13\n\x0b\x66lake_color\x18\x03 \x03(\x02\x12\x14\n\x0c\x66lake_spread\x18\x04 \x01(\x02\x12\x0b\n\x03\x65ta\x18\x05 \x01(\x02\"P\n\x13OBJMaterialSettings\x12\n\n\x02kd\x18\x01 \x03(\x02\x12\n\n\x02ks\x18\x02 \x03(\x02\x12\n\n\x02ns\x18\x03 \x01(\x02\x12\t\n\x01\x64\x18\x04 \x01(\x02\x12\n\n\x02tf\x18\x05 \x03(\x02\"\xb9\x04\n\x12PrincipledSettings\x12\x12\n\nbase_color\x18\x01 \x03(\x02\x12\x12\n\nedge_color\x18\x02 \x03(\x02\x12\x10\n\x08metallic\x18\x03 \x01(\x02\x12\x0f\n\x07\x64iffuse\x18\x04 \x01(\x02\x12\x10\n\x08specular\x18\x05 \x01(\x02\x12\x0b\n\x03ior\x18\x06 \x01(\x02\x12\x14\n\x0ctransmission\x18\x07 \x01(\x02\x12\x1a\n\x12transmission_color\x18\x08 \x03(\x02\x12\x1a\n\x12transmission_depth\x18\t \x01(\x02\x12\x11\n\troughness\x18\n \x01(\x02\x12\x12\n\nanisotropy\x18\x0b \x01(\x02\x12\x10\n\x08rotation\x18\x0c \x01(\x02\x12\x0e\n\x06normal\x18\r \x01(\x02\x12\x13\n\x0b\x62\x61se_normal\x18\x0e \x01(\x02\x12\x0c\n\x04thin\x18\x0f \x01(\x08\x12\x11\n\tthickness\x18\x10 \x01(\x02\x12\x11\n\tbacklight\x18\x11 \x01(\x02\x12\x0c\n\x04\x63oat\x18\x12 \x01(\x02\x12\x10\n\x08\x63oat_ior\x18\x13 \x01(\x02\x12\x12\n\ncoat_color\x18\x14 \x03(\x02\x12\x16\n\x0e\x63oat_thickness\x18\x15 \x01(\x02\x12\x16\n\x0e\x63oat_roughness\x18\x16 \x01(\x02\x12\x13\n\x0b\x63oat_normal\x18\x17 \x01(\x02\x12\r\n\x05sheen\x18\x18 \x01(\x02\x12\x13\n\x0bsheen_color\x18\x19 \x03(\x02\x12\x12\n\nsheen_tint\x18\x1a \x01(\x02\x12\x17\n\x0fsheen_roughness\x18\x1b \x01(\x02\x12\x0f\n\x07opacity\x18\x1c \x01(\x02\"l\n\x11ThinGlassSettings\x12\x0b\n\x03\x65ta\x18\x01 \x01(\x02\x12\x19\n\x11\x61ttenuation_color\x18\x02 \x03(\x02\x12\x1c\n\x14\x61ttenuation_distance\x18\x03 \x01(\x02\x12\x11\n\tthickness\x18\x04 \x01(\x02\"H\n\x16GenerateFunctionResult\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0c\n\x04hash\x18\x03 \x01(\tb\x06proto3')
+
+_builder.BuildMessageAndEnumDescriptors(DESCRIPTOR, globals())
+_builder.BuildTopDescriptorsAndMessages(DESCRIPTOR, 'messages_pb2', globals())
+if _descriptor._USE_C_DESCRIPTORS == False:
+
+  DESCRIPTOR._options = None
+  _CLIENTMESSAGE._serialized_start=19
+  _CLIENTMESSAGE._serialized_end=782
+  _CLIENTMESSAGE_TYPE._serialized_start=221
+  _CLIENTMESSAGE_TYPE._serialized_end=782
+  _HELLORESULT._serialized_start=784
+  _HELLORESULT._serialized_end=849
+  _SERVERSTATERESULT._serialized_start=851
+  _SERVERSTATERESULT._serialized_end=885
+  _ANIMATIONJOB._serialized_start=888
+  _ANIMATIONJOB._serialized_end=1055
+  _ANIMATIONFRAME._serialized_start=1057
+  _ANIMATIONFRAME._serialized_end=1152
+  _ANIMATIONJOBRESULT._serialized_start=1154
+  _ANIMATIONJOBRESULT._serialized_end=1230
+  _QUERYBOUNDRESULT._serialized_start=1233
+  _QUERYBOUNDRESULT._serialized_end=1376
+  _RENDERRESULT._serialized_start=1379
+  _RENDERRESULT._serialized_end=1963
+  _RENDERRESULT_TYPE._serialized_start=1855
+  _RENDERRESULT_TYPE._serialized_end=1896
+  _RENDERRESULT_ENCODING._serialized_start=1898
+  _RENDERRESULT_ENCODING._serialized_end=1963
+  _SCENEUPDATEBATCH._serialized_start=1965
+  _SCENEUPDATEBATCH._serialized_end=2014
+  _SCENEUPDATE._serialized_start=2016
+  _SCENEUPDATE._serialized_end=2082
+  _SCENEUPDATEBATCHRESULT._serialized_start=2084
+  _SCENEUPDATEBATCHRESULT._serialized_end=2162
+  _UPDATEPLUGININSTANCE._serialized_start=2165
+  _UPDATEPLUGININSTANCE._serialized_end=2363
+  _UPDATEPLUGININSTANCE_TYPE._serialized_start=2320
+  _UPDATEPLUGININSTANCE_TYPE._serialized_end=2363
+  _UPDATEOBJECT._serialized_start=2366
+  _UPDATEOBJECT._serialized_end=2614
+  _UPDATEOBJECT_TYPE._serialized_start=2521
+  _UPDATEOBJECT_TYPE._serialized_end=2614
+  _COLOR._serialized_start=2616
+  _COLOR._serialized_end=2667
+  _VOLUME._serialized_start=2669
+  _VOLUME._serialized_end=2769
+  _SLICE._serialized_start=2771
+  _SLICE._serialized_end=2833
+  _SLICES._serialized_start=2835
+  _SLICES._serialized_end=2867
+  _MESHDATA._serialized_start=2870
+  _MESHDATA._serialized_end=3116
+  _MESHDATA_FLAGS._serialized_start=2965
+  _MESHDATA_FLAGS._serialized_end=3116
+  _MESHCACHERESULT._serialized_start=3118
+  _MESHCACHERESULT._serialized_end=3151
+  _WORLDSETTINGS._serialized_start=3153
+  _WORLDSETTINGS._serialized_end=3244
+  _CAMERASETTINGS._serialized_start=3247
+  _CAMERASETTINGS._serialized_end=3584
+  _CAMERASETTINGS_TYPE._serialized_start=3528
+  _CAMERASETTINGS_TYPE._serialized_end=3584
+  _RENDERSETTINGS._serialized_start=3587
+  _RENDERSETTINGS._serialized_end=3933
+  _LIGHTSETTINGS._serialized_start=3936
+  _LIGHTSETTINGS._serialized_end=4317
+  _LIGHTSETTINGS_TYPE._serialized_start=4258
+  _LIGHTSETTINGS_TYPE._serialized_end=4317
+  _MATERIALUPDATE._serialized_start=4320
+  _MATERIALUPDATE._serialized_end=4526
+  _MATERIALUPDATE_TYPE._serialized_start=4389
+  _MATERIALUPDATE_TYPE._serialized_end=4526
+  _ALLOYSETTINGS._serialized_start=4528
+  _ALLOYSETTINGS._serialized_end=4597
+  _CARPAINTSETTINGS._serialized_start=4600
+  _CARPAINTSETTINGS._serialized_end=4957
+  _GLASSSETTINGS._serialized_start=4959
+  _GLASSSETTINGS._serialized_end=5044
+  _LUMINOUSSETTINGS._serialized_start=5046
+  _LUMINOUSSETTINGS._serialized_end=5120
+  _METALSETTINGS._serialized_start=5122
+  _METALSETTINGS._serialized_end=5171
+  _METALLICPAINTSETTINGS._serialized_start=5173
+  _METALLICPAINTSETTINGS._serialized_end=5294
+  _OBJMATERIALSETTINGS._serialized_start=5296
+  _OBJMATERIALSETTINGS._serialized_end=5376
+  _PRINCIPLEDSETTINGS._serialized_start=5379
+  _PRINCIPLEDSETTINGS._serialized_end=5948
+  _THINGLASSSETTINGS._serialized_start=5950
+  _THINGLASSSETTINGS._serialized_end=6058
+  _GENERATEFUNCTIONRESULT._serialized_start=6060
+  _GENERATEFUNCTIONRESULT._serialized_end=6132
 # @@protoc_insertion_point(module_scope)
@@ -3,9 +3,18 @@ import socket
 from struct import unpack
 import numpy
 
-from .common import PROTOCOL_VERSION, send_protobuf, receive_protobuf, receive_buffer, receive_into_numpy_array
+from .common import PROTOCOL_VERSION, send_protobuf, receive_protobuf, receive_buffer, receive_into_numpy_array, session_name
 from .connection import Connection
-from .messages_pb2 import ClientMessage, HelloResult, QueryBoundResult, ServerStateResult
+from .messages_pb2 import ClientMessage, HelloResult, QueryBoundResult, ServerStateResult, RenderResult
+
+try:
+    import lz4.block
+except ImportError:
+    lz4 = None
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
 
 # XXX if this operator gets called during rendering, then what? :)
 
@@ -36,6 +45,7 @@ class OSPRayUpdateMeshBound(bpy.types.Operator):
         client_message = ClientMessage()
         client_message.type = ClientMessage.HELLO
         client_message.uint_value = PROTOCOL_VERSION
+        client_message.string_value2 = session_name()
         send_protobuf(sock, client_message)
 
         result = HelloResult()
@@ -56,6 +66,12 @@ class OSPRayUpdateMeshBound(bpy.types.Operator):
         client_message = ClientMessage()
         client_message.type = ClientMessage.QUERY_BOUND
         client_message.string_value = mesh.name
+        client_message.uint_value = int(mesh.ospray.bound_level_of_detail)
+        client_message.uint_value2 = 0
+        if lz4 is not None:
+            client_message.uint_value2 |= RenderResult.LZ4
+        if zstandard is not None:
+            client_message.uint_value2 |= RenderResult.ZSTD
         send_protobuf(sock, client_message)
 
         # Get result
@@ -69,24 +85,32 @@ class OSPRayUpdateMeshBound(bpy.types.Operator):
             self.report({'ERROR'}, 'Query failed: %s' % result.message)
             return {'CANCELLED'}
 
-        # Receive actual geometry
+        # Receive actual geometry, as a single (possibly compressed) buffer
+
+        data = receive_buffer(sock, result.result_size)
+
+        if result.encoding == RenderResult.LZ4:
+            data = lz4.block.decompress(data, uncompressed_size=result.uncompressed_size)
+        elif result.encoding == RenderResult.ZSTD:
+            data = zstandard.ZstdDecompressor().decompress(data, max_output_size=result.uncompressed_size)
+
         # Lengths are for the complete vector, not the number of higher
         # level elements
-        vertices_len, edges_len, faces_len, loop_len = unpack('<IIII', receive_buffer(sock, 4*4))
-        
-        vertices = numpy.empty(vertices_len, dtype=numpy.float32)
-        edges = numpy.empty(edges_len, dtype=numpy.uint32)
-        faces = numpy.empty(faces_len, dtype=numpy.uint32)
-        loop_start = numpy.empty(loop_len, dtype=numpy.uint32)
-        loop_total = numpy.empty(loop_len, dtype=numpy.uint32)
-
-        print('Mesh bound: %d v, %d e, %d f, %d l' % (vertices_len, edges_len, faces_len, loop_len))
-        
-        receive_into_numpy_array(sock, vertices, vertices_len*4)
-        receive_into_numpy_array(sock, edges, edges_len*4)
-        receive_into_numpy_array(sock, faces, faces_len*4)
-        receive_into_numpy_array(sock, loop_start, loop_len*4)
-        receive_into_numpy_array(sock, loop_total, loop_len*4)
+        vertices_len, edges_len, faces_len, loop_len = unpack('<IIII', data[:4*4])
+
+        print('Mesh bound (level %d): %d v, %d e, %d f, %d l (%d bytes received)' % \
+            (result.level_of_detail, vertices_len, edges_len, faces_len, loop_len, result.result_size))
+
+        offset = 4*4
+        vertices = numpy.frombuffer(data, dtype=numpy.float32, count=vertices_len, offset=offset)
+        offset += vertices_len*4
+        edges = numpy.frombuffer(data, dtype=numpy.uint32, count=edges_len, offset=offset)
+        offset += edges_len*4
+        faces = numpy.frombuffer(data, dtype=numpy.uint32, count=faces_len, offset=offset)
+        offset += faces_len*4
+        loop_start = numpy.frombuffer(data, dtype=numpy.uint32, count=loop_len, offset=offset)
+        offset += loop_len*4
+        loop_total = numpy.frombuffer(data, dtype=numpy.uint32, count=loop_len, offset=offset)
         
         #print(vertices)
         #print(edges)
@@ -143,6 +167,7 @@ class OSPRayGetServerState(bpy.types.Operator):
         client_message = ClientMessage()
         client_message.type = ClientMessage.HELLO
         client_message.uint_value = PROTOCOL_VERSION
+        client_message.string_value2 = session_name()
         send_protobuf(sock, client_message)
 
         result = HelloResult()
@@ -177,10 +202,63 @@ class OSPRayGetServerState(bpy.types.Operator):
         return {'FINISHED'}
 
 
+class AnimationJobEngine:
+    """Stands in for the render engine, for a Connection used outside of rendering"""
+
+    camera_override = None
+
+    def update_stats(self, stats, info):
+        print(info)
+
+
+class OSPRaySubmitAnimationJob(bpy.types.Operator):
+    
+    """Render the scene's frame range on the server, in the background. Frames are 
+    saved as EXR files in the output directory, on the server"""
+    bl_idname = "ospray.submit_animation_job"
+    bl_label = "Submit animation job"
+    bl_options = {'REGISTER'}
+
+    def execute(self, context):
+
+        scene = context.scene
+        ospray = scene.ospray
+        output_directory = bpy.path.abspath(scene.render.filepath).rstrip('/')
+
+        # A separate session, so the job doesn't hold up interactive 
+        # or final rendering from this Blender instance.
+        # XXX a second submit blocks until the session's current job is done
+        engine = AnimationJobEngine()
+        connection = Connection(engine, ospray.host, ospray.port)
+
+        if not connection.connect(session=session_name()+':job'):
+            self.report({'ERROR'}, 'Failed to connect to server')
+            return {'CANCELLED'}
+
+        current_frame = scene.frame_current
+        scene.frame_set(scene.frame_start)
+
+        connection.update(None, context.evaluated_depsgraph_get())
+        result = connection.submit_animation_job(context, scene.frame_start, scene.frame_end, output_directory)
+
+        connection.close()
+
+        scene.frame_set(current_frame)
+
+        if not result.success:
+            self.report({'ERROR'}, 'Animation job failed: %s' % result.message)
+            return {'CANCELLED'}
+
+        self.report({'INFO'}, 'Submitted animation job for frames %d-%d (%d job(s) queued)' % \
+            (scene.frame_start, scene.frame_end, result.queue_length))
+
+        return {'FINISHED'}
+
 
 classes = (
     OSPRayUpdateMeshBound,
-    OSPRayGetServerState
+    OSPRayGetServerState,
+    OSPRaySubmitAnimationJob
 )
 
 def register():
@@ -108,6 +108,21 @@ class RenderOspraySettingsScene(PropertyGroup):
         max = 65535
         )
 
+    render_variance_target: FloatProperty(
+        name='Variance target',
+        description='Final render stops when the estimated variance drops below this value, or after the number of render samples (use 0 to always render all samples)',
+        default = 0,
+        min = 0,
+        max = 100
+        )
+
+    render_time_budget: IntProperty(
+        name='Time budget (s)',
+        description='Final render stops after the sample that exceeds this number of seconds (use 0 for no limit)',
+        default = 0,
+        min = 0
+        )
+
     viewport_samples: IntProperty(
         name='Viewport samples',
         description='Number of samples per pixel (spp), interactive render',
@@ -198,6 +213,22 @@ class RenderOspraySettingsScene(PropertyGroup):
         default = True
         )
 
+    # Denoising (on the server, when available)
+
+    denoise_final: BoolProperty(
+        name="Denoise final render",
+        description="Denoise the final render after the last sample, using normal and albedo buffers",
+        default = False
+        )
+
+    denoise_interactive_interval: IntProperty(
+        name='Denoise viewport after',
+        description='In viewport rendering denoise from sample N on, or only the last sample when there are fewer (use 0 for no denoising). Needs a float viewport pixel format',
+        default = 0,
+        min = 0,
+        max = 1024
+        )
+
     # Final render
             
     framebuffer_update_rate: IntProperty(
@@ -218,6 +249,40 @@ class RenderOspraySettingsScene(PropertyGroup):
         max = 64
         )
 
+    viewport_pixel_format: EnumProperty(
+        name='Pixel format',
+        description='Format in which interactive render pixels are sent from the server',
+        items=[ ('RGBA32F', 'Float', '4 x 32-bit float per pixel'),
+                ('RGBA16F', 'Half float', '4 x 16-bit float per pixel'),
+                ('SRGBA', 'sRGB 8-bit', '4 x 8-bit per pixel, in sRGB color space'),
+               ],
+        default='RGBA32F'
+        )
+
+    viewport_compression: EnumProperty(
+        name='Compression',
+        description='Compression of interactive render pixels sent from the server (needs support in the server, plus the lz4 or zstandard Python module)',
+        items=[ ('NONE', 'None', ''),
+                ('LZ4', 'LZ4', ''),
+                ('ZSTD', 'Zstandard', ''),
+               ],
+        default='NONE'
+        )
+
+    viewport_tiles: BoolProperty(
+        name='Send changed tiles only',
+        description='For interactive rendering only send the parts of the image that changed noticeably since the previous update',
+        default=False
+        )
+
+    viewport_tile_threshold: FloatProperty(
+        name='Tile threshold',
+        description='Minimum change in a pixel value for a tile to be sent again (float pixel formats only)',
+        default=0.002,
+        min=0.0, max=1.0,
+        precision=4
+        )
+
     # Clear scene
 
     clear_scene_keep_plugin_instances: BoolProperty(
@@ -321,6 +386,17 @@ class RenderOspraySettingsMesh(PropertyGroup):
         default='',
         maxlen=64,
         ) 
+
+    bound_level_of_detail: EnumProperty(
+        name='Bound detail',
+        description='Level of detail of the bounding mesh retrieved from the server',
+        items=[ ('0', 'Default', 'The bound provided by the plugin, or the coarse level when available'),
+                ('1', 'Bounding box', 'The bounding box of the plugin bound'),
+                ('2', 'Coarse', 'Coarse simplification of the plugin geometry'),
+                ('3', 'Fine', 'Fine simplification of the plugin geometry (slower to generate)'),
+               ],
+        default='0'
+        )
                 
 class RenderOspraySettingsLight(PropertyGroup):
     
@@ -52,6 +52,7 @@ class OSPRAY_RENDER_PT_connection(Panel):
         col.prop(ospray, 'port') 
         col.separator()
         col.operator('ospray.get_server_state')
+        col.operator('ospray.submit_animation_job')
                 
         
 class OSPRAY_RENDER_PT_rendering(Panel):
@@ -81,6 +82,8 @@ class OSPRAY_RENDER_PT_rendering(Panel):
         col.separator()
 
         col.prop(ospray, 'render_samples')
+        col.prop(ospray, 'render_variance_target')
+        col.prop(ospray, 'render_time_budget')
         col.prop(ospray, 'viewport_samples')
         col.separator()
         col.prop(ospray, 'max_path_length')
@@ -101,9 +104,18 @@ class OSPRAY_RENDER_PT_rendering(Panel):
             col.prop(ospray, 'geometry_lights') 
         #col.prop(ospray, 'shadows_enabled')    # XXX Removed in 2.0?
 
+        col.separator()
+        col.prop(ospray, 'denoise_final')
+        col.prop(ospray, 'denoise_interactive_interval')
+
         col.separator()
         col.prop(ospray, 'framebuffer_update_rate')
         col.prop(ospray, 'reduction_factor')
+        col.prop(ospray, 'viewport_pixel_format')
+        col.prop(ospray, 'viewport_compression')
+        col.prop(ospray, 'viewport_tiles')
+        if ospray.viewport_tiles:
+            col.prop(ospray, 'viewport_tile_threshold')
 
         col.separator()
         col.prop(ospray, 'clear_scene_keep_plugin_instances')
@@ -211,6 +223,7 @@ class OSPRAY_MESH_PT_data(Panel):
         col.separator()
         # XXX only show this mesh from "ospray-enabled" meshes
         # XXX only enable after sync with server once?
+        col.prop(ospray, 'bound_level_of_detail')
         col.operator('ospray.update_mesh_bound')
 
     
@@ -17,6 +17,9 @@ sock.connect(('localhost', 5909))
 client_message = ClientMessage()
 client_message.type = ClientMessage.HELLO
 client_message.uint_value = PROTOCOL_VERSION
+# Session to get the state of, e.g. user@host:pid as used by Blender
+if len(sys.argv) > 1:
+    client_message.string_value2 = sys.argv[1]
 send_protobuf(sock, client_message)
 
 result = HelloResult()
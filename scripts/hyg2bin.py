@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+# Convert Hyg star database (http://www.astronexus.com/hyg) from CSV
+# (or the JSON made by hygcsv2json.py) to the binary catalog format
+# read by the geometry_hyg_stars plugin
+#
+# Stars are sorted on increasing magnitude (brightest first), so the
+# plugin's max_magnitude parameter selects a prefix of the file.
+#
+# Paul Melis <paul.melis@surfsara.nl>
+import sys, csv, json, struct, math
+from array import array
+
+MAGIC = b'BLSTARS1'
+SORTED_BY_MAGNITUDE = 0x1
+
+def bv2rgb(bv):
+    """Approximate (linear) RGB color of a star, from its B-V color index"""
+
+    if bv is None:
+        return (1.0, 1.0, 1.0)
+
+    bv = min(max(bv, -0.4), 2.0)
+
+    # Ballesteros' formula for the temperature
+    t = 4600.0 * (1.0 / (0.92*bv + 1.7) + 1.0 / (0.92*bv + 0.62))
+
+    # Black body color, after Tanner Helland's approximation
+    t = t / 100.0
+
+    if t <= 66:
+        r = 255.0
+        g = 99.4708025861 * math.log(t) - 161.1195681661
+        if t <= 19:
+            b = 0.0
+        else:
+            b = 138.5177312231 * math.log(t - 10) - 305.0447927307
+    else:
+        r = 329.698727446 * math.pow(t - 60, -0.1332047592)
+        g = 288.1221695283 * math.pow(t - 60, -0.0755148492)
+        b = 255.0
+
+    return tuple(min(max(c, 0.0), 255.0) / 255.0 for c in (r, g, b))
+
+def read_csv(fname):
+
+    stars = []
+
+    with open(fname, 'rt', newline='') as f:
+
+        for row in csv.DictReader(f):
+
+            ci = row.get('ci', row.get('ColorIndex', ''))
+            stars.append((
+                float(row['mag']),
+                float(row['x']), float(row['y']), float(row['z']),
+                float(ci) if ci != '' else None
+            ))
+
+    return stars
+
+def read_json(fname):
+
+    stars = []
+
+    with open(fname, 'rt') as f:
+
+        for e in json.load(f):
+            stars.append((e['mag'], e['x'], e['y'], e['z'], e.get('ci')))
+
+    return stars
+
+if len(sys.argv) != 3:
+    print('usage: %s hygdata.csv|hygdata.json output.bin' % sys.argv[0])
+    sys.exit(-1)
+
+if sys.argv[1].endswith('.json'):
+    stars = read_json(sys.argv[1])
+else:
+    stars = read_csv(sys.argv[1])
+
+stars.sort(key=lambda s: s[0])
+
+positions = array('f')
+magnitudes = array('f')
+colors = array('f')
+
+for mag, x, y, z, ci in stars:
+    positions.extend((x, y, z))
+    magnitudes.append(mag)
+    colors.extend(bv2rgb(ci))
+
+if sys.byteorder != 'little':
+    positions.byteswap()
+    magnitudes.byteswap()
+    colors.byteswap()
+
+with open(sys.argv[2], 'wb') as g:
+    g.write(MAGIC)
+    g.write(struct.pack('<II', len(stars), SORTED_BY_MAGNITUDE))
+    positions.tofile(g)
+    magnitudes.tofile(g)
+    colors.tofile(g)
+
+print('Wrote %d stars to %s' % (len(stars), sys.argv[2]))
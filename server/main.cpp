@@ -20,6 +20,7 @@
 
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <stdint.h>
 #include <cstdio>
 #include <cstdlib>
@@ -27,11 +28,21 @@
 #include <iostream>
 #include <string>
 #include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
 #include <dlfcn.h>
 #include <thread>
 #include <queue>
+#include <list>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <functional>
+#include <cerrno>
+#include <cstring>
+#include <limits>
 
 #include <ospray/ospray.h>
 //#include <ospray/ospray_testing/ospray_testing.h>
@@ -40,10 +51,20 @@
 #include <glm/gtx/string_cast.hpp>      // to_string()
 
 #include "config.h"
+#ifdef FRAMEBUFFER_LZ4
+#include <lz4.h>
+#endif
+#ifdef FRAMEBUFFER_ZSTD
+#include <zstd.h>
+#endif
+#ifdef DISTRIBUTED
+#include <mpi.h>
+#endif
 #include "image.h"
 #include "tcpsocket.h"
 #include "json.hpp"
 #include "blocking_queue.h"
+#include "timing.h"
 #include "cool2warm.h"
 #include "util.h"
 #include "util_internal.h"
@@ -54,7 +75,8 @@
 using json = nlohmann::json;
 
 const int       PORT = 5909;
-const uint32_t  PROTOCOL_VERSION = 2;
+const int       HELLO_TIMEOUT = 10;         // Seconds a new connection has to send HELLO
+const uint32_t  PROTOCOL_VERSION = 4;
 
 bool framebuffer_compression = getenv("BLOSPRAY_COMPRESS_FRAMEBUFFER") != nullptr;
 bool keep_framebuffer_files = getenv("BLOSPRAY_KEEP_FRAMEBUFFER_FILES") != nullptr;
@@ -62,58 +84,147 @@ bool dump_client_messages = getenv("BLOSPRAY_DUMP_CLIENT_MESSAGES") != nullptr;
 bool abort_on_ospray_error = getenv("BLOSPRAY_ABORT_ON_OSPRAY_ERROR") != nullptr;
 // Print server state to console just before starting to render
 bool dump_server_state = getenv("BLOSPRAY_DUMP_SERVER_STATE") != nullptr;
+// Memory sizes given in MB are in units of 10^6 bytes, as reported by memory_usage()
+const size_t MB = 1000 * 1000;
+// Maximum memory used for keeping deleted Blender meshes around for reuse (MB)
+size_t blender_mesh_cache_max_size = (getenv("BLOSPRAY_MESH_CACHE_SIZE") ? atol(getenv("BLOSPRAY_MESH_CACHE_SIZE")) : 1024) * MB;
+// Budget (MB) for plugin instances plus Blender meshes, 0 is unlimited 
+size_t memory_budget = (getenv("BLOSPRAY_MEMORY_BUDGET") ? atol(getenv("BLOSPRAY_MEMORY_BUDGET")) : 0) * MB;
+// Directory for persistent plugin instance caches (see plugin_cache.h), disabled when empty
+std::string plugin_cache_directory = getenv("BLOSPRAY_PLUGIN_CACHE_DIR") ? getenv("BLOSPRAY_PLUGIN_CACHE_DIR") : "";
+// Number of threads creating instances of thread-safe plugins in the background, 0 = create synchronously
+int plugin_creation_threads = getenv("BLOSPRAY_PLUGIN_THREADS") ? atoi(getenv("BLOSPRAY_PLUGIN_THREADS")) : 4;
+// Don't load OSPRay's denoiser module, even when available (saves the memory of the normal and albedo framebuffer channels)
+bool disable_denoiser = getenv("BLOSPRAY_NO_DENOISER") != nullptr;
+// Write the timed phases as a Chrome trace (JSON) file, after each client connection
+const char *trace_file = getenv("BLOSPRAY_TRACE_FILE");
+// Seconds a session is kept after its last connection ended (and its animation
+// jobs are done), for a next connection of the same client. Then the session's 
+// state is released. Sessions are kept when rendering distributed.
+int session_timeout = getenv("BLOSPRAY_SESSION_TIMEOUT") ? atoi(getenv("BLOSPRAY_SESSION_TIMEOUT")) : 300;
+
+// Timings of server phases (messages, plugin instances, commits, 
+// frames, framebuffer output), see timing.h. Shared by all sessions,
+// reported in the server state.
+Timings timings;
+
+// Distributed rendering (when built with DISTRIBUTED and started under
+// MPI with more than one rank). Rank 0 handles the client connections
+// and replicates scene changes to the other ranks, which only render,
+// see distributed_worker_loop(). Plugin instances load their own part of
+// the data on each rank (PluginState::domain_index).
+int mpi_rank = 0;
+int mpi_size = 1;
+#ifdef DISTRIBUTED
+MPI_Comm distributed_comm;
+#endif
 
-OSPRenderer     ospray_renderer;
-std::string     current_renderer_type;
-OSPWorld        ospray_world = nullptr;
-OSPCamera       ospray_camera = nullptr;
+// Sessions
+//
+// Each client session (identified by the name the client passes in HELLO)
+// is handled by its own thread, which keeps the session's state (scene,
+// framebuffers, renderer, ...) in the thread_local variables below.
+// The main thread accepts connections, each of which gets a short-lived 
+// thread that receives the HELLO and hands the connection to the thread 
+// of the session it belongs to. A session's state persists across its
+// connections, as it did with a single-client server, until no connection
+// arrived for session_timeout seconds. The session then releases its 
+// state and its thread ends.
+//
+// Anything not thread_local is shared between sessions. Access to it, and
+// to OSPRay in general, is serialized with server_mutex, which a session 
+// thread holds except when it is waiting for something to happen: client
+// messages or bulk data (see recvall_unlocked()), frames being rendered.
+// Plugin instances created in the background (see plugin_creation_thread_func())
+// only take it for their OSPRay calls.
+
+struct PendingConnection
+{
+    TCPSocket       *sock;
+    ClientMessage   hello;          // Already received by the connection's thread
+};
 
-struct SceneMaterial
+struct Session
 {
-    MaterialUpdate::Type    type;
-    OSPMaterial             material;
+    std::string                         name;
+    int                                 id;
+    BlockingQueue<PendingConnection*>   connections;
+    BlockingQueue<AnimationJob*>        animation_jobs;     // Rendered between connections
+    std::thread                         thread;
+};
 
-    SceneMaterial()
-    {
-        material = nullptr;
-    }
+// Active sessions, plus the ended ones whose thread still needs to be 
+// joined. Both protected by sessions_mutex, which is taken after
+// server_mutex when both are needed.
+std::map<std::string, Session*>     sessions;
+std::vector<Session*>               ended_sessions;
+int                                 next_session_id = 0;
+std::mutex                          sessions_mutex;
+std::mutex                          server_mutex;
+thread_local Session                *session = nullptr;
+
+thread_local OSPRenderer     ospray_renderer;
+thread_local std::string     current_renderer_type;
+thread_local OSPWorld        ospray_world = nullptr;
+thread_local OSPCamera       ospray_camera = nullptr;
 
-    ~SceneMaterial()
-    {
-        if (material != nullptr)
-            ospRelease(material);
-    }
+struct SceneMaterial
+{
+    MaterialUpdate::Type    type;
+    // Shared with other scene materials with the same settings
+    SharedMaterial          material;
 };
 
 typedef std::map<std::string, SceneMaterial*>  SceneMaterialMap;
 
-std::map<std::string, OSPRenderer>  renderers;
+thread_local std::map<std::string, OSPRenderer>  renderers;
 
-std::map<std::string, OSPMaterial>  default_materials;
-SceneMaterialMap            scene_materials;
+thread_local std::map<std::string, OSPMaterial>  default_materials;
+thread_local SceneMaterialMap            scene_materials;
 //std::string                 scene_materials_renderer;
 
-std::vector<OSPInstance>    ospray_scene_instances;
+// Transfer functions, volumetric models (of isosurfaces and slices) and
+// materials, shared by all scene elements with the same definition
+thread_local SharedObjectRegistry<OSPTransferFunction>   transfer_functions;
+thread_local SharedObjectRegistry<OSPVolumetricModel>    volumetric_models;
+thread_local SharedObjectRegistry<OSPMaterial>           materials;
 
-OSPLight                    ospray_scene_ambient_light;
-std::vector<OSPLight>       ospray_scene_lights;
+thread_local std::vector<OSPInstance>    ospray_scene_instances;
 
-OSPData                     ospray_scene_instances_data = nullptr;
-OSPData                     ospray_scene_lights_data = nullptr;
-bool                        update_ospray_scene_instances = true;
-bool                        update_ospray_scene_lights = true;
+thread_local OSPLight                    ospray_scene_ambient_light;
+thread_local std::vector<OSPLight>       ospray_scene_lights;
+
+thread_local OSPData                     ospray_scene_instances_data = nullptr;
+thread_local OSPData                     ospray_scene_lights_data = nullptr;
+thread_local bool                        update_ospray_scene_instances = true;
+thread_local bool                        update_ospray_scene_lights = true;
+// Objects already in the world changed (e.g. an instance transform), which 
+// needs a world commit, but not a new instance list
+thread_local bool                        ospray_world_changed = true;
 
 // User-chosen framebuffer settings
 // Final render
-int                         final_framebuffer_width = 0, final_framebuffer_height = 0;
-OSPFrameBufferFormat        final_framebuffer_format;
-int                         final_framebuffer_update_rate = 1;    
-OSPFrameBuffer              final_framebuffer = nullptr;   
-int                         framebuffer_update_rate = 1;    
+thread_local int                         final_framebuffer_width = 0, final_framebuffer_height = 0;
+thread_local OSPFrameBufferFormat        final_framebuffer_format;
+thread_local int                         final_framebuffer_update_rate = 1;    
+thread_local OSPFrameBuffer              final_framebuffer = nullptr;   
+thread_local bool                        final_framebuffer_denoising = false;
+thread_local int                         framebuffer_update_rate = 1;    
 // Interactive render
-int                         interactive_framebuffer_width = 0, interactive_framebuffer_height = 0;
-OSPFrameBufferFormat        interactive_framebuffer_format;
-int                         framebuffer_initial_reduction_factor = 1;         
+thread_local int                         interactive_framebuffer_width = 0, interactive_framebuffer_height = 0;
+thread_local OSPFrameBufferFormat        interactive_framebuffer_format;
+thread_local uint32_t                    interactive_framebuffer_encoding = RenderResult::RAW;     // RenderResult::Encoding flags
+thread_local int                         framebuffer_initial_reduction_factor = 1;         
+// Final render termination, besides the number of samples (0 = not used), 
+// see check_final_render_termination()
+thread_local float                       final_render_variance_target = 0.0f;
+thread_local float                       final_render_time_budget = 0.0f;   // Seconds
+// Renderer varianceThreshold from the render settings
+thread_local float                       renderer_variance_threshold = 0.0f;
+// Denoising, see denoise_current_frame()
+OSPImageOperation                        denoiser = nullptr;                // Shared, nullptr when not available
+thread_local uint32_t                    denoise_interactive_interval = 0;
+thread_local bool                        denoise_final = false;
 
 // Derived values    
 
@@ -123,12 +234,14 @@ struct AllocatedFramebuffer
     OSPFrameBuffer  framebuffer;
     int             width;
     int             height;
+    bool            denoising;      // Denoiser image operation set
 
     AllocatedFramebuffer(int width, int height, OSPFrameBufferFormat format, int channels)
     {
         framebuffer = ospNewFrameBuffer(width, height, format, channels);
         this->width = width;
         this->height = height;
+        denoising = false;
     }
 
     AllocatedFramebuffer(const AllocatedFramebuffer &other)
@@ -137,6 +250,7 @@ struct AllocatedFramebuffer
         ospRetain(framebuffer);
         width = other.width;
         height = other.height;
+        denoising = other.denoising;
     }
 
     ~AllocatedFramebuffer()
@@ -150,16 +264,16 @@ struct AllocatedFramebuffer
     }
 };
 
-std::vector<AllocatedFramebuffer> framebuffers;
+thread_local std::vector<AllocatedFramebuffer> framebuffers;
 // XXX fold factors into AllocatedFramebuffer
-std::vector<int>            framebuffer_reduction_factors;      // [0] = 1, ..., framebuffer_initial_reduction_factor
-int                         framebuffer_reduction_index = 0;    // Index into framebuffer_reduction_factors
+thread_local std::vector<int>            framebuffer_reduction_factors;      // [0] = 1, ..., framebuffer_initial_reduction_factor
+thread_local int                         framebuffer_reduction_index = 0;    // Index into framebuffer_reduction_factors
 
 // Current framebuffer
-int                         framebuffer_reduction_factor = 1;
-int                         reduced_framebuffer_width, reduced_framebuffer_height;
+thread_local int                         framebuffer_reduction_factor = 1;
+thread_local int                         reduced_framebuffer_width, reduced_framebuffer_height;
 
-TCPSocket                   *render_output_socket = nullptr;
+thread_local TCPSocket                   *render_output_socket = nullptr;
 
 enum RenderMode
 {
@@ -168,19 +282,94 @@ enum RenderMode
     RM_INTERACTIVE
 };
 
-RenderMode      render_mode = RM_IDLE;
-int             render_samples = 1;
-int             current_sample;
-OSPFuture       render_future = nullptr;
-struct timeval  rendering_start_time, frame_start_time;
-bool            cancel_rendering;
+thread_local RenderMode      render_mode = RM_IDLE;
+thread_local int             render_samples = 1;
+thread_local int             current_sample;
+thread_local OSPFuture       render_future = nullptr;
+thread_local struct timeval  rendering_start_time, frame_start_time;
+thread_local TimingClock::time_point     frame_start_clock;
+thread_local float           scene_prepare_time = 0.0f;     // Seconds, of the current render
+thread_local bool            cancel_rendering;
+
+// Render completion notification. A helper thread blocks on the
+// render future and writes a byte to this pipe when the frame is done,
+// so the connection loop can wait in poll() on both the client socket
+// and the render, instead of busy-polling.
+thread_local int             render_done_pipe[2] = { -1, -1 };
+thread_local std::thread     render_wait_thread;
+
+// Framebuffer output stage. A finished frame is copied into the
+// staging buffer of a send job, which is then written/sent by a separate
+// thread while OSPRay renders the next sample. Jobs are recycled through
+// a pool of fixed size, which bounds the number of frames in flight.
+
+struct FramebufferSendJob
+{
+    TCPSocket               *sock;
+    RenderResult            render_result;
+    bool                    send_pixels;        // false: only send render_result
+    bool                    final;              // true: write EXR file and send that
+    int                     width, height;
+    OSPFrameBufferFormat    format;
+    uint32_t                encoding;           // Requested RenderResult::Encoding flags (interactive)
+    bool                    full_frame;         // Never send as tiles
+    float                   tile_threshold;
+    int                     shm_slot;           // Final: pixels already in this shared memory slot, or -1
+    size_t                  shm_slot_size;
+    std::vector<uint8_t>    pixels;             // RGBA, layout depends on format
+    std::vector<uint8_t>    encoded;
+};
+
+const int                           NUM_FRAMEBUFFER_SEND_JOBS = 2;
+
+// One per session, shared between the session thread and its send thread
+struct FramebufferSender
+{
+    BlockingQueue<FramebufferSendJob*>  send_queue;
+    BlockingQueue<FramebufferSendJob*>  free_jobs;
+
+    // Stats of the last completed send, for display
+    std::atomic<float>                  last_send_time;
+    std::atomic<float>                  last_send_size;         // MB
+
+    std::thread                         thread;
+
+    FramebufferSender(): last_send_time(0.0f), last_send_size(0.0f) {}
+};
+
+thread_local FramebufferSender      *framebuffer_sender = nullptr;
+
+// Shared memory framebuffer transport (final renders, client on the same
+// host). A ring of slots that are written by the server and read by the 
+// client. A slot's sequence number is odd while the slot is being written 
+// and 2*sample when complete, so the client can detect a slot that got 
+// overwritten while reading it (it then skips that update).
 
-// Geometry buffers used during network receive
+struct SharedFramebufferSlot
+{
+    uint64_t    sequence;
+    uint32_t    width, height;
+    uint32_t    sample;
+    uint8_t     padding[44];
+    // Followed by width*height RGBA float pixels
+};
 
-std::vector<float>      vertex_buffer;
-std::vector<float>      normal_buffer;
-std::vector<float>      vertex_color_buffer;
-std::vector<uint32_t>   triangle_buffer;
+const int                           SHM_NUM_SLOTS = 3;
+thread_local std::string                         shm_name;                   // Empty when not in use
+thread_local int                                 shm_fd = -1;
+thread_local uint8_t                             *shm_ptr = nullptr;
+thread_local size_t                              shm_slot_size = 0;
+
+// Tile-based delta updates (RenderResult::TILES). The sender thread keeps
+// a copy of the pixels as last sent, so tiles are compared against what the
+// client actually has (and small changes can't accumulate unnoticed).
+// The tile_reference_* values are only used by (and local to) the send thread.
+const int                           FRAMEBUFFER_TILE_SIZE = 64;
+thread_local float                               interactive_framebuffer_tile_threshold = 0.0f;
+thread_local bool                                send_full_framebuffer = true;   // Next frame, set at start of rendering
+thread_local int                                 tile_reference_width = 0, tile_reference_height = 0;
+thread_local OSPFrameBufferFormat                tile_reference_format;
+thread_local std::vector<uint8_t>                tile_reference_pixels;
 
 // Plugin registry
 
@@ -188,7 +377,112 @@ typedef std::map<std::string, PluginDefinition> PluginDefinitionsMap;
 typedef std::map<std::string, PluginState*>     PluginStateMap;
 
 PluginDefinitionsMap    plugin_definitions;
-PluginStateMap          plugin_state;
+thread_local PluginStateMap          plugin_state;
+
+// Instances of thread-safe plugins are created in the background by
+// plugin_creation_thread_func(), so the client can send the next plugin
+// instance (and the scene objects) while the previous ones are still 
+// loading. Anything that actually needs the instance's state waits for 
+// the job to finish, see wait_for_plugin_instance().
+struct PluginCreationJob
+{
+    create_instance_function_t  function;
+    PluginState                 *state;
+    PluginResult                result;
+    float                       time;           // Seconds
+
+    bool                        done;
+    std::mutex                  mutex;
+    std::condition_variable     finished;
+};
+
+typedef std::shared_ptr<PluginCreationJob>  PluginCreationJobPtr;
+
+BlockingQueue<PluginCreationJobPtr>     plugin_creation_queue;
+
+// Levels of detail of a plugin's bound, as requested with QUERY_BOUND
+enum BoundLevel
+{
+    BOUND_DEFAULT = 0,      // The plugin's bound, or COARSE when generated
+    BOUND_BBOX = 1,
+    BOUND_COARSE = 2,
+    BOUND_FINE = 3
+};
+
+// Quadric clustering divisions for the generated levels
+const int BOUND_COARSE_DIVISIONS = 16;
+const int BOUND_FINE_DIVISIONS = 64;
+
+// Simplified versions of a plugin bound's source mesh (see 
+// BoundingMesh::from_triangles()), generated in the background 
+// after the plugin instance is created, by a single generator thread.
+// The generator doesn't hold a reference to the levels, the destructor
+// stops and joins it, so the levels can't go away while it runs.
+struct BoundLevels
+{
+    BoundingMesh                *coarse;
+    BoundingMesh                *fine;
+    bool                        done;           // Generator finished (or stopped)
+    std::atomic<bool>           stop;
+
+    std::mutex                  mutex;          // Protects the above, except stop
+    std::condition_variable     generated;
+
+    std::thread                 generator;
+
+    BoundLevels(): coarse(nullptr), fine(nullptr), done(false), stop(false) {}
+
+    ~BoundLevels()
+    {
+        // Takes at most the simplification of the level in progress
+        stop = true;
+        if (generator.joinable())
+            generator.join();
+
+        delete coarse;
+        delete fine;
+    }
+};
+
+typedef std::shared_ptr<BoundLevels>    BoundLevelsPtr;
+
+// Plugin states can be shared between sessions, when created by the same
+// plugin with the same parameters (and renderer type, if the plugin uses 
+// it). So large datasets are only loaded once. Keyed on shared_plugin_state_key().
+struct SharedPluginState
+{
+    PluginState             *state;
+    int                     users;          // Number of plugin instances using the state
+
+    PluginCreationJobPtr    pending;        // Non-null while being created in the background
+    bool                    failed;         // Background creation failed
+
+    // Creation time (seconds) and increase in server memory usage during
+    // creation (megabytes). The latter is only measured for instances
+    // created by the session thread, background creation overlaps with
+    // other work, so those plugins report their state's memory_size.
+    float                   creation_time;
+    float                   memory_usage;
+
+    // Non-null when the plugin's bound has a source mesh
+    BoundLevelsPtr          bound_levels;
+
+    SharedPluginState()
+    {
+        state = nullptr;
+        users = 0;
+        failed = false;
+        creation_time = 0.0f;
+        memory_usage = 0.0f;
+    }
+};
+
+std::map<std::string, SharedPluginState>    shared_plugin_states;
+
+// Incremented each time a scene gets prepared for rendering. Scene data
+// stores the value when it was last rendered, as LRU order for the
+// memory budget.
+uint64_t    render_serial = 0;
 
 // Server-side data associated with blender Mesh Data that has a
 // blospray plugin attached to it
@@ -203,21 +497,21 @@ struct PluginInstance
     std::string     parameters_hash;
     std::string     custom_properties_hash;
 
+    std::string     shared_state_key;
+
     // XXX store hash of parameters that the instance was generated from
 
-    // Plugin state contains OSPRay scene elements
+    // Plugin state contains OSPRay scene elements. 
+    // Owned by shared_plugin_states[shared_state_key]
     // XXX move properties out of PluginState?
     PluginState     *state;     // XXX store as object, not as pointer?
 
+    uint64_t        last_rendered;  // render_serial
+
     PluginInstance()
     {
         state = nullptr;
-    }
-
-    ~PluginInstance()
-    {
-        if (state != nullptr)
-            delete state;
+        last_rendered = render_serial;
     }
 };
 
@@ -231,13 +525,40 @@ struct BlenderMesh
 
     json            parameters;     // XXX not sure we need this
 
+    // Content hash provided by the client, empty if not set
+    std::string     content_hash;
+
+    // Mesh data as received from the network. The geometry's data
+    // arrays are created with ospNewSharedData() on these buffers, so
+    // they must stay alive (and unmodified) as long as the geometry is
+    // used for rendering.
+    std::vector<float>      vertices;
+    std::vector<float>      normals;
+    std::vector<float>      vertex_colors;
+    std::vector<uint32_t>   triangles;
+
     OSPGeometry     geometry;
 
+    uint64_t        last_rendered;  // render_serial
+
+    BlenderMesh()
+    {
+        geometry = nullptr;
+        last_rendered = render_serial;
+    }
+
     ~BlenderMesh()
     {
+        // Release the geometry before the buffers above get freed
         if (geometry != nullptr)
             ospRelease(geometry);
     }
+
+    size_t memory_size() const
+    {
+        return (vertices.size() + normals.size() + vertex_colors.size()) * sizeof(float)
+            + triangles.size() * sizeof(uint32_t);
+    }
 };
 
 // Top-level scene objects
@@ -248,28 +569,38 @@ typedef std::map<std::string, SceneDataType>    SceneDataTypeMap;
 typedef std::map<std::string, PluginInstance*>  PluginInstanceMap;
 typedef std::map<std::string, BlenderMesh*>     BlenderMeshMap;
 
-SceneObjectMap      scene_objects;
-SceneDataTypeMap    scene_data_types;
-PluginInstanceMap   plugin_instances;
-BlenderMeshMap      blender_meshes;
+thread_local SceneObjectMap      scene_objects;
+thread_local SceneDataTypeMap    scene_data_types;
+thread_local PluginInstanceMap   plugin_instances;
+thread_local BlenderMeshMap      blender_meshes;
+
+// Blender meshes that were deleted, but kept around (in LRU order, most
+// recent first) in case the client sends a mesh with the same content 
+// hash again. This makes re-sending a scene after CLEAR_SCENE cheap,
+// e.g. after reconnecting or when switching between final and interactive 
+// rendering.
+typedef std::list<BlenderMesh*>                         BlenderMeshCacheList;
+typedef std::map<std::string, BlenderMeshCacheList::iterator>  BlenderMeshCacheMap;
+
+BlenderMeshCacheList    blender_mesh_cache_lru;
+BlenderMeshCacheMap     blender_mesh_cache;
+size_t                  blender_mesh_cache_size = 0;
 
 void start_rendering(const ClientMessage& client_message);
+void prepare_renderers();
+void set_variance_threshold(float threshold);
+void distributed_broadcast(const SceneUpdate& command);
+void distributed_broadcast(ClientMessage::Type type, const std::vector<std::string>& messages);
+void distributed_broadcast_render_frame();
+void check_final_render_termination(float variance, struct timeval now);
 
 // Plugin handling
 
 // If needed, loads plugin shared library and initializes plugin
-// XXX perhaps this operation should have its own ...Result type
-// XXX use internal name here?
-bool
-ensure_plugin_is_loaded(GenerateFunctionResult &result, PluginDefinition &definition,
-    PluginType type, const std::string& name)
+// E.g. "volume_raw", which is also the base name of the shared library
+std::string
+get_plugin_internal_name(PluginType type, const std::string& name)
 {
-    if (name == "")
-    {
-        printf("No plugin name provided!\n");
-        return false;
-    }
-
     std::string internal_name;
 
     switch (type)
@@ -285,7 +616,22 @@ ensure_plugin_is_loaded(GenerateFunctionResult &result, PluginDefinition &defini
         break;
     }
 
-    internal_name += "_" + name;
+    return internal_name + "_" + name;
+}
+
+// XXX perhaps this operation should have its own ...Result type
+// XXX use internal name here?
+bool
+ensure_plugin_is_loaded(GenerateFunctionResult &result, PluginDefinition &definition,
+    PluginType type, const std::string& name)
+{
+    if (name == "")
+    {
+        printf("No plugin name provided!\n");
+        return false;
+    }
+
+    const std::string internal_name = get_plugin_internal_name(type, name);
 
     PluginDefinitionsMap::iterator it = plugin_definitions.find(internal_name);
 
@@ -330,6 +676,8 @@ ensure_plugin_is_loaded(GenerateFunctionResult &result, PluginDefinition &defini
             return false;
         }
 
+        definition.thread_safe = false;
+
         if (!initialize(&definition))
         {
             result.set_success(false);
@@ -444,1226 +792,1137 @@ check_plugin_parameters(GenerateFunctionResult& result, const PluginParameter *p
     return ok;
 }
 
-void
-delete_plugin_instance(const std::string& name)
-{        
-    PluginInstanceMap::iterator it = plugin_instances.find(name);
-
-    if (it == plugin_instances.end())
+// Checks the OSPRay objects a plugin's create_instance function set
+// in the plugin state. Returns false if the state is unusable.
+bool
+check_created_plugin_state(PluginType plugin_type, PluginState *state)
+{
+    switch (plugin_type)
     {
-        printf("ERROR: plugin instance '%s' to delete not found!\n", name.c_str());
-        return;
-    }
+    case PT_GEOMETRY:
 
-    PluginInstance *plugin_instance = it->second;
-    PluginState *state = plugin_instance->state;
-    const std::string& internal_name = plugin_instance->plugin_internal_name;
+        if (state->geometry == nullptr)
+        {
+            printf("... ERROR: geometry create_instance did not set an OSPGeometry!\n");
+            return false;
+        }    
 
-    if (state->data)
-    {
-        PluginDefinitionsMap::iterator it = plugin_definitions.find(internal_name);
+        break;
 
-        if (it != plugin_definitions.end())
+    case PT_VOLUME:
+
+        if (state->volume != nullptr)
         {
-            // Call plugin's clear_data_function_t
-            it->second.functions.clear_data_function(state);
+            printf("... volume data range %.6f %.6f\n", state->volume_data_range[0], state->volume_data_range[1]);
         }
         else
         {
-            printf("... WARNING: user data non-null on plugin instance of type '%s', but no clear data function set\n", 
-                internal_name.c_str());
+            printf("... ERROR: volume create_instance did not set an OSPVolume!\n");
+            return false;
+        }
+
+        break;
+
+    case PT_SCENE:
+
+        if (state->group_instances.size() > 0 || state->instance_arrays.size() > 0)
+        {
+            size_t num_array_instances = 0;
+            for (auto& ia : state->instance_arrays)
+                num_array_instances += ia.transforms.size();
+
+            printf("... %d instances\n", state->group_instances.size());
+            printf("... %d instance array(s) with %d instances\n", state->instance_arrays.size(), num_array_instances);
+            printf("... %d lights\n", state->lights.size());
         }
+        else
+            printf("... WARNING: scene create_instance returned zero instances!\n");    
+
+        break;
     }
-    
-    delete state;
 
-    plugin_instances.erase(it);
-    plugin_state.erase(name);
-    scene_data_types.erase(name);
+    return true;
 }
 
 void
-delete_blender_mesh(const std::string& name)
+plugin_creation_thread_func()
 {
-    SceneDataTypeMap::iterator it = scene_data_types.find(name);
-
-    if (it == scene_data_types.end())
+    while (true)
     {
-        printf("ERROR: blender mesh to delete '%s' not found!\n", name.c_str());
-        return;
-    }
+        PluginCreationJobPtr job = plugin_creation_queue.pop();
 
-    if (it->second != SDT_BLENDER_MESH)
-    {
-        printf("ERROR: blender mesh to delete '%s' is not of type SDT_BLENDER_MESH!\n", name.c_str());
-        return;
-    }
+        // The plugin takes server_mutex for its OSPRay calls, see 
+        // PluginOSPRayLock
+        job->state->ospray_mutex = &server_mutex;
 
-    BlenderMeshMap::iterator bm = blender_meshes.find(name);
-    if (bm == blender_meshes.end())
-    {
-        printf("ERROR: blender mesh to delete '%s' not found!\n", name.c_str());
-        return;        
-    }
+        ScopedTimer timer(timings, "plugin create_instance");
+        job->function(job->result, job->state);
+        const float time = timer.stop();
 
-    delete bm->second;
+        job->state->ospray_mutex = nullptr;
 
-    scene_data_types.erase(name);
-}
+        if (job->result.success && job->state->memory_size == 0)
+            printf("WARNING: background plugin instance did not set memory_size, not accounted in the memory budget\n");
 
-//
-// Scene management
-//
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->time = time;
+        job->done = true;
+        job->finished.notify_all();
+    }
+}
 
+// Generates the simplified levels of the bound, coarse first (as that's
+// the default level). Runs in BoundLevels::generator.
 void
-delete_object(const std::string& object_name)
-{        
-    SceneObjectMap::iterator it = scene_objects.find(object_name);
+generate_bound_levels(BoundLevels *levels, std::shared_ptr<BoundingMesh> source)
+{
+    ScopedTimer timer(timings, "bound generation");
 
-    if (it == scene_objects.end())
+    const int divisions[2] = { BOUND_COARSE_DIVISIONS, BOUND_FINE_DIVISIONS };
+    BoundingMesh* BoundLevels::*members[2] = { &BoundLevels::coarse, &BoundLevels::fine };
+
+    for (int i = 0; i < 2 && !levels->stop; i++)
     {
-        printf("ERROR: object to delete '%s' not found!\n", object_name.c_str());
-        return;
+        BoundingMesh *bm = BoundingMesh::simplify_qc(
+            source->source_vertices.data(), source->source_vertices.size()/3,
+            source->source_triangles.data(), source->source_triangles.size()/3,
+            divisions[i]);
+
+        std::unique_lock<std::mutex> lock(levels->mutex);
+        levels->*members[i] = bm;
+        levels->generated.notify_all();
     }
 
-    SceneObject *scene_object = it->second;
-    delete scene_object;
+    std::unique_lock<std::mutex> lock(levels->mutex);
+    levels->done = true;
+    levels->generated.notify_all();
 
-    scene_objects.erase(object_name);
+    printf("Generated bound levels in %.3fs\n", timer.stop());
 }
 
-void 
-delete_scene_data(const std::string& name)
+// Starts generating the bound levels for a newly created (or updated)
+// plugin state, if its bound has a source mesh. The source is moved
+// out of the bound, so it's freed once the levels are done.
+void
+start_bound_generation(SharedPluginState& shared)
 {
-    SceneDataTypeMap::iterator it = scene_data_types.find(name);
+    BoundingMesh *bound = shared.state->bound;
 
-    if (it == scene_data_types.end())
-    {
-        printf("ERROR: scene data '%s' to delete not found!\n", name.c_str());
+    if (bound == nullptr || !bound->has_source())
         return;
-    }
 
-    if (it->second == SDT_PLUGIN)
-        delete_plugin_instance(name);
-    else
+    if (!BoundingMesh::can_simplify())
     {
-        assert(it->second == SDT_BLENDER_MESH);
-        delete_blender_mesh(name);
+        // The levels would only be bboxes, just drop the source mesh
+        std::vector<float>().swap(bound->source_vertices);
+        std::vector<uint32_t>().swap(bound->source_triangles);
+        return;
     }
 
-    scene_data_types.erase(name);
+    std::shared_ptr<BoundingMesh> source = std::make_shared<BoundingMesh>();
+    source->source_vertices.swap(bound->source_vertices);
+    source->source_triangles.swap(bound->source_triangles);
+
+    printf("... Generating bound levels in the background (%d triangles)\n", (int)(source->source_triangles.size()/3));
+
+    shared.bound_levels = std::make_shared<BoundLevels>();
+    shared.bound_levels->generator = std::thread(generate_bound_levels, shared.bound_levels.get(), source);
 }
 
-void
-delete_all_scene_data()
+// Waits for the background creation of the plugin instance's state 
+// (if any) to finish. Called with server_mutex held, which is released
+// while waiting. Returns false if creating the state failed.
+bool
+finish_plugin_creation(PluginInstance *plugin_instance)
 {
-    for (auto& kv : scene_data_types)
-    {
-        const std::string& name = kv.first;
-        const SceneDataType& type = kv.second;
-
-        if (type == SDT_PLUGIN)
-            delete_plugin_instance(name);
-        else
-        {
-            assert(type == SDT_BLENDER_MESH);
-            delete_blender_mesh(name);
-        }
-    }
+    const std::string& shared_state_key = plugin_instance->shared_state_key;
 
-    scene_data_types.clear();
-}
+    std::map<std::string, SharedPluginState>::iterator shared = shared_plugin_states.find(shared_state_key);
+    assert(shared != shared_plugin_states.end());
 
-/*
-Find scene object by name, create new if not found.
-Three cases:
-1. no existing object with name 
-2. existing object with name, but of wrong type 
-3. existing object with name and correct type 
+    PluginCreationJobPtr job = shared->second.pending;
 
-Returns NULL if no existing object found with given name.
-*/
+    if (job == nullptr)
+        return !shared->second.failed;
 
-SceneObject*
-find_scene_object(const std::string& name, SceneObjectType type, bool delete_existing_mismatch=true)
-{
-    SceneObject *scene_object;
-    SceneObjectMap::iterator it = scene_objects.find(name);
+    printf("... Waiting for plugin instance '%s' to be created\n", plugin_instance->name.c_str());
 
-    if (it == scene_objects.end())
+    server_mutex.unlock();
     {
-        printf("... No existing object\n");
-        return nullptr;
+        std::unique_lock<std::mutex> lock(job->mutex);
+        while (!job->done)
+            job->finished.wait(lock);
     }
-    
-    scene_object = it->second;
-    if (scene_object->type != type)
+    server_mutex.lock();
+
+    // Another session sharing the state might have handled the job 
+    // in the meantime. The shared state itself is still there, as we're one 
+    // of its users.
+    shared = shared_plugin_states.find(shared_state_key);
+    assert(shared != shared_plugin_states.end());
+
+    if (shared->second.pending == job)
     {
-        if (delete_existing_mismatch)
+        printf("... Created instance '%s' in %.3fs\n", plugin_instance->name.c_str(), job->time);
+
+        shared->second.creation_time = job->time;
+
+        if (!job->result.success)
         {
-            printf("... Existing object is not of type %s, but of type %s, deleting\n", 
-                SceneObjectType_names[type], SceneObjectType_names[scene_object->type]);
-            delete_object(name);
-            return nullptr;
+            printf("... ERROR: create_instance failed:\n");
+            printf("... %s\n", job->result.message.c_str());
+            shared->second.failed = true;
         }
+        else if (!check_created_plugin_state(plugin_instance->type, job->state))
+            shared->second.failed = true;
         else
-            return scene_object;
-    }
-    else
-    {        
-        printf("... Existing object matches type %s\n", SceneObjectType_names[type]);
-        return scene_object;
+            start_bound_generation(shared->second);
+
+        shared->second.pending = nullptr;
     }
+
+    return !shared->second.failed;
 }
 
-bool
-scene_data_with_type_exists(const std::string& name, SceneDataType type)
-{
-    SceneDataTypeMap::iterator it = scene_data_types.find(name);
+void
+delete_plugin_instance(const std::string& name)
+{        
+    PluginInstanceMap::iterator it = plugin_instances.find(name);
 
-    if (it == scene_data_types.end())
+    if (it == plugin_instances.end())
     {
-        printf("... Scene data '%s' does not exist\n", name.c_str());
-        return false;
+        printf("ERROR: plugin instance '%s' to delete not found!\n", name.c_str());
+        return;
     }
-    else if (it->second != type)
+
+    PluginInstance *plugin_instance = it->second;
+
+    // The state can't be deleted while the plugin is still working on it
+    finish_plugin_creation(plugin_instance);
+
+    PluginState *state = plugin_instance->state;
+    const std::string& internal_name = plugin_instance->plugin_internal_name;
+
+    // Only delete the state when no other session uses it
+    std::map<std::string, SharedPluginState>::iterator shared = shared_plugin_states.find(plugin_instance->shared_state_key);
+    assert(shared != shared_plugin_states.end());
+
+    if (--shared->second.users > 0)
+        printf("... Plugin state still used by %d other instance(s), keeping it\n", shared->second.users);
+    else
     {
-        printf("... Scene data '%s' is not of type %s, but of type %s\n", 
-            name.c_str(), SceneDataType_names[type], SceneDataType_names[it->second]);
-        return false;
+        if (state->data)
+        {
+            PluginDefinitionsMap::iterator it = plugin_definitions.find(internal_name);
+
+            if (it != plugin_definitions.end())
+            {
+                // Call plugin's clear_data_function_t
+                it->second.functions.clear_data_function(state);
+            }
+            else
+            {
+                printf("... WARNING: user data non-null on plugin instance of type '%s', but no clear data function set\n", 
+                    internal_name.c_str());
+            }
+        }
+        
+        delete state;
+        shared_plugin_states.erase(shared);
     }
 
-    printf("... Scene data '%s' found, type %s\n", name.c_str(), SceneDataType_names[type]);
-    
-    return true;        
+    plugin_instances.erase(it);
+    plugin_state.erase(name);
+    scene_data_types.erase(name);
+
+    delete plugin_instance;
 }
 
-//
-// Scene elements
-//
+// Blender mesh cache
 
-OSPTransferFunction
-create_transfer_function(const std::string& name, float minval, float maxval)
+// Deletes the least recently used mesh in the cache
+void
+blender_mesh_cache_evict_last()
 {
-    printf("... create_transfer_function('%s', %.6f, %.6f)\n", name.c_str(), minval, maxval);
+    BlenderMesh *evicted = blender_mesh_cache_lru.back();
+    
+    printf("... Evicting mesh '%s' (%s) from mesh cache\n", evicted->name.c_str(), evicted->content_hash.c_str());
 
-	/*if (name == "jet")
-	{
-		osp_vec2f voxelRange = { minval, maxval };
-		return ospTestingNewTransferFunction(voxelRange, "jet");
-    }
-    else if (name == "cool2warm")*/
-    {
-		// XXX should do this only once
-	    float tf_colors[3*cool2warm_entries];
-	    float tf_opacities[cool2warm_entries];
+    blender_mesh_cache_lru.pop_back();
+    blender_mesh_cache.erase(evicted->content_hash);
+    blender_mesh_cache_size -= evicted->memory_size();
+    
+    delete evicted;
+}
 
-	    for (int i = 0; i < cool2warm_entries; i++)
-	    {
-	        tf_opacities[i]  = cool2warm[4*i+0];
-	        tf_colors[3*i+0] = cool2warm[4*i+1];
-	        tf_colors[3*i+1] = cool2warm[4*i+2];
-	        tf_colors[3*i+2] = cool2warm[4*i+3];
-	    }
+// Returns a new (committed) geometry with copies of the mesh's data
+OSPGeometry
+copy_blender_mesh_geometry(const BlenderMesh *blender_mesh)
+{
+    const uint32_t nv = blender_mesh->num_vertices;
+    OSPData data;
 
-    	OSPTransferFunction tf = ospNewTransferFunction("piecewiseLinear");
+    OSPGeometry geometry = ospNewGeometry("mesh");
 
-        	ospSetVec2f(tf, "valueRange", minval, maxval);
+        data = ospNewCopiedData(nv, OSP_VEC3F, blender_mesh->vertices.data());
+        ospSetObject(geometry, "vertex.position", data);
+        ospRelease(data);
 
-        	OSPData color_data = ospNewCopiedData(cool2warm_entries, OSP_VEC3F, tf_colors);
-            ospCommit(color_data);
-        	ospSetObject(tf, "color", color_data);        	
+        data = ospNewCopiedData(blender_mesh->num_triangles, OSP_VEC3UI, blender_mesh->triangles.data());
+        ospSetObject(geometry, "index", data);
+        ospRelease(data);
 
-        	// XXX color and opacity can be decoupled?
-        	OSPData opacity_data = ospNewCopiedData(cool2warm_entries, OSP_FLOAT, tf_opacities);
-            ospCommit(opacity_data);
-        	ospSetObject(tf, "opacity", opacity_data);        	
+        if (!blender_mesh->normals.empty())
+        {
+            data = ospNewCopiedData(nv, OSP_VEC3F, blender_mesh->normals.data());
+            ospSetObject(geometry, "vertex.normal", data);
+            ospRelease(data);
+        }
 
-    	ospCommit(tf);
-        ospRelease(color_data);
-        ospRelease(opacity_data);        
+        if (!blender_mesh->vertex_colors.empty())
+        {
+            data = ospNewCopiedData(nv, OSP_VEC4F, blender_mesh->vertex_colors.data());
+            ospSetObject(geometry, "vertex.color", data);
+            ospRelease(data);
+        }
 
-    	return tf;
-	}
+    ospCommit(geometry);
 
-    return nullptr;
+    return geometry;
 }
 
-OSPTransferFunction
-create_user_transfer_function(float minval, float maxval, const Volume& volume, int num_tf_entries=128)
+// The mesh's geometry shares the mesh's buffers, which get freed (or,
+// when cached, reused by any session) once the mesh is deleted. Mesh
+// objects of the current session still using the geometry (e.g. when
+// the mesh got deleted before the objects linking it) are switched to a
+// copy of it.
+void
+detach_blender_mesh_objects(BlenderMesh *blender_mesh)
 {
-    printf("... create_user_transfer_function(%.6f, %.6f, ...)\n", minval, maxval);
-
-    if (volume.tf_positions_size() != volume.tf_colors_size())
-    {
-        printf("... WARNING: number of positions and colors not equal, falling back to default TF\n");
-        return create_transfer_function("cool2warm", minval, maxval);
-    }
-
-    const int& num_positions = volume.tf_positions_size();
+    OSPGeometry copy = nullptr;
 
-    printf("Input (%d positions):\n", num_positions);
-    for (int i = 0; i < num_positions; i++)
+    for (auto& kv : scene_objects)
     {
-        const Color& col = volume.tf_colors(i);
-        printf("[%d] pos = %.3f; col = %.3f %.3f %.3f; %.3f\n", i, volume.tf_positions(i), 
-            col.r(), col.g(), col.b(), col.a());
-    }
-
-    float tf_colors[3*num_tf_entries];
-    float tf_opacities[num_tf_entries];
+        if (kv.second->type != SOT_MESH)
+            continue;
 
-    assert(num_tf_entries >= 2);
-    float value_step = 1.0f / (num_tf_entries - 1);
-    float normalized_value;
-    int pos;    // XXX rename in index
-    float r, g, b, a;
+        SceneObjectMesh *mesh_object = dynamic_cast<SceneObjectMesh*>(kv.second);
 
-    normalized_value = 0.0f;
+        if (mesh_object->geometry != blender_mesh->geometry)
+            continue;
 
-    // XXX need to verify correctness here
-    //printf("TF:\n");
-    for (int i = 0; i < num_tf_entries; i++)
-    {
-        // Find first position that is <= normalized_value        
-        if (normalized_value < volume.tf_positions(0))
-        {            
-            const Color &col = volume.tf_colors(0);
-            r = col.r();
-            g = col.g();
-            b = col.b();
-            a = col.a();
-        }
-        else                    
+        if (copy == nullptr)
         {
-            pos = 0;
-            while (pos < num_positions && volume.tf_positions(pos) <= normalized_value)
-                pos++;
-            
-            if (pos == num_positions)
-            {
-                const Color &col = volume.tf_colors(volume.tf_colors_size()-1);
-                r = col.r();
-                g = col.g();
-                b = col.b();
-                a = col.a();             
-            }
-            else
-            {
-                // Interpolate
-                pos--;
-                const Color &col1 = volume.tf_colors(pos);
-                const Color &col2 = volume.tf_colors(pos+1);
-
-                const float pos1 = volume.tf_positions(pos);
-                const float pos2 = volume.tf_positions(pos+1);
-                const float f = 1.0 - (normalized_value - pos1) / (pos2 - pos1);
-
-                r = f*col1.r() + (1-f)*col2.r();
-                g = f*col1.g() + (1-f)*col2.g();
-                b = f*col1.b() + (1-f)*col2.b();
-                a = f*col1.a() + (1-f)*col2.a(); 
-            }
-        }    
-
-        printf("[%d] %f, %f, %f; %f\n", i, r, g, b, a);
+            printf("... Mesh '%s' still used by objects, giving them a copy\n", blender_mesh->name.c_str());
+            copy = copy_blender_mesh_geometry(blender_mesh);
+        }
 
-        tf_colors[3*i+0] = r;
-        tf_colors[3*i+1] = g;
-        tf_colors[3*i+2] = b;
-        tf_opacities[i]  = a;
+        ospSetObject(mesh_object->gmodel, "geometry", copy);
+        ospCommit(mesh_object->gmodel);
+        ospCommit(mesh_object->group);
+        ospCommit(mesh_object->instance);
+        mesh_object->geometry = copy;
 
-        normalized_value += value_step;
+        ospray_world_changed = true;
     }
 
-    OSPTransferFunction tf = ospNewTransferFunction("piecewiseLinear");
+    // The geometric models hold the references
+    if (copy != nullptr)
+        ospRelease(copy);
+}
 
-        ospSetVec2f(tf, "valueRange", minval, maxval);
+// Takes ownership of the mesh, which is either cached or deleted
+void
+blender_mesh_cache_add(BlenderMesh *blender_mesh)
+{
+    detach_blender_mesh_objects(blender_mesh);
 
-        OSPData color_data = ospNewCopiedData(num_tf_entries, OSP_VEC3F, tf_colors);
-        ospSetObject(tf, "color", color_data);
+    const std::string& hash = blender_mesh->content_hash;
+    const size_t size = blender_mesh->memory_size();
 
-        OSPData opacity_data = ospNewCopiedData(num_tf_entries, OSP_FLOAT, tf_opacities);
-        ospSetObject(tf, "opacity", opacity_data);   
+    if (hash == "" || size > blender_mesh_cache_max_size || blender_mesh_cache.find(hash) != blender_mesh_cache.end())
+    {
+        delete blender_mesh;
+        return;
+    }
 
-    ospCommit(tf);
-    ospRelease(color_data);
-    ospRelease(opacity_data);        
+    blender_mesh_cache_lru.push_front(blender_mesh);
+    blender_mesh_cache[hash] = blender_mesh_cache_lru.begin();
+    blender_mesh_cache_size += size;
 
-    return tf;
+    // Evict least recently used
+    while (blender_mesh_cache_size > blender_mesh_cache_max_size)
+        blender_mesh_cache_evict_last();
 }
 
-
-bool
-handle_update_plugin_instance(TCPSocket *sock)
+// Returns nullptr if not cached, otherwise the caller takes ownership
+BlenderMesh*
+blender_mesh_cache_take(const std::string& hash)
 {
-    UpdatePluginInstance    update;
+    BlenderMeshCacheMap::iterator it = blender_mesh_cache.find(hash);
 
-    if (!receive_protobuf(sock, update))
-        return false;
+    if (it == blender_mesh_cache.end())
+        return nullptr;
 
-    //print_protobuf(update);
+    BlenderMesh *blender_mesh = *(it->second);
 
-    const std::string& data_name = update.name();
+    blender_mesh_cache_lru.erase(it->second);
+    blender_mesh_cache.erase(it);
+    blender_mesh_cache_size -= blender_mesh->memory_size();
 
-    printf("PLUGIN INSTANCE '%s'\n", data_name.c_str());
+    return blender_mesh;
+}
 
-    bool create_new_instance;
-    PluginInstance *plugin_instance;
-    PluginState *state;    
-    PluginType plugin_type;
+void
+delete_blender_mesh(const std::string& name)
+{
+    SceneDataTypeMap::iterator it = scene_data_types.find(name);
 
-    switch (update.type())
+    if (it == scene_data_types.end())
     {
-    case UpdatePluginInstance::GEOMETRY:
-        plugin_type = PT_GEOMETRY;
-        break;
-    case UpdatePluginInstance::VOLUME:
-        plugin_type = PT_VOLUME;
-        break;
-    case UpdatePluginInstance::SCENE:
-        plugin_type = PT_SCENE;
-        break;
-    default:
-        printf("... WARNING: unknown plugin instance type %d!\n", update.type());
-        return false;
+        printf("ERROR: blender mesh to delete '%s' not found!\n", name.c_str());
+        return;
     }
 
-    const char *plugin_type_name = PluginType_names[plugin_type];
-    const std::string &plugin_name = update.plugin_name();
-
-    printf("... plugin type: %s\n", plugin_type_name);
-    printf("... plugin name: '%s'\n", plugin_name.c_str());
+    if (it->second != SDT_BLENDER_MESH)
+    {
+        printf("ERROR: blender mesh to delete '%s' is not of type SDT_BLENDER_MESH!\n", name.c_str());
+        return;
+    }
 
-    const char *s_plugin_parameters = update.plugin_parameters().c_str();
-    //printf("Received plugin parameters:\n%s\n", s_plugin_parameters);
-    const json &plugin_parameters = json::parse(s_plugin_parameters);
-    printf("... parameters:\n");
-    printf("%s\n", plugin_parameters.dump(4).c_str());
-    
-#if 0
-    const char *s_custom_properties = update.custom_properties().c_str();
-    //printf("Received custom properties:\n%s\n", s_custom_properties);
-    const json &custom_properties = json::parse(s_custom_properties);
-    if (!custom_properties.empty())
+    BlenderMeshMap::iterator bm = blender_meshes.find(name);
+    if (bm == blender_meshes.end())
     {
-        printf("... custom properties:\n");
-        printf("%s\n", custom_properties.dump(4).c_str());
+        printf("ERROR: blender mesh to delete '%s' not found!\n", name.c_str());
+        return;        
     }
-#endif
 
-    // Check against the current instances
+    blender_mesh_cache_add(bm->second);
+    blender_meshes.erase(bm);
 
-    create_new_instance = true;
+    scene_data_types.erase(name);
+}
 
-    if (scene_data_with_type_exists(data_name, SDT_PLUGIN))
-    {
-        // Have existing plugin instance with this name, check what it is
-        plugin_instance = plugin_instances[data_name];
-        assert(plugin_state.find(data_name) != plugin_state.end());
-        state = plugin_state[data_name];
+//
+// Scene management
+//
 
-        // XXX could use internal name?
-        if (plugin_instance->type != plugin_type || plugin_instance->plugin_name != plugin_name)
-        {
-            printf("... Existing plugin (type %s, name '%s') does't match, overwriting!\n", 
-                PluginType_names[plugin_instance->type], plugin_name.c_str());
-            delete_plugin_instance(data_name);            
-        }
-        else
-        {
-            // Plugin still of the same type and name, check if parameters and properties still up to date
-            const std::string& parameters_hash = get_sha1(update.plugin_parameters());
-#if 0
-            const std::string& custom_props_hash = get_sha1(update.custom_properties());
-#endif
+// Removes the given instances (or lights) from the world list, keeping
+// the order of the remaining entries
+template<typename T>
+void
+remove_from_world_list(std::vector<T>& list, const std::vector<T>& to_remove)
+{
+    if (to_remove.empty())
+        return;
 
-            if (parameters_hash != plugin_instance->parameters_hash)
-            {
-                printf("... Parameters changed, re-creating plugin instance\n");
-                delete_plugin_instance(data_name);                
-            }
-#if 0
-            else if (custom_props_hash != plugin_instance->custom_properties_hash)
-            {
-                printf("... Custom properties changed, re-running plugin\n");
-                delete_plugin_instance(data_name);                
-            }
-#endif
-            else if (plugin_instance->state->uses_renderer_type && plugin_instance->state->renderer != current_renderer_type)
-            {
-                printf("... Plugin depends on renderer type, which changed from '%s', re-running plugin\n", 
-                    plugin_instance->state->renderer.c_str());
-                delete_plugin_instance(data_name);                
-            }
-            else
-                create_new_instance = false;
-        }
-    }
+    const std::unordered_set<T> remove_set(to_remove.begin(), to_remove.end());
 
-    // Prepare result
-    // By default all is well, we let the plugin signal something went wrong 
-    GenerateFunctionResult result;    
-    result.set_success(true);    
+    list.erase(std::remove_if(list.begin(), list.end(), 
+        [&remove_set](const T& t) { return remove_set.count(t) > 0; }), list.end());
+}
 
-    if (!create_new_instance)
+void
+delete_object(const std::string& object_name)
+{        
+    SceneObjectMap::iterator it = scene_objects.find(object_name);
+
+    if (it == scene_objects.end())
     {
-        printf("... Cached plugin instance still up-to-date\n");
-        // XXX we misuse GenerateFunctionResult here, as nothing was generated...
-        send_protobuf(sock, result);
-        return true;
+        printf("ERROR: object to delete '%s' not found!\n", object_name.c_str());
+        return;
     }
 
-    // At this point we're creating a new plugin instance, check the plugin itself first
-
-    PluginDefinition plugin_definition;
+    SceneObject *scene_object = it->second;
+    delete scene_object;
 
-    if (!ensure_plugin_is_loaded(result, plugin_definition, plugin_type, plugin_name))
-    {
-        // Something went wrong...
-        send_protobuf(sock, result);
-        return false;
-    }    
+    scene_objects.erase(object_name);
+}
 
-    create_instance_function_t create_instance_function = plugin_definition.functions.create_instance_function;
+void 
+delete_scene_data(const std::string& name)
+{
+    SceneDataTypeMap::iterator it = scene_data_types.find(name);
 
-    if (create_instance_function == NULL)
+    if (it == scene_data_types.end())
     {
-        printf("... ERROR: plugin create_instance_function is NULL!\n");
-        result.set_message("Plugin create_instance_function is NULL!");
-        send_protobuf(sock, result);
-        return false;
+        printf("ERROR: scene data '%s' to delete not found!\n", name.c_str());
+        return;
     }
 
-    // Check parameters passed to generate function
-
-    if (!check_plugin_parameters(result, plugin_definition.parameters, plugin_parameters))
-    {
-        // Something went wrong...
-        send_protobuf(sock, result);
-        return false;
-    }    
-    
-    // XXX find a better place to replace envvars
-    // Could do this on the raw (unparsed) json string?
-    json plugin_parameters2;
-    for (json::const_iterator it = plugin_parameters.begin(); it != plugin_parameters.end(); ++it)
+    if (it->second == SDT_PLUGIN)
+        delete_plugin_instance(name);
+    else
     {
-        const json& value = it.value();
-        
-        if (value.is_string())
-            plugin_parameters2[it.key()] = replace_environment_variables(value.get<std::string>());
-        else
-            plugin_parameters2[it.key()] = value;
+        assert(it->second == SDT_BLENDER_MESH);
+        delete_blender_mesh(name);
     }
 
-    // Create plugin instance and state    
+    scene_data_types.erase(name);
+}
 
-    state = new PluginState; 
-    state->renderer = current_renderer_type;   
-    state->uses_renderer_type = plugin_definition.uses_renderer_type;
-    state->parameters = plugin_parameters2;
+void
+delete_all_scene_data()
+{
+    // Copy, as the delete functions below modify scene_data_types
+    const SceneDataTypeMap data_types = scene_data_types;
 
-    PluginResult plugin_result;
+    for (auto& kv : data_types)
+    {
+        const std::string& name = kv.first;
+        const SceneDataType& type = kv.second;
 
-    // Call generate function
+        if (type == SDT_PLUGIN)
+            delete_plugin_instance(name);
+        else
+        {
+            assert(type == SDT_BLENDER_MESH);
+            delete_blender_mesh(name);
+        }
+    }
 
-    struct timeval t0, t1;
+    scene_data_types.clear();
+}
 
-    printf("... Calling create_instance function\n");
-    gettimeofday(&t0, NULL);
+// Makes sure the given plugin instance is ready for use, i.e. not 
+// being created in the background anymore. An instance whose creation
+// failed is deleted, in which case false is returned.
+// Called with server_mutex held, which is released while waiting.
+bool
+wait_for_plugin_instance(const std::string& name)
+{
+    PluginInstanceMap::iterator it = plugin_instances.find(name);
 
-    create_instance_function(plugin_result, state);
+    if (it == plugin_instances.end())
+        return false;
 
-    gettimeofday(&t1, NULL);
-    printf("... Created instance in %.3fs\n", time_diff(t0, t1));
-    
-    if (!plugin_result.success)
+    if (!finish_plugin_creation(it->second))
     {
-        result.set_success(false);
-        result.set_message(plugin_result.message);
-        
-        printf("... ERROR: create_instance failed:\n");
-        printf("... %s\n", result.message().c_str());
-        send_protobuf(sock, result);
-        delete state;
+        printf("... Deleting plugin instance '%s', as creating it failed\n", name.c_str());
+        delete_scene_data(name);
         return false;
     }
 
-    // Handle any other business for this type of plugin
-    // XXX set result.success to false?
-    
-    std::string internal_name;
-
-    switch (plugin_type)
-    {
-    case PT_GEOMETRY:
+    return true;
+}
 
-        if (state->geometry == nullptr)
-        {
-            send_protobuf(sock, result);
+void
+wait_for_all_plugin_instances()
+{
+    // Copy, as failed instances get deleted
+    std::vector<std::string> names;
 
-            printf("... ERROR: geometry create_instance did not set an OSPGeometry!\n");
-            delete state;
-            return false;
-        }    
-        
-        internal_name = "geometry";
+    for (auto& kv : plugin_instances)
+        names.push_back(kv.first);
 
-        break;
+    for (auto& name : names)
+        wait_for_plugin_instance(name);
+}
 
-    case PT_VOLUME:
+// Memory budget
 
-        if (state->volume != nullptr)
-        {
-            printf("... volume data range %.6f %.6f\n", state->volume_data_range[0], state->volume_data_range[1]);
-        }
-        else
-        {
-            send_protobuf(sock, result);
+// Accounted size of a plugin state, in bytes
+size_t
+shared_plugin_state_memory_size(const SharedPluginState& shared)
+{
+    // The state is still being filled in while pending
+    if (shared.pending != nullptr)
+        return 0;
 
-            printf("... ERROR: volume create_instance did not set an OSPVolume!\n");
-            delete state;
-            return false;
-        }
-        
-        internal_name = "volume";
+    if (shared.state != nullptr && shared.state->memory_size > 0)
+        return shared.state->memory_size;
 
-        break;
+    return shared.memory_usage > 0.0f ? (size_t)(shared.memory_usage * MB) : 0;
+}
 
-    case PT_SCENE:
+size_t
+plugin_instance_memory_size(const PluginInstance *plugin_instance)
+{
+    std::map<std::string, SharedPluginState>::const_iterator shared = shared_plugin_states.find(plugin_instance->shared_state_key);
 
-        if (state->group_instances.size() > 0)
-        {
-            printf("... %d instances\n", state->group_instances.size());
-            printf("... %d lights\n", state->lights.size());
-        }
-        else
-            printf("... WARNING: scene create_instance returned zero instances!\n");    
-        
-        internal_name = "scene";
+    if (shared == shared_plugin_states.end())
+        return 0;
 
-        break;
-    }
+    return shared_plugin_state_memory_size(shared->second);
+}
 
-    // Load function succeeded
-    
-    internal_name += "_" + plugin_name;
+// Memory accounted for in the budget, in bytes: the plugin states of all
+// sessions, plus this session's Blender meshes and the mesh cache.
+// XXX Blender meshes of other sessions are not included
+size_t
+accounted_memory_size()
+{
+    size_t size = blender_mesh_cache_size;
 
-    plugin_instance = new PluginInstance;
-    plugin_instance->type = plugin_type;
-    plugin_instance->plugin_name = plugin_name;
-    plugin_instance->plugin_internal_name = internal_name;
-    plugin_instance->state = state; 
-    plugin_instance->name = data_name;    
-    plugin_instance->parameters_hash = get_sha1(s_plugin_parameters);
-#if 0
-    plugin_instance->custom_properties_hash = get_sha1(s_custom_properties);    
-#endif
-    
-    plugin_instances[data_name] = plugin_instance;
-    plugin_state[data_name] = state;
-    scene_data_types[data_name] = SDT_PLUGIN;
+    for (auto& kv : shared_plugin_states)
+        size += shared_plugin_state_memory_size(kv.second);
 
-    send_protobuf(sock, result);
+    for (auto& kv : blender_meshes)
+        size += kv.second->memory_size();
 
-    return true;
+    return size;
 }
 
-bool
-handle_update_blender_mesh_data(TCPSocket *sock, const std::string& name)
+// Evicts least-recently-rendered data not used by the current scene, 
+// i.e. cached meshes and this session's plugin instances not referenced 
+// by any scene object, until the accounted memory fits in the budget.
+// Plugin instances sharing their state with other instances are kept,
+// as deleting them would not free anything.
+void
+enforce_memory_budget()
 {
-    printf("DATA '%s' (blender mesh)\n", name.c_str());
+    if (memory_budget == 0)
+        return;
 
-    BlenderMesh *blender_mesh;
-    OSPGeometry geometry;
-    bool create_new_mesh = false;
+    size_t used = accounted_memory_size();
 
-    SceneDataTypeMap::iterator it = scene_data_types.find(name);
-    if (it == scene_data_types.end())
+    if (used <= memory_budget)
+        return;
+
+    printf("Memory budget of %.1f MB exceeded (%.1f MB accounted), evicting unused scene data\n",
+        1.0f*memory_budget/MB, 1.0f*used/MB);
+
+    std::set<std::string> referenced;
+
+    for (auto& kv : scene_objects)
     {
-        // No previous mesh with this name
-        printf("... Unseen name, creating new mesh\n");
-        create_new_mesh = true;
+        if (kv.second->data_link != "")
+            referenced.insert(kv.second->data_link);
     }
-    else
+
+    while (used > memory_budget)
     {
-        // Have existing scene data with this name, check what it is
-        SceneDataType type = it->second;
+        PluginInstance *oldest = nullptr;
 
-        if (type != SDT_BLENDER_MESH)
+        for (auto& kv : plugin_instances)
         {
-            printf("... WARNING: data is currently of type %s, overwriting with new mesh!\n", SceneDataType_names[type]);
+            PluginInstance *plugin_instance = kv.second;
+
+            if (referenced.find(kv.first) != referenced.end())
+                continue;
+
+            std::map<std::string, SharedPluginState>::const_iterator shared = shared_plugin_states.find(plugin_instance->shared_state_key);
+
+            if (shared == shared_plugin_states.end() || shared->second.users > 1 || shared->second.pending != nullptr)
+                continue;
+
+            if (oldest == nullptr || plugin_instance->last_rendered < oldest->last_rendered)
+                oldest = plugin_instance;
+        }
+
+        if (!blender_mesh_cache_lru.empty() 
+            && (oldest == nullptr || blender_mesh_cache_lru.back()->last_rendered <= oldest->last_rendered))
+        {
+            blender_mesh_cache_evict_last();
+        }
+        else if (oldest != nullptr)
+        {
+            // Copy, as the instance gets deleted
+            const std::string name = oldest->name;
+
+            printf("... Evicting plugin instance '%s' (%.1f MB)\n", name.c_str(), 
+                1.0f*plugin_instance_memory_size(oldest)/MB);
+
             delete_scene_data(name);
-            create_new_mesh = true;
         }
         else
         {
-            printf("... Updating existing mesh\n");            
-            blender_mesh = blender_meshes[name];
-            geometry = blender_mesh->geometry;
-            // As we're updating an existing geometry these might not get set 
-            // again below, so remove them here. If they are set below there
-            // value will get updated anyway
-            // XXX is it ok to remove a param that was never set?
-            ospRemoveParam(geometry, "vertex.normal");
-            ospRemoveParam(geometry, "vertex.color");
+            printf("WARNING: nothing left to evict, memory budget remains exceeded\n");
+            break;
         }
-    }
 
-    if (create_new_mesh)
-    {
-        blender_mesh = blender_meshes[name] = new BlenderMesh;
-        geometry = blender_mesh->geometry = ospNewGeometry("mesh");
-        scene_data_types[name] = SDT_BLENDER_MESH;
+        used = accounted_memory_size();
     }
+}
 
-    MeshData    mesh_data;
-    OSPData     data;
-    uint32_t    nv, nt, flags;    
-
-    if (!receive_protobuf(sock, mesh_data))
-        return false;
+/*
+Find scene object by name, create new if not found.
+Three cases:
+1. no existing object with name 
+2. existing object with name, but of wrong type 
+3. existing object with name and correct type 
 
-    nv = blender_mesh->num_vertices = mesh_data.num_vertices();
-    nt = blender_mesh->num_triangles = mesh_data.num_triangles();
-    flags = mesh_data.flags();
+Returns NULL if no existing object found with given name.
+*/
 
-    printf("... %d vertices, %d triangles, flags 0x%08x\n", nv, nt, flags);
+SceneObject*
+find_scene_object(const std::string& name, SceneObjectType type, bool delete_existing_mismatch=true)
+{
+    SceneObject *scene_object;
+    SceneObjectMap::iterator it = scene_objects.find(name);
 
-    if (nv == 0 || nt == 0)
+    if (it == scene_objects.end())
     {
-        printf("... WARNING: mesh without vertices/triangles not allowed, ignoring!\n");
-        // XXX release geometry
-        return false;
+        printf("... No existing object\n");
+        return nullptr;
     }
-
-    // Receive mesh data
-
-    vertex_buffer.reserve(nv*3);
-    if (sock->recvall(&vertex_buffer[0], nv*3*sizeof(float)) == -1)
-        return false;
-
-    if (flags & MeshData::NORMALS)
+    
+    scene_object = it->second;
+    if (scene_object->type != type)
     {
-        printf("... Mesh has normals\n");
-        normal_buffer.reserve(nv*3);
-        if (sock->recvall(&normal_buffer[0], nv*3*sizeof(float)) == -1)
-            return false;
+        if (delete_existing_mismatch)
+        {
+            printf("... Existing object is not of type %s, but of type %s, deleting\n", 
+                SceneObjectType_names[type], SceneObjectType_names[scene_object->type]);
+            delete_object(name);
+            return nullptr;
+        }
+        else
+            return scene_object;
     }
-
-    if (flags & MeshData::VERTEX_COLORS)
-    {
-        printf("... Mesh has vertex colors\n");
-        vertex_color_buffer.reserve(nv*4);
-        if (sock->recvall(&vertex_color_buffer[0], nv*4*sizeof(float)) == -1)
-            return false;
+    else
+    {        
+        printf("... Existing object matches type %s\n", SceneObjectType_names[type]);
+        return scene_object;
     }
+}
 
-    triangle_buffer.reserve(nt*3);
-    if (sock->recvall(&triangle_buffer[0], nt*3*sizeof(uint32_t)) == -1)
-        return false;
-
-    // Set up geometry
-
-    data = ospNewCopiedData(nv, OSP_VEC3F, &vertex_buffer[0]);    
-    ospSetObject(geometry, "vertex.position", data);
-    ospRelease(data);
+bool
+scene_data_with_type_exists(const std::string& name, SceneDataType type)
+{
+    SceneDataTypeMap::iterator it = scene_data_types.find(name);
 
-    if (flags & MeshData::NORMALS)
+    if (it == scene_data_types.end())
     {
-        data = ospNewCopiedData(nv, OSP_VEC3F, &normal_buffer[0]);        
-        ospSetObject(geometry, "vertex.normal", data);
-        ospRelease(data);
+        printf("... Scene data '%s' does not exist\n", name.c_str());
+        return false;
     }
-
-    if (flags & MeshData::VERTEX_COLORS)
+    else if (it->second != type)
     {
-        data = ospNewCopiedData(nv, OSP_VEC4F, &vertex_color_buffer[0]);        
-        ospSetObject(geometry, "vertex.color", data);
-        ospRelease(data);
+        printf("... Scene data '%s' is not of type %s, but of type %s\n", 
+            name.c_str(), SceneDataType_names[type], SceneDataType_names[it->second]);
+        return false;
     }
 
-    data = ospNewCopiedData(nt, OSP_VEC3UI, &triangle_buffer[0]);    
-    ospSetObject(geometry, "index", data);
-    ospRelease(data);
-
-    ospCommit(geometry);
-
-    return true;
+    printf("... Scene data '%s' found, type %s\n", name.c_str(), SceneDataType_names[type]);
+    
+    return true;        
 }
 
-bool
-update_blender_mesh_object(const UpdateObject& update)
-{    
-    const std::string& object_name = update.name();
-    const std::string& linked_data = update.data_link();
-
-    printf("OBJECT '%s' (blender mesh)\n", object_name.c_str());   
-    printf("--> '%s'\n", linked_data.c_str());
-
-    SceneObject     *scene_object;
-    SceneObjectMesh *mesh_object;
-    OSPInstance     instance;
-    OSPGroup        group;
-    OSPGeometricModel gmodel;
-
-    scene_object = find_scene_object(object_name, SOT_MESH);
-
-    if (scene_object == nullptr)
-        mesh_object = new SceneObjectMesh;    
-    else
-        mesh_object = dynamic_cast<SceneObjectMesh*>(scene_object);
-
-    instance = mesh_object->instance;
-    assert(instance != nullptr);
-    group = mesh_object->group;
-    assert(group != nullptr);
+//
+// Scene elements
+//
 
-    // Check linked data
+// A piecewise linear transfer function
+struct TransferFunctionDefinition
+{
+    std::vector<float>  colors;         // RGB
+    std::vector<float>  opacities;
+    float               value_range[2];
 
-    if (!scene_data_with_type_exists(linked_data, SDT_BLENDER_MESH))
+    // Registry key
+    std::string key() const
     {
-        if (scene_object == nullptr)
-            delete mesh_object;
-        return false;
+        std::string data((const char*)colors.data(), colors.size()*sizeof(float));
+        data.append((const char*)opacities.data(), opacities.size()*sizeof(float));
+        data.append((const char*)value_range, sizeof(value_range));
+        return "piecewiseLinear:" + get_sha1(data);
     }
+};
 
-    BlenderMesh *blender_mesh = blender_meshes[linked_data];
-    OSPGeometry geometry = blender_mesh->geometry;
-
-    if (geometry == NULL)
-    {
-        printf("... ERROR: geometry is NULL!\n");
-        if (scene_object == nullptr)
-            delete mesh_object;
-        return false;
-    }    
+void
+default_transfer_function(TransferFunctionDefinition& tf, float minval, float maxval)
+{
+    tf.colors.resize(3*cool2warm_entries);
+    tf.opacities.resize(cool2warm_entries);
 
-    if (scene_object == nullptr)
+    for (int i = 0; i < cool2warm_entries; i++)
     {
-        mesh_object->data_link = linked_data;
-        gmodel = mesh_object->gmodel = ospNewGeometricModel(geometry);
+        tf.opacities[i]  = cool2warm[4*i+0];
+        tf.colors[3*i+0] = cool2warm[4*i+1];
+        tf.colors[3*i+1] = cool2warm[4*i+2];
+        tf.colors[3*i+2] = cool2warm[4*i+3];
     }
-    else
+
+    tf.value_range[0] = minval;
+    tf.value_range[1] = maxval;
+}
+
+// Resamples the color ramp of the volume settings to num_tf_entries entries
+void
+user_transfer_function(TransferFunctionDefinition& tf, float minval, float maxval, const Volume& volume, int num_tf_entries=128)
+{
+    if (volume.tf_positions_size() != volume.tf_colors_size())
     {
-        // XXX need this for updating material
-        gmodel = mesh_object->gmodel;
+        printf("... WARNING: number of positions and colors not equal, falling back to default TF\n");
+        default_transfer_function(tf, minval, maxval);
+        return;
     }
 
-    // Update object 
+    const int& num_positions = volume.tf_positions_size();
 
-    glm::mat4   obj2world;
-    float       affine_xform[12];
+    assert(num_tf_entries >= 2);
 
-    object2world_from_protobuf(obj2world, update);
-    affine3fv_from_mat4(affine_xform, obj2world);
-    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+    tf.colors.resize(3*num_tf_entries);
+    tf.opacities.resize(num_tf_entries);
 
-    ospCommit(instance);    
-    
-    ospSetObjectAsData(group, "geometry", OSP_GEOMETRIC_MODEL, gmodel);
-    ospCommit(group);    
+    const float value_step = 1.0f / (num_tf_entries - 1);
+    float r, g, b, a;
 
-    const std::string& matname = update.material_link();
+    // The ramp positions are sorted, as are the values sampled, so
+    // the index of the first position > value only moves forward
+    int pos = 0;
 
-    SceneMaterialMap::iterator it = scene_materials.find(matname);
-    if (it != scene_materials.end())
-    {
-        printf("... Material '%s'\n", matname.c_str());
-        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, it->second->material);
-    }
-    else
+    for (int i = 0; i < num_tf_entries; i++)
     {
-        printf("... WARNING: Material '%s' not found, using default!\n", matname.c_str());
-        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, default_materials[current_renderer_type]);
+        const float normalized_value = i * value_step;
+
+        while (pos < num_positions && volume.tf_positions(pos) <= normalized_value)
+            pos++;
+
+        if (pos == 0 || pos == num_positions)
+        {
+            // Before the first or after the last position
+            const Color &col = volume.tf_colors(pos == 0 ? 0 : num_positions-1);
+            r = col.r();
+            g = col.g();
+            b = col.b();
+            a = col.a();
+        }
+        else
+        {
+            // Interpolate
+            const Color &col1 = volume.tf_colors(pos-1);
+            const Color &col2 = volume.tf_colors(pos);
+
+            const float pos1 = volume.tf_positions(pos-1);
+            const float pos2 = volume.tf_positions(pos);
+            const float f = 1.0 - (normalized_value - pos1) / (pos2 - pos1);
+
+            r = f*col1.r() + (1-f)*col2.r();
+            g = f*col1.g() + (1-f)*col2.g();
+            b = f*col1.b() + (1-f)*col2.b();
+            a = f*col1.a() + (1-f)*col2.a(); 
+        }
+
+        tf.colors[3*i+0] = r;
+        tf.colors[3*i+1] = g;
+        tf.colors[3*i+2] = b;
+        tf.opacities[i]  = a;
     }
 
-    /*
-    float cols[] = { 1, 0, 0, 1 };
-    OSPData colors = ospNewCopiedData(1, OSP_VEC4F, &cols[0]);        
-    ospSetObject(gmodel, "color", colors);
-    ospRelease(colors);
-    */
+    tf.value_range[0] = minval;
+    tf.value_range[1] = maxval;
+}
 
-    ospCommit(gmodel);
+void
+set_transfer_function(OSPTransferFunction tf, const TransferFunctionDefinition& definition)
+{
+    ospSetVec2f(tf, "valueRange", definition.value_range[0], definition.value_range[1]);
 
-    if (scene_object == nullptr)
-        scene_objects[object_name] = mesh_object;
+        OSPData color_data = ospNewCopiedData(definition.colors.size()/3, OSP_VEC3F, definition.colors.data());
+        ospSetObject(tf, "color", color_data);
 
-    // XXX should create this list from scene_objects?
-    ospray_scene_instances.push_back(instance);
-    update_ospray_scene_instances = true;
+        // XXX color and opacity can be decoupled?
+        OSPData opacity_data = ospNewCopiedData(definition.opacities.size(), OSP_FLOAT, definition.opacities.data());
+        ospSetObject(tf, "opacity", opacity_data);   
 
-    return true;
+    ospCommit(tf);
+    ospRelease(color_data);
+    ospRelease(opacity_data);
 }
 
+// Returns the (committed) transfer function for the definition, creating 
+// it if no identical one exists
+SharedTransferFunction
+get_transfer_function(const TransferFunctionDefinition& definition)
+{
+    const std::string key = definition.key();
 
-bool
-update_geometry_object(const UpdateObject& update)
-{   
-    const std::string& object_name = update.name();
-    const std::string& linked_data = update.data_link(); 
+    SharedTransferFunction tf = transfer_functions.find(key);
 
-    printf("OBJECT '%s' (geometry)\n", object_name.c_str());    
-    printf("--> '%s'\n", linked_data.c_str());
+    if (tf != nullptr)
+        return tf;
 
-    SceneObject     *scene_object;
-    SceneObjectGeometry *geometry_object;
-    OSPInstance     instance;
-    OSPGroup        group;
-    OSPGeometricModel gmodel;
+    printf("... Creating transfer function (%d entries, range %.6f, %.6f)\n", 
+        (int)definition.opacities.size(), definition.value_range[0], definition.value_range[1]);
 
-    scene_object = find_scene_object(object_name, SOT_GEOMETRY);
+    OSPTransferFunction t = ospNewTransferFunction("piecewiseLinear");
+    set_transfer_function(t, definition);
 
-    if (scene_object == nullptr)
-        geometry_object = new SceneObjectGeometry;
-    else
-        geometry_object = dynamic_cast<SceneObjectGeometry*>(scene_object);
+    return transfer_functions.add(key, t);
+}
 
-    instance = geometry_object->instance;
-    assert(instance != nullptr);
-    group = geometry_object->group;
-    assert(group != nullptr);        
+// Makes tf (as used by a single model) refer to the transfer function
+// for the definition. When tf isn't shared with other models it is 
+// changed in place, instead of creating a new one. Returns true if tf 
+// now refers to a different OSPRay object, which needs to be set on 
+// the model.
+bool
+use_transfer_function(SharedTransferFunction& tf, const TransferFunctionDefinition& definition)
+{
+    const std::string key = definition.key();
 
-    // Check linked data    
-    
-    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+    if (tf != nullptr && tf->key == key)
     {
-        if (scene_object == nullptr)
-            delete geometry_object;
+        printf("... Transfer function unchanged\n");
         return false;
     }
 
-    PluginInstance* plugin_instance = plugin_instances[linked_data];
-    assert(plugin_instance->type == PT_GEOMETRY);
-    PluginState *state = plugin_instance->state;
-
-    OSPGeometry geometry = state->geometry;
-
-    if (geometry == NULL)
+    if (transfer_functions.find(key) == nullptr && transfer_functions.rekey(tf, key))
     {
-        printf("... ERROR: geometry is NULL!\n");
-        if (scene_object == nullptr)
-            delete geometry_object;
+        printf("... Updating transfer function in place\n");
+        set_transfer_function(tf->object, definition);
         return false;
-    }    
-
-    if (scene_object == nullptr)
-    {
-        gmodel = geometry_object->gmodel = ospNewGeometricModel(geometry); 
-
-        ospSetObjectAsData(group, "geometry", OSP_GEOMETRIC_MODEL, gmodel);
-        ospCommit(group);
     }
-    else
-        gmodel = geometry_object->gmodel;
 
-    glm::mat4   obj2world;
-    float       affine_xform[12];
+    tf = get_transfer_function(definition);
 
-    object2world_from_protobuf(obj2world, update);
-    affine3fv_from_mat4(affine_xform, obj2world);
+    return true;
+}
 
-    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);    
-    ospCommit(instance);
+// Volumetric model of a volume with the given TF, for use in
+// isosurfaces and slices (i.e. not one rendered as a volume)
+SharedVolumetricModel
+get_volumetric_model(OSPVolume volume, const SharedTransferFunction& tf)
+{
+    char key[64];
+    snprintf(key, sizeof(key), "%p:", (void*)volume);
 
-    const std::string& matname = update.material_link();
+    const std::string vkey = key + tf->key;
 
-    SceneMaterialMap::iterator it = scene_materials.find(matname);
-    if (it != scene_materials.end())
-    {
-        printf("... Material '%s'\n", matname.c_str()); 
-        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, it->second->material);
-    }
-    else
-    {
-        printf("... WARNING: Material '%s' not found, using default!\n", matname.c_str());
-        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, default_materials[current_renderer_type]);
-    }
-    
-    ospCommit(gmodel);
+    SharedVolumetricModel vmodel = volumetric_models.find(vkey);
 
-    if (scene_object == nullptr)
-        scene_objects[object_name] = geometry_object;
+    if (vmodel != nullptr)
+        return vmodel;
 
-    ospray_scene_instances.push_back(instance);
-    update_ospray_scene_instances = true;
+    OSPVolumetricModel m = ospNewVolumetricModel(volume);
+        ospSetObject(m, "transferFunction", tf->object);
+    ospCommit(m);
 
-    return true;
+    return volumetric_models.add(vkey, m);
 }
 
-bool
-update_scene_object(const UpdateObject& update)
-{    
-    const std::string& object_name = update.name();
-    const std::string& linked_data = update.data_link();
+std::string
+shared_plugin_state_key(PluginType type, const std::string& plugin_name, 
+    const std::string& plugin_parameters, bool uses_renderer_type)
+{
+    std::string key = std::string(PluginType_names[type]) + ":" + plugin_name + ":" + get_sha1(plugin_parameters);
 
-    printf("OBJECT '%s' (scene)\n", update.name().c_str());    
-    printf("--> '%s'\n", linked_data.c_str());
+    if (uses_renderer_type)
+        key += ":" + current_renderer_type;
 
-    SceneObject     *scene_object;
-    SceneObjectScene *scene_object_scene;       // XXX yuck
+    return key;
+}
 
-    scene_object = find_scene_object(object_name, SOT_SCENE);
+// XXX find a better place to replace envvars
+// Could do this on the raw (unparsed) json string?
+json
+replace_parameter_environment_variables(const json& plugin_parameters)
+{
+    json plugin_parameters2;
 
-    if (scene_object != nullptr)
-    {
-        scene_object_scene = dynamic_cast<SceneObjectScene*>(scene_object);
-        for (OSPInstance &i : scene_object_scene->instances)
-            ospRelease(i);
-        scene_object_scene->instances.clear();
-        scene_object_scene->lights.clear();
-    }
-    else
+    for (json::const_iterator it = plugin_parameters.begin(); it != plugin_parameters.end(); ++it)
     {
-        scene_object_scene = new SceneObjectScene;
-        scene_object_scene->data_link = linked_data;
+        const json& value = it.value();
+        
+        if (value.is_string())
+            plugin_parameters2[it.key()] = replace_environment_variables(value.get<std::string>());
+        else
+            plugin_parameters2[it.key()] = value;
     }
 
-    // Check linked data    
-    
-    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
-    {   
-        if (scene_object == nullptr)
-            delete scene_object_scene;
+    return plugin_parameters2;
+}
+
+void
+set_plugin_cache_path(PluginState *state, PluginType plugin_type, const std::string& plugin_name)
+{
+    if (plugin_cache_directory == "")
+        return;
+
+    // Based on the parameters after envvar substitution, as the 
+    // environment might differ between server runs
+    state->cache_path = plugin_cache_directory + "/" + get_plugin_internal_name(plugin_type, plugin_name) 
+        + "-" + get_sha1(state->parameters.dump());
+    if (state->uses_renderer_type)
+        state->cache_path += "-" + current_renderer_type;
+    if (state->num_domains > 1)
+        state->cache_path += "-domain" + std::to_string(state->domain_index) + "of" + std::to_string(state->num_domains);
+}
+
+// Try to update an existing plugin instance for changed parameters in 
+// place, using the plugin's update_instance_function. Returns false if 
+// the instance needs to be re-created instead.
+bool
+update_plugin_instance(PluginInstance *plugin_instance, const std::string& s_plugin_parameters, 
+    const json& plugin_parameters)
+{
+    PluginDefinitionsMap::iterator it = plugin_definitions.find(plugin_instance->plugin_internal_name);
+
+    if (it == plugin_definitions.end() || it->second.functions.update_instance_function == NULL)
         return false;
-    }
 
-    PluginInstance* plugin_instance = plugin_instances[linked_data];
-    assert(plugin_instance->type == PT_SCENE);
+    const PluginDefinition& plugin_definition = it->second;
     PluginState *state = plugin_instance->state;
 
-    GroupInstances group_instances = state->group_instances;
-
-    if (group_instances.size() == 0)
-        printf("... WARNING: no instances to add!\n");
-    else
-        printf("... Adding %d instances to scene\n", group_instances.size());
+    if (!finish_plugin_creation(plugin_instance))
+        return false;
 
-    glm::mat4   obj2world;
-    float       affine_xform[12];
+    if (state->uses_renderer_type && state->renderer != current_renderer_type)
+        return false;
 
-    object2world_from_protobuf(obj2world, update);
+    // Other instances (in other sessions) still need the state as it is
+    std::map<std::string, SharedPluginState>::iterator shared = shared_plugin_states.find(plugin_instance->shared_state_key);
+    assert(shared != shared_plugin_states.end());
 
-    for (GroupInstance& gi : group_instances)
+    if (shared->second.users > 1)
     {
-        OSPGroup group = gi.first;
-        const glm::mat4 instance_xform = gi.second;
-
-        affine3fv_from_mat4(affine_xform, obj2world * instance_xform);
-
-        OSPInstance instance = ospNewInstance(group);
-            ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
-        ospCommit(instance);
-
-        scene_object_scene->instances.push_back(instance);
-
-        ospray_scene_instances.push_back(instance);
-        update_ospray_scene_instances = true;
+        printf("... Plugin state shared with other instances, can't update it in place\n");
+        return false;
     }
 
-    // Lights
-    const Lights& lights = state->lights;
-    if (lights.size() > 0)
-    {
-        printf("... Adding %d lights to scene!\n", lights.size());
-        for (OSPLight light : state->lights)
-        {
-            // XXX Sigh, need to apply object2world transform manually
-            // This should be coming in 2.0
-            scene_object_scene->lights.push_back(light);
-
-            ospray_scene_lights.push_back(light);
-            update_ospray_scene_lights = true;
-        }
-    }
+    // If there already is a state for the new parameters use that one
+    const std::string& shared_state_key = shared_plugin_state_key(plugin_instance->type, plugin_instance->plugin_name, 
+        s_plugin_parameters, plugin_definition.uses_renderer_type);
 
-    if (scene_object == nullptr)
-        scene_objects[object_name] = scene_object_scene;
+    if (shared_plugin_states.find(shared_state_key) != shared_plugin_states.end())
+        return false;
 
-    return true;
-}
+    GenerateFunctionResult check_result;
 
-// XXX has a bug when switching renderer types
-bool
-update_volume_object(const UpdateObject& update, const Volume& volume_settings)
-{
-    const std::string& object_name = update.name();
-    const std::string& linked_data = update.data_link(); 
+    if (!check_plugin_parameters(check_result, plugin_definition.parameters, plugin_parameters))
+        return false;
 
-    printf("OBJECT '%s' (volume)\n", update.name().c_str()); 
-    printf("--> '%s'\n", linked_data.c_str());  
+    const json& new_parameters = replace_parameter_environment_variables(plugin_parameters);
 
-    SceneObject         *scene_object;
-    SceneObjectVolume   *volume_object;
-    OSPInstance         instance;
-    OSPGroup            group;
-    OSPVolumetricModel  vmodel;
+    PluginResult plugin_result;
+    struct timeval t0, t1;
 
-    scene_object = find_scene_object(object_name, SOT_VOLUME);
+    printf("... Calling update_instance function\n");
+    gettimeofday(&t0, NULL);
 
-    if (scene_object != nullptr)
-        volume_object = dynamic_cast<SceneObjectVolume*>(scene_object);
-    else
-        volume_object = new SceneObjectVolume;
+    bool updated = plugin_definition.functions.update_instance_function(plugin_result, state, state->parameters, new_parameters);
 
-    instance = volume_object->instance;
-    assert(instance != nullptr);
-    group = volume_object->group;
-    assert(group != nullptr); 
-    vmodel = volume_object->vmodel;
+    gettimeofday(&t1, NULL);
 
-    // Check linked data
-    
-    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+    if (!updated)
     {
-        if (scene_object == nullptr)
-            delete volume_object;   
+        printf("... Plugin can't update instance in place\n");
         return false;
     }
 
-    PluginInstance* plugin_instance = plugin_instances[linked_data];
-    assert(plugin_instance->type == PT_VOLUME);
-    PluginState *state = plugin_instance->state;
-
-    OSPVolume volume = state->volume;
-
-    if (volume == NULL)
+    if (!plugin_result.success)
     {
-        printf("... ERROR: volume is NULL!\n");
-        delete volume_object;
+        printf("... ERROR: update_instance failed:\n");
+        printf("... %s\n", plugin_result.message.c_str());
         return false;
-    }    
-
-    if (scene_object == nullptr)
-    {
-        assert(scene_objects.find(object_name) == scene_objects.end());
-        scene_objects[object_name] = volume_object;
-        vmodel = volume_object->vmodel = ospNewVolumetricModel(volume);
     }
-    
-    // These are pathtracer only
-    ospSetFloat(vmodel, "densityScale", volume_settings.density_scale());
-    ospSetFloat(vmodel, "anisotropy", volume_settings.anisotropy());
 
-    OSPTransferFunction tf;
-    
-    // XXX the TF is based on the actual volume data range here, but there
-    // are situations in which a user would want to specify the actual range
-    // (e.g. rendering a dataset sequence where the per-step data range varies,
-    // while the TF should keep the same range for consistent color and opacity)
+    if (!check_created_plugin_state(plugin_instance->type, state))
+        return false;
 
-    if (volume_settings.tf_positions_size() > 0 && volume_settings.tf_colors_size() > 0)
-    {
-        printf("... Creating user-defined transfer function\n");
-        tf = create_user_transfer_function(state->volume_data_range[0], state->volume_data_range[1], volume_settings);
-    }
-    else
-    {
-        // Default TF        
-        printf("... Creating default cool2warm transfer function\n");
-        tf = create_transfer_function("cool2warm", state->volume_data_range[0], state->volume_data_range[1]);
-    }
+    printf("... Updated instance in %.3fs\n", time_diff(t0, t1));
 
-    ospSetObject(vmodel, "transferFunction", tf);
-    ospRelease(tf);
+    state->parameters = new_parameters;
+    set_plugin_cache_path(state, plugin_instance->type, plugin_instance->plugin_name);
 
-    ospCommit(vmodel);
+    // Re-key the shared state on the new parameters
+    SharedPluginState shared_state = shared->second;
+    shared_plugin_states.erase(shared);
+    shared_plugin_states[shared_state_key] = shared_state;
 
-    ospSetObjectAsData(group, "volume", OSP_VOLUMETRIC_MODEL, vmodel);
-    ospCommit(group);
+    // The bound might have changed
+    shared_plugin_states[shared_state_key].bound_levels = nullptr;
+    start_bound_generation(shared_plugin_states[shared_state_key]);
 
-    glm::mat4   obj2world;
-    float       affine_xform[12];
+    plugin_instance->shared_state_key = shared_state_key;
+    plugin_instance->parameters_hash = get_sha1(s_plugin_parameters);
 
-    object2world_from_protobuf(obj2world, update);
-    affine3fv_from_mat4(affine_xform, obj2world);
+    // The plugin modified its OSPRay objects in place
+    ospray_world_changed = true;
 
-    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
-    ospCommit(instance);
+    return true;
+}
 
-    if (scene_object == nullptr)
-        scene_objects[object_name] = volume_object;
+// Source of the messages of a single scene update in an UPDATE_SCENE_BATCH.
+// The handlers below are templated on the connection type, so they receive
+// from (and send to) either the client socket or a batched update
+struct SceneUpdateMessages
+{
+    SceneUpdateMessages(const SceneUpdate *update)
+        : update(update), next(0), has_result(false)
+    {}
 
-    ospray_scene_instances.push_back(instance);
-    update_ospray_scene_instances = true;
+    const SceneUpdate       *update;
+    int                     next;               // Index of next message to receive
 
-    return true;
-}
+    GenerateFunctionResult  result;             // Last result sent, if any
+    bool                    has_result;
+};
 
+template<typename T>
 bool
-update_isosurfaces_object(const UpdateObject& update)
+receive_protobuf(SceneUpdateMessages *messages, T& protobuf)
 {
-    const std::string& object_name = update.name();
-    const std::string& linked_data = update.data_link();    
+    if (messages->next >= messages->update->messages_size())
+    {
+        fprintf(stderr, "... ERROR: scene update is missing message %d\n", messages->next);
+        return false;
+    }
 
-    printf("OBJECT '%s' (isosurfaces)\n", update.name().c_str()); 
-    printf("--> '%s'\n", linked_data.c_str());     
+    const std::string& data = messages->update->messages(messages->next++);
 
-    SceneObject         *scene_object;
-    SceneObjectIsosurfaces   *isosurfaces_object;
-    OSPInstance         instance;
-    OSPGroup            group;
-    OSPGeometry         isosurfaces_geometry;
-    OSPVolumetricModel  vmodel;
-    OSPGeometricModel   gmodel;
+    return protobuf.ParseFromArray(data.data(), data.size());
+}
 
-    scene_object = find_scene_object(object_name, SOT_ISOSURFACES);
+bool
+send_protobuf(SceneUpdateMessages *messages, GenerateFunctionResult& result)
+{
+    messages->result = result;
+    messages->has_result = true;
+    return true;
+}
 
-    if (scene_object != nullptr)
-        isosurfaces_object = dynamic_cast<SceneObjectIsosurfaces*>(scene_object);
-    else
-        isosurfaces_object = new SceneObjectIsosurfaces;
+template<typename Connection>
+bool
+handle_update_plugin_instance(Connection *sock)
+{
+    UpdatePluginInstance    update;
 
-    instance = isosurfaces_object->instance;
-    assert(instance != nullptr);
-    group = isosurfaces_object->group;
-    assert(group != nullptr); 
-    vmodel = isosurfaces_object->vmodel;
-    gmodel = isosurfaces_object->gmodel;
-    assert(gmodel != nullptr);
-    isosurfaces_geometry = isosurfaces_object->isosurfaces_geometry;
-    assert(isosurfaces_geometry != nullptr);
+    if (!receive_protobuf(sock, update))
+        return false;
 
-    // Check linked data
+    //print_protobuf(update);
 
-    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
-    {
-        if (scene_object != nullptr)
-            delete isosurfaces_object;
-        return false;
-    }
+    const std::string& data_name = update.name();
 
-    PluginInstance* plugin_instance = plugin_instances[linked_data];
-    assert(plugin_instance->type == PT_VOLUME);
-    PluginState *state = plugin_instance->state;
+    printf("PLUGIN INSTANCE '%s'\n", data_name.c_str());
 
-    OSPVolume volume = state->volume;
+    bool create_new_instance;
+    PluginInstance *plugin_instance;
+    PluginState *state;    
+    PluginType plugin_type;
 
-    if (volume == NULL)
+    switch (update.type())
     {
-        printf("... ERROR: volume is NULL!\n");
-        if (scene_object != nullptr)
-            delete isosurfaces_object;
+    case UpdatePluginInstance::GEOMETRY:
+        plugin_type = PT_GEOMETRY;
+        break;
+    case UpdatePluginInstance::VOLUME:
+        plugin_type = PT_VOLUME;
+        break;
+    case UpdatePluginInstance::SCENE:
+        plugin_type = PT_SCENE;
+        break;
+    default:
+        printf("... WARNING: unknown plugin instance type %d!\n", update.type());
         return false;
-    }        
-
-    if (scene_object == nullptr)
-    {
-        assert(scene_objects.find(object_name) == scene_objects.end());
-        scene_objects[object_name] = isosurfaces_object;
+    }
 
-        // XXX hacked temp volume module, as we need the volume to create it
-        vmodel = isosurfaces_object->vmodel = ospNewVolumetricModel(volume);
-            OSPTransferFunction tf = create_transfer_function("cool2warm", state->volume_data_range[0], state->volume_data_range[1]);
-            ospSetObject(vmodel, "transferFunction", tf);
-            ospRelease(tf);
-         ospCommit(vmodel);
+    const char *plugin_type_name = PluginType_names[plugin_type];
+    const std::string &plugin_name = update.plugin_name();
 
-        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, default_materials[current_renderer_type]);        
-    }
+    printf("... plugin type: %s\n", plugin_type_name);
+    printf("... plugin name: '%s'\n", plugin_name.c_str());
 
+    const char *s_plugin_parameters = update.plugin_parameters().c_str();
+    //printf("Received plugin parameters:\n%s\n", s_plugin_parameters);
+    const json &plugin_parameters = json::parse(s_plugin_parameters);
+    printf("... parameters:\n");
+    printf("%s\n", plugin_parameters.dump(4).c_str());
+    
+#if 0
     const char *s_custom_properties = update.custom_properties().c_str();
     //printf("Received custom properties:\n%s\n", s_custom_properties);
     const json &custom_properties = json::parse(s_custom_properties);
@@ -1672,1324 +1931,4244 @@ update_isosurfaces_object(const UpdateObject& update)
         printf("... custom properties:\n");
         printf("%s\n", custom_properties.dump(4).c_str());
     }
-    
-    if (custom_properties.find("isovalues") == custom_properties.end())
-    {
-        printf("... WARNING: no property 'isovalues' set on object!\n");
-        return false;
-    }
-
-    const json& isovalues_prop = custom_properties["isovalues"];
-    int n = isovalues_prop.size();
-
-    float *isovalues = new float[n];
-    for (int i = 0; i < n; i++)
-    {        
-        isovalues[i] = isovalues_prop[i];
-        printf("... isovalue #%d: %.3f\n", i, isovalues[i]);
-    }
-
-    OSPData isovalues_data = ospNewCopiedData(n, OSP_FLOAT, isovalues);  
-    ospCommit(isovalues_data);
-    delete [] isovalues;
+#endif
 
-    ospSetObject(isosurfaces_geometry, "volume", vmodel);
-    //ospRelease(volume);
+    // Check against the current instances
 
-    ospSetObject(isosurfaces_geometry, "isovalue", isovalues_data);
-    ospRelease(isovalues_data);
+    create_new_instance = true;
 
-    ospCommit(isosurfaces_geometry);
+    if (scene_data_with_type_exists(data_name, SDT_PLUGIN))
+    {
+        // Have existing plugin instance with this name, check what it is
+        plugin_instance = plugin_instances[data_name];
+        assert(plugin_state.find(data_name) != plugin_state.end());
+        state = plugin_state[data_name];
+
+        // XXX could use internal name?
+        if (plugin_instance->type != plugin_type || plugin_instance->plugin_name != plugin_name)
+        {
+            printf("... Existing plugin (type %s, name '%s') does't match, overwriting!\n", 
+                PluginType_names[plugin_instance->type], plugin_name.c_str());
+            delete_plugin_instance(data_name);            
+        }
+        else
+        {
+            // Plugin still of the same type and name, check if parameters and properties still up to date
+            const std::string& parameters_hash = get_sha1(update.plugin_parameters());
+#if 0
+            const std::string& custom_props_hash = get_sha1(update.custom_properties());
+#endif
+
+            if (parameters_hash != plugin_instance->parameters_hash)
+            {
+                if (update_plugin_instance(plugin_instance, update.plugin_parameters(), plugin_parameters))
+                {
+                    printf("... Parameters changed, plugin instance updated in place\n");
+                    create_new_instance = false;
+                }
+                else
+                {
+                    printf("... Parameters changed, re-creating plugin instance\n");
+                    delete_plugin_instance(data_name);                
+                }
+            }
+#if 0
+            else if (custom_props_hash != plugin_instance->custom_properties_hash)
+            {
+                printf("... Custom properties changed, re-running plugin\n");
+                delete_plugin_instance(data_name);                
+            }
+#endif
+            else if (plugin_instance->state->uses_renderer_type && plugin_instance->state->renderer != current_renderer_type)
+            {
+                printf("... Plugin depends on renderer type, which changed from '%s', re-running plugin\n", 
+                    plugin_instance->state->renderer.c_str());
+                delete_plugin_instance(data_name);                
+            }
+            else
+                create_new_instance = false;
+        }
+    }
+
+    // Prepare result
+    // By default all is well, we let the plugin signal something went wrong 
+    GenerateFunctionResult result;    
+    result.set_success(true);    
+
+    if (!create_new_instance)
+    {
+        printf("... Cached plugin instance still up-to-date\n");
+        // XXX we misuse GenerateFunctionResult here, as nothing was generated...
+        send_protobuf(sock, result);
+        return true;
+    }
+
+    // At this point we're creating a new plugin instance, check the plugin itself first
+
+    PluginDefinition plugin_definition;
+
+    if (!ensure_plugin_is_loaded(result, plugin_definition, plugin_type, plugin_name))
+    {
+        // Something went wrong...
+        send_protobuf(sock, result);
+        return false;
+    }    
+
+    create_instance_function_t create_instance_function = plugin_definition.functions.create_instance_function;
+
+    if (create_instance_function == NULL)
+    {
+        printf("... ERROR: plugin create_instance_function is NULL!\n");
+        result.set_message("Plugin create_instance_function is NULL!");
+        send_protobuf(sock, result);
+        return false;
+    }
+
+    // Check parameters passed to generate function
+
+    if (!check_plugin_parameters(result, plugin_definition.parameters, plugin_parameters))
+    {
+        // Something went wrong...
+        send_protobuf(sock, result);
+        return false;
+    }    
+    
+    // Check if another session already created the same instance
+
+    const std::string& shared_state_key = shared_plugin_state_key(plugin_type, plugin_name, 
+        update.plugin_parameters(), plugin_definition.uses_renderer_type);
+
+    std::map<std::string, SharedPluginState>::iterator shared = shared_plugin_states.find(shared_state_key);
+
+    if (shared != shared_plugin_states.end() && shared->second.failed)
+    {
+        // Creating the state failed for the other instance(s), which
+        // get deleted when they're used
+        printf("... ERROR: creating the same plugin instance failed before\n");
+        result.set_success(false);
+        result.set_message("Creating plugin instance with these parameters failed before");
+        send_protobuf(sock, result);
+        return false;
+    }
+
+    if (shared != shared_plugin_states.end())
+    {
+        printf("... Sharing plugin state with %d existing instance(s)\n", shared->second.users);
+        
+        state = shared->second.state;
+        shared->second.users++;
+
+        plugin_instance = new PluginInstance;
+        plugin_instance->type = plugin_type;
+        plugin_instance->plugin_name = plugin_name;
+        plugin_instance->plugin_internal_name = get_plugin_internal_name(plugin_type, plugin_name);
+        plugin_instance->state = state; 
+        plugin_instance->name = data_name;    
+        plugin_instance->parameters_hash = get_sha1(s_plugin_parameters);
+        plugin_instance->shared_state_key = shared_state_key;
+
+        plugin_instances[data_name] = plugin_instance;
+        plugin_state[data_name] = state;
+        scene_data_types[data_name] = SDT_PLUGIN;
+
+        send_protobuf(sock, result);
+
+        return true;
+    }
+
+    // Create plugin instance and state    
+
+    state = new PluginState; 
+    state->renderer = current_renderer_type;   
+    state->uses_renderer_type = plugin_definition.uses_renderer_type;
+    state->parameters = replace_parameter_environment_variables(plugin_parameters);
+    state->domain_index = mpi_rank;
+    state->num_domains = mpi_size;
+
+    set_plugin_cache_path(state, plugin_type, plugin_name);
+
+    if (plugin_definition.thread_safe && plugin_creation_threads > 0)
+    {
+        // Create the instance in the background and let the client 
+        // carry on. Create errors are reported when the instance gets used.
+        printf("... Creating instance in the background\n");
+
+        PluginCreationJobPtr job = std::make_shared<PluginCreationJob>();
+        job->function = create_instance_function;
+        job->state = state;
+        job->done = false;
+
+        plugin_instance = new PluginInstance;
+        plugin_instance->type = plugin_type;
+        plugin_instance->plugin_name = plugin_name;
+        plugin_instance->plugin_internal_name = get_plugin_internal_name(plugin_type, plugin_name);
+        plugin_instance->state = state; 
+        plugin_instance->name = data_name;    
+        plugin_instance->parameters_hash = get_sha1(s_plugin_parameters);
+        plugin_instance->shared_state_key = shared_state_key;
+
+        SharedPluginState& shared_state = shared_plugin_states[shared_state_key];
+        shared_state.state = state;
+        shared_state.users = 1;
+        shared_state.pending = job;
+
+        plugin_instances[data_name] = plugin_instance;
+        plugin_state[data_name] = state;
+        scene_data_types[data_name] = SDT_PLUGIN;
+
+        plugin_creation_queue.push(job);
+
+        send_protobuf(sock, result);
+
+        return true;
+    }
+
+    PluginResult plugin_result;
+
+    // Call generate function
+
+    printf("... Calling create_instance function\n");
+
+    const float mem0 = memory_usage();
+    ScopedTimer timer(timings, "plugin create_instance");
+
+    create_instance_function(plugin_result, state);
+
+    const float creation_time = timer.stop();
+    const float creation_memory = memory_usage() - mem0;
+
+    printf("... Created instance in %.3fs\n", creation_time);
+    
+    if (!plugin_result.success)
+    {
+        result.set_success(false);
+        result.set_message(plugin_result.message);
+        
+        printf("... ERROR: create_instance failed:\n");
+        printf("... %s\n", result.message().c_str());
+        send_protobuf(sock, result);
+        delete state;
+        return false;
+    }
+
+    // Handle any other business for this type of plugin
+
+    if (!check_created_plugin_state(plugin_type, state))
+    {
+        result.set_success(false);
+        result.set_message(std::string("Invalid plugin state after create_instance (") + PluginType_names[plugin_type] + ")");
+        send_protobuf(sock, result);
+        delete state;
+        return false;
+    }
+
+    // Load function succeeded
+
+    plugin_instance = new PluginInstance;
+    plugin_instance->type = plugin_type;
+    plugin_instance->plugin_name = plugin_name;
+    plugin_instance->plugin_internal_name = get_plugin_internal_name(plugin_type, plugin_name);
+    plugin_instance->state = state; 
+    plugin_instance->name = data_name;    
+    plugin_instance->parameters_hash = get_sha1(s_plugin_parameters);
+#if 0
+    plugin_instance->custom_properties_hash = get_sha1(s_custom_properties);    
+#endif
+    plugin_instance->shared_state_key = shared_state_key;
+
+    SharedPluginState& shared_state = shared_plugin_states[shared_state_key];
+    shared_state.state = state;
+    shared_state.users = 1;
+    shared_state.creation_time = creation_time;
+    shared_state.memory_usage = creation_memory;
+
+    start_bound_generation(shared_state);
+    
+    plugin_instances[data_name] = plugin_instance;
+    plugin_state[data_name] = state;
+    scene_data_types[data_name] = SDT_PLUGIN;
+
+    send_protobuf(sock, result);
+
+    return true;
+}
+
+// Receives bulk data following a client message into buf, which only 
+// this session uses, with server_mutex released, so a large transfer
+// (or a slow client) doesn't hold up the other sessions. Returns -1 on 
+// socket errors, as recvall().
+ssize_t
+recvall_unlocked(TCPSocket *sock, void *buf, size_t len)
+{
+    server_mutex.unlock();
+    const ssize_t res = sock->recvall(buf, len);
+    server_mutex.lock();
+
+    return res;
+}
+
+// Receive one array of a Blender mesh into buf, which must not be shared
+// with a geometry (as the receive can fail halfway)
+template<typename T>
+bool
+receive_mesh_array(TCPSocket *sock, std::vector<T>& buf, size_t n)
+{
+    buf.resize(n);
+    return recvall_unlocked(sock, &buf[0], n*sizeof(T)) != -1;
+}
+
+// Sets buf as (shared) array parameter on the geometry
+template<typename T>
+void
+set_mesh_array(OSPGeometry geometry, const char *param, std::vector<T>& buf, OSPDataType type, size_t n)
+{
+    OSPData data = ospNewSharedData(&buf[0], type, n);
+    ospSetObject(geometry, param, data);
+    ospRelease(data);
+}
+
+// Make the objects using the given Blender mesh pick up its 
+// (changed) geometry
+void
+update_blender_mesh_objects(const std::string& name, OSPGeometry geometry)
+{
+    for (auto& kv : scene_objects)
+    {
+        SceneObject *scene_object = kv.second;
+
+        if (scene_object->type != SOT_MESH || scene_object->data_link != name)
+            continue;
+
+        SceneObjectMesh *mesh_object = dynamic_cast<SceneObjectMesh*>(scene_object);
+        ospSetObject(mesh_object->gmodel, "geometry", geometry);
+        mesh_object->geometry = geometry;
+        ospCommit(mesh_object->gmodel);
+        ospCommit(mesh_object->group);
+        ospCommit(mesh_object->instance);
+
+        ospray_world_changed = true;
+    }
+}
+
+bool
+handle_update_blender_mesh_data(TCPSocket *sock, const std::string& name)
+{
+    printf("DATA '%s' (blender mesh)\n", name.c_str());
+
+    BlenderMesh *blender_mesh;
+    OSPGeometry geometry;
+    bool create_new_mesh = false;
+
+    SceneDataTypeMap::iterator it = scene_data_types.find(name);
+    if (it == scene_data_types.end())
+    {
+        // No previous mesh with this name
+        printf("... Unseen name, creating new mesh\n");
+        create_new_mesh = true;
+    }
+    else
+    {
+        // Have existing scene data with this name, check what it is
+        SceneDataType type = it->second;
+
+        if (type != SDT_BLENDER_MESH)
+        {
+            printf("... WARNING: data is currently of type %s, overwriting with new mesh!\n", SceneDataType_names[type]);
+            delete_scene_data(name);
+            create_new_mesh = true;
+        }
+        else
+        {
+            printf("... Updating existing mesh\n");            
+            blender_mesh = blender_meshes[name];
+            geometry = blender_mesh->geometry;
+        }
+    }
+
+    MeshData    mesh_data;
+    uint32_t    nv, nt, flags;    
+
+    if (!receive_protobuf(sock, mesh_data))
+        return false;
+
+    // If the client provided a content hash, check if we already have the
+    // mesh. If so, tell the client so it doesn't send the actual data.
+
+    const std::string& content_hash = mesh_data.content_hash();
+
+    if (content_hash != "")
+    {
+        MeshCacheResult result;
+
+        if (!create_new_mesh && blender_mesh->content_hash == content_hash)
+        {
+            printf("... Mesh content unchanged (%s)\n", content_hash.c_str());
+            result.set_cached(true);
+            send_protobuf(sock, result);
+            return true;
+        }
+
+        BlenderMesh *cached_mesh = blender_mesh_cache_take(content_hash);
+
+        result.set_cached(cached_mesh != nullptr);
+        send_protobuf(sock, result);
+
+        if (cached_mesh != nullptr)
+        {
+            printf("... Reusing cached mesh '%s' (%s)\n", cached_mesh->name.c_str(), content_hash.c_str());
+
+            cached_mesh->name = name;
+            blender_meshes[name] = cached_mesh;
+            scene_data_types[name] = SDT_BLENDER_MESH;
+
+            // Objects first, so the replaced mesh has no users left when cached
+            if (!create_new_mesh)
+            {
+                update_blender_mesh_objects(name, cached_mesh->geometry);
+                blender_mesh_cache_add(blender_mesh);
+            }
+
+            return true;
+        }
+    }
+
+    if (create_new_mesh)
+    {
+        blender_mesh = blender_meshes[name] = new BlenderMesh;
+        blender_mesh->name = name;
+        geometry = blender_mesh->geometry = ospNewGeometry("mesh");
+        blender_mesh->num_vertices = blender_mesh->num_triangles = 0;
+        scene_data_types[name] = SDT_BLENDER_MESH;
+    }
+
+    // Set below, once all data is received
+    blender_mesh->content_hash = "";
+
+    nv = mesh_data.num_vertices();
+    nt = mesh_data.num_triangles();
+    flags = mesh_data.flags();
+
+    printf("... %d vertices, %d triangles, flags 0x%08x\n", nv, nt, flags);
+
+    // On errors below a new mesh is deleted again. An existing mesh keeps
+    // its previous (complete) data, as nothing is changed before all of
+    // the new data has arrived.
+    auto fail = [&]() {
+        if (create_new_mesh)
+            delete_blender_mesh(name);
+        return false;
+    };
+
+    if (nv == 0 || nt == 0)
+    {
+        printf("... WARNING: mesh without vertices/triangles not allowed, ignoring!\n");
+        return fail();
+    }
+
+    // With unchanged topology the client only sends the vertex attributes 
+    // that changed, the others are kept as is. This requires the mesh to
+    // already exist with the same number of vertices and triangles (and
+    // the attributes marked unchanged to be present).
+
+    const bool topology_unchanged = flags & MeshData::TOPOLOGY_UNCHANGED;  
+
+    bool positions_unchanged = false, normals_unchanged = false, colors_unchanged = false;
+
+    if (topology_unchanged)
+    {
+        positions_unchanged = flags & MeshData::POSITIONS_UNCHANGED;
+        normals_unchanged = (flags & MeshData::NORMALS) && (flags & MeshData::NORMALS_UNCHANGED);
+        colors_unchanged = (flags & MeshData::VERTEX_COLORS) && (flags & MeshData::VERTEX_COLORS_UNCHANGED);
+
+        if (create_new_mesh 
+            || nv != blender_mesh->num_vertices || nt != blender_mesh->num_triangles
+            || (normals_unchanged && blender_mesh->normals.size() != nv*3)
+            || (colors_unchanged && blender_mesh->vertex_colors.size() != nv*4))
+        {
+            printf("... ERROR: topology-unchanged update does not match existing mesh!\n");
+
+            // Read (and discard) the attributes that were sent, to stay in sync
+            // with the client
+            size_t num_floats = 0;
+            if (!positions_unchanged)
+                num_floats += nv*3;
+            if ((flags & MeshData::NORMALS) && !normals_unchanged)
+                num_floats += nv*3;
+            if ((flags & MeshData::VERTEX_COLORS) && !colors_unchanged)
+                num_floats += nv*4;
+
+            std::vector<float> discard(num_floats);
+            if (num_floats > 0)
+                recvall_unlocked(sock, &discard[0], num_floats*sizeof(float));
+
+            return fail();
+        }
+
+        printf("... Topology unchanged, updating vertex attributes in place\n");
+    }
+
+    // Receive into separate buffers first, as the geometry might be
+    // sharing the mesh's current buffers (and keeps doing so when the
+    // connection drops halfway, with the session living on)
+
+    const bool has_normals = flags & MeshData::NORMALS;
+    const bool has_colors = flags & MeshData::VERTEX_COLORS;
+
+    std::vector<float>      vertices, normals, vertex_colors;
+    std::vector<uint32_t>   triangles;
+
+    if (has_normals)
+        printf("... Mesh has normals%s\n", normals_unchanged ? " (unchanged)" : "");
+    if (has_colors)
+        printf("... Mesh has vertex colors%s\n", colors_unchanged ? " (unchanged)" : "");
+
+    if ((!positions_unchanged && !receive_mesh_array(sock, vertices, nv*3))
+        || (has_normals && !normals_unchanged && !receive_mesh_array(sock, normals, nv*3))
+        || (has_colors && !colors_unchanged && !receive_mesh_array(sock, vertex_colors, nv*4))
+        || (!topology_unchanged && !receive_mesh_array(sock, triangles, nt*3)))
+        return fail();
+
+    // All data arrived, swap it in. We're in idle render mode here, so
+    // the buffers the geometry currently shares can be freed, the data
+    // arrays are replaced before the geometry commit below.
+
+    blender_mesh->num_vertices = nv;
+    blender_mesh->num_triangles = nt;
+
+    if (!positions_unchanged)
+    {
+        blender_mesh->vertices.swap(vertices);
+        set_mesh_array(geometry, "vertex.position", blender_mesh->vertices, OSP_VEC3F, nv);
+    }
+
+    if (!has_normals)
+    {
+        // Might have been set on a previous update
+        // XXX is it ok to remove a param that was never set?
+        ospRemoveParam(geometry, "vertex.normal");
+        blender_mesh->normals.clear();
+        blender_mesh->normals.shrink_to_fit();
+    }
+    else if (!normals_unchanged)
+    {
+        blender_mesh->normals.swap(normals);
+        set_mesh_array(geometry, "vertex.normal", blender_mesh->normals, OSP_VEC3F, nv);
+    }
+
+    if (!has_colors)
+    {
+        ospRemoveParam(geometry, "vertex.color");
+        blender_mesh->vertex_colors.clear();
+        blender_mesh->vertex_colors.shrink_to_fit();
+    }
+    else if (!colors_unchanged)
+    {
+        blender_mesh->vertex_colors.swap(vertex_colors);
+        set_mesh_array(geometry, "vertex.color", blender_mesh->vertex_colors, OSP_VEC4F, nv);
+    }
+
+    if (!topology_unchanged)
+    {
+        blender_mesh->triangles.swap(triangles);
+        set_mesh_array(geometry, "index", blender_mesh->triangles, OSP_VEC3UI, nt);
+    }
+
+    ospCommit(geometry);
+
+    blender_mesh->content_hash = content_hash;
+
+    if (!create_new_mesh)
+        update_blender_mesh_objects(name, geometry);
+
+    return true;
+}
+
+bool
+update_blender_mesh_object(const UpdateObject& update)
+{    
+    const std::string& object_name = update.name();
+    const std::string& linked_data = update.data_link();
+
+    printf("OBJECT '%s' (blender mesh)\n", object_name.c_str());   
+    printf("--> '%s'\n", linked_data.c_str());
+
+    SceneObject     *scene_object;
+    SceneObjectMesh *mesh_object;
+    OSPInstance     instance;
+    OSPGroup        group;
+    OSPGeometricModel gmodel;
+
+    scene_object = find_scene_object(object_name, SOT_MESH);
+
+    if (scene_object == nullptr)
+        mesh_object = new SceneObjectMesh;    
+    else
+        mesh_object = dynamic_cast<SceneObjectMesh*>(scene_object);
+
+    instance = mesh_object->instance;
+    assert(instance != nullptr);
+    group = mesh_object->group;
+    assert(group != nullptr);
+
+    // Check linked data
+
+    if (!scene_data_with_type_exists(linked_data, SDT_BLENDER_MESH))
+    {
+        if (scene_object == nullptr)
+            delete mesh_object;
+        return false;
+    }
+
+    BlenderMesh *blender_mesh = blender_meshes[linked_data];
+    OSPGeometry geometry = blender_mesh->geometry;
+
+    if (geometry == NULL)
+    {
+        printf("... ERROR: geometry is NULL!\n");
+        if (scene_object == nullptr)
+            delete mesh_object;
+        return false;
+    }    
+
+    if (scene_object == nullptr)
+    {
+        mesh_object->data_link = linked_data;
+        gmodel = mesh_object->gmodel = ospNewGeometricModel(geometry);
+        mesh_object->geometry = geometry;
+    }
+    else
+    {
+        // XXX need this for updating material
+        gmodel = mesh_object->gmodel;
+    }
+
+    // Update object 
+
+    glm::mat4   obj2world;
+    float       affine_xform[12];
+
+    object2world_from_protobuf(obj2world, update);
+    affine3fv_from_mat4(affine_xform, obj2world);
+    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+
+    ospCommit(instance);    
+    
+    ospSetObjectAsData(group, "geometry", OSP_GEOMETRIC_MODEL, gmodel);
+    ospCommit(group);    
+
+    const std::string& matname = update.material_link();
+    mesh_object->material_link = matname;
+
+    SceneMaterialMap::iterator it = scene_materials.find(matname);
+    if (it != scene_materials.end())
+    {
+        printf("... Material '%s'\n", matname.c_str());
+        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, it->second->material->object);
+    }
+    else
+    {
+        printf("... WARNING: Material '%s' not found, using default!\n", matname.c_str());
+        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, default_materials[current_renderer_type]);
+    }
+
+    /*
+    float cols[] = { 1, 0, 0, 1 };
+    OSPData colors = ospNewCopiedData(1, OSP_VEC4F, &cols[0]);        
+    ospSetObject(gmodel, "color", colors);
+    ospRelease(colors);
+    */
+
+    ospCommit(gmodel);
+
+    if (scene_object == nullptr)
+    {
+        scene_objects[object_name] = mesh_object;
+
+        // XXX should create this list from scene_objects?
+        ospray_scene_instances.push_back(instance);
+        update_ospray_scene_instances = true;
+    }
+    else
+    {
+        // Instance is already in the world, only needs a world commit
+        ospray_world_changed = true;
+    }
+
+    return true;
+}
+
+
+bool
+update_geometry_object(const UpdateObject& update)
+{   
+    const std::string& object_name = update.name();
+    const std::string& linked_data = update.data_link(); 
+
+    printf("OBJECT '%s' (geometry)\n", object_name.c_str());    
+    printf("--> '%s'\n", linked_data.c_str());
+
+    SceneObject     *scene_object;
+    SceneObjectGeometry *geometry_object;
+    OSPInstance     instance;
+    OSPGroup        group;
+    OSPGeometricModel gmodel;
+
+    scene_object = find_scene_object(object_name, SOT_GEOMETRY);
+
+    if (scene_object == nullptr)
+        geometry_object = new SceneObjectGeometry;
+    else
+        geometry_object = dynamic_cast<SceneObjectGeometry*>(scene_object);
+
+    instance = geometry_object->instance;
+    assert(instance != nullptr);
+    group = geometry_object->group;
+    assert(group != nullptr);        
+
+    // Check linked data    
+    
+    wait_for_plugin_instance(linked_data);
+
+    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+    {
+        if (scene_object == nullptr)
+            delete geometry_object;
+        return false;
+    }
+
+    PluginInstance* plugin_instance = plugin_instances[linked_data];
+    assert(plugin_instance->type == PT_GEOMETRY);
+    PluginState *state = plugin_instance->state;
+
+    OSPGeometry geometry = state->geometry;
+
+    if (geometry == NULL)
+    {
+        printf("... ERROR: geometry is NULL!\n");
+        if (scene_object == nullptr)
+            delete geometry_object;
+        return false;
+    }    
+
+    if (scene_object == nullptr)
+    {
+        gmodel = geometry_object->gmodel = ospNewGeometricModel(geometry); 
+
+        ospSetObjectAsData(group, "geometry", OSP_GEOMETRIC_MODEL, gmodel);
+        ospCommit(group);
+    }
+    else
+        gmodel = geometry_object->gmodel;
+
+    glm::mat4   obj2world;
+    float       affine_xform[12];
+
+    object2world_from_protobuf(obj2world, update);
+    affine3fv_from_mat4(affine_xform, obj2world);
+
+    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);    
+    ospCommit(instance);
+
+    const std::string& matname = update.material_link();
+    geometry_object->material_link = matname;
+
+    SceneMaterialMap::iterator it = scene_materials.find(matname);
+    if (it != scene_materials.end())
+    {
+        printf("... Material '%s'\n", matname.c_str()); 
+        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, it->second->material->object);
+    }
+    else
+    {
+        printf("... WARNING: Material '%s' not found, using default!\n", matname.c_str());
+        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, default_materials[current_renderer_type]);
+    }
+    
+    ospCommit(gmodel);
+
+    if (scene_object == nullptr)
+    {
+        scene_objects[object_name] = geometry_object;
+
+        // XXX should create this list from scene_objects?
+        ospray_scene_instances.push_back(instance);
+        update_ospray_scene_instances = true;
+    }
+    else
+    {
+        // Instance is already in the world, only needs a world commit
+        ospray_world_changed = true;
+    }
+
+    return true;
+}
+
+bool
+update_scene_object(const UpdateObject& update)
+{    
+    const std::string& object_name = update.name();
+    const std::string& linked_data = update.data_link();
+
+    printf("OBJECT '%s' (scene)\n", update.name().c_str());    
+    printf("--> '%s'\n", linked_data.c_str());
+
+    SceneObject     *scene_object;
+    SceneObjectScene *scene_object_scene;       // XXX yuck
+
+    scene_object = find_scene_object(object_name, SOT_SCENE);
+
+    if (scene_object != nullptr)
+    {
+        scene_object_scene = dynamic_cast<SceneObjectScene*>(scene_object);
+
+        // Take the previous instances and lights out of the world
+        remove_from_world_list(ospray_scene_instances, scene_object_scene->instances);
+        remove_from_world_list(ospray_scene_lights, scene_object_scene->lights);
+        update_ospray_scene_instances = true;
+        update_ospray_scene_lights = true;
+
+        for (OSPInstance &i : scene_object_scene->instances)
+            ospRelease(i);
+        scene_object_scene->instances.clear();
+        scene_object_scene->lights.clear();
+    }
+    else
+    {
+        scene_object_scene = new SceneObjectScene;
+        scene_object_scene->data_link = linked_data;
+    }
+
+    // Check linked data    
+    
+    wait_for_plugin_instance(linked_data);
+
+    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+    {   
+        if (scene_object == nullptr)
+            delete scene_object_scene;
+        return false;
+    }
+
+    PluginInstance* plugin_instance = plugin_instances[linked_data];
+    assert(plugin_instance->type == PT_SCENE);
+    PluginState *state = plugin_instance->state;
+
+    GroupInstances group_instances = state->group_instances;
+
+    if (group_instances.size() == 0 && state->instance_arrays.size() == 0)
+        printf("... WARNING: no instances to add!\n");
+    else
+        printf("... Adding %d instances to scene\n", group_instances.size());
+
+    glm::mat4   obj2world;
+    float       affine_xform[12];
+
+    object2world_from_protobuf(obj2world, update);
+
+    for (GroupInstance& gi : group_instances)
+    {
+        OSPGroup group = gi.first;
+        const glm::mat4 instance_xform = gi.second;
+
+        affine3fv_from_mat4(affine_xform, obj2world * instance_xform);
+
+        OSPInstance instance = ospNewInstance(group);
+            ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+        ospCommit(instance);
+
+        scene_object_scene->instances.push_back(instance);
+
+        ospray_scene_instances.push_back(instance);
+        update_ospray_scene_instances = true;
+    }
+
+    // Instance arrays. OSPRay still needs an OSPInstance per instance,
+    // but we can at least create them in one go
+
+    for (const InstanceArray& ia : state->instance_arrays)
+    {
+        const size_t n = ia.transforms.size();
+
+        if (n == 0)
+            continue;
+
+        if (ia.group_indices.size() > 0 && ia.group_indices.size() != n)
+        {
+            printf("... ERROR: instance array has %d transforms, but %d group indices!\n", n, ia.group_indices.size());
+            continue;
+        }
+
+        printf("... Adding %d instances of %d group(s) to scene\n", n, ia.groups.size());
+
+        scene_object_scene->instances.reserve(scene_object_scene->instances.size() + n);
+        ospray_scene_instances.reserve(ospray_scene_instances.size() + n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const uint32_t group_index = ia.group_indices.size() > 0 ? ia.group_indices[i] : 0;
+
+            if (group_index >= ia.groups.size())
+                continue;
+
+            affine3fv_from_mat4(affine_xform, obj2world * ia.transforms[i]);
+
+            OSPInstance instance = ospNewInstance(ia.groups[group_index]);
+                ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+            ospCommit(instance);
+
+            scene_object_scene->instances.push_back(instance);
+            ospray_scene_instances.push_back(instance);
+        }
+
+        update_ospray_scene_instances = true;
+    }
+
+    // Lights
+    const Lights& lights = state->lights;
+    if (lights.size() > 0)
+    {
+        printf("... Adding %d lights to scene!\n", lights.size());
+        for (OSPLight light : state->lights)
+        {
+            // XXX Sigh, need to apply object2world transform manually
+            // This should be coming in 2.0
+            scene_object_scene->lights.push_back(light);
+
+            ospray_scene_lights.push_back(light);
+            update_ospray_scene_lights = true;
+        }
+    }
+
+    if (scene_object == nullptr)
+        scene_objects[object_name] = scene_object_scene;
+
+    return true;
+}
+
+// Volumes that have a LOD version currently use it
+thread_local bool volume_lod_active = false;
+
+// Volume to use for a volume object, given the current LOD state
+OSPVolume
+volume_object_active_volume(const SceneObjectVolume *volume_object)
+{
+    if (volume_lod_active && volume_object->volume_lod != nullptr)
+        return volume_object->volume_lod;
+    return volume_object->volume;
+}
+
+void
+set_volume_object_volumes(SceneObjectVolume *volume_object, const PluginState *state)
+{
+    if (state->volume != nullptr)
+        ospRetain(state->volume);
+    if (state->volume_lod != nullptr)
+        ospRetain(state->volume_lod);
+
+    if (volume_object->volume != nullptr)
+        ospRelease(volume_object->volume);
+    if (volume_object->volume_lod != nullptr)
+        ospRelease(volume_object->volume_lod);
+
+    volume_object->volume = state->volume;
+    volume_object->volume_lod = state->volume_lod;
+}
+
+// Switch all volume objects that have a LOD volume to either that
+// volume or the full-resolution one. Needs to be called before 
+// starting a frame, which then commits the world (see render_frame()).
+void
+use_volume_lod(bool use_lod)
+{
+    if (use_lod == volume_lod_active)
+        return;
+
+    volume_lod_active = use_lod;
+
+    int num_switched = 0;
+
+    for (auto& kv : scene_objects)
+    {
+        if (kv.second->type != SOT_VOLUME)
+            continue;
+
+        SceneObjectVolume *volume_object = dynamic_cast<SceneObjectVolume*>(kv.second);
+
+        if (volume_object->volume_lod == nullptr)
+            continue;
+
+        ospSetObject(volume_object->vmodel, "volume", volume_object_active_volume(volume_object));
+        ospCommit(volume_object->vmodel);
+        ospCommit(volume_object->group);
+        ospCommit(volume_object->instance);
+
+        num_switched++;
+    }
+
+    if (num_switched > 0)
+    {
+        ospray_world_changed = true;
+        printf("(%s volumes: %d) ", use_lod ? "LOD" : "full", num_switched);
+    }
+}
+
+// XXX has a bug when switching renderer types
+bool
+update_volume_object(const UpdateObject& update, const Volume& volume_settings)
+{
+    const std::string& object_name = update.name();
+    const std::string& linked_data = update.data_link(); 
+
+    printf("OBJECT '%s' (volume)\n", update.name().c_str()); 
+    printf("--> '%s'\n", linked_data.c_str());  
+
+    SceneObject         *scene_object;
+    SceneObjectVolume   *volume_object;
+    OSPInstance         instance;
+    OSPGroup            group;
+    OSPVolumetricModel  vmodel;
+
+    scene_object = find_scene_object(object_name, SOT_VOLUME);
+
+    if (scene_object != nullptr)
+        volume_object = dynamic_cast<SceneObjectVolume*>(scene_object);
+    else
+        volume_object = new SceneObjectVolume;
+
+    instance = volume_object->instance;
+    assert(instance != nullptr);
+    group = volume_object->group;
+    assert(group != nullptr); 
+    vmodel = volume_object->vmodel;
+
+    // Check linked data
+    
+    wait_for_plugin_instance(linked_data);
+
+    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+    {
+        if (scene_object == nullptr)
+            delete volume_object;   
+        return false;
+    }
+
+    PluginInstance* plugin_instance = plugin_instances[linked_data];
+    assert(plugin_instance->type == PT_VOLUME);
+    PluginState *state = plugin_instance->state;
+
+    OSPVolume volume = state->volume;
+
+    if (volume == NULL)
+    {
+        printf("... ERROR: volume is NULL!\n");
+        delete volume_object;
+        return false;
+    }    
+
+    set_volume_object_volumes(volume_object, state);
+
+    if (scene_object == nullptr)
+    {
+        assert(scene_objects.find(object_name) == scene_objects.end());
+        scene_objects[object_name] = volume_object;
+        vmodel = volume_object->vmodel = ospNewVolumetricModel(volume_object_active_volume(volume_object));
+    }
+    else
+        ospSetObject(vmodel, "volume", volume_object_active_volume(volume_object));
+    
+    // These are pathtracer only
+    ospSetFloat(vmodel, "densityScale", volume_settings.density_scale());
+    ospSetFloat(vmodel, "anisotropy", volume_settings.anisotropy());
+
+    TransferFunctionDefinition tf_definition;
+    
+    // XXX the TF is based on the actual volume data range here, but there
+    // are situations in which a user would want to specify the actual range
+    // (e.g. rendering a dataset sequence where the per-step data range varies,
+    // while the TF should keep the same range for consistent color and opacity)
+
+    if (volume_settings.tf_positions_size() > 0 && volume_settings.tf_colors_size() > 0)
+    {
+        printf("... User-defined transfer function\n");
+        user_transfer_function(tf_definition, state->volume_data_range[0], state->volume_data_range[1], volume_settings);
+    }
+    else
+    {
+        // Default TF        
+        printf("... Default cool2warm transfer function\n");
+        default_transfer_function(tf_definition, state->volume_data_range[0], state->volume_data_range[1]);
+    }
+
+    if (use_transfer_function(volume_object->transfer_function, tf_definition))
+        ospSetObject(vmodel, "transferFunction", volume_object->transfer_function->object);
+
+    ospCommit(vmodel);
+
+    ospSetObjectAsData(group, "volume", OSP_VOLUMETRIC_MODEL, vmodel);
+    ospCommit(group);
+
+    glm::mat4   obj2world;
+    float       affine_xform[12];
+
+    object2world_from_protobuf(obj2world, update);
+    affine3fv_from_mat4(affine_xform, obj2world);
+
+    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+    ospCommit(instance);
+
+    if (scene_object == nullptr)
+    {
+        scene_objects[object_name] = volume_object;
+
+        // XXX should create this list from scene_objects?
+        ospray_scene_instances.push_back(instance);
+        update_ospray_scene_instances = true;
+    }
+    else
+    {
+        // Instance is already in the world, only needs a world commit
+        ospray_world_changed = true;
+    }
+
+    return true;
+}
+
+bool
+update_isosurfaces_object(const UpdateObject& update)
+{
+    const std::string& object_name = update.name();
+    const std::string& linked_data = update.data_link();    
+
+    printf("OBJECT '%s' (isosurfaces)\n", update.name().c_str()); 
+    printf("--> '%s'\n", linked_data.c_str());     
+
+    SceneObject         *scene_object;
+    SceneObjectIsosurfaces   *isosurfaces_object;
+    OSPInstance         instance;
+    OSPGroup            group;
+    OSPGeometry         isosurfaces_geometry;
+    OSPVolumetricModel  vmodel;
+    OSPGeometricModel   gmodel;
+
+    scene_object = find_scene_object(object_name, SOT_ISOSURFACES);
+
+    if (scene_object != nullptr)
+        isosurfaces_object = dynamic_cast<SceneObjectIsosurfaces*>(scene_object);
+    else
+        isosurfaces_object = new SceneObjectIsosurfaces;
+
+    instance = isosurfaces_object->instance;
+    assert(instance != nullptr);
+    group = isosurfaces_object->group;
+    assert(group != nullptr); 
+    gmodel = isosurfaces_object->gmodel;
+    assert(gmodel != nullptr);
+    isosurfaces_geometry = isosurfaces_object->isosurfaces_geometry;
+    assert(isosurfaces_geometry != nullptr);
+
+    // Check linked data
+
+    wait_for_plugin_instance(linked_data);
+
+    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+    {
+        if (scene_object != nullptr)
+            delete isosurfaces_object;
+        return false;
+    }
+
+    PluginInstance* plugin_instance = plugin_instances[linked_data];
+    assert(plugin_instance->type == PT_VOLUME);
+    PluginState *state = plugin_instance->state;
+
+    OSPVolume volume = state->volume;
+
+    if (volume == NULL)
+    {
+        printf("... ERROR: volume is NULL!\n");
+        if (scene_object != nullptr)
+            delete isosurfaces_object;
+        return false;
+    }        
+
+    if (scene_object == nullptr)
+    {
+        assert(scene_objects.find(object_name) == scene_objects.end());
+        scene_objects[object_name] = isosurfaces_object;
+
+        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, default_materials[current_renderer_type]);        
+    }
+
+    // The isosurfaces need a volumetric model, which is shared by all
+    // isosurfaces objects of the volume
+    TransferFunctionDefinition tf_definition;
+    default_transfer_function(tf_definition, state->volume_data_range[0], state->volume_data_range[1]);
+
+    isosurfaces_object->transfer_function = get_transfer_function(tf_definition);
+    isosurfaces_object->vmodel = get_volumetric_model(volume, isosurfaces_object->transfer_function);
+    vmodel = isosurfaces_object->vmodel->object;
+
+    const char *s_custom_properties = update.custom_properties().c_str();
+    //printf("Received custom properties:\n%s\n", s_custom_properties);
+    const json &custom_properties = json::parse(s_custom_properties);
+    if (!custom_properties.empty())
+    {
+        printf("... custom properties:\n");
+        printf("%s\n", custom_properties.dump(4).c_str());
+    }
+    
+    if (custom_properties.find("isovalues") == custom_properties.end())
+    {
+        printf("... WARNING: no property 'isovalues' set on object!\n");
+        return false;
+    }
+
+    const json& isovalues_prop = custom_properties["isovalues"];
+    int n = isovalues_prop.size();
+
+    float *isovalues = new float[n];
+    for (int i = 0; i < n; i++)
+    {        
+        isovalues[i] = isovalues_prop[i];
+        printf("... isovalue #%d: %.3f\n", i, isovalues[i]);
+    }
+
+    OSPData isovalues_data = ospNewCopiedData(n, OSP_FLOAT, isovalues);  
+    ospCommit(isovalues_data);
+    delete [] isovalues;
+
+    ospSetObject(isosurfaces_geometry, "volume", vmodel);
+    //ospRelease(volume);
+
+    ospSetObject(isosurfaces_geometry, "isovalue", isovalues_data);
+    ospRelease(isovalues_data);
+
+    ospCommit(isosurfaces_geometry);
 
     glm::mat4   obj2world;
     float       affine_xform[12];
 
-    object2world_from_protobuf(obj2world, update);
-    affine3fv_from_mat4(affine_xform, obj2world);
+    object2world_from_protobuf(obj2world, update);
+    affine3fv_from_mat4(affine_xform, obj2world);
+
+    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+    ospCommit(instance);
+
+    ospCommit(gmodel);
+    ospCommit(group);
+
+    if (scene_object == nullptr)
+    {
+        scene_objects[object_name] = isosurfaces_object;
+
+        // XXX should create this list from scene_objects?
+        ospray_scene_instances.push_back(instance);
+        update_ospray_scene_instances = true;
+    }
+    else
+    {
+        // Instance is already in the world, only needs a world commit
+        ospray_world_changed = true;
+    }
+    
+    return true;
+}
+
+// A slices object is just regular geometry that gets colored 
+// using a volume texture
+// XXX parenting can be animated using a Childof object constraint
+// XXX a text field in a node can't be animated
+bool
+add_slice_objects(const UpdateObject& update, const Slices& slices)
+{
+    const std::string& linked_data = update.data_link();
+
+    printf("OBJECT '%s' (slices)\n", update.name().c_str());
+    printf("--> '%s'\n", linked_data.c_str());    
+
+    wait_for_plugin_instance(linked_data);
+
+    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
+        return false;
+
+    PluginInstance* plugin_instance = plugin_instances[linked_data];
+    assert(plugin_instance->type == PT_VOLUME);
+    PluginState *state = plugin_instance->state;
+
+    OSPVolume volume = state->volume;
+
+    if (volume == nullptr)
+    {
+        printf("... ERROR: volume is NULL!\n");
+        return false;
+    }        
+
+    const char *s_custom_properties = update.custom_properties().c_str();
+    //printf("Received custom properties:\n%s\n", s_custom_properties);
+    const json &custom_properties = json::parse(s_custom_properties);
+    if (!custom_properties.empty())
+    {
+        printf("... custom properties:\n");
+        printf("%s\n", custom_properties.dump(4).c_str());
+    }
+
+    SceneObject         *scene_object;
+    SceneObjectSlice    *slice_object;
+    OSPGroup            group;
+    OSPGeometricModel   gmodel;
+    OSPInstance         instance;
+
+    // All slices share the same volumetric model, transfer function
+    // and material (i.e. volume texture)
+
+    TransferFunctionDefinition tf_definition;
+    default_transfer_function(tf_definition, state->volume_data_range[0], state->volume_data_range[1]);
+
+    SharedTransferFunction tf = get_transfer_function(tf_definition);
+    SharedVolumetricModel vmodel = get_volumetric_model(volume, tf);
+
+    const std::string material_key = current_renderer_type + ":slice:" + vmodel->key;
+    SharedMaterial material = materials.find(material_key);
+
+    if (material == nullptr)
+    {
+        OSPTexture volume_texture = ospNewTexture("volume");
+            ospSetObject(volume_texture, "volume", vmodel->object);   // XXX volume model, not volume
+        ospCommit(volume_texture);
+
+        OSPMaterial m = ospNewMaterial(current_renderer_type.c_str(), "default");
+            ospSetObject(m, "map_Kd", volume_texture);
+        ospCommit(m);
+        ospRelease(volume_texture);
+
+        material = materials.add(material_key, m);
+    }
+
+    // Each slice becomes a separate scene object of type SOT_SLICE
+    for (int i = 0; i < slices.slices_size(); i++)
+    {
+        const Slice& slice = slices.slices(i);
+
+        const std::string& object_name = slice.name();
+        const std::string& linked_mesh = slice.mesh_link();
+
+        // Get linked geometry
+
+        printf("... linked mesh '%s' (blender mesh)\n", linked_mesh.c_str());    
+
+        SceneDataTypeMap::iterator it = scene_data_types.find(linked_mesh);
+
+        if (it == scene_data_types.end())
+        {
+            printf("--> '%s' | WARNING: linked data not found!\n", linked_mesh.c_str());
+            return false;
+        }
+        else if (it->second != SDT_BLENDER_MESH)
+        {
+            printf("--> '%s' | WARNING: linked data is not of type SDT_BLENDER_MESH but of type %s!\n", 
+                linked_mesh.c_str(), SceneDataType_names[it->second]);
+            return false;
+        }
+        else
+            printf("--> '%s' (blender mesh data)\n", linked_mesh.c_str());
+
+        BlenderMesh *blender_mesh = blender_meshes[linked_mesh];
+        OSPGeometry geometry = blender_mesh->geometry;
+
+        if (geometry == nullptr)
+        {
+            printf("... ERROR: geometry of blender mesh is NULL!\n");
+            return false;
+        }                    
+
+        // Update/create scene object
+
+        scene_object = find_scene_object(object_name, SOT_SLICE);
+
+        if (scene_object != nullptr)
+            slice_object = dynamic_cast<SceneObjectSlice*>(scene_object);
+        else
+            slice_object = new SceneObjectSlice;
+
+        instance = slice_object->instance;
+        assert(instance != nullptr);
+        group = slice_object->group;
+        assert(group != nullptr); 
+        gmodel = slice_object->gmodel;
+        assert(gmodel != nullptr);
+        slice_object->slice_geometry = geometry;
+
+        // Set up slice geometry
+
+        slice_object->vmodel = vmodel;
+        slice_object->transfer_function = tf;
+
+        if (slice_object->material != material)
+        {
+            slice_object->material = material;
+            ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, material->object);
+        }
+        ospCommit(gmodel);
+
+        ospCommit(group);
+     
+        glm::mat4   obj2world;
+        float       affine_xform[12];
+
+        object2world_from_protobuf(obj2world, slice);
+        affine3fv_from_mat4(affine_xform, obj2world);
+        
+        ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
+        ospCommit(instance);        
+
+        if (scene_object == nullptr)
+        {
+            scene_objects[object_name] = slice_object;
+
+            // XXX should create this list from scene_objects?
+            ospray_scene_instances.push_back(instance);
+            update_ospray_scene_instances = true;
+        }
+        else
+        {
+            // Instance is already in the world, only needs a world commit
+            ospray_world_changed = true;
+        }
+    }
+
+    return true;
+}
+
+bool
+update_light_object(const UpdateObject& update, const LightSettings& light_settings)
+{
+    const std::string& object_name = light_settings.object_name();
+    //const std::string& linked_data = light_settings.light_name();    
+
+    printf("OBJECT '%s' (light)\n", object_name.c_str());
+    //printf("--> '%s' (blender light data)\n", linked_data.c_str());    // XXX not set for ambient
+
+    SceneObject *scene_object;
+    SceneObjectLight *light_object = nullptr;
+    OSPLight light;
+    LightSettings::Type light_type;    
+
+    scene_object = find_scene_object(object_name, SOT_LIGHT);
+
+    if (scene_object != nullptr)
+    {
+        // Check existing light
+        light_object = dynamic_cast<SceneObjectLight*>(scene_object);
+        
+        light = light_object->light;
+        assert(light != nullptr);
+        
+        light_type = light_object->light_type;
+
+        if (light_type != light_settings.type())
+        {            
+            printf("... Light type changed from %d to %d, replacing with new light\n",
+                light_type, light_settings.type());
+
+            delete_object(object_name);                    
+
+            auto it = std::find(ospray_scene_lights.begin(), ospray_scene_lights.end(), light);
+            ospray_scene_lights.erase(it);
+            update_ospray_scene_lights = true;
+            
+            light_object = nullptr;
+        }
+    }
+    
+    if (light_object == nullptr)
+    {            
+        light_type = light_settings.type();
+        printf("... Creating new light of type %d\n", light_type);
+
+        light_object = new SceneObjectLight;
+        switch (light_type)
+        {
+        /*case LightSettings::AMBIENT:
+            light = ospNewLight("ambient");
+            break;*/
+        case LightSettings::POINT:
+            light = ospNewLight("sphere");
+            break; 
+        case LightSettings::SPOT:
+            light = ospNewLight("spot");
+            break; 
+        case LightSettings::SUN:
+            light = ospNewLight("distant");
+            break; 
+        case  LightSettings::AREA:
+            light = ospNewLight("quad");
+            break; 
+        default:
+            printf("ERROR: unhandled light type %d!\n", light_type);
+        }
+
+        light_object->light = light;
+        light_object->light_type = light_type;
+        light_object->data_link = light_settings.light_name();
+
+        scene_objects[object_name] = light_object;    
+
+        ospray_scene_lights.push_back(light);    
+        update_ospray_scene_lights = true;
+    }
+
+    if (light_settings.type() == LightSettings::SPOT)
+    {
+        ospSetFloat(light, "openingAngle", light_settings.opening_angle());
+        ospSetFloat(light, "penumbraAngle", light_settings.penumbra_angle());
+    }
+    else if (light_settings.type() == LightSettings::SUN)
+    {
+        ospSetFloat(light, "angularDiameter", light_settings.angular_diameter());
+    }
+    else if (light_settings.type() == LightSettings::AREA)
+    {
+        // XXX blender's area light is more general than ospray's quad light
+        ospSetVec3f(light, "edge1", light_settings.edge1(0), light_settings.edge1(1), light_settings.edge1(2));
+        ospSetVec3f(light, "edge2", light_settings.edge2(0), light_settings.edge2(1), light_settings.edge2(2));
+    }
+    //else
+    // XXX HDRI
+
+    printf("... intensity %.3f, visible %d\n", light_settings.intensity(), light_settings.visible());
+
+    ospSetVec3f(light, "color", light_settings.color(0), light_settings.color(1), light_settings.color(2));
+    ospSetFloat(light, "intensity", light_settings.intensity());
+    ospSetBool(light, "visible", light_settings.visible());
+
+    if (light_settings.type() != LightSettings::SUN && light_settings.type() != LightSettings::AMBIENT)
+        ospSetVec3f(light, "position", light_settings.position(0), light_settings.position(1), light_settings.position(2));
+
+    if (light_settings.type() == LightSettings::SUN || light_settings.type() == LightSettings::SPOT)
+        ospSetVec3f(light, "direction", light_settings.direction(0), light_settings.direction(1), light_settings.direction(2));
+
+    if (light_settings.type() == LightSettings::POINT || light_settings.type() == LightSettings::SPOT)
+        ospSetFloat(light, "radius", light_settings.radius());
+
+    ospCommit(light);  
+
+    ospray_world_changed = true;
+
+    return true;
+}
+
+// XXX add world/object bounds
+void
+get_server_state(json& j)
+{    
+    json p;
+
+    wait_for_all_plugin_instances();
+
+    j["session"] = session->name;
+
+    p = {};
+    for (auto& kv: scene_objects)
+    {
+        const SceneObject* object = kv.second;
+        p[kv.first] = { {"type", SceneObjectType_names[object->type]}, {"data_link", object->data_link} };
+    }
+    j["scene_objects"] = p;
+
+    p = {};
+    for (auto& kv: scene_materials)
+        p[kv.first] = kv.second->material->key;
+    j["scene_materials"] = p;        
+
+    // Shared objects, with their number of users
+    p = {};
+    transfer_functions.foreach([&p](const std::string& key, long users) { p[key] = users; });
+    j["transfer_functions"] = p;
+
+    p = {};
+    volumetric_models.foreach([&p](const std::string& key, long users) { p[key] = users; });
+    j["volumetric_models"] = p;
+
+    p = {};
+    materials.foreach([&p](const std::string& key, long users) { p[key] = users; });
+    j["materials"] = p;
+
+    p = {};
+    for (auto& kv: plugin_instances)
+    {
+        const PluginInstance *instance = kv.second;
+        const PluginState *state = instance->state;
+
+        json ll;
+        for (auto& l : state->lights)
+            ll.push_back((size_t)l);
+
+        json gi;
+        for (auto& i : state->group_instances)
+            gi.push_back({(size_t)(i.first), to_string(i.second)});
+
+        // Only the number of instances, per-instance data could be large
+        json ia;
+        for (auto& a : state->instance_arrays)
+        {
+            json groups;
+            for (auto& g : a.groups)
+                groups.push_back((size_t)g);
+            ia.push_back({ {"groups", groups}, {"num_instances", a.transforms.size()} });
+        }
+
+        json d = p[kv.first] = { 
+            {"name", instance->name}, 
+            {"type", PluginType_names[instance->type]},
+            {"plugin_name", instance->plugin_name},
+            {"parameters_hash", instance->parameters_hash},
+            {"custom_properties_hash", instance->custom_properties_hash},
+            {"state", {
+                {"renderer", state->renderer},
+                {"uses_renderer_type", state->uses_renderer_type},
+                {"parameters", state->parameters},
+                {"bound", (size_t)state->bound},
+                {"geometry", (size_t)state->geometry},
+                {"volume", (size_t)state->volume},
+                {"volume_lod", (size_t)state->volume_lod},
+                {"volume_data_range", { state->volume_data_range[0], state->volume_data_range[1] } },
+                {"data", (size_t)state->data},
+                {"lights", ll},
+                {"group_instances", gi},
+                {"instance_arrays", ia}
+            } }
+        };
+
+        std::map<std::string, SharedPluginState>::const_iterator shared = shared_plugin_states.find(instance->shared_state_key);
+        if (shared != shared_plugin_states.end())
+        {
+            p[kv.first]["creation_time"] = shared->second.creation_time;
+            p[kv.first]["memory_usage"] = shared->second.memory_usage;
+            p[kv.first]["memory_size"] = shared_plugin_state_memory_size(shared->second);
+            p[kv.first]["users"] = shared->second.users;
+        }
+
+        p[kv.first]["last_rendered"] = instance->last_rendered;
+    }
+    j["plugin_instances"] = p;
+
+    p = {};
+    for (auto& kv: blender_meshes)
+    {
+        const BlenderMesh *mesh = kv.second;
+        p[kv.first] = { 
+            {"name", mesh->name}, {"parameters", mesh->parameters}, {"geometry", (size_t)mesh->geometry},
+            {"num_vertices", mesh->num_vertices}, {"num_triangles", mesh->num_triangles},
+            {"memory_size", mesh->memory_size()}, {"last_rendered", mesh->last_rendered}
+        };
+    }
+    j["blender_meshes"] = p;
+
+    j["blender_mesh_cache"] = { 
+        {"num_meshes", blender_mesh_cache_lru.size()}, {"memory_size", blender_mesh_cache_size}
+    };
+
+    j["memory_budget"] = { 
+        {"budget", memory_budget}, {"accounted", accounted_memory_size()}
+    };
+
+    p = {};
+    for (auto& kv: scene_data_types)
+    {
+        p[kv.first] = SceneDataType_names[kv.second];
+    }
+    j["scene_data_types"] = p;
+
+    p = {};
+    for (auto& kv: plugin_definitions)
+    {
+        const PluginDefinition& pdef = kv.second;
+        p[kv.first] = { {"type", PluginType_names[pdef.type]}, {"uses_renderer_type", pdef.uses_renderer_type} };    // XXX params
+    }
+    j["plugin_definitions"] = p;
+
+    // Scene 
+
+    json scene;
+
+    p = {};
+    for (auto& i: ospray_scene_instances)
+        p.push_back((size_t)i);
+    scene["ospray_scene_instances"] = p;
+
+    p = {};
+    for (auto& l: ospray_scene_lights)
+        p.push_back((size_t)l);
+    scene["ospray_scene_lights"] = p;
+
+    j["scene"] = scene;
+
+    // Framebuffer
+
+    json fb;
+
+    p = {};
+    for (int i = 0; i < framebuffers.size(); i++)
+        p.push_back((size_t)framebuffers[i].framebuffer);
+    fb["framebuffers"] = p;
+
+    fb["framebuffer_initial_reduction_factor"] = framebuffer_initial_reduction_factor;
+
+    j["framebuffer"] = fb;
+
+    // Camera
+
+    json cam;
+
+    cam["ospray_camera"] = (size_t)ospray_camera;
+
+    j["camera"] = cam;    
+
+    // World
+
+    json world;
+
+    world["ospray_world"] = (size_t)ospray_world;
+
+    j["world"] = world;
+
+    // Renderer
+
+    json r;
+
+    r["ospray_renderer"] = (size_t)ospray_renderer;
+
+    json rr;
+    for (auto& nr : renderers)
+        rr[nr.first] = (size_t)nr.second;
+    j["renderers"] = rr;
+
+    j["renderer"] = r;    
+
+    // Timings and memory
+
+    json t;
+    timings.get_json(t);
+    j["timings"] = t;
+
+    j["memory_usage"] = memory_usage();
+}
+
+bool 
+handle_get_server_state(TCPSocket *sock)
+{    
+    json j;
+
+    get_server_state(j);
+
+    // Send result
+    ServerStateResult   result;
+    result.set_state(j.dump(4));
+    send_protobuf(sock, result);
+
+    return true;
+}
+
+void 
+print_server_state()
+{
+    json j;
+    get_server_state(j);
+
+    printf("Server state:\n");
+    printf("%s\n", j.dump(4).c_str());
+}
+
+
+// Returns false on receive errors and when the object update failed
+template<typename Connection>
+bool
+handle_update_object(Connection *sock)
+{
+    UpdateObject    update;    
+    bool            ok = true;
+
+    if (!receive_protobuf(sock, update))
+        return false;
+
+    //print_protobuf(update);
+
+    switch (update.type())
+    {
+    case UpdateObject::MESH:
+        ok = update_blender_mesh_object(update);
+        break;
+
+    case UpdateObject::GEOMETRY:
+        ok = update_geometry_object(update);
+        break;
+
+    case UpdateObject::SCENE:
+        ok = update_scene_object(update);
+        break;
+
+    case UpdateObject::VOLUME:
+        {
+        Volume volume;
+        if (!receive_protobuf(sock, volume))
+            return false;
+        ok = update_volume_object(update, volume);
+        }
+        break;
+
+    case UpdateObject::ISOSURFACES:
+        ok = update_isosurfaces_object(update);
+        break;
+    
+    case UpdateObject::SLICES:
+        {
+        Slices slices;
+        if (!receive_protobuf(sock, slices))
+            return false;
+        ok = add_slice_objects(update, slices);
+        }
+        break;
+
+    case UpdateObject::LIGHT:
+        {
+        LightSettings light_settings;
+        if (!receive_protobuf(sock, light_settings))
+            return false;
+        ok = update_light_object(update, light_settings);
+        }
+        break;
+
+    default:
+        printf("WARNING: unhandled update type %s\n", UpdateObject_Type_descriptor()->FindValueByNumber(update.type())->name().c_str());
+        break;
+    }
+
+    return ok;
+}
+
+// Shared memory framebuffer transport
+
+void
+shm_transport_close()
+{
+    if (shm_name == "")
+        return;
+
+    printf("Removing shared memory framebuffer transport %s\n", shm_name.c_str());
+
+    if (shm_ptr != nullptr)
+        munmap(shm_ptr, SHM_NUM_SLOTS*shm_slot_size);
+    close(shm_fd);
+    shm_unlink(shm_name.c_str());
+
+    shm_name = "";
+    shm_fd = -1;
+    shm_ptr = nullptr;
+    shm_slot_size = 0;
+}
+
+// Make slots big enough for a framebuffer of the given size
+bool
+shm_transport_resize(int width, int height)
+{
+    if (shm_name == "")
+        return false;
+
+    size_t slot_size = sizeof(SharedFramebufferSlot) + size_t(width)*height*4*sizeof(float);
+    // Page-align slots
+    slot_size = (slot_size + 4095) & ~size_t(4095);
+
+    if (slot_size == shm_slot_size)
+        return true;
+
+    if (shm_ptr != nullptr)
+    {
+        munmap(shm_ptr, SHM_NUM_SLOTS*shm_slot_size);
+        shm_ptr = nullptr;
+    }
+
+    shm_slot_size = slot_size;
+
+    if (ftruncate(shm_fd, SHM_NUM_SLOTS*slot_size) == -1)
+    {
+        perror("ftruncate() on shared memory failed");
+        shm_transport_close();
+        return false;
+    }
+
+    void *p = mmap(nullptr, SHM_NUM_SLOTS*slot_size, PROT_READ|PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (p == MAP_FAILED)
+    {
+        perror("mmap() of shared memory failed");
+        shm_transport_close();
+        return false;
+    }
+
+    shm_ptr = (uint8_t*)p;
+    memset(shm_ptr, 0, SHM_NUM_SLOTS*slot_size);
+
+    printf("... Shared memory framebuffer transport: %d slots of %.1f MB\n", SHM_NUM_SLOTS, slot_size/1000000.0f);
+
+    return true;
+}
+
+bool
+shm_transport_open()
+{
+    char name[64];
+
+    shm_transport_close();
+
+    sprintf(name, "/blospray-%d-%d", getpid(), session->id);
+
+    shm_fd = shm_open(name, O_CREAT|O_RDWR|O_TRUNC, 0600);
+    if (shm_fd == -1)
+    {
+        perror("shm_open() failed");
+        return false;
+    }
+
+    shm_name = name;
+
+    printf("Using shared memory framebuffer transport %s\n", name);
+
+    if (final_framebuffer_width > 0)
+        return shm_transport_resize(final_framebuffer_width, final_framebuffer_height);
+
+    return true;
+}
+
+// Copy the final framebuffer into the slot for the given sample, returns the slot index.
+// Returns -1 (nothing written) for samples < 1, as the sequence numbers below
+// start at 1, and for a framebuffer that doesn't fit the slots.
+int
+shm_transport_write(OSPFrameBuffer framebuffer, int width, int height, int sample)
+{
+    if (sample < 1 || width < 0 || height < 0
+        || sizeof(SharedFramebufferSlot) + size_t(width)*height*4*sizeof(float) > shm_slot_size)
+    {
+        printf("... WARNING: can't write sample %d (%d x %d) to shared memory\n", sample, width, height);
+        return -1;
+    }
+
+    const int slot = sample % SHM_NUM_SLOTS;
+    uint8_t *p = shm_ptr + slot*shm_slot_size;
+
+    SharedFramebufferSlot *header = (SharedFramebufferSlot*)p;
+
+    __atomic_store_n(&header->sequence, 2*uint64_t(sample)-1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    header->width = width;
+    header->height = height;
+    header->sample = sample;
+
+    const float *fb = (const float*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+    memcpy(p + sizeof(SharedFramebufferSlot), fb, size_t(width)*height*4*sizeof(float));
+    ospUnmapFrameBuffer(fb, framebuffer);
+
+    __atomic_store_n(&header->sequence, 2*uint64_t(sample), __ATOMIC_RELEASE);
+
+    return slot;
+}
+
+int
+framebuffer_channels()
+{
+    int channels = OSP_FB_COLOR | /*OSP_FB_DEPTH |*/ OSP_FB_ACCUM | OSP_FB_VARIANCE;
+
+    // Used by the denoiser
+    if (denoiser != nullptr)
+        channels |= OSP_FB_NORMAL | OSP_FB_ALBEDO;
+
+    return channels;
+}
+
+// XXX include channels
+void
+update_framebuffer_settings(const std::string& mode, OSPFrameBufferFormat format, uint32_t width, uint32_t height, 
+    uint32_t encoding, float tile_threshold)
+{
+    printf("FRAMEBUFFER %s, %d x %d (format %d, encoding %d)\n", mode.c_str(), width, height, format, encoding);
+
+    if (mode == "final")
+    {
+        
+        if (final_framebuffer_width == width && final_framebuffer_height == height && final_framebuffer_format == format)
+        {
+            printf("... No need to update framebuffer dimensions or format\n");
+            return;
+        }
+
+        if (final_framebuffer != nullptr)
+            ospRelease(final_framebuffer);
+
+        final_framebuffer = ospNewFrameBuffer(width, height, format, framebuffer_channels());
+        final_framebuffer_denoising = false;
+        final_framebuffer_width = width;
+        final_framebuffer_height = height;
+        final_framebuffer_format = format;
+
+        if (shm_name != "")
+            shm_transport_resize(width, height);
+    }
+    else
+    {
+        assert(mode == "interactive");
+
+        if ((format == OSP_FB_RGBA32F || format == OSP_FB_SRGBA || format == OSP_FB_RGBA8) == false)
+        {
+            printf("... WARNING: unsupported interactive framebuffer format %d, using OSP_FB_RGBA32F\n", format);
+            format = OSP_FB_RGBA32F;
+        }
+
+#ifndef FRAMEBUFFER_LZ4
+        if (encoding & RenderResult::LZ4)
+        {
+            printf("... WARNING: LZ4 framebuffer compression not available, ignoring\n");
+            encoding &= ~RenderResult::LZ4;
+        }
+#endif
+#ifndef FRAMEBUFFER_ZSTD
+        if (encoding & RenderResult::ZSTD)
+        {
+            printf("... WARNING: Zstandard framebuffer compression not available, ignoring\n");
+            encoding &= ~RenderResult::ZSTD;
+        }
+#endif
+        if ((encoding & RenderResult::LZ4) && (encoding & RenderResult::ZSTD))
+        {
+            printf("... WARNING: both LZ4 and Zstandard compression requested, using LZ4\n");
+            encoding &= ~RenderResult::ZSTD;
+        }
+
+        // Only affects sending, framebuffers can be kept
+        interactive_framebuffer_encoding = encoding;
+        interactive_framebuffer_tile_threshold = tile_threshold;
+
+        if (interactive_framebuffer_width == width && interactive_framebuffer_height == height && interactive_framebuffer_format == format)
+            return;
+
+        printf("... Clearing existing framebuffers (dimensions or format changed)\n");
+
+        // Clear framebuffers
+        framebuffers.clear();
+        framebuffer_reduction_factors.clear();
+
+        // Update values to use
+        interactive_framebuffer_width = width;
+        interactive_framebuffer_height = height;
+        interactive_framebuffer_format = format;        
+    }
+}
+
+void
+update_camera(CameraSettings& camera_settings)
+{
+    printf("CAMERA '%s' (camera)\n", camera_settings.object_name().c_str());
+    printf("--> '%s' (camera data)\n", camera_settings.camera_name().c_str());
+
+    float cam_pos[3], cam_viewdir[3], cam_updir[3];
+
+    cam_pos[0] = camera_settings.position(0);
+    cam_pos[1] = camera_settings.position(1);
+    cam_pos[2] = camera_settings.position(2);
+
+    cam_viewdir[0] = camera_settings.view_dir(0);
+    cam_viewdir[1] = camera_settings.view_dir(1);
+    cam_viewdir[2] = camera_settings.view_dir(2);
+
+    cam_updir[0] = camera_settings.up_dir(0);
+    cam_updir[1] = camera_settings.up_dir(1);
+    cam_updir[2] = camera_settings.up_dir(2);
+    
+    // XXX for now create new cam object
+    // YYY why?
+    if (ospray_camera != nullptr)
+        ospRelease(ospray_camera);
+
+    switch (camera_settings.type())
+    {
+        case CameraSettings::PERSPECTIVE:
+            printf("... perspective\n");
+            ospray_camera = ospNewCamera("perspective");
+            ospSetFloat(ospray_camera, "fovy",  camera_settings.fov_y());  // Degrees
+            break;
+
+        case CameraSettings::ORTHOGRAPHIC:
+            printf("... orthographic\n");
+            ospray_camera = ospNewCamera("orthographic");
+            ospSetFloat(ospray_camera, "height", camera_settings.height());
+            break;
+
+        case CameraSettings::PANORAMIC:
+            printf("... panoramic\n");
+            ospray_camera = ospNewCamera("panoramic");
+            break;
+
+        default:
+            fprintf(stderr, "WARNING: unknown camera type %d\n", camera_settings.type());
+            break;
+    }
+
+    ospSetFloat(ospray_camera, "aspect", camera_settings.aspect());        // XXX perspective only
+    ospSetFloat(ospray_camera, "nearClip", camera_settings.clip_start());
+
+    ospSetParam(ospray_camera, "position", OSP_VEC3F, cam_pos);
+    ospSetParam(ospray_camera, "direction", OSP_VEC3F, cam_viewdir);
+    ospSetParam(ospray_camera, "up",  OSP_VEC3F, cam_updir);
+
+    if (camera_settings.dof_focus_distance() > 0.0f)
+    {
+        // XXX seem to stuck in loop during rendering when distance is 0
+        ospSetFloat(ospray_camera, "focusDistance", camera_settings.dof_focus_distance());
+        ospSetFloat(ospray_camera, "apertureRadius", camera_settings.dof_aperture());
+    }
+
+    if (camera_settings.border_size() == 4)
+    {
+        // Border render enabled
+        ospSetVec2f(ospray_camera, "imageStart", camera_settings.border(0), camera_settings.border(1));
+        ospSetVec2f(ospray_camera, "imageEnd", camera_settings.border(2), camera_settings.border(3));
+    }    
+
+    ospCommit(ospray_camera);
+}
+
+// Makes material refer to the material of the given OSPRay type with the
+// given settings. Returns the material whose parameters need to be set 
+// (and committed), i.e. a new one or material itself when it isn't shared
+// with other scene materials and can be changed in place. Returns nullptr 
+// if an identical material already exists, which material then refers to.
+OSPMaterial
+select_material(SharedMaterial& material, const char *type, const google::protobuf::Message& settings)
+{
+    const std::string prefix = current_renderer_type + ":" + type + ":";
+    const std::string key = prefix + get_sha1(settings.SerializeAsString());
+
+    if (material != nullptr && material->key == key)
+    {
+        printf("... Material unchanged\n");
+        return nullptr;
+    }
+
+    SharedMaterial existing = materials.find(key);
+
+    if (existing != nullptr)
+    {
+        printf("... Using existing identical material\n");
+        material = existing;
+        return nullptr;
+    }
+
+    if (material != nullptr && material->key.compare(0, prefix.size(), prefix) == 0 
+        && materials.rekey(material, key))
+        return material->object;
+
+    material = materials.add(key, ospNewMaterial(current_renderer_type.c_str(), type));
+
+    return material->object;
+}
+
+// Sets a scene material's (new) OSPRay material on the objects linked to it
+void
+update_material_users(const std::string& name, OSPMaterial material)
+{
+    for (auto& kv : scene_objects)
+    {
+        SceneObject *object = kv.second;
+
+        if (object->material_link != name)
+            continue;
+
+        OSPGeometricModel gmodel;
+        OSPGroup group;
+        OSPInstance instance;
+
+        if (object->type == SOT_MESH)
+        {
+            SceneObjectMesh *mesh_object = dynamic_cast<SceneObjectMesh*>(object);
+            gmodel = mesh_object->gmodel;
+            group = mesh_object->group;
+            instance = mesh_object->instance;
+        }
+        else if (object->type == SOT_GEOMETRY)
+        {
+            SceneObjectGeometry *geometry_object = dynamic_cast<SceneObjectGeometry*>(object);
+            gmodel = geometry_object->gmodel;
+            group = geometry_object->group;
+            instance = geometry_object->instance;
+        }
+        else
+            continue;
+
+        if (gmodel == nullptr)
+            continue;
+
+        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, material);
+        ospCommit(gmodel);
+        ospCommit(group);
+        ospCommit(instance);
+
+        ospray_world_changed = true;
+    }
+}
+
+template<typename Connection>
+void
+handle_update_material(Connection *sock)
+{
+    MaterialUpdate update;
+
+    receive_protobuf(sock, update);
+
+    printf("MATERIAL '%s'\n", update.name().c_str());
+
+    // Objects using the material need a world commit to pick up changes
+    ospray_world_changed = true;
+
+    SceneMaterial *scene_material;
+    OSPMaterial material = nullptr;
+
+    SceneMaterialMap::iterator it = scene_materials.find(update.name());
+    if (it != scene_materials.end())
+    {
+        printf("... Updating existing material\n");
+        scene_material = it->second;
+    }
+    else
+        scene_material = new SceneMaterial;
+
+    // To detect a change of OSPRay material (not just its parameters)
+    const SharedObject<OSPMaterial> *previous_material = scene_material->material.get();
+
+    switch (update.type())
+    {
+
+    case MaterialUpdate::ALLOY:
+    {
+        AlloySettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... Alloy\n");
+
+        material = select_material(scene_material->material, "alloy", settings);
+        if (material == nullptr)
+            break;
+
+        if (settings.color_size() == 3)
+            ospSetVec3f(material, "color", settings.color(0), settings.color(1), settings.color(2));    
+        if (settings.edge_color_size() == 3)
+            ospSetVec3f(material, "edgeColor", settings.edge_color(0), settings.edge_color(1), settings.edge_color(2));    
+        ospSetFloat(material, "roughness", settings.roughness());
+
+        break;
+    }
+
+    case MaterialUpdate::CAR_PAINT:
+    {
+        CarPaintSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... Car paint\n");
+
+        material = select_material(scene_material->material, "carPaint", settings);
+        if (material == nullptr)
+            break;
+
+        if (settings.base_color_size() == 3)
+            ospSetVec3f(material, "baseColor", settings.base_color(0), settings.base_color(1), settings.base_color(2));    
+        ospSetFloat(material, "roughness", settings.roughness());
+        ospSetFloat(material, "normal", settings.normal());
+        ospSetFloat(material, "flakeDensity", settings.flake_density());    
+        ospSetFloat(material, "flakeScale", settings.flake_scale());    
+        ospSetFloat(material, "flakeSpread", settings.flake_spread());    
+        ospSetFloat(material, "flakeJitter", settings.flake_jitter());    
+        ospSetFloat(material, "flakeRoughness", settings.flake_roughness());
+        ospSetFloat(material, "coat", settings.coat());
+        ospSetFloat(material, "coatIor", settings.coat_ior());
+        if (settings.coat_color_size() == 3)
+            ospSetVec3f(material, "coatColor", settings.coat_color(0), settings.coat_color(1), settings.coat_color(2)); 
+        ospSetFloat(material, "coatThickness", settings.coat_thickness());
+        ospSetFloat(material, "coatRoughness", settings.coat_roughness());
+        ospSetFloat(material, "coatNormal", settings.coat_normal());
+        if (settings.flipflop_color_size() == 3)
+            ospSetVec3f(material, "flipflopColor", settings.flipflop_color(0), settings.flipflop_color(1), settings.flipflop_color(2)); 
+        ospSetFloat(material, "flipflopFalloff", settings.flipflop_falloff());
+
+        break;        
+    }
+
+    case MaterialUpdate::GLASS:
+    {
+        GlassSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... Glass\n");
+
+        material = select_material(scene_material->material, "glass", settings);
+        if (material == nullptr)
+            break;
+
+        ospSetFloat(material, "eta", settings.eta());
+        if (settings.attenuation_color_size() == 3)
+            ospSetVec3f(material, "attenuationColor", settings.attenuation_color(0), settings.attenuation_color(1), settings.attenuation_color(2));        
+        ospSetFloat(material, "attenuationDistance", settings.attenuation_distance());
+
+        break;
+    }
+
+    case MaterialUpdate::THIN_GLASS:
+    {
+        ThinGlassSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... ThinGlass\n");
+
+        material = select_material(scene_material->material, "thinGlass", settings);
+        if (material == nullptr)
+            break;
+
+        ospSetFloat(material, "eta", settings.eta());
+        if (settings.attenuation_color_size() == 3)
+            ospSetVec3f(material, "attenuationColor", settings.attenuation_color(0), settings.attenuation_color(1), settings.attenuation_color(2));        
+        ospSetFloat(material, "attenuationDistance", settings.attenuation_distance());
+        ospSetFloat(material, "thickness", settings.thickness());
+
+        break;
+    }
+
+    case MaterialUpdate::LUMINOUS:
+    {
+        LuminousSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... Luminous\n");
+
+        material = select_material(scene_material->material, "luminous", settings);
+        if (material == nullptr)
+            break;
+
+        if (settings.color_size() == 3)
+            ospSetVec3f(material, "color", settings.color(0), settings.color(1), settings.color(2));    
+        ospSetFloat(material, "intensity", settings.intensity());    
+        ospSetFloat(material, "transparency", settings.transparency());
+
+        break;
+    }
+
+    case MaterialUpdate::METAL:
+    {
+        MetalSettings settings;
+
+        receive_protobuf(sock, settings);  
+
+        const uint32_t& metal = settings.metal();
+
+        printf("... Metal (%d)\n", metal);
+
+        assert(metal < 5);
+
+        material = select_material(scene_material->material, "metal", settings);
+        if (material == nullptr)
+            break;
+
+        const float metal_eta_values[] = {
+            1.5f, 0.98f, 0.6f,      // Aluminium
+            3.2f, 3.1f, 2.3f,       // Chromium
+            0.1f, 0.8f, 1.1f,       // Copper
+            0.07f, 0.37f, 1.5f,     // Gold
+            0.051f, 0.043f, 0.041f  // Silver
+        };
+
+        const float metal_k_values[] = {
+            7.6f, 6.6f, 5.4f,       // Aluminium
+            3.3f, 3.3f, 3.1f,       // Chromium
+            3.5f, 2.5f, 2.4f,       // Copper
+            3.7f, 2.3f, 1.7f,       // Gold
+            5.3f, 3.6f, 2.3f,       // Silver
+        };
+        
+        const float *eta = metal_eta_values + 3*metal;
+        const float *k = metal_k_values + 3*metal;
+
+        ospSetVec3f(material, "eta", eta[0], eta[1], eta[2]);
+        ospSetVec3f(material, "k", k[0], k[1], k[2]);
+        ospSetFloat(material, "roughness", settings.roughness());  
+        ospCommit(material);
+
+        break;
+    }    
+
+    case MaterialUpdate::METALLIC_PAINT:
+    {
+        MetallicPaintSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... MetallicPaint\n");
+
+        material = select_material(scene_material->material, "metallicPaint", settings);
+        if (material == nullptr)
+            break;
+
+        if (settings.base_color_size() == 3)
+            ospSetVec3f(material, "baseColor", settings.base_color(0), settings.base_color(1), settings.base_color(2));    
+        if (settings.flake_color_size() == 3)
+            ospSetVec3f(material, "flakeColor", settings.flake_color(0), settings.flake_color(1), settings.flake_color(2));   
+        ospSetFloat(material, "flakeAmount", settings.flake_amount());    
+        ospSetFloat(material, "flakeSpread", settings.flake_spread());    
+        ospSetFloat(material, "eta", settings.eta());
+
+        break;
+    }
+
+    case MaterialUpdate::OBJMATERIAL:       // XXX rename to obj
+    {
+        OBJMaterialSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... OBJMaterial (kd %.3f,%.3f,%.3f; ...)\n", settings.kd(0), settings.kd(1), settings.kd(2));
+
+        material = select_material(scene_material->material, "obj", settings);
+        if (material == nullptr)
+            break;
+
+        if (settings.kd_size() == 3)
+            ospSetVec3f(material, "kd", settings.kd(0), settings.kd(1), settings.kd(2));
+        if (settings.ks_size() == 3)
+            ospSetVec3f(material, "ks", settings.ks(0), settings.ks(1), settings.ks(2));
+        ospSetFloat(material, "ns", settings.ns());
+        ospSetFloat(material, "d", settings.d());            
+
+        break;
+    }
+
+    case MaterialUpdate::PRINCIPLED:
+    {
+        PrincipledSettings settings;
+
+        receive_protobuf(sock, settings);
+        printf("... Principled\n");
+
+        material = select_material(scene_material->material, "principled", settings);
+        if (material == nullptr)
+            break;
+
+        if (settings.base_color_size() == 3)
+            ospSetVec3f(material, "baseColor", settings.base_color(0), settings.base_color(1), settings.base_color(2));    
+        if (settings.edge_color_size() == 3)
+            ospSetVec3f(material, "edgeColor", settings.edge_color(0), settings.edge_color(1), settings.edge_color(2)); 
+        ospSetFloat(material, "metallic", settings.metallic());    
+        ospSetFloat(material, "diffuse", settings.diffuse());    
+        ospSetFloat(material, "specular", settings.specular());
+        ospSetFloat(material, "ior", settings.ior());
+        ospSetFloat(material, "transmission", settings.transmission());
+        if (settings.transmission_color_size() == 3)
+            ospSetVec3f(material, "transmissionColor", settings.transmission_color(0), settings.transmission_color(1), settings.transmission_color(2)); 
+        ospSetFloat(material, "transmissionDepth", settings.transmission_depth());
+        ospSetFloat(material, "roughness", settings.roughness());
+        ospSetFloat(material, "anisotropy", settings.anisotropy());
+        ospSetFloat(material, "rotation", settings.rotation());
+        ospSetFloat(material, "normal", settings.normal());
+        ospSetFloat(material, "baseNormal", settings.base_normal());
+        ospSetBool(material, "thin", settings.thin());
+        ospSetFloat(material, "thickness", settings.thickness());
+        ospSetFloat(material, "backlight", settings.backlight());
+        ospSetFloat(material, "coat", settings.coat());
+        ospSetFloat(material, "coatIor", settings.coat_ior());
+        if (settings.coat_color_size() == 3)
+            ospSetVec3f(material, "coatColor", settings.coat_color(0), settings.coat_color(1), settings.coat_color(2)); 
+        ospSetFloat(material, "coatThickness", settings.coat_thickness());
+        ospSetFloat(material, "coatRoughness", settings.coat_roughness());
+        ospSetFloat(material, "coatNormal", settings.coat_normal());
+        ospSetFloat(material, "sheen", settings.sheen());
+        if (settings.sheen_color_size() == 3)
+            ospSetVec3f(material, "sheenColor", settings.sheen_color(0), settings.sheen_color(1), settings.sheen_color(2)); 
+        ospSetFloat(material, "sheenTint", settings.sheen_tint());
+        ospSetFloat(material, "sheenRoughness", settings.sheen_roughness());
+        ospSetFloat(material, "opacity", settings.opacity());
+
+        break;
+    }
+
+    default:
+        printf("ERROR: unknown material update type %d!\n", update.type());
+        if (it == scene_materials.end())
+            delete scene_material;
+        return;
+
+    }
+
+    if (material != nullptr)
+        ospCommit(material);
+
+    scene_material->type = update.type();
+    scene_materials[update.name()] = scene_material;
+
+    if (scene_material->material.get() != previous_material)
+        update_material_users(update.name(), scene_material->material->object);
+}
+
+void
+update_renderer_type(const std::string& type)
+{
+    if (type == current_renderer_type)
+        return;
+
+    printf("Updating renderer type to '%s'\n", type.c_str());
+
+    ospray_renderer = renderers[type.c_str()];
 
-    ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
-    ospCommit(instance);
+    // Materials are renderer-specific
+    for (auto& sm : scene_materials)
+        delete sm.second;
+    scene_materials.clear();
+    // XXX any more?
 
-    ospCommit(gmodel);
-    ospCommit(group);
+    current_renderer_type = type;
+}
 
-    if (scene_object == nullptr)
-        scene_objects[object_name] = isosurfaces_object;
+bool
+update_render_settings(const RenderSettings& render_settings)
+{
+    printf("Applying render settings\n");
+
+    //ospSetInt(renderer, "spp", 1);
+
+    ospSetInt(ospray_renderer, "maxPathLength", render_settings.max_path_length());
+    ospSetFloat(ospray_renderer, "minContribution", render_settings.min_contribution());
+    ospSetFloat(ospray_renderer, "varianceThreshold", render_settings.variance_threshold());
+    renderer_variance_threshold = render_settings.variance_threshold();
+
+    if (current_renderer_type == "scivis")
+    {
+        ospSetInt(ospray_renderer, "aoSamples", render_settings.ao_samples());
+        ospSetFloat(ospray_renderer, "aoRadius", render_settings.ao_radius());
+        ospSetFloat(ospray_renderer, "aoIntensity", render_settings.ao_intensity());
+        ospSetFloat(ospray_renderer, "volumeSamplingRate", render_settings.volume_sampling_rate());
+    }
+    else
+    {
+        // Pathtracer
+
+        ospSetInt(ospray_renderer, "roulettePathLength", render_settings.roulette_path_length());
+        ospSetFloat(ospray_renderer, "maxContribution", render_settings.max_contribution());
+        ospSetBool(ospray_renderer, "geometryLights", render_settings.geometry_lights());
+    }
+
+    ospCommit(ospray_renderer);
+
+    denoise_interactive_interval = render_settings.denoise_interactive_interval();
+    denoise_final = render_settings.denoise_final();
+
+    if ((denoise_interactive_interval > 0 || denoise_final) && denoiser == nullptr)
+        printf("... WARNING: denoising requested, but no denoiser available\n");
+
+    // Done!
 
-    ospray_scene_instances.push_back(instance);
-    update_ospray_scene_instances = true;
-    
     return true;
 }
 
-// A slices object is just regular geometry that gets colored 
-// using a volume texture
-// XXX parenting can be animated using a Childof object constraint
-// XXX a text field in a node can't be animated
 bool
-add_slice_objects(const UpdateObject& update, const Slices& slices)
+update_world_settings(const WorldSettings& world_settings)
+{    
+    printf("Updating world settings\n");
+
+    printf("... ambient color %.3f, %.3f, %.3f; intensity %.3f\n", 
+        world_settings.ambient_color(0), 
+        world_settings.ambient_color(1), 
+        world_settings.ambient_color(2), 
+        world_settings.ambient_intensity());
+
+    ospSetVec3f(ospray_scene_ambient_light, "color", world_settings.ambient_color(0), world_settings.ambient_color(1), world_settings.ambient_color(2));
+    ospSetFloat(ospray_scene_ambient_light, "intensity", world_settings.ambient_intensity());
+    ospCommit(ospray_scene_ambient_light);
+    ospray_world_changed = true;
+
+    printf("... background color %f, %f, %f, %f\n", 
+        world_settings.background_color(0),
+        world_settings.background_color(1),
+        world_settings.background_color(2),
+        world_settings.background_color(3));    
+
+    ospSetVec4f(ospray_renderer, "backgroundColor",
+        world_settings.background_color(0),
+        world_settings.background_color(1),
+        world_settings.background_color(2),
+        world_settings.background_color(3));
+
+    ospCommit(ospray_renderer);
+
+    return true;
+}
+
+/*
+// Send result
+
+size_t
+write_framebuffer_exr(OSPFrameBuffer framebuffer, const char *fname)
 {
-    const std::string& linked_data = update.data_link();
+    // Access framebuffer
+    const float *color = (float*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
 
-    printf("OBJECT '%s' (slices)\n", update.name().c_str());
-    printf("--> '%s'\n", linked_data.c_str());    
+    writeFramebufferEXR(fname, framebuffer_width, framebuffer_height, framebuffer_compression, color);
 
-    if (!scene_data_with_type_exists(linked_data, SDT_PLUGIN))
-        return false;
+    // Unmap framebuffer
+    ospUnmapFrameBuffer(color, framebuffer);
 
-    PluginInstance* plugin_instance = plugin_instances[linked_data];
-    assert(plugin_instance->type == PT_VOLUME);
-    PluginState *state = plugin_instance->state;
+    struct stat st;
+    stat(fname, &st);
 
-    OSPVolume volume = state->volume;
+    return st.st_size;
+}
+
+// Not used atm, as we use sendfile()
+void
+send_framebuffer(TCPSocket *sock)
+{
+    uint32_t bufsize;
+
+    struct timeval t0, t1;
+    gettimeofday(&t0, NULL);
+
+    // Access framebuffer
+    const float *fb = (float*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+
+#if 1
+    // Write to OpenEXR file and send *its* contents
+    const char *FBFILE = "/dev/shm/orsfb.exr";
+
+    // XXX this also maps/unmaps the framebuffer!
+    size_t size = write_framebuffer_exr(FBFILE);
+
+    printf("Sending framebuffer as OpenEXR file, %d bytes\n", size);
+
+    bufsize = size;
+    sock->send((uint8_t*)&bufsize, 4);
+    sock->sendfile(FBFILE);
+#else
+    // Send directly
+    bufsize = framebuffer_width*framebuffer_height*4*4;
+
+    printf("Sending %d bytes of framebuffer data\n", bufsize);
+
+    sock->send(&bufsize, 4);
+    sock->sendall((uint8_t*)fb, framebuffer_width*framebuffer_height*4*4);
+#endif
+
+    // XXX can already unmap after written to file
+    // Unmap framebuffer
+    ospUnmapFrameBuffer(fb, framebuffer);
+
+    gettimeofday(&t1, NULL);
+    printf("Sent framebuffer in %.3f seconds\n", time_diff(t0, t1));
+}
+*/
+
+// Querying
+
+// Returns the requested generated level (BOUND_COARSE or BOUND_FINE) of
+// the bound, waiting for it to be generated if needed. Called with 
+// server_mutex held, which is released while waiting. The returned mesh
+// is kept alive by levels. Returns nullptr if the level isn't available
+// (e.g. generating it was stopped), the caller then falls back to the 
+// plugin's bound.
+const BoundingMesh*
+get_bound_level(BoundLevelsPtr levels, BoundLevel level)
+{
+    BoundingMesh *BoundLevels::*member = level == BOUND_FINE ? &BoundLevels::fine : &BoundLevels::coarse;
 
-    if (volume == nullptr)
     {
-        printf("... ERROR: volume is NULL!\n");
-        return false;
-    }        
+        std::unique_lock<std::mutex> lock(levels->mutex);
+        if (levels.get()->*member != nullptr || levels->done)
+            return levels.get()->*member;
+    }
 
-    const char *s_custom_properties = update.custom_properties().c_str();
-    //printf("Received custom properties:\n%s\n", s_custom_properties);
-    const json &custom_properties = json::parse(s_custom_properties);
-    if (!custom_properties.empty())
+    printf("... Waiting for bound level %d to be generated\n", level);
+
+    // Never wait for server_mutex while holding the levels' mutex, as
+    // another session might hold server_mutex and want the levels' mutex
+    server_mutex.unlock();
     {
-        printf("... custom properties:\n");
-        printf("%s\n", custom_properties.dump(4).c_str());
+        std::unique_lock<std::mutex> lock(levels->mutex);
+        while (levels.get()->*member == nullptr && !levels->done)
+            levels->generated.wait(lock);
     }
+    server_mutex.lock();
 
-    SceneObject         *scene_object;
-    SceneObjectSlice    *slice_object;
-    OSPGroup            group;
-    OSPVolumetricModel  vmodel;
-    OSPGeometricModel   gmodel;
-    OSPInstance         instance;
+    std::unique_lock<std::mutex> lock(levels->mutex);
+    return levels.get()->*member;
+}
 
-    // Each slice becomes a separate scene object of type SOT_SLICE
-    for (int i = 0; i < slices.slices_size(); i++)
+// QUERY_BOUND: the bound is sent as BoundingMesh::serialize()'d data,
+// optionally compressed with LZ4 or Zstandard
+bool
+handle_query_bound(TCPSocket *sock, const ClientMessage& client_message)
+{
+    const std::string& name = client_message.string_value();
+    BoundLevel level = (BoundLevel)client_message.uint_value();
+    const uint32_t accepted_encoding = client_message.uint_value2();
+
+    QueryBoundResult result;
+    char msg[1024];
+
+    wait_for_plugin_instance(name);
+
+    PluginStateMap::const_iterator it = plugin_state.find(name);
+
+    if (it == plugin_state.end())
     {
-        const Slice& slice = slices.slices(i);
+        sprintf(msg, "No plugin state for id '%s'", name.c_str());
 
-        const std::string& object_name = slice.name();
-        const std::string& linked_mesh = slice.mesh_link();
+        result.set_success(false);
+        result.set_message(msg);
 
-        // Get linked geometry
+        printf("... FAILED: %s\n", msg);
 
-        printf("... linked mesh '%s' (blender mesh)\n", linked_mesh.c_str());    
+        send_protobuf(sock, result);
 
-        SceneDataTypeMap::iterator it = scene_data_types.find(linked_mesh);
+        return false;
+    }
 
-        if (it == scene_data_types.end())
-        {
-            printf("--> '%s' | WARNING: linked data not found!\n", linked_mesh.c_str());
-            return false;
-        }
-        else if (it->second != SDT_BLENDER_MESH)
+    const PluginState *state = it->second;
+
+    const BoundingMesh *bound = state->bound;
+
+    if (bound == nullptr)
+    {
+        sprintf(msg, "No bound specified");
+
+        result.set_success(false);
+        result.set_message(msg);
+
+        printf("... FAILED: %s\n", msg);
+
+        send_protobuf(sock, result);
+
+        return true;
+    }
+
+    if (level > BOUND_FINE)
+        level = BOUND_DEFAULT;
+
+    // Hold on to the levels, as the state might get deleted by 
+    // another session while we wait
+    BoundLevelsPtr levels;
+
+    PluginInstanceMap::const_iterator pi = plugin_instances.find(name);
+    if (pi != plugin_instances.end())
+    {
+        std::map<std::string, SharedPluginState>::const_iterator shared = shared_plugin_states.find(pi->second->shared_state_key);
+        if (shared != shared_plugin_states.end())
+            levels = shared->second.bound_levels;
+    }
+
+    BoundingMesh *bbox = nullptr;
+    const BoundingMesh *selected = nullptr;
+
+    if (level == BOUND_BBOX)
+        selected = bbox = BoundingMesh::bbox_from_vertices(bound->vertices.data(), bound->vertices.size()/3, true);
+    else if (levels != nullptr)
+    {
+        if (level == BOUND_DEFAULT)
+            level = BOUND_COARSE;
+
+        // Might release server_mutex, so bound can't be used after this
+        selected = get_bound_level(levels, level);
+
+        if (selected == nullptr)
         {
-            printf("--> '%s' | WARNING: linked data is not of type SDT_BLENDER_MESH but of type %s!\n", 
-                linked_mesh.c_str(), SceneDataType_names[it->second]);
-            return false;
+            it = plugin_state.find(name);
+
+            if (it == plugin_state.end() || it->second->bound == nullptr)
+            {
+                sprintf(msg, "Plugin state for id '%s' went away", name.c_str());
+
+                result.set_success(false);
+                result.set_message(msg);
+
+                printf("... FAILED: %s\n", msg);
+
+                send_protobuf(sock, result);
+
+                return false;
+            }
+
+            bound = it->second->bound;
         }
-        else
-            printf("--> '%s' (blender mesh data)\n", linked_mesh.c_str());
+    }
 
-        BlenderMesh *blender_mesh = blender_meshes[linked_mesh];
-        OSPGeometry geometry = blender_mesh->geometry;
+    if (selected == nullptr)
+    {
+        // No (generated) levels, the plugin's bound is all we have
+        level = BOUND_DEFAULT;
+        selected = bound;
+    }
 
-        if (geometry == nullptr)
-        {
-            printf("... ERROR: geometry of blender mesh is NULL!\n");
-            return false;
-        }                    
+    // Serialize directly into the buffer sent, unless compressing
 
-        // Update/create scene object
+    const uint32_t size = selected->serialized_size();
+    std::vector<uint8_t> buffer(size);
+    selected->serialize(buffer.data());
+
+    delete bbox;
 
-        scene_object = find_scene_object(object_name, SOT_SLICE);
+    uint32_t encoding = RenderResult::RAW;
+    std::vector<uint8_t> compressed;
 
-        if (scene_object != nullptr)
-            slice_object = dynamic_cast<SceneObjectSlice*>(scene_object);
-        else
-            slice_object = new SceneObjectSlice;
+#ifdef FRAMEBUFFER_LZ4
+    if (accepted_encoding & RenderResult::LZ4)
+    {
+        compressed.resize(LZ4_compressBound(size));
 
-        instance = slice_object->instance;
-        assert(instance != nullptr);
-        group = slice_object->group;
-        assert(group != nullptr); 
-        vmodel = slice_object->vmodel;
-        gmodel = slice_object->gmodel;
-        assert(gmodel != nullptr);
-        slice_object->slice_geometry = geometry;
+        const int n = LZ4_compress_default((const char*)buffer.data(), (char*)compressed.data(), size, compressed.size());
 
-        // Set up slice geometry
+        if (n > 0)
+        {
+            compressed.resize(n);
+            encoding = RenderResult::LZ4;
+        }
+    }
+#endif
 
-        // XXX temp inserted volumetric model
-        if (vmodel == nullptr)
-            vmodel = slice_object->vmodel = ospNewVolumetricModel(volume);
-            
-        OSPTransferFunction tf = create_transfer_function("cool2warm", state->volume_data_range[0], state->volume_data_range[1]);
-        ospSetObject(vmodel, "transferFunction", tf);            
-        ospCommit(vmodel);
-        ospRelease(tf);
-    
-        OSPTexture volume_texture = ospNewTexture("volume");
-            ospSetObject(volume_texture, "volume", vmodel);   // XXX volume model, not volume
-        ospCommit(volume_texture);
+#ifdef FRAMEBUFFER_ZSTD
+    if (encoding == RenderResult::RAW && (accepted_encoding & RenderResult::ZSTD))
+    {
+        compressed.resize(ZSTD_compressBound(size));
 
-        OSPMaterial material = ospNewMaterial(current_renderer_type.c_str(), "default");
-            ospSetObject(material, "map_Kd", volume_texture);
-        ospCommit(material);
-        ospRelease(volume_texture);        
+        const size_t n = ZSTD_compress(compressed.data(), compressed.size(), buffer.data(), size, 1);
 
-        ospSetObjectAsData(gmodel, "material", OSP_MATERIAL, material);
-        ospCommit(gmodel);
-        ospRelease(material);
+        if (!ZSTD_isError(n))
+        {
+            compressed.resize(n);
+            encoding = RenderResult::ZSTD;
+        }
+    }
+#endif
 
-        ospCommit(group);
-     
-        glm::mat4   obj2world;
-        float       affine_xform[12];
+    const std::vector<uint8_t>& data = encoding == RenderResult::RAW ? buffer : compressed;
 
-        object2world_from_protobuf(obj2world, slice);
-        affine3fv_from_mat4(affine_xform, obj2world);
-        
-        ospSetParam(instance, "xfm", OSP_AFFINE3F, affine_xform);
-        ospCommit(instance);        
+    printf("... Sending bound level %d (%d vertices), %d bytes (%d uncompressed)\n", 
+        level, (int)(selected->vertices.size()/3), (int)data.size(), size);
 
-        if (scene_object == nullptr)
-            scene_objects[object_name] = slice_object;
+    result.set_success(true);
+    result.set_result_size(data.size());
+    result.set_uncompressed_size(size);
+    result.set_encoding(encoding);
+    result.set_level_of_detail(level);
 
-        ospray_scene_instances.push_back(instance);
-        update_ospray_scene_instances = true;
-    }
+    send_protobuf(sock, result);
+    sock->sendall(data.data(), data.size());
 
     return true;
 }
 
 bool
-update_light_object(const UpdateObject& update, const LightSettings& light_settings)
+clear_scene(const std::string& type)
 {
-    const std::string& object_name = light_settings.object_name();
-    //const std::string& linked_data = light_settings.light_name();    
-
-    printf("OBJECT '%s' (light)\n", object_name.c_str());
-    //printf("--> '%s' (blender light data)\n", linked_data.c_str());    // XXX not set for ambient
+    printf("Clearing scene\n");
+    printf("... type: %s\n", type.c_str());
+        
+    if (ospray_world != nullptr)
+        ospRelease(ospray_world);
+    
+    ospray_world = ospNewWorld();    
+    //ospSetBool(ospray_world, "compactMode", true);
 
-    SceneObject *scene_object;
-    SceneObjectLight *light_object = nullptr;
-    OSPLight light;
-    LightSettings::Type light_type;    
+    if (ospray_scene_instances_data != nullptr)
+        ospRelease(ospray_scene_instances_data);
+        
+    if (ospray_scene_lights_data != nullptr)
+        ospRelease(ospray_scene_lights_data);   
 
-    scene_object = find_scene_object(object_name, SOT_LIGHT);
+    ospray_scene_instances.clear();
+    ospray_scene_instances_data = nullptr;
+    update_ospray_scene_instances = true;
 
-    if (scene_object != nullptr)
-    {
-        // Check existing light
-        light_object = dynamic_cast<SceneObjectLight*>(scene_object);
-        
-        light = light_object->light;
-        assert(light != nullptr);
-        
-        light_type = light_object->light_type;
+    ospray_scene_lights.clear();
+    ospray_scene_lights.push_back(ospray_scene_ambient_light);
+    ospray_scene_lights_data = nullptr;
+    update_ospray_scene_lights = true;
 
-        if (light_type != light_settings.type())
-        {            
-            printf("... Light type changed from %d to %d, replacing with new light\n",
-                light_type, light_settings.type());
+    ospray_world_changed = true;
 
-            delete_object(object_name);                    
+    for (auto& so : scene_objects)
+        delete so.second;
+    scene_objects.clear();
 
-            auto it = std::find(ospray_scene_lights.begin(), ospray_scene_lights.end(), light);
-            ospray_scene_lights.erase(it);
-            update_ospray_scene_lights = true;
-            
-            light_object = nullptr;
-        }
-    }
-    
-    if (light_object == nullptr)
-    {            
-        light_type = light_settings.type();
-        printf("... Creating new light of type %d\n", light_type);
+    if (type == "keep_plugin_instances")
+    {
+        std::set<std::string> data_to_delete;
 
-        light_object = new SceneObjectLight;
-        switch (light_type)
+        for (auto& kv : scene_data_types)
         {
-        /*case LightSettings::AMBIENT:
-            light = ospNewLight("ambient");
-            break;*/
-        case LightSettings::POINT:
-            light = ospNewLight("sphere");
-            break; 
-        case LightSettings::SPOT:
-            light = ospNewLight("spot");
-            break; 
-        case LightSettings::SUN:
-            light = ospNewLight("distant");
-            break; 
-        case  LightSettings::AREA:
-            light = ospNewLight("quad");
-            break; 
-        default:
-            printf("ERROR: unhandled light type %d!\n", light_type);
+            if (kv.second != SDT_PLUGIN)
+                data_to_delete.insert(kv.first);
         }
 
-        light_object->light = light;
-        light_object->light_type = light_type;
-        light_object->data_link = light_settings.light_name();
-
-        scene_objects[object_name] = light_object;    
-
-        ospray_scene_lights.push_back(light);    
-        update_ospray_scene_lights = true;
-    }
+        for (auto& name : data_to_delete)
+            delete_scene_data(name);
 
-    if (light_settings.type() == LightSettings::SPOT)
-    {
-        ospSetFloat(light, "openingAngle", light_settings.opening_angle());
-        ospSetFloat(light, "penumbraAngle", light_settings.penumbra_angle());
+        // The kept instances are no longer referenced
+        enforce_memory_budget();
     }
-    else if (light_settings.type() == LightSettings::SUN)
+    else
     {
-        ospSetFloat(light, "angularDiameter", light_settings.angular_diameter());
+        // "all"
+        delete_all_scene_data();    
     }
-    else if (light_settings.type() == LightSettings::AREA)
+
+    for (auto& sm : scene_materials)
+        delete sm.second;
+    scene_materials.clear();
+
+    return true;
+}
+
+// Distributed mode: sets the world's regions (i.e. the part of space this
+// rank renders) to the world-space bounds of the domains of the local 
+// plugin instances. When there's other local data (e.g. Blender meshes, 
+// which only live on rank 0) no regions are set, in which case OSPRay 
+// uses the bounds of all local data.
+void
+set_world_regions()
+{
+    std::vector<float> regions;
+    bool other_data = false;
+
+    for (auto& kv : scene_objects)
     {
-        // XXX blender's area light is more general than ospray's quad light
-        ospSetVec3f(light, "edge1", light_settings.edge1(0), light_settings.edge1(1), light_settings.edge1(2));
-        ospSetVec3f(light, "edge2", light_settings.edge2(0), light_settings.edge2(1), light_settings.edge2(2));
-    }
-    //else
-    // XXX HDRI
+        const SceneObject *so = kv.second;
 
-    printf("... intensity %.3f, visible %d\n", light_settings.intensity(), light_settings.visible());
+        if (so->type == SOT_LIGHT)
+            continue;
 
-    ospSetVec3f(light, "color", light_settings.color(0), light_settings.color(1), light_settings.color(2));
-    ospSetFloat(light, "intensity", light_settings.intensity());
-    ospSetBool(light, "visible", light_settings.visible());
+        PluginInstanceMap::iterator it = plugin_instances.find(so->data_link);
 
-    if (light_settings.type() != LightSettings::SUN && light_settings.type() != LightSettings::AMBIENT)
-        ospSetVec3f(light, "position", light_settings.position(0), light_settings.position(1), light_settings.position(2));
+        if (it == plugin_instances.end() || it->second->state == nullptr || !it->second->state->has_domain_bounds)
+        {
+            other_data = true;
+            continue;
+        }
 
-    if (light_settings.type() == LightSettings::SUN || light_settings.type() == LightSettings::SPOT)
-        ospSetVec3f(light, "direction", light_settings.direction(0), light_settings.direction(1), light_settings.direction(2));
+        const float *b = it->second->state->domain_bounds;
 
-    if (light_settings.type() == LightSettings::POINT || light_settings.type() == LightSettings::SPOT)
-        ospSetFloat(light, "radius", light_settings.radius());
+        glm::vec3 lo(std::numeric_limits<float>::max()), hi(std::numeric_limits<float>::lowest());
 
-    ospCommit(light);  
+        for (int c = 0; c < 8; c++)
+        {
+            const glm::vec4 corner(b[c & 1 ? 3 : 0], b[c & 2 ? 4 : 1], b[c & 4 ? 5 : 2], 1.0f);
+            const glm::vec3 p = glm::vec3(so->object2world * corner);
 
-    return true;
-}
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
 
-// XXX add world/object bounds
-void
-get_server_state(json& j)
-{    
-    json p;
+        regions.insert(regions.end(), { lo.x, lo.y, lo.z, hi.x, hi.y, hi.z });
+    }
 
-    p = {};
-    for (auto& kv: scene_objects)
+    if (other_data || regions.empty())
     {
-        const SceneObject* object = kv.second;
-        p[kv.first] = { {"type", SceneObjectType_names[object->type]}, {"data_link", object->data_link} };
+        // XXX data on different ranks that overlaps gets composited incorrectly
+        printf("Rank %d: using bounds of local data as region\n", mpi_rank);
+        ospRemoveParam(ospray_world, "regions");
+        return;
     }
-    j["scene_objects"] = p;
 
-    p = {};
-    for (auto& kv: scene_materials)
-        p[kv.first] = (size_t)kv.second;
-    j["scene_materials"] = p;        
+    printf("Rank %d: %d region(s) from plugin domains\n", mpi_rank, (int)regions.size()/6);
 
-    p = {};
-    for (auto& kv: plugin_instances)
-    {
-        const PluginInstance *instance = kv.second;
-        const PluginState *state = instance->state;
+    OSPData regions_data = ospNewCopiedData(regions.size()/6, OSP_BOX3F, regions.data());
+    ospCommit(regions_data);
+    ospSetObject(ospray_world, "regions", regions_data);
+    ospRelease(regions_data);
+}
 
-        json ll;
-        for (auto& l : state->lights)
-            ll.push_back((size_t)l);
+// Commits the world, after changes to (the objects in) it
+void
+commit_world()
+{
+    ScopedTimer timer(timings, "world commit");
+    ospCommit(ospray_world);
 
-        json gi;
-        for (auto& i : state->group_instances)
-            gi.push_back({(size_t)(i.first), to_string(i.second)});
+    ospray_world_changed = false;
+}
 
-        json d = p[kv.first] = { 
-            {"name", instance->name}, 
-            {"type", PluginType_names[instance->type]},
-            {"plugin_name", instance->plugin_name},
-            {"parameters_hash", instance->parameters_hash},
-            {"custom_properties_hash", instance->custom_properties_hash},
-            {"state", {
-                {"renderer", state->renderer},
-                {"uses_renderer_type", state->uses_renderer_type},
-                {"parameters", state->parameters},
-                {"bound", (size_t)state->bound},
-                {"geometry", (size_t)state->geometry},
-                {"volume", (size_t)state->volume},
-                {"volume_data_range", { state->volume_data_range[0], state->volume_data_range[1] } },
-                {"data", (size_t)state->data},
-                {"lights", ll},
-                {"group_instances", gi}
-            } }
-        };
-    }
-    j["plugin_instances"] = p;
+bool
+prepare_scene()
+{
+    // Instances not used by any scene object might still be in progress
+    wait_for_all_plugin_instances();
 
-    p = {};
-    for (auto& kv: blender_meshes)
-    {
-        const BlenderMesh *mesh = kv.second;
-        p[kv.first] = { 
-            {"name", mesh->name}, {"parameters", mesh->parameters}, {"geometry", (size_t)mesh->geometry},
-            {"num_vertices", mesh->num_vertices}, {"num_triangles", mesh->num_triangles}
-        };
-    }
-    j["blender_meshes"] = p;
+    render_serial++;
 
-    p = {};
-    for (auto& kv: scene_data_types)
+    for (auto& kv : scene_objects)
     {
-        p[kv.first] = SceneDataType_names[kv.second];
+        const std::string& data_link = kv.second->data_link;
+
+        PluginInstanceMap::iterator pi = plugin_instances.find(data_link);
+        if (pi != plugin_instances.end())
+            pi->second->last_rendered = render_serial;
+
+        BlenderMeshMap::iterator bm = blender_meshes.find(data_link);
+        if (bm != blender_meshes.end())
+            bm->second->last_rendered = render_serial;
     }
-    j["scene_data_types"] = p;
 
-    p = {};
-    for (auto& kv: plugin_definitions)
+    enforce_memory_budget();
+
+    if (!update_ospray_scene_instances && !update_ospray_scene_lights && !ospray_world_changed)
     {
-        const PluginDefinition& pdef = kv.second;
-        p[kv.first] = { {"type", PluginType_names[pdef.type]}, {"uses_renderer_type", pdef.uses_renderer_type} };    // XXX params
+        // E.g. only the camera or render settings changed, in which case
+        // we can skip the world commit (and the BVH rebuild it causes)
+        printf("World (%d instance(s), %d light(s)) still up-to-date, not committing\n", 
+            ospray_scene_instances.size(), ospray_scene_lights.size());
+        return true;
     }
-    j["plugin_definitions"] = p;
 
-    // Scene 
+    if (update_ospray_scene_instances)
+    {
+        if (ospray_scene_instances_data != nullptr)
+            ospRelease(ospray_scene_instances_data);    
 
-    json scene;
+        printf("Setting up world with %d instance(s)\n", ospray_scene_instances.size());
 
-    p = {};
-    for (auto& i: ospray_scene_instances)
-        p.push_back((size_t)i);
-    scene["ospray_scene_instances"] = p;
+        if (ospray_scene_instances.size() > 0)
+        {
+            ospray_scene_instances_data = ospNewSharedData(&ospray_scene_instances[0], OSP_INSTANCE, ospray_scene_instances.size());
+            ospCommit(ospray_scene_instances_data);
+            ospSetObject(ospray_world, "instance", ospray_scene_instances_data);    
+            ospRetain(ospray_scene_instances_data);
+        }
 
-    p = {};
-    for (auto& l: ospray_scene_lights)
-        p.push_back((size_t)l);
-    scene["ospray_scene_lights"] = p;
+        update_ospray_scene_instances = false;
+    }
+    else
+        printf("World instances (%d) still up-to-date\n", ospray_scene_instances.size());
 
-    j["scene"] = scene;
+    if (update_ospray_scene_lights)
+    {
+        if (ospray_scene_lights_data != nullptr)
+            ospRelease(ospray_scene_lights_data);
+    
+        printf("Setting up %d light(s) in the world\n", ospray_scene_lights.size());
 
-    // Framebuffer
+        if (ospray_scene_lights.size() > 0)
+        {
+            ospray_scene_lights_data = ospNewSharedData(&ospray_scene_lights[0], OSP_LIGHT, ospray_scene_lights.size());
+            ospCommit(ospray_scene_lights_data);
+            ospSetObject(ospray_world, "light", ospray_scene_lights_data);
+            ospRetain(ospray_scene_lights_data);
+        }
 
-    json fb;
+        update_ospray_scene_lights = false;
+    }
+    else
+        printf("World lights (%d) still up-to-date\n", ospray_scene_lights.size());
 
-    p = {};
-    for (int i = 0; i < framebuffers.size(); i++)
-        p.push_back((size_t)framebuffers[i].framebuffer);
-    fb["framebuffers"] = p;
+    if (mpi_size > 1)
+        set_world_regions();
 
-    fb["framebuffer_initial_reduction_factor"] = framebuffer_initial_reduction_factor;
+    commit_world();
 
-    j["framebuffer"] = fb;
+    return true;
+}
 
-    // Camera
+bool 
+handle_hello(TCPSocket *sock, const ClientMessage& client_message)
+{
+    const uint32_t client_version = client_message.uint_value();    
 
-    json cam;
+    HelloResult result;
+    bool res = true;
 
-    cam["ospray_camera"] = (size_t)ospray_camera;
+    if (client_version != PROTOCOL_VERSION)
+    {
+        char s[256];
+        sprintf(s, "Client protocol version %d does not match our protocol version %d", client_version, PROTOCOL_VERSION);
+        printf("ERROR: %s\n", s);
 
-    j["camera"] = cam;    
+        result.set_success(false);
+        result.set_message(s);
+        res = false;  
+    } 
+    else
+    {
+        //printf("Got HELLO message, client protocol version %d matches ours\n", client_version);
+        result.set_success(true);
 
-    // World
+        if (client_message.string_value() == "shm")
+        {
+            if (shm_transport_open())
+                result.set_shm_name(shm_name);
+            else
+                printf("WARNING: could not set up shared memory framebuffer transport, falling back to TCP\n");
+        }
+    }
 
-    json world;
+    send_protobuf(sock, result);
 
-    world["ospray_world"] = (size_t)ospray_world;
+    return res;
+}
 
-    j["world"] = world;
+// Rendering
 
-    // Renderer
+void
+render_wait_thread_func(OSPFuture future, int done_fd)
+{
+    ospWait(future, OSP_TASK_FINISHED);
 
-    json r;
+    const char c = 1;
+    if (write(done_fd, &c, 1) != 1)
+        perror("write() to render done pipe failed");
+}
 
-    r["ospray_renderer"] = (size_t)ospray_renderer;
+// Whether the frame about to be rendered should be denoised: from sample
+// denoise_interactive_interval onwards (or the last sample, when fewer) of
+// an interactive render at full resolution, or the last sample of a final
+// render. Interactive denoising stays on once it kicks in, as toggling it
+// every N samples makes the viewport flicker.
+// The denoiser only supports float framebuffers.
+bool
+denoise_current_frame()
+{
+    if (denoiser == nullptr)
+        return false;
 
-    json rr;
-    for (auto& nr : renderers)
-        rr[nr.first] = (size_t)nr.second;
-    j["renderers"] = rr;
+    if (render_mode == RM_FINAL)
+        return denoise_final && current_sample == render_samples 
+            && final_framebuffer_format == OSP_FB_RGBA32F;
 
-    j["renderer"] = r;    
+    if (render_mode == RM_INTERACTIVE)
+        return denoise_interactive_interval > 0 && framebuffer_reduction_factor == 1 
+            && interactive_framebuffer_format == OSP_FB_RGBA32F
+            && (current_sample >= denoise_interactive_interval || current_sample == render_samples);
+
+    return false;
 }
 
-bool 
-handle_get_server_state(TCPSocket *sock)
-{    
-    json j;
+// Sets or removes the denoiser on the framebuffer, when that changes.
+// This doesn't reset accumulation, the denoiser is applied to the 
+// color output only.
+void
+set_framebuffer_denoising(OSPFrameBuffer framebuffer, bool& denoising, bool denoise)
+{
+    if (denoise == denoising)
+        return;
 
-    get_server_state(j);
+    if (denoise)
+        ospSetObjectAsData(framebuffer, "imageOperation", OSP_IMAGE_OPERATION, denoiser);
+    else
+        ospRemoveParam(framebuffer, "imageOperation");
 
-    // Send result
-    ServerStateResult   result;
-    result.set_state(j.dump(4));
-    send_protobuf(sock, result);
+    ospCommit(framebuffer);
 
-    return true;
+    denoising = denoise;
 }
 
-void 
-print_server_state()
+// Start rendering a frame, with completion signaled on render_done_pipe
+void
+render_frame(OSPFrameBuffer framebuffer)
 {
-    json j;
-    get_server_state(j);
+    // Other ranks render on DISTRIBUTED_RENDER_FRAME, see distributed_worker_loop()
+    if (mpi_rank > 0)
+        return;
 
-    printf("Server state:\n");
-    printf("%s\n", j.dump(4).c_str());
-}
+    if (mpi_size > 1)
+        distributed_broadcast_render_frame();
 
+    if (render_mode == RM_FINAL)
+        set_framebuffer_denoising(framebuffer, final_framebuffer_denoising, denoise_current_frame());
+    else
+        set_framebuffer_denoising(framebuffer, framebuffers[framebuffer_reduction_index].denoising, denoise_current_frame());
 
-bool
-handle_update_object(TCPSocket *sock)
-{
-    UpdateObject    update;    
+    // E.g. after switching to or from the LOD volumes
+    if (ospray_world_changed)
+        commit_world();
 
-    if (!receive_protobuf(sock, update))
-        return false;
+    gettimeofday(&frame_start_time, NULL);
+    frame_start_clock = TimingClock::now();
 
-    //print_protobuf(update);
+    render_future = ospRenderFrame(framebuffer, ospray_renderer, ospray_camera, ospray_world);
 
-    switch (update.type())
+    if (render_future == nullptr)
     {
-    case UpdateObject::MESH:
-        update_blender_mesh_object(update);
-        break;
+        printf("ERROR: ospRenderFrame() returned NULL!\n");
+        return;
+    }
 
-    case UpdateObject::GEOMETRY:
-        update_geometry_object(update);
-        break;
+    render_wait_thread = std::thread(render_wait_thread_func, render_future, render_done_pipe[1]);
+}
 
-    case UpdateObject::SCENE:
-        update_scene_object(update);
-        break;
+// Wait for the current frame to finish (optionally canceling it first),
+// then release the future and clear any pending completion notification
+void
+finish_render_frame(bool cancel)
+{
+    if (render_future == nullptr)
+        return;
 
-    case UpdateObject::VOLUME:
-        {
-        Volume volume;
-        if (!receive_protobuf(sock, volume))
-            return false;
-        update_volume_object(update, volume);
-        }
-        break;
+    // See https://github.com/ospray/ospray/issues/368
+    // XXX when distributed all ranks would need to cancel, let the frame finish
+    if (cancel && mpi_size == 1)
+        ospCancel(render_future);
 
-    case UpdateObject::ISOSURFACES:
-        update_isosurfaces_object(update);
-        break;
-    
-    case UpdateObject::SLICES:
-        {
-        Slices slices;
-        if (!receive_protobuf(sock, slices))
-            return false;
-        add_slice_objects(update, slices);
-        }
-        break;
+    // The wait thread returns as soon as the future is finished
+    if (render_wait_thread.joinable())
+        render_wait_thread.join();
 
-    case UpdateObject::LIGHT:
-        {
-        LightSettings light_settings;
-        if (!receive_protobuf(sock, light_settings))
-            return false;
-        update_light_object(update, light_settings);
-        }
-        break;
+    // Read end is non-blocking
+    char buf[16];
+    while (read(render_done_pipe[0], buf, sizeof(buf)) > 0)
+        ;
 
-    default:
-        printf("WARNING: unhandled update type %s\n", UpdateObject_Type_descriptor()->FindValueByNumber(update.type())->name().c_str());
-        break;
-    }
+    ospRelease(render_future);
+    render_future = nullptr;
+}
 
-    return true;
+// Framebuffer sending
+
+int
+framebuffer_pixel_size(OSPFrameBufferFormat format)
+{
+    return format == OSP_FB_RGBA32F ? 4*sizeof(float) : 4*sizeof(uint8_t);
 }
 
-// XXX include channels
-void
-update_framebuffer_settings(const std::string& mode, OSPFrameBufferFormat format, uint32_t width, uint32_t height)
+// Compare the tiles of the job's pixels against the reference (last-sent) 
+// pixels, update the reference for those that changed and return their indices.
+// Returns false if there is no usable reference, in which case the whole
+// framebuffer needs to be sent.
+bool
+find_changed_tiles(const FramebufferSendJob *job, std::vector<uint32_t>& changed_tiles)
 {
-    printf("FRAMEBUFFER %s, %d x %d (format %d)\n", mode.c_str(), width, height, format);
+    const int width = job->width;
+    const int height = job->height;
+    const int pixel_size = framebuffer_pixel_size(job->format);
+    const int tiles_x = (width + FRAMEBUFFER_TILE_SIZE - 1) / FRAMEBUFFER_TILE_SIZE;
+    const int tiles_y = (height + FRAMEBUFFER_TILE_SIZE - 1) / FRAMEBUFFER_TILE_SIZE;
 
-    if (mode == "final")
+    changed_tiles.clear();
+
+    if (job->full_frame 
+        || 
+        tile_reference_width != width || tile_reference_height != height || tile_reference_format != job->format)
+    {        
+        tile_reference_width = width;
+        tile_reference_height = height;
+        tile_reference_format = job->format;
+        tile_reference_pixels = job->pixels;
+        return false;
+    }
+
+    for (int ty = 0; ty < tiles_y; ty++)
     {
-        
-        if (final_framebuffer_width == width && final_framebuffer_height == height && final_framebuffer_format == format)
-        {
-            printf("... No need to update framebuffer dimensions or format\n");
-            return;
-        }
+        const int y0 = ty * FRAMEBUFFER_TILE_SIZE;
+        const int y1 = std::min(y0 + FRAMEBUFFER_TILE_SIZE, height);
 
-        if (final_framebuffer != nullptr)
-            ospRelease(final_framebuffer);
+        for (int tx = 0; tx < tiles_x; tx++)
+        {
+            const int x0 = tx * FRAMEBUFFER_TILE_SIZE;
+            const int x1 = std::min(x0 + FRAMEBUFFER_TILE_SIZE, width);
+            const size_t row_size = (x1 - x0) * pixel_size;
 
-        int channels = OSP_FB_COLOR | /*OSP_FB_DEPTH |*/ OSP_FB_ACCUM | OSP_FB_VARIANCE;
-        //int channels = OSP_FB_COLOR | /*OSP_FB_DEPTH |*/ OSP_FB_ACCUM | OSP_FB_VARIANCE | OSP_FB_NORMAL | OSP_FB_ALBEDO;    
+            bool changed = false;
 
-        final_framebuffer = ospNewFrameBuffer(width, height, format, channels);
-        final_framebuffer_width = width;
-        final_framebuffer_height = height;
-        final_framebuffer_format = format;
-    }
-    else
-    {
-        assert(mode == "interactive");
+            for (int y = y0; y < y1 && !changed; y++)
+            {
+                const size_t offset = (size_t(y)*width + x0) * pixel_size;
+                const uint8_t *p = job->pixels.data() + offset;
+                const uint8_t *r = tile_reference_pixels.data() + offset;
 
-        if (interactive_framebuffer_width == width && interactive_framebuffer_height == height && interactive_framebuffer_format == format)
-            return;
+                if (job->format == OSP_FB_RGBA32F && job->tile_threshold > 0.0f)
+                {
+                    const float *pf = (const float*)p;
+                    const float *rf = (const float*)r;
+
+                    for (int i = 0; i < (x1-x0)*4; i++)
+                    {
+                        if (std::fabs(pf[i] - rf[i]) > job->tile_threshold)
+                        {
+                            changed = true;
+                            break;
+                        }
+                    }
+                }
+                else
+                    changed = memcmp(p, r, row_size) != 0;
+            }
 
-        printf("... Clearing existing framebuffers (dimensions or format changed)\n");
+            if (!changed)
+                continue;
 
-        // Clear framebuffers
-        framebuffers.clear();
-        framebuffer_reduction_factors.clear();
+            changed_tiles.push_back(ty*tiles_x + tx);
 
-        // Update values to use
-        interactive_framebuffer_width = width;
-        interactive_framebuffer_height = height;
-        interactive_framebuffer_format = format;        
+            for (int y = y0; y < y1; y++)
+            {
+                const size_t offset = (size_t(y)*width + x0) * pixel_size;
+                memcpy(tile_reference_pixels.data() + offset, job->pixels.data() + offset, row_size);
+            }
+        }
     }
+
+    return true;
 }
 
-void
-update_camera(CameraSettings& camera_settings)
+// Encode a job's pixels into job->encoded, according to the requested 
+// encoding. Returns the encoding actually applied (e.g. half floats are
+// only used for OSP_FB_RGBA32F, tiles only when there is a previous frame
+// to compare against), sets pixels_size to the size of the (uncompressed) 
+// pixel data and num_tiles to the number of tiles sent (TILES only).
+uint32_t
+encode_framebuffer(FramebufferSendJob *job, uint32_t& pixels_size, uint32_t& num_tiles)
 {
-    printf("CAMERA '%s' (camera)\n", camera_settings.object_name().c_str());
-    printf("--> '%s' (camera data)\n", camera_settings.camera_name().c_str());
+    const size_t num_pixels = job->width*job->height;
+    uint32_t encoding = RenderResult::RAW;
 
-    float cam_pos[3], cam_viewdir[3], cam_updir[3];
+    const uint8_t *pixels = job->pixels.data();
+    pixels_size = job->pixels.size();
+    num_tiles = 0;
 
-    cam_pos[0] = camera_settings.position(0);
-    cam_pos[1] = camera_settings.position(1);
-    cam_pos[2] = camera_settings.position(2);
+    int pixel_size = framebuffer_pixel_size(job->format);
 
-    cam_viewdir[0] = camera_settings.view_dir(0);
-    cam_viewdir[1] = camera_settings.view_dir(1);
-    cam_viewdir[2] = camera_settings.view_dir(2);
+    std::vector<uint16_t> halfs;
+
+    if ((job->encoding & RenderResult::HALF_FLOAT) && job->format == OSP_FB_RGBA32F)
+    {
+        const float *p = (const float*)job->pixels.data();
+
+        halfs.resize(num_pixels*4);
+        for (size_t i = 0; i < num_pixels*4; i++)
+            halfs[i] = float_to_half(p[i]);
+
+        pixels = (const uint8_t*)halfs.data();
+        pixels_size = halfs.size()*sizeof(uint16_t);
+        pixel_size = 4*sizeof(uint16_t);
+        encoding |= RenderResult::HALF_FLOAT;
+    }
 
-    cam_updir[0] = camera_settings.up_dir(0);
-    cam_updir[1] = camera_settings.up_dir(1);
-    cam_updir[2] = camera_settings.up_dir(2);
-    
-    // XXX for now create new cam object
-    // YYY why?
-    if (ospray_camera != nullptr)
-        ospRelease(ospray_camera);
+    std::vector<uint32_t> changed_tiles;
+    std::vector<uint8_t> tiles;
 
-    switch (camera_settings.type())
+    if (job->encoding & RenderResult::TILES)
     {
-        case CameraSettings::PERSPECTIVE:
-            printf("... perspective\n");
-            ospray_camera = ospNewCamera("perspective");
-            ospSetFloat(ospray_camera, "fovy",  camera_settings.fov_y());  // Degrees
-            break;
+        const int tiles_x = (job->width + FRAMEBUFFER_TILE_SIZE - 1) / FRAMEBUFFER_TILE_SIZE;
+        const int tiles_y = (job->height + FRAMEBUFFER_TILE_SIZE - 1) / FRAMEBUFFER_TILE_SIZE;
 
-        case CameraSettings::ORTHOGRAPHIC:
-            printf("... orthographic\n");
-            ospray_camera = ospNewCamera("orthographic");
-            ospSetFloat(ospray_camera, "height", camera_settings.height());
-            break;
+        if (find_changed_tiles(job, changed_tiles) && changed_tiles.size() < size_t(tiles_x*tiles_y))
+        {
+            // Tile indices, followed by the tile pixels
+            tiles.resize(changed_tiles.size()*sizeof(uint32_t));
+            memcpy(tiles.data(), changed_tiles.data(), tiles.size());
 
-        case CameraSettings::PANORAMIC:
-            printf("... panoramic\n");
-            ospray_camera = ospNewCamera("panoramic");
-            break;
+            for (uint32_t t : changed_tiles)
+            {
+                const int x0 = (t % tiles_x) * FRAMEBUFFER_TILE_SIZE;
+                const int y0 = (t / tiles_x) * FRAMEBUFFER_TILE_SIZE;
+                const int x1 = std::min(x0 + FRAMEBUFFER_TILE_SIZE, job->width);
+                const int y1 = std::min(y0 + FRAMEBUFFER_TILE_SIZE, job->height);
+                const size_t row_size = (x1 - x0) * pixel_size;
 
-        default:
-            fprintf(stderr, "WARNING: unknown camera type %d\n", camera_settings.type());
-            break;
+                for (int y = y0; y < y1; y++)
+                {
+                    const uint8_t *row = pixels + (size_t(y)*job->width + x0) * pixel_size;
+                    tiles.insert(tiles.end(), row, row + row_size);
+                }
+            }
+
+            pixels = tiles.data();
+            pixels_size = tiles.size();
+            num_tiles = changed_tiles.size();
+            encoding |= RenderResult::TILES;
+        }
     }
 
-    ospSetFloat(ospray_camera, "aspect", camera_settings.aspect());        // XXX perspective only
-    ospSetFloat(ospray_camera, "nearClip", camera_settings.clip_start());
+#ifdef FRAMEBUFFER_LZ4
+    if (job->encoding & RenderResult::LZ4)
+    {
+        job->encoded.resize(LZ4_compressBound(pixels_size));
+        
+        const int n = LZ4_compress_default((const char*)pixels, (char*)job->encoded.data(), 
+                        pixels_size, job->encoded.size());
 
-    ospSetParam(ospray_camera, "position", OSP_VEC3F, cam_pos);
-    ospSetParam(ospray_camera, "direction", OSP_VEC3F, cam_viewdir);
-    ospSetParam(ospray_camera, "up",  OSP_VEC3F, cam_updir);
+        if (n > 0)
+        {
+            job->encoded.resize(n);
+            return encoding | RenderResult::LZ4;
+        }
 
-    if (camera_settings.dof_focus_distance() > 0.0f)
-    {
-        // XXX seem to stuck in loop during rendering when distance is 0
-        ospSetFloat(ospray_camera, "focusDistance", camera_settings.dof_focus_distance());
-        ospSetFloat(ospray_camera, "apertureRadius", camera_settings.dof_aperture());
+        printf("WARNING: LZ4 compression of framebuffer failed, sending uncompressed\n");
     }
+#endif
 
-    if (camera_settings.border_size() == 4)
+#ifdef FRAMEBUFFER_ZSTD
+    if (job->encoding & RenderResult::ZSTD)
     {
-        // Border render enabled
-        ospSetVec2f(ospray_camera, "imageStart", camera_settings.border(0), camera_settings.border(1));
-        ospSetVec2f(ospray_camera, "imageEnd", camera_settings.border(2), camera_settings.border(3));
-    }    
+        job->encoded.resize(ZSTD_compressBound(pixels_size));
 
-    ospCommit(ospray_camera);
+        // Level 1 is the fastest setting
+        const size_t n = ZSTD_compress(job->encoded.data(), job->encoded.size(), 
+                            pixels, pixels_size, 1);
+
+        if (!ZSTD_isError(n))
+        {
+            job->encoded.resize(n);
+            return encoding | RenderResult::ZSTD;
+        }
+
+        printf("WARNING: Zstandard compression of framebuffer failed (%s), sending uncompressed\n", ZSTD_getErrorName(n));
+    }
+#endif
+
+    job->encoded.assign(pixels, pixels+pixels_size);
+
+    return encoding;
 }
 
 void
-handle_update_material(TCPSocket *sock)
+framebuffer_send_thread_func(FramebufferSender *sender)
 {
-    MaterialUpdate update;
+    FramebufferSendJob  *job;
+    char                fname[1024];
+    struct timeval      t0, t1;
+    size_t              size;
 
-    receive_protobuf(sock, update);
+    while (true)
+    {
+        job = sender->send_queue.pop();
 
-    printf("MATERIAL '%s'\n", update.name().c_str());
+        // Pushed by stop_framebuffer_send_thread()
+        if (job == nullptr)
+            return;
 
-    SceneMaterial *scene_material = nullptr;
-    OSPMaterial material = nullptr;
+        gettimeofday(&t0, NULL);
 
-    SceneMaterialMap::iterator it = scene_materials.find(update.name());
-    if (it != scene_materials.end())
-    {
-        printf("... Updating existing material\n");
+        RenderResult& render_result = job->render_result;
+        size = 0;
 
-        scene_material = it->second;
-        if (scene_material->type != update.type())
+        if (!job->send_pixels)
+            send_protobuf(job->sock, render_result);
+        else if (job->shm_slot >= 0)
         {
-            printf("... Material type changed\n");
-            delete scene_material;
-            scene_material = nullptr;
-            scene_materials.erase(update.name());
+            // Pixels already in shared memory
+            size = job->width*job->height*4*sizeof(float);
+
+            render_result.set_file_name("<shm>");
+            render_result.set_file_size(size);
+            render_result.set_shm_slot(job->shm_slot);
+            render_result.set_shm_slot_size(job->shm_slot_size);
+
+            send_protobuf(job->sock, render_result);
         }
-        else
-            material = scene_material->material;
-    }
+        else if (job->final)
+        {
+            // Encode framebuffer as an OpenEXR file in memory, the client 
+            // still receives it as a file
+            ScopedTimer encode_timer(timings, "framebuffer encode");
+            if (!encodeFramebufferEXR(job->encoded, job->width, job->height, framebuffer_compression, (const float*)job->pixels.data()))
+                job->encoded.clear();
+            render_result.set_encode_time(encode_timer.stop());
 
-    switch (update.type())
-    {
+            size = job->encoded.size();
 
-    case MaterialUpdate::ALLOY:
-    {
-        AlloySettings settings;
+            render_result.set_file_name("<memory>");
+            render_result.set_file_size(size);
 
-        receive_protobuf(sock, settings);
-        printf("... Alloy\n");
+            ScopedTimer send_timer(timings, "framebuffer send");
+            send_protobuf(job->sock, render_result);
+            job->sock->sendall(job->encoded.data(), size);
+            send_timer.stop();
 
-        if (scene_material == nullptr)
+            if (keep_framebuffer_files)
+            {
+                sprintf(fname, "/dev/shm/blospray-final-%04d.exr", render_result.sample());
+                FILE *f = fopen(fname, "wb");
+                if (f != NULL)
+                {
+                    fwrite(job->encoded.data(), 1, size, f);
+                    fclose(f);
+                }
+            }
+        }
+        else
         {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "alloy");
+            // Send framebuffer directly, instead of as a file
+            uint32_t pixels_size, num_tiles;
+            ScopedTimer encode_timer(timings, "framebuffer encode");
+            const uint32_t encoding = encode_framebuffer(job, pixels_size, num_tiles);
+            render_result.set_encode_time(encode_timer.stop());
+
+            size = job->encoded.size();
+
+            render_result.set_file_name("<memory>");
+            render_result.set_file_size(size);
+            render_result.set_format(job->format);
+            render_result.set_encoding(encoding);
+            render_result.set_pixels_size(pixels_size);
+            render_result.set_tile_size(FRAMEBUFFER_TILE_SIZE);
+            render_result.set_num_tiles(num_tiles);
+
+            ScopedTimer send_timer(timings, "framebuffer send");
+            send_protobuf(job->sock, render_result);
+            job->sock->sendall(job->encoded.data(), size);
+            send_timer.stop();
+
+            if (keep_framebuffer_files && job->format == OSP_FB_RGBA32F)
+            {
+                sprintf(fname, "/dev/shm/blospray-interactive-%04d-%d.exr", 
+                    render_result.sample(), render_result.reduction_factor());
+                writeFramebufferEXR(fname, job->width, job->height, framebuffer_compression, (const float*)job->pixels.data());
+            }
         }
 
-        if (settings.color_size() == 3)
-            ospSetVec3f(material, "color", settings.color(0), settings.color(1), settings.color(2));    
-        if (settings.edge_color_size() == 3)
-            ospSetVec3f(material, "edgeColor", settings.edge_color(0), settings.edge_color(1), settings.edge_color(2));    
-        ospSetFloat(material, "roughness", settings.roughness());
+        gettimeofday(&t1, NULL);
 
-        break;
+        sender->last_send_time = time_diff(t0, t1);
+        sender->last_send_size = size/1000000.0f;
+
+        sender->free_jobs.push(job);
     }
+}
 
-    case MaterialUpdate::CAR_PAINT:
-    {
-        CarPaintSettings settings;
+// Blocks until all queued framebuffer sends are done. Needed before
+// anything else gets sent on a socket used for framebuffer output.
+void
+wait_for_framebuffer_sends()
+{
+    FramebufferSendJob *jobs[NUM_FRAMEBUFFER_SEND_JOBS];
 
-        receive_protobuf(sock, settings);
-        printf("... Car paint\n");
+    for (int i = 0; i < NUM_FRAMEBUFFER_SEND_JOBS; i++)
+        jobs[i] = framebuffer_sender->free_jobs.pop();
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "carPaint");
-        }
+    for (int i = 0; i < NUM_FRAMEBUFFER_SEND_JOBS; i++)
+        framebuffer_sender->free_jobs.push(jobs[i]);
+}
 
-        if (settings.base_color_size() == 3)
-            ospSetVec3f(material, "baseColor", settings.base_color(0), settings.base_color(1), settings.base_color(2));    
-        ospSetFloat(material, "roughness", settings.roughness());
-        ospSetFloat(material, "normal", settings.normal());
-        ospSetFloat(material, "flakeDensity", settings.flake_density());    
-        ospSetFloat(material, "flakeScale", settings.flake_scale());    
-        ospSetFloat(material, "flakeSpread", settings.flake_spread());    
-        ospSetFloat(material, "flakeJitter", settings.flake_jitter());    
-        ospSetFloat(material, "flakeRoughness", settings.flake_roughness());
-        ospSetFloat(material, "coat", settings.coat());
-        ospSetFloat(material, "coatIor", settings.coat_ior());
-        if (settings.coat_color_size() == 3)
-            ospSetVec3f(material, "coatColor", settings.coat_color(0), settings.coat_color(1), settings.coat_color(2)); 
-        ospSetFloat(material, "coatThickness", settings.coat_thickness());
-        ospSetFloat(material, "coatRoughness", settings.coat_roughness());
-        ospSetFloat(material, "coatNormal", settings.coat_normal());
-        if (settings.flipflop_color_size() == 3)
-            ospSetVec3f(material, "flipflopColor", settings.flipflop_color(0), settings.flipflop_color(1), settings.flipflop_color(2)); 
-        ospSetFloat(material, "flipflopFalloff", settings.flipflop_falloff());
+void
+start_framebuffer_send_thread()
+{
+    framebuffer_sender = new FramebufferSender;
 
-        break;        
-    }
+    for (int i = 0; i < NUM_FRAMEBUFFER_SEND_JOBS; i++)
+        framebuffer_sender->free_jobs.push(new FramebufferSendJob);
 
-    case MaterialUpdate::GLASS:
-    {
-        GlassSettings settings;
+    framebuffer_sender->thread = std::thread(framebuffer_send_thread_func, framebuffer_sender);
+}
 
-        receive_protobuf(sock, settings);
-        printf("... Glass\n");
+void
+stop_framebuffer_send_thread()
+{
+    wait_for_framebuffer_sends();
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "glass");
-        }
+    framebuffer_sender->send_queue.push(nullptr);
+    framebuffer_sender->thread.join();
 
-        ospSetFloat(material, "eta", settings.eta());
-        if (settings.attenuation_color_size() == 3)
-            ospSetVec3f(material, "attenuationColor", settings.attenuation_color(0), settings.attenuation_color(1), settings.attenuation_color(2));        
-        ospSetFloat(material, "attenuationDistance", settings.attenuation_distance());
+    for (int i = 0; i < NUM_FRAMEBUFFER_SEND_JOBS; i++)
+        delete framebuffer_sender->free_jobs.pop();
 
-        break;
-    }
+    delete framebuffer_sender;
+    framebuffer_sender = nullptr;
+}
 
-    case MaterialUpdate::THIN_GLASS:
-    {
-        ThinGlassSettings settings;
+void
+ensure_idle_render_mode()
+{
+    if (render_mode == RM_IDLE)
+        return;
 
-        receive_protobuf(sock, settings);
-        printf("... ThinGlass\n");
+    if (render_future == nullptr)
+        return;
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "thinGlass");
-        }
+    finish_render_frame(true);
+    wait_for_framebuffer_sends();
 
-        ospSetFloat(material, "eta", settings.eta());
-        if (settings.attenuation_color_size() == 3)
-            ospSetVec3f(material, "attenuationColor", settings.attenuation_color(0), settings.attenuation_color(1), settings.attenuation_color(2));        
-        ospSetFloat(material, "attenuationDistance", settings.attenuation_distance());
-        ospSetFloat(material, "thickness", settings.thickness());
+    render_mode = RM_IDLE;
 
-        break;
-    }
+    printf("Canceled active render\n");
+}
 
-    case MaterialUpdate::LUMINOUS:
-    {
-        LuminousSettings settings;
+// Applies a single update from a SceneUpdateBatch or AnimationFrame.
+// Returns false on failure, with error set to the plugin's message (if any)
+bool
+apply_scene_update(const SceneUpdate& update, std::string& error)
+{
+    SceneUpdateMessages messages(&update);
+    bool ok;
 
-        receive_protobuf(sock, settings);
-        printf("... Luminous\n");
+    error = "";
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "luminous");
-        }
+    switch (update.type())
+    {
+    case ClientMessage::UPDATE_PLUGIN_INSTANCE:
+        ok = handle_update_plugin_instance(&messages);
+        break;
 
-        if (settings.color_size() == 3)
-            ospSetVec3f(material, "color", settings.color(0), settings.color(1), settings.color(2));    
-        ospSetFloat(material, "intensity", settings.intensity());    
-        ospSetFloat(material, "transparency", settings.transparency());
+    case ClientMessage::UPDATE_OBJECT:
+        ok = handle_update_object(&messages);
+        break;
 
+    case ClientMessage::UPDATE_MATERIAL:
+        handle_update_material(&messages);
+        ok = true;
         break;
+
+    default:
+        fprintf(stderr, "... WARNING: ignoring scene update of unsupported type %d\n", update.type());
+        error = "Unsupported scene update type " + std::to_string(update.type());
+        return false;
     }
 
-    case MaterialUpdate::METAL:
+    if (messages.has_result && !messages.result.success())
     {
-        MetalSettings settings;
+        error = messages.result.message();
+        return false;
+    }
 
-        receive_protobuf(sock, settings);  
+    return ok && (!messages.has_result || messages.result.success());
+}
 
-        const uint32_t& metal = settings.metal();
+// Applies a batch of scene updates, replacing separate UPDATE_PLUGIN_INSTANCE,
+// UPDATE_MATERIAL and UPDATE_OBJECT messages (and their round trips).
+// Returns false on socket errors
+bool
+handle_update_scene_batch(TCPSocket *sock, const ClientMessage& client_message)
+{
+    const uint32_t batch_size = client_message.uint_value();
 
-        printf("... Metal (%d)\n", metal);
+    std::vector<uint8_t> buffer(batch_size);
+    SceneUpdateBatch batch;
 
-        assert(metal < 5);
+    if (recvall_unlocked(sock, buffer.data(), batch_size) == -1)
+        return false;
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "metal");
-        }
+    struct timeval t0, t1;
+    gettimeofday(&t0, NULL);
 
-        const float metal_eta_values[] = {
-            1.5f, 0.98f, 0.6f,      // Aluminium
-            3.2f, 3.1f, 2.3f,       // Chromium
-            0.1f, 0.8f, 1.1f,       // Copper
-            0.07f, 0.37f, 1.5f,     // Gold
-            0.051f, 0.043f, 0.041f  // Silver
-        };
+    SceneUpdateBatchResult result;
+    result.set_success(true);
 
-        const float metal_k_values[] = {
-            7.6f, 6.6f, 5.4f,       // Aluminium
-            3.3f, 3.3f, 3.1f,       // Chromium
-            3.5f, 2.5f, 2.4f,       // Copper
-            3.7f, 2.3f, 1.7f,       // Gold
-            5.3f, 3.6f, 2.3f,       // Silver
-        };
-        
-        const float *eta = metal_eta_values + 3*metal;
-        const float *k = metal_k_values + 3*metal;
+    if (!batch.ParseFromArray(buffer.data(), batch_size))
+    {
+        fprintf(stderr, "... ERROR: failed to parse scene update batch (%u bytes)\n", batch_size);
+        result.set_success(false);
+        result.add_errors("Failed to parse scene update batch");
+        send_protobuf(sock, result);
+        return true;
+    }
 
-        ospSetVec3f(material, "eta", eta[0], eta[1], eta[2]);
-        ospSetVec3f(material, "k", k[0], k[1], k[2]);
-        ospSetFloat(material, "roughness", settings.roughness());  
-        ospCommit(material);
+    printf("... Scene update batch of %d updates (%u bytes)\n", batch.updates_size(), batch_size);
+
+    if (mpi_size > 1)
+        distributed_broadcast(ClientMessage::UPDATE_SCENE_BATCH, { std::string((const char*)buffer.data(), batch_size) });
+
+    std::string error;
+
+    for (int i = 0; i < batch.updates_size(); i++)
+    {
+        if (!apply_scene_update(batch.updates(i), error))
+        {
+            result.add_errors(error.empty() ? "Scene update " + std::to_string(i) + " failed" : error);
+            result.set_success(false);
+        }
+    }
+
+    result.set_num_updates(batch.updates_size());
 
-        break;
-    }    
+    gettimeofday(&t1, NULL);
+    printf("... Applied scene update batch in %.3fs\n", time_diff(t0, t1));
 
-    case MaterialUpdate::METALLIC_PAINT:
-    {
-        MetallicPaintSettings settings;
+    send_protobuf(sock, result);
 
-        receive_protobuf(sock, settings);
-        printf("... MetallicPaint\n");
+    return true;
+}
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "metallicPaint");
-        }
+// Animation jobs
 
-        if (settings.base_color_size() == 3)
-            ospSetVec3f(material, "baseColor", settings.base_color(0), settings.base_color(1), settings.base_color(2));    
-        if (settings.flake_color_size() == 3)
-            ospSetVec3f(material, "flakeColor", settings.flake_color(0), settings.flake_color(1), settings.flake_color(2));   
-        ospSetFloat(material, "flakeAmount", settings.flake_amount());    
-        ospSetFloat(material, "flakeSpread", settings.flake_spread());    
-        ospSetFloat(material, "eta", settings.eta());
+// The plugin instances of each frame get a frame-specific name, so the 
+// instances for the next frame can be created while the current frame 
+// renders, without touching the ones in use
+std::string
+animation_frame_data_name(const std::string& name, uint32_t frame)
+{
+    char s[32];
 
-        break;
-    }
+    sprintf(s, " [frame %d]", frame);
 
-    case MaterialUpdate::OBJMATERIAL:       // XXX rename to obj
+    return name + s;
+}
+
+// Renames the plugin instances in the frame's updates, plus the links to
+// them in the frame's object updates. Returns the new names.
+std::vector<std::string>
+rename_animation_frame_plugin_instances(AnimationFrame& frame)
+{
+    std::map<std::string, std::string> renamed;
+    std::vector<std::string> names;
+
+    for (int i = 0; i < frame.updates_size(); i++)
     {
-        OBJMaterialSettings settings;
+        SceneUpdate *update = frame.mutable_updates(i);
 
-        receive_protobuf(sock, settings);
-        printf("... OBJMaterial (kd %.3f,%.3f,%.3f; ...)\n", settings.kd(0), settings.kd(1), settings.kd(2));
+        if (update->type() != ClientMessage::UPDATE_PLUGIN_INSTANCE || update->messages_size() == 0)
+            continue;
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "obj");
-        }
+        UpdatePluginInstance plugin_update;
+        plugin_update.ParseFromString(update->messages(0));
 
-        if (settings.kd_size() == 3)
-            ospSetVec3f(material, "kd", settings.kd(0), settings.kd(1), settings.kd(2));
-        if (settings.ks_size() == 3)
-            ospSetVec3f(material, "ks", settings.ks(0), settings.ks(1), settings.ks(2));
-        ospSetFloat(material, "ns", settings.ns());
-        ospSetFloat(material, "d", settings.d());            
+        const std::string name = animation_frame_data_name(plugin_update.name(), frame.frame());
 
-        break;
+        renamed[plugin_update.name()] = name;
+        names.push_back(name);
+
+        plugin_update.set_name(name);
+        plugin_update.SerializeToString(update->mutable_messages(0));
     }
 
-    case MaterialUpdate::PRINCIPLED:
-    {
-        PrincipledSettings settings;
+    if (renamed.empty())
+        return names;
 
-        receive_protobuf(sock, settings);
-        printf("... Principled\n");
+    for (int i = 0; i < frame.updates_size(); i++)
+    {
+        SceneUpdate *update = frame.mutable_updates(i);
 
-        if (scene_material == nullptr)
-        {
-            scene_material = new SceneMaterial;
-            material = scene_material->material = ospNewMaterial(current_renderer_type.c_str(), "principled");
-        }
+        if (update->type() != ClientMessage::UPDATE_OBJECT || update->messages_size() == 0)
+            continue;
 
-        if (settings.base_color_size() == 3)
-            ospSetVec3f(material, "baseColor", settings.base_color(0), settings.base_color(1), settings.base_color(2));    
-        if (settings.edge_color_size() == 3)
-            ospSetVec3f(material, "edgeColor", settings.edge_color(0), settings.edge_color(1), settings.edge_color(2)); 
-        ospSetFloat(material, "metallic", settings.metallic());    
-        ospSetFloat(material, "diffuse", settings.diffuse());    
-        ospSetFloat(material, "specular", settings.specular());
-        ospSetFloat(material, "ior", settings.ior());
-        ospSetFloat(material, "transmission", settings.transmission());
-        if (settings.transmission_color_size() == 3)
-            ospSetVec3f(material, "transmissionColor", settings.transmission_color(0), settings.transmission_color(1), settings.transmission_color(2)); 
-        ospSetFloat(material, "transmissionDepth", settings.transmission_depth());
-        ospSetFloat(material, "roughness", settings.roughness());
-        ospSetFloat(material, "anisotropy", settings.anisotropy());
-        ospSetFloat(material, "rotation", settings.rotation());
-        ospSetFloat(material, "normal", settings.normal());
-        ospSetFloat(material, "baseNormal", settings.base_normal());
-        ospSetBool(material, "thin", settings.thin());
-        ospSetFloat(material, "thickness", settings.thickness());
-        ospSetFloat(material, "backlight", settings.backlight());
-        ospSetFloat(material, "coat", settings.coat());
-        ospSetFloat(material, "coatIor", settings.coat_ior());
-        if (settings.coat_color_size() == 3)
-            ospSetVec3f(material, "coatColor", settings.coat_color(0), settings.coat_color(1), settings.coat_color(2)); 
-        ospSetFloat(material, "coatThickness", settings.coat_thickness());
-        ospSetFloat(material, "coatRoughness", settings.coat_roughness());
-        ospSetFloat(material, "coatNormal", settings.coat_normal());
-        ospSetFloat(material, "sheen", settings.sheen());
-        if (settings.sheen_color_size() == 3)
-            ospSetVec3f(material, "sheenColor", settings.sheen_color(0), settings.sheen_color(1), settings.sheen_color(2)); 
-        ospSetFloat(material, "sheenTint", settings.sheen_tint());
-        ospSetFloat(material, "sheenRoughness", settings.sheen_roughness());
-        ospSetFloat(material, "opacity", settings.opacity());
+        UpdateObject object_update;
+        object_update.ParseFromString(update->messages(0));
 
-        break;
-    }
+        std::map<std::string, std::string>::iterator it = renamed.find(object_update.data_link());
 
-    default:
-        printf("ERROR: unknown material update type %d!\n", update.type());
-        return;
+        if (it == renamed.end())
+            continue;
 
+        object_update.set_data_link(it->second);
+        object_update.SerializeToString(update->mutable_messages(0));
     }
 
-    ospCommit(material);
-
-    scene_material->type = update.type();
-    scene_materials[update.name()] = scene_material;
+    return names;
 }
 
+// Applies either the plugin instance updates of the frame, or all others
 void
-update_renderer_type(const std::string& type)
+apply_animation_frame_updates(const AnimationFrame& frame, bool plugin_instances)
 {
-    if (type == current_renderer_type)
-        return;
+    std::string error;
 
-    printf("Updating renderer type to '%s'\n", type.c_str());
-
-    ospray_renderer = renderers[type.c_str()];
+    for (const SceneUpdate& update : frame.updates())
+    {
+        if ((update.type() == ClientMessage::UPDATE_PLUGIN_INSTANCE) != plugin_instances)
+            continue;
 
-    scene_materials.clear();
-    // XXX any more?
+        if (mpi_size > 1)
+            distributed_broadcast(update);
 
-    current_renderer_type = type;
+        if (!apply_scene_update(update, error))
+            printf("... WARNING: update for frame %d failed: %s\n", frame.frame(), error.c_str());
+    }
 }
 
+// Renders all samples of the current scene into the final framebuffer
+// and saves it as fname. while_rendering() gets called once the first 
+// sample is in progress.
 bool
-update_render_settings(const RenderSettings& render_settings)
+render_animation_frame(const AnimationJob& job, const char *fname, std::function<void()> while_rendering)
 {
-    printf("Applying render settings\n");
+    struct timeval t0, t1;
 
-    //ospSetInt(renderer, "spp", 1);
+    gettimeofday(&t0, NULL);
 
-    ospSetInt(ospray_renderer, "maxPathLength", render_settings.max_path_length());
-    ospSetFloat(ospray_renderer, "minContribution", render_settings.min_contribution());
-    ospSetFloat(ospray_renderer, "varianceThreshold", render_settings.variance_threshold());
+    if (mpi_size > 1)
+    {
+        // Lets the other ranks set up for the final render, as for START_RENDERING
+        ClientMessage start_message;
+        start_message.set_type(ClientMessage::START_RENDERING);
+        start_message.set_string_value("final");
+        start_message.set_uint_value(std::max(1u, job.samples()));
+        start_message.set_float_value(job.variance_target());
+        start_message.set_uint_value3(job.time_budget());
+        distributed_broadcast(ClientMessage::START_RENDERING, { start_message.SerializeAsString() });
+    }
+
+    // Full-resolution volumes, picked up by the world commit below
+    use_volume_lod(false);
 
-    if (current_renderer_type == "scivis")
     {
-        ospSetInt(ospray_renderer, "aoSamples", render_settings.ao_samples());
-        ospSetFloat(ospray_renderer, "aoRadius", render_settings.ao_radius());
-        ospSetFloat(ospray_renderer, "aoIntensity", render_settings.ao_intensity());
-        ospSetFloat(ospray_renderer, "volumeSamplingRate", render_settings.volume_sampling_rate());
+        ScopedTimer timer(timings, "prepare scene");
+        prepare_scene();
     }
-    else
+
+    render_mode = RM_FINAL;
+    render_samples = std::max(1u, job.samples());
+    current_sample = 1;
+
+    final_render_variance_target = job.variance_target();
+    final_render_time_budget = job.time_budget();
+    set_variance_threshold(final_render_variance_target > 0.0f ? final_render_variance_target : renderer_variance_threshold);
+
+    ospResetAccumulation(final_framebuffer);
+    gettimeofday(&rendering_start_time, NULL);
+
+    float variance;
+
+    while (true)
     {
-        // Pathtracer
+        set_framebuffer_denoising(final_framebuffer, final_framebuffer_denoising, denoise_current_frame());
 
-        ospSetInt(ospray_renderer, "roulettePathLength", render_settings.roulette_path_length());
-        ospSetFloat(ospray_renderer, "maxContribution", render_settings.max_contribution());
-        ospSetBool(ospray_renderer, "geometryLights", render_settings.geometry_lights());
-    }
+        if (mpi_size > 1)
+            distributed_broadcast_render_frame();
 
-    ospCommit(ospray_renderer);
+        ScopedTimer timer(timings, "render");
 
-    // Done!
+        OSPFuture future = ospRenderFrame(final_framebuffer, ospray_renderer, ospray_camera, ospray_world);
 
-    return true;
-}
+        if (current_sample == 1)
+            while_rendering();
 
-bool
-update_world_settings(const WorldSettings& world_settings)
-{    
-    printf("Updating world settings\n");
+        server_mutex.unlock();
+        ospWait(future, OSP_TASK_FINISHED);
+        server_mutex.lock();
 
-    printf("... ambient color %.3f, %.3f, %.3f; intensity %.3f\n", 
-        world_settings.ambient_color(0), 
-        world_settings.ambient_color(1), 
-        world_settings.ambient_color(2), 
-        world_settings.ambient_intensity());
+        ospRelease(future);
+        timer.stop();
 
-    ospSetVec3f(ospray_scene_ambient_light, "color", world_settings.ambient_color(0), world_settings.ambient_color(1), world_settings.ambient_color(2));
-    ospSetFloat(ospray_scene_ambient_light, "intensity", world_settings.ambient_intensity());
-    ospCommit(ospray_scene_ambient_light);
+        gettimeofday(&t1, NULL);
+        variance = ospGetVariance(final_framebuffer);
 
-    printf("... background color %f, %f, %f, %f\n", 
-        world_settings.background_color(0),
-        world_settings.background_color(1),
-        world_settings.background_color(2),
-        world_settings.background_color(3));    
+        printf("[%d/%d] Var %5.3f ", current_sample, render_samples, variance);
 
-    ospSetVec4f(ospray_renderer, "backgroundColor",
-        world_settings.background_color(0),
-        world_settings.background_color(1),
-        world_settings.background_color(2),
-        world_settings.background_color(3));
+        if (final_framebuffer_denoising)
+            printf("| Denoised ");
 
-    ospCommit(ospray_renderer);
+        if (current_sample < render_samples)
+            check_final_render_termination(variance, t1);
 
-    return true;
-}
+        printf("\n");
 
-/*
-// Send result
+        if (current_sample == render_samples)
+            break;
 
-size_t
-write_framebuffer_exr(OSPFrameBuffer framebuffer, const char *fname)
-{
-    // Access framebuffer
-    const float *color = (float*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+        current_sample++;
+    }
 
-    writeFramebufferEXR(fname, framebuffer_width, framebuffer_height, framebuffer_compression, color);
+    render_mode = RM_IDLE;
 
-    // Unmap framebuffer
-    ospUnmapFrameBuffer(color, framebuffer);
+    ScopedTimer save_timer(timings, "framebuffer save");
 
-    struct stat st;
-    stat(fname, &st);
+    const float *color = (const float*)ospMapFrameBuffer(final_framebuffer, OSP_FB_COLOR);
+    const bool res = writeFramebufferEXR(fname, final_framebuffer_width, final_framebuffer_height, framebuffer_compression, color);
+    ospUnmapFrameBuffer(color, final_framebuffer);
 
-    return st.st_size;
+    save_timer.stop();
+
+    gettimeofday(&t1, NULL);
+    printf("... %s: %d samples, variance %.4f, %.3f seconds\n", fname, current_sample, variance, time_diff(t0, t1));
+
+    return res;
 }
 
-// Not used atm, as we use sendfile()
+// Deletes the plugin instances of an animation frame, on all ranks
 void
-send_framebuffer(TCPSocket *sock)
+delete_animation_frame_plugin_instances(const std::vector<std::string>& names)
 {
-    uint32_t bufsize;
+    for (const std::string& name : names)
+    {
+        if (mpi_size > 1)
+        {
+            ClientMessage delete_message;
+            delete_message.set_type(ClientMessage::DELETE_PLUGIN_INSTANCE);
+            delete_message.set_string_value(name);
+            distributed_broadcast(ClientMessage::DELETE_PLUGIN_INSTANCE, { delete_message.SerializeAsString() });
+        }
+
+        delete_scene_data(name);
+    }
+}
 
+void
+run_animation_job(AnimationJob *job)
+{
     struct timeval t0, t1;
+    struct stat st;
+    char fname[1024];
+
     gettimeofday(&t0, NULL);
 
-    // Access framebuffer
-    const float *fb = (float*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+    printf("Session '%s': rendering animation job of %d frame(s) to %s\n", 
+        session->name.c_str(), job->frames_size(), job->output_directory().c_str());
 
-#if 1
-    // Write to OpenEXR file and send *its* contents
-    const char *FBFILE = "/dev/shm/orsfb.exr";
+    if (mpi_size > 1)
+    {
+        ClientMessage fb_message;
+        fb_message.set_type(ClientMessage::UPDATE_FRAMEBUFFER_SETTINGS);
+        fb_message.set_string_value("final");
+        fb_message.set_uint_value(OSP_FB_RGBA32F);
+        fb_message.set_uint_value2(job->width());
+        fb_message.set_uint_value3(job->height());
+        fb_message.set_uint_value4(RenderResult::RAW);
+        distributed_broadcast(ClientMessage::UPDATE_FRAMEBUFFER_SETTINGS, { fb_message.SerializeAsString() });
+    }
 
-    // XXX this also maps/unmaps the framebuffer!
-    size_t size = write_framebuffer_exr(FBFILE);
+    update_framebuffer_settings("final", OSP_FB_RGBA32F, job->width(), job->height(), RenderResult::RAW, 0.0f);
 
-    printf("Sending framebuffer as OpenEXR file, %d bytes\n", size);
+    // Frames already rendered (e.g. by an earlier, interrupted, run of the job) are skipped
 
-    bufsize = size;
-    sock->send((uint8_t*)&bufsize, 4);
-    sock->sendfile(FBFILE);
-#else
-    // Send directly
-    bufsize = framebuffer_width*framebuffer_height*4*4;
+    std::vector<AnimationFrame*> frames;
+    std::vector<std::string> fnames;
 
-    printf("Sending %d bytes of framebuffer data\n", bufsize);
+    for (int i = 0; i < job->frames_size(); i++)
+    {
+        AnimationFrame *frame = job->mutable_frames(i);
 
-    sock->send(&bufsize, 4);
-    sock->sendall((uint8_t*)fb, framebuffer_width*framebuffer_height*4*4);
-#endif
+        snprintf(fname, 1024, "%s/%04d.exr", job->output_directory().c_str(), frame->frame());
 
-    // XXX can already unmap after written to file
-    // Unmap framebuffer
-    ospUnmapFrameBuffer(fb, framebuffer);
+        if (stat(fname, &st) == 0)
+        {
+            printf("... %s exists, skipping frame %d\n", fname, frame->frame());
+            continue;
+        }
+
+        frames.push_back(frame);
+        fnames.push_back(fname);
+    }
+
+    std::vector<std::vector<std::string>> frame_plugin_instances;
+
+    for (AnimationFrame *frame : frames)
+        frame_plugin_instances.push_back(rename_animation_frame_plugin_instances(*frame));
+
+    if (!frames.empty())
+        apply_animation_frame_updates(*frames[0], true);
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        printf("Frame %d (%d/%d)\n", frames[i]->frame(), int(i+1), int(frames.size()));
+
+        apply_animation_frame_updates(*frames[i], false);
+
+        CameraSettings camera_settings(frames[i]->camera());
+        if (mpi_size > 1)
+            distributed_broadcast(ClientMessage::UPDATE_CAMERA, { camera_settings.SerializeAsString() });
+        update_camera(camera_settings);
+
+        // The objects now use this frame's plugin instances
+        if (i > 0)
+            delete_animation_frame_plugin_instances(frame_plugin_instances[i-1]);
+
+        // Create the plugin instances for the next frame while this one renders
+        if (!render_animation_frame(*job, fnames[i].c_str(), [&]() {
+                if (i+1 < frames.size())
+                    apply_animation_frame_updates(*frames[i+1], true);
+            }))
+            printf("... ERROR: could not write %s\n", fnames[i].c_str());
+    }
+
+    // Nothing renders the last frame anymore. The objects keep their
+    // OSPRay references until the next scene export replaces them.
+    if (!frames.empty())
+        delete_animation_frame_plugin_instances(frame_plugin_instances.back());
 
     gettimeofday(&t1, NULL);
-    printf("Sent framebuffer in %.3f seconds\n", time_diff(t0, t1));
-}
-*/
+    printf("Session '%s': animation job done, %d frame(s) in %.3f seconds\n", 
+        session->name.c_str(), int(frames.size()), time_diff(t0, t1));
 
-// Querying
+    delete job;
+}
 
+// Queues an animation job, which gets rendered when the connection ends.
+// Returns false on socket errors
 bool
-handle_query_bound(TCPSocket *sock, const std::string& name)
+handle_submit_animation_job(TCPSocket *sock, const ClientMessage& client_message)
 {
-    QueryBoundResult result;
-    char msg[1024];
+    const uint32_t job_size = client_message.uint_value();
 
-    PluginStateMap::const_iterator it = plugin_state.find(name);
+    std::vector<uint8_t> buffer(job_size);
+    AnimationJob *job = new AnimationJob;
+    AnimationJobResult result;
 
-    if (it == plugin_state.end())
+    if (recvall_unlocked(sock, buffer.data(), job_size) == -1)
+    {
+        delete job;
+        return false;
+    }
+
+    if (!job->ParseFromArray(buffer.data(), job_size))
+    {
+        result.set_success(false);
+        result.set_message("Failed to parse animation job");
+    }
+    else if (job->frames_size() == 0 || job->width() == 0 || job->height() == 0)
+    {
+        result.set_success(false);
+        result.set_message("Animation job has no frames, or framebuffer size is zero");
+    }
+    else if (mkdir(job->output_directory().c_str(), 0755) == -1 && errno != EEXIST)
     {
-        sprintf(msg, "No plugin state for id '%s'", name.c_str());
-
         result.set_success(false);
-        result.set_message(msg);
+        result.set_message("Could not create output directory " + job->output_directory() + ": " + strerror(errno));
+    }
+    else
+    {
+        printf("Queued animation job of %d frame(s) (%u bytes)\n", job->frames_size(), job_size);
 
-        printf("... FAILED: %s\n", msg);
+        session->animation_jobs.push(job);
+        job = nullptr;
 
-        send_protobuf(sock, result);
+        result.set_success(true);
+        result.set_queue_length(session->animation_jobs.size());
+    }
 
-        return false;
+    if (job != nullptr)
+    {
+        printf("... ERROR: %s\n", result.message().c_str());
+        delete job;
     }
 
-    const PluginState *state = it->second;
+    send_protobuf(sock, result);
 
-    BoundingMesh *bound = state->bound;
+    return true;
+}
 
-    if (bound)
-    {
-        uint32_t    size;
-        uint8_t     *buffer = bound->serialize(size);
+// Distributed rendering
 
-        result.set_success(true);
-        result.set_result_size(size);
+// Client messages replicated to the other ranks, either before handling
+// them (when all that's needed is in the ClientMessage itself), or after,
+// together with the protobufs received by the handler
+bool
+distributed_replicate_before(ClientMessage::Type type)
+{
+    return type == ClientMessage::UPDATE_RENDERER_TYPE || type == ClientMessage::CLEAR_SCENE 
+        || type == ClientMessage::UPDATE_FRAMEBUFFER_SETTINGS || type == ClientMessage::START_RENDERING;
+}
 
-        send_protobuf(sock, result);
-        sock->sendall(buffer, size);
+bool
+distributed_replicate_after(ClientMessage::Type type)
+{
+    return type == ClientMessage::UPDATE_RENDER_SETTINGS || type == ClientMessage::UPDATE_WORLD_SETTINGS 
+        || type == ClientMessage::UPDATE_PLUGIN_INSTANCE || type == ClientMessage::UPDATE_OBJECT 
+        || type == ClientMessage::UPDATE_MATERIAL || type == ClientMessage::UPDATE_CAMERA;
+}
 
-        delete [] buffer;
-    }
-    else
-    {
-        sprintf(msg, "No bound specified");
+// Rank 0: sends a command to the other ranks. The messages are
+// those of a SceneUpdate for UPDATE_PLUGIN_INSTANCE, UPDATE_OBJECT and
+// UPDATE_MATERIAL, the raw SceneUpdateBatch for UPDATE_SCENE_BATCH, the
+// settings protobuf for UPDATE_RENDER_SETTINGS, UPDATE_WORLD_SETTINGS 
+// and UPDATE_CAMERA, and the ClientMessage itself otherwise.
+void
+distributed_broadcast(const SceneUpdate& command)
+{
+#ifdef DISTRIBUTED
+    std::string data = command.SerializeAsString();
+    uint64_t size = data.size();
 
-        result.set_success(false);
-        result.set_message(msg);
+    assert(size < (uint64_t)std::numeric_limits<int>::max());
 
-        printf("... FAILED: %s\n", msg);
+    MPI_Bcast(&size, 1, MPI_UINT64_T, 0, distributed_comm);
+    MPI_Bcast(&data[0], size, MPI_BYTE, 0, distributed_comm);
+#endif
+}
 
-        send_protobuf(sock, result);
-    }
+void
+distributed_broadcast(ClientMessage::Type type, const std::vector<std::string>& messages)
+{
+    SceneUpdate command;
 
-    return true;
+    command.set_type(type);
+    for (const std::string& message : messages)
+        command.add_messages(message);
+
+    distributed_broadcast(command);
 }
 
-bool
-clear_scene(const std::string& type)
+// Rank 0: announces the frame about to be rendered with ospRenderFrame(), 
+// which the other ranks need to call as well
+void
+distributed_broadcast_render_frame()
 {
-    printf("Clearing scene\n");
-    printf("... type: %s\n", type.c_str());
-        
-    if (ospray_world != nullptr)
-        ospRelease(ospray_world);
-    
-    ospray_world = ospNewWorld();    
-    //ospSetBool(ospray_world, "compactMode", true);
+    ClientMessage message;
 
-    if (ospray_scene_instances_data != nullptr)
-        ospRelease(ospray_scene_instances_data);
-        
-    if (ospray_scene_lights_data != nullptr)
-        ospRelease(ospray_scene_lights_data);   
+    message.set_type(ClientMessage::DISTRIBUTED_RENDER_FRAME);
+    message.set_string_value(render_mode == RM_FINAL ? "final" : "interactive");
+    message.set_uint_value(current_sample);
+    message.set_uint_value2(framebuffer_reduction_index);
 
-    ospray_scene_instances.clear();
-    ospray_scene_instances_data = nullptr;
-    update_ospray_scene_instances = true;
+    distributed_broadcast(ClientMessage::DISTRIBUTED_RENDER_FRAME, { message.SerializeAsString() });
+}
 
-    ospray_scene_lights.clear();
-    ospray_scene_lights.push_back(ospray_scene_ambient_light);
-    ospray_scene_lights_data = nullptr;
-    update_ospray_scene_lights = true;
+// Other ranks: render the frame announced by rank 0
+void
+distributed_render_frame(const ClientMessage& message)
+{
+    OSPFrameBuffer framebuffer;
 
-    for (auto& so : scene_objects)
-        delete so.second;
-    scene_objects.clear();
+    current_sample = message.uint_value();
 
-    if (type == "keep_plugin_instances")
+    if (message.string_value() == "final")
+        framebuffer = final_framebuffer;
+    else
     {
-        std::set<std::string> data_to_delete;
+        const int index = message.uint_value2();
 
-        for (auto& kv : scene_data_types)
+        if (index != framebuffer_reduction_index)
         {
-            if (kv.second != SDT_PLUGIN)
-                data_to_delete.insert(kv.first);
+            // Next (higher) resolution framebuffer, see handle_connection()
+            framebuffer_reduction_index = index;
+            framebuffer_reduction_factor = framebuffer_reduction_factors[index];
+            framebuffers[index].clear();
         }
 
-        for (auto& name : data_to_delete)
-            delete_scene_data(name);
-    }
-    else
-    {
-        // "all"
-        delete_all_scene_data();    
+        framebuffer = framebuffers[index].framebuffer;
+
+        use_volume_lod(framebuffer_reduction_factor > 1);
     }
 
-    for (auto& sm : scene_materials)
-        delete sm.second;
-    scene_materials.clear();
+    if (ospray_world_changed)
+        commit_world();
 
-    return true;
+    OSPFuture future = ospRenderFrame(framebuffer, ospray_renderer, ospray_camera, ospray_world);
+
+    server_mutex.unlock();
+    ospWait(future, OSP_TASK_FINISHED);
+    server_mutex.lock();
+
+    ospRelease(future);
 }
 
-bool
-prepare_scene()
+// Other ranks: apply a command from rank 0
+void
+distributed_apply(const SceneUpdate& command)
 {
-    if (update_ospray_scene_instances)
+    ClientMessage client_message;
+    std::string error;
+
+    switch (command.type())
     {
-        if (ospray_scene_instances_data != nullptr)
-            ospRelease(ospray_scene_instances_data);    
+    case ClientMessage::UPDATE_PLUGIN_INSTANCE:
+    case ClientMessage::UPDATE_OBJECT:
+    case ClientMessage::UPDATE_MATERIAL:
+        // Objects linking to data that only lives on rank 0 (Blender meshes) fail here
+        if (!apply_scene_update(command, error))
+            printf("... WARNING: rank %d: scene update failed: %s\n", mpi_rank, error.c_str());
+        break;
 
-        printf("Setting up world with %d instance(s)\n", ospray_scene_instances.size());
+    case ClientMessage::UPDATE_SCENE_BATCH:
+    {
+        SceneUpdateBatch batch;
 
-        if (ospray_scene_instances.size() > 0)
+        batch.ParseFromString(command.messages(0));
+
+        for (const SceneUpdate& update : batch.updates())
         {
-            ospray_scene_instances_data = ospNewSharedData(&ospray_scene_instances[0], OSP_INSTANCE, ospray_scene_instances.size());
-            ospCommit(ospray_scene_instances_data);
-            ospSetObject(ospray_world, "instance", ospray_scene_instances_data);    
-            ospRetain(ospray_scene_instances_data);
+            if (!apply_scene_update(update, error))
+                printf("... WARNING: rank %d: scene update failed: %s\n", mpi_rank, error.c_str());
         }
 
-        update_ospray_scene_instances = false;
+        break;
     }
-    else
-        printf("World instances (%d) still up-to-date\n", ospray_scene_instances.size());
 
-    if (update_ospray_scene_lights)
+    case ClientMessage::UPDATE_RENDER_SETTINGS:
     {
-        if (ospray_scene_lights_data != nullptr)
-            ospRelease(ospray_scene_lights_data);
-    
-        printf("Setting up %d light(s) in the world\n", ospray_scene_lights.size());
+        RenderSettings render_settings;
+        render_settings.ParseFromString(command.messages(0));
+        update_render_settings(render_settings);
+        break;
+    }
 
-        if (ospray_scene_lights.size() > 0)
-        {
-            ospray_scene_lights_data = ospNewSharedData(&ospray_scene_lights[0], OSP_LIGHT, ospray_scene_lights.size());
-            ospCommit(ospray_scene_lights_data);
-            ospSetObject(ospray_world, "light", ospray_scene_lights_data);
-            ospRetain(ospray_scene_lights_data);
-        }
+    case ClientMessage::UPDATE_WORLD_SETTINGS:
+    {
+        WorldSettings world_settings;
+        world_settings.ParseFromString(command.messages(0));
+        update_world_settings(world_settings);
+        break;
+    }
 
-        update_ospray_scene_lights = false;
+    case ClientMessage::UPDATE_CAMERA:
+    {
+        CameraSettings camera_settings;
+        camera_settings.ParseFromString(command.messages(0));
+        update_camera(camera_settings);
+        break;
     }
-    else
-        printf("World lights (%d) still up-to-date\n", ospray_scene_lights.size());
 
-    ospCommit(ospray_world);
+    default:
+        client_message.ParseFromString(command.messages(0));
 
-    return true;
-}
+        switch (command.type())
+        {
+        case ClientMessage::UPDATE_RENDERER_TYPE:
+            update_renderer_type(client_message.string_value());
+            break;
 
-bool 
-handle_hello(TCPSocket *sock, const ClientMessage& client_message)
-{
-    const uint32_t client_version = client_message.uint_value();    
+        case ClientMessage::CLEAR_SCENE:
+            clear_scene(client_message.string_value());
+            break;
 
-    HelloResult result;
-    bool res = true;
+        case ClientMessage::UPDATE_FRAMEBUFFER_SETTINGS:
+            update_framebuffer_settings(client_message.string_value(),
+                (OSPFrameBufferFormat)(client_message.uint_value()), 
+                client_message.uint_value2(), client_message.uint_value3(),
+                client_message.uint_value4(), client_message.float_value());
+            break;
 
-    if (client_version != PROTOCOL_VERSION)
-    {
-        char s[256];
-        sprintf(s, "Client protocol version %d does not match our protocol version %d", client_version, PROTOCOL_VERSION);
-        printf("ERROR: %s\n", s);
+        case ClientMessage::DELETE_PLUGIN_INSTANCE:
+            if (scene_data_with_type_exists(client_message.string_value(), SDT_PLUGIN))
+                delete_scene_data(client_message.string_value());
+            break;
 
-        result.set_success(false);
-        result.set_message(s);
-        res = false;  
-    } 
-    else
-    {
-        //printf("Got HELLO message, client protocol version %d matches ours\n", client_version);
-        result.set_success(true);
-    }
+        case ClientMessage::START_RENDERING:
+            // Sets up framebuffers, scene and renderer, but doesn't render 
+            // (see render_frame()), frames follow as DISTRIBUTED_RENDER_FRAME
+            render_mode = RM_IDLE;
+            start_rendering(client_message);
+            break;
 
-    send_protobuf(sock, result);
+        case ClientMessage::DISTRIBUTED_RENDER_FRAME:
+            distributed_render_frame(client_message);
+            break;
 
-    return res;
+        default:
+            printf("WARNING: rank %d: unhandled command %d!\n", mpi_rank, command.type());
+        }
+    }
 }
 
+// Other ranks: apply the commands received from rank 0, forever.
+// These ranks have a single session.
 void
-ensure_idle_render_mode()
+distributed_worker_loop()
 {
-    if (render_mode == RM_IDLE)
-        return;
+#ifdef DISTRIBUTED
+    SceneUpdate command;
+    std::string data;
+    uint64_t size;
 
-    if (render_future == nullptr)
-        return;
+    server_mutex.lock();
 
-    ospCancel(render_future);
-    ospWait(render_future, OSP_TASK_FINISHED);
+    session = new Session;
+    session->name = "default";
+    session->id = 0;
 
-    ospRelease(render_future);
-    render_future = nullptr;
+    prepare_renderers();
 
-    render_mode = RM_IDLE;
+    printf("Rank %d: waiting for commands from rank 0\n", mpi_rank);
 
-    printf("Canceled active render\n");
+    while (true)
+    {
+        server_mutex.unlock();
+
+        MPI_Bcast(&size, 1, MPI_UINT64_T, 0, distributed_comm);
+        data.resize(size);
+        MPI_Bcast(&data[0], size, MPI_BYTE, 0, distributed_comm);
+
+        server_mutex.lock();
+
+        if (!command.ParseFromString(data))
+        {
+            printf("ERROR: rank %d: could not parse command (%ld bytes)\n", mpi_rank, (long)size);
+            continue;
+        }
+
+        distributed_apply(command);
+    }
+#endif
 }
 
 // Returns false on socket errors
@@ -2998,6 +6177,22 @@ handle_client_message(TCPSocket *sock, const ClientMessage& client_message, bool
 {
     connection_done = false;
 
+    // Covers receiving and handling any data following the message
+    ScopedTimer timer(timings, "message " + ClientMessage_Type_Name(client_message.type()));
+
+    // Distributed mode: replicate the client messages that change the 
+    // scene or start rendering to the other ranks
+    received_protobufs.clear();
+    record_received_protobufs = false;
+
+    if (mpi_size > 1)
+    {
+        if (distributed_replicate_before(client_message.type()))
+            distributed_broadcast(client_message.type(), { client_message.SerializeAsString() });
+        else
+            record_received_protobufs = distributed_replicate_after(client_message.type());
+    }
+
     switch (client_message.type())
     {
         case ClientMessage::HELLO:
@@ -3015,11 +6210,6 @@ handle_client_message(TCPSocket *sock, const ClientMessage& client_message, bool
             printf("Got BYE message\n");
             ensure_idle_render_mode();
             sock->close();
-            if (render_mode == RM_INTERACTIVE && render_output_socket != nullptr)
-            {
-                render_output_socket->close();
-                render_output_socket = nullptr;
-            }
             connection_done = true;
             return true;
 
@@ -3029,11 +6219,6 @@ handle_client_message(TCPSocket *sock, const ClientMessage& client_message, bool
             printf("Got QUIT message\n");
             ensure_idle_render_mode();
             sock->close();
-            if (render_mode == RM_INTERACTIVE && render_output_socket != nullptr)
-            {
-                render_output_socket->close();
-                render_output_socket = nullptr;
-            }
             connection_done = true;
             return true;
 
@@ -3097,12 +6282,32 @@ handle_client_message(TCPSocket *sock, const ClientMessage& client_message, bool
             ensure_idle_render_mode();
             handle_update_object(sock);
             break;
+
+        case ClientMessage::UPDATE_SCENE_BATCH:
+            ensure_idle_render_mode();
+            if (!handle_update_scene_batch(sock, client_message))
+            {
+                sock->close();
+                connection_done = true;
+                return false;
+            }
+            break;
+
+        case ClientMessage::SUBMIT_ANIMATION_JOB:
+            if (!handle_submit_animation_job(sock, client_message))
+            {
+                sock->close();
+                connection_done = true;
+                return false;
+            }
+            break;
         
         case ClientMessage::UPDATE_FRAMEBUFFER_SETTINGS:
             ensure_idle_render_mode();
             update_framebuffer_settings(client_message.string_value(),
                 (OSPFrameBufferFormat)(client_message.uint_value()), 
-                client_message.uint_value2(), client_message.uint_value3());
+                client_message.uint_value2(), client_message.uint_value3(),
+                client_message.uint_value4(), client_message.float_value());
             break;
 
         case ClientMessage::UPDATE_CAMERA:
@@ -3133,7 +6338,7 @@ handle_client_message(TCPSocket *sock, const ClientMessage& client_message, bool
             break;
 
         case ClientMessage::QUERY_BOUND:
-            handle_query_bound(sock, client_message.string_value());
+            handle_query_bound(sock, client_message);
             break;
 
         case ClientMessage::START_RENDERING:
@@ -3174,11 +6379,51 @@ handle_client_message(TCPSocket *sock, const ClientMessage& client_message, bool
             connection_done = true;
             break;
 
-        default:
-            printf("WARNING: unhandled client message %d!\n", client_message.type());
-    }
+        default:
+            printf("WARNING: unhandled client message %d!\n", client_message.type());
+    }
+
+    if (record_received_protobufs)
+    {
+        record_received_protobufs = false;
+        distributed_broadcast(client_message.type(), received_protobufs);
+    }
+
+    return true;
+}
+
+void
+set_variance_threshold(float threshold)
+{
+    ospSetFloat(ospray_renderer, "varianceThreshold", threshold);
+    ospCommit(ospray_renderer);
+}
+
+// Ends a final render early, by lowering render_samples, when the 
+// variance target is reached or the time budget is used up
+void
+check_final_render_termination(float variance, struct timeval now)
+{
+    const char *reason = nullptr;
+
+    // Variance is only estimated from the second sample on
+    if (final_render_variance_target > 0.0f && current_sample >= 2 && variance <= final_render_variance_target)
+        reason = "Variance target reached";
+    else if (final_render_time_budget > 0.0f && time_diff(rendering_start_time, now) >= final_render_time_budget)
+        reason = "Time budget used";
+
+    if (reason == nullptr)
+        return;
+
+    int last_sample = current_sample;
+
+    // Render one more sample, for the denoiser
+    if (denoise_final && denoiser != nullptr && !final_framebuffer_denoising && final_framebuffer_format == OSP_FB_RGBA32F)
+        last_sample++;
+
+    printf("| %s, last sample %d ", reason, last_sample);
 
-    return true;
+    render_samples = last_sample;
 }
 
 void
@@ -3209,10 +6454,24 @@ start_rendering(const ClientMessage& client_message)
 
         framebuffer = final_framebuffer;
         ospResetAccumulation(final_framebuffer);
+
+        final_render_variance_target = client_message.float_value();
+        final_render_time_budget = client_message.uint_value3();
+
+        if (final_render_variance_target > 0.0f)
+            printf("... Rendering until variance < %.4f (at most %d samples)\n", final_render_variance_target, render_samples);
+        if (final_render_time_budget > 0.0f)
+            printf("... Time budget %.0f seconds\n", final_render_time_budget);
+
+        // Adaptive accumulation, so converged tiles stop getting sampled
+        set_variance_threshold(final_render_variance_target > 0.0f ? final_render_variance_target : renderer_variance_threshold);
     }
     else if (mode == "interactive")
     {
         render_mode = RM_INTERACTIVE;
+
+        final_render_variance_target = final_render_time_budget = 0.0f;
+        set_variance_threshold(renderer_variance_threshold);
         framebuffer_initial_reduction_factor = client_message.uint_value2();
         framebuffer_update_rate = 1;
 
@@ -3251,11 +6510,8 @@ start_rendering(const ClientMessage& client_message)
                     interactive_framebuffer_width, interactive_framebuffer_height, factor, 
                     interactive_framebuffer_format);
 
-                int channels = OSP_FB_COLOR | /*OSP_FB_DEPTH |*/ OSP_FB_ACCUM | OSP_FB_VARIANCE;
-                //int channels = OSP_FB_COLOR | /*OSP_FB_DEPTH |*/ OSP_FB_ACCUM | OSP_FB_VARIANCE | OSP_FB_NORMAL | OSP_FB_ALBEDO;
-
                 framebuffers.push_back(
-                    AllocatedFramebuffer(reduced_framebuffer_width, reduced_framebuffer_height, interactive_framebuffer_format, channels)
+                    AllocatedFramebuffer(reduced_framebuffer_width, reduced_framebuffer_height, interactive_framebuffer_format, framebuffer_channels())
                 );
             }
         }
@@ -3274,9 +6530,14 @@ start_rendering(const ClientMessage& client_message)
     }
         
     cancel_rendering = false;
+    send_full_framebuffer = true;
 
     // Set up world and scene objects
-    prepare_scene();   
+    {
+        ScopedTimer timer(timings, "prepare scene");
+        prepare_scene();
+        scene_prepare_time = timer.stop();
+    }
 
     if (dump_server_state)
         print_server_state();    
@@ -3290,42 +6551,90 @@ start_rendering(const ClientMessage& client_message)
         printf("[%d/%d] ", current_sample, render_samples);
 
     printf("I:%d L:%d m:%d | ", ospray_scene_instances.size(), ospray_scene_lights.size(), scene_materials.size());
-    fflush(stdout);    
 
-    gettimeofday(&frame_start_time, NULL);
+    // Use the LOD versions of volumes for the reduced-resolution frames
+    use_volume_lod(render_mode == RM_INTERACTIVE && framebuffer_reduction_factor > 1);
 
-    render_future = ospRenderFrame(framebuffer, ospray_renderer, ospray_camera, ospray_world);
-    
-    if (render_future == nullptr)
-        printf("ERROR: ospRenderFrame() returned NULL!\n");
+    fflush(stdout);    
+
+    render_frame(framebuffer);
 }
    
 // Connection handling
 
+// Called with server_mutex held, the HELLO message has already been
+// received
 bool
-handle_connection(TCPSocket *sock)
+handle_connection(TCPSocket *sock, const ClientMessage& hello)
 {
     ClientMessage       client_message;
     bool                connection_done;
 
-    struct stat         st;
-
-    char                fname[1024];
     float               variance;
     float               mem_usage, peak_memory_usage=0.0f;    
     struct timeval      frame_end_time, now;
 
     RenderResult        render_result;
 
+    struct pollfd       fds[3];
+    int                 nfds, res;
+
+    if (!handle_hello(sock, hello))
+    {
+        sock->close();
+        return false;
+    }
+
     while (true)
     {
-        usleep(1000);
+        // Block until a client message arrives, the current frame
+        // finishes, or the render output connection goes away
+
+        fds[0].fd = sock->get_fd();
+        fds[0].events = POLLIN;
+        fds[1].fd = render_done_pipe[0];
+        fds[1].events = POLLIN;
+        nfds = 2;
+
+        if (render_output_socket != nullptr)
+        {
+            // Only interested in POLLHUP/POLLERR, which are always reported
+            fds[2].fd = render_output_socket->get_fd();
+            fds[2].events = 0;
+            nfds = 3;
+        }
+
+        for (int i = 0; i < nfds; i++)
+            fds[i].revents = 0;
+
+        // Let other sessions do their thing while we wait
+        server_mutex.unlock();
+        res = poll(fds, nfds, -1);
+        server_mutex.lock();
 
-        // Check for new client message
-        // XXX loop to get more messages before checking frame is done, as we 
-        // currently have an implicit limit due to the usleep above
+        if (res == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            perror("poll() failed");
+            // XXX if we were rendering, handle the chaos
+            sock->close();
+            return false;
+        }
+
+        if (nfds == 3 && (fds[2].revents & (POLLHUP|POLLERR)))
+        {
+            printf("Render output connection closed by client\n");
+            wait_for_framebuffer_sends();
+            render_output_socket->close();
+            delete render_output_socket;
+            render_output_socket = nullptr;
+        }
+
+        // Handle all pending client messages before checking on the frame
 
-        while (sock->is_readable())
+        while ((fds[0].revents & (POLLIN|POLLHUP|POLLERR)) && sock->is_readable())
         {            
             if (!receive_protobuf(sock, client_message))
             {
@@ -3344,6 +6653,10 @@ handle_connection(TCPSocket *sock)
                 printf("<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<\n");
             }
 
+            // Don't interleave replies with framebuffer output still being sent
+            if (render_mode != RM_IDLE)
+                wait_for_framebuffer_sends();
+
             if (!handle_client_message(sock, client_message, connection_done))
             {
                 printf("Failed to handle client message, goodbye!\n");
@@ -3362,12 +6675,8 @@ handle_connection(TCPSocket *sock)
         {    
             printf("CANCELING RENDER...\n");
 
-            // See https://github.com/ospray/ospray/issues/368
-            ospCancel(render_future);
-            ospWait(render_future, OSP_TASK_FINISHED);
-
-            ospRelease(render_future);
-            render_future = nullptr;
+            finish_render_frame(true);
+            wait_for_framebuffer_sends();
 
             gettimeofday(&now, NULL);
             printf("Rendering cancelled after %.3f seconds\n", time_diff(rendering_start_time, now));
@@ -3385,15 +6694,15 @@ handle_connection(TCPSocket *sock)
             continue;            
         }
                 
-        if (!ospIsReady(render_future, OSP_TASK_FINISHED))
+        if (render_future == nullptr || !ospIsReady(render_future, OSP_TASK_FINISHED))
             continue;
 
         // Frame done, process it
 
         gettimeofday(&frame_end_time, NULL);        
+        timings.add("render", frame_start_clock, TimingClock::now());
         
-        ospRelease(render_future);
-        render_future = nullptr;
+        finish_render_frame(false);
 
         OSPFrameBuffer framebuffer;
 
@@ -3407,6 +6716,12 @@ handle_connection(TCPSocket *sock)
         printf("Frame %7.3f s | Var %5.3f | Mem %7.1f MB ", 
                 time_diff(frame_start_time, frame_end_time), variance, mem_usage);
 
+        if (render_mode == RM_FINAL ? final_framebuffer_denoising : framebuffers[framebuffer_reduction_index].denoising)
+            printf("| Denoised ");
+
+        if (render_mode == RM_FINAL && current_sample < render_samples)
+            check_final_render_termination(variance, frame_end_time);
+
         mem_usage = memory_usage();
         peak_memory_usage = std::max(mem_usage, peak_memory_usage);        
 
@@ -3415,6 +6730,18 @@ handle_connection(TCPSocket *sock)
         render_result.set_variance(variance);        
         render_result.set_memory_usage(mem_usage);
         render_result.set_peak_memory_usage(peak_memory_usage);
+        render_result.set_render_time(time_diff(frame_start_time, frame_end_time));
+        render_result.set_prepare_time(scene_prepare_time);
+        render_result.set_send_time(framebuffer_sender->last_send_time.load());
+
+        // Hand off the frame to the sender thread. Blocks if all send
+        // jobs are still in use, i.e. the network is the bottleneck.
+
+        FramebufferSendJob *job = framebuffer_sender->free_jobs.pop();
+
+        job->send_pixels = false;
+        job->shm_slot = -1;
+        job->shm_slot_size = shm_slot_size;
         
         if (render_mode == RM_FINAL)
         {    
@@ -3422,6 +6749,12 @@ handle_connection(TCPSocket *sock)
             render_result.set_width(final_framebuffer_width);
             render_result.set_height(final_framebuffer_height);
 
+            job->sock = sock;
+            job->final = true;
+            job->format = final_framebuffer_format;
+            job->encoding = RenderResult::RAW;
+            job->full_frame = true;
+
             // Depending on the framebuffer update rate check if we need to send
             // the framebuffer. In case this was the last sample always send it.
             if ((framebuffer_update_rate > 0 
@@ -3431,92 +6764,75 @@ handle_connection(TCPSocket *sock)
                 || 
                 current_sample == render_samples)
             {
-                // Save framebuffer to file 
-                sprintf(fname, "/dev/shm/blospray-final-%04d.exr", current_sample);
-#if 0
-                const float *color = (float*)ospMapFrameBuffer(final_framebuffer, OSP_FB_COLOR);     
-                const float *normal = (float*)ospMapFrameBuffer(final_framebuffer, OSP_FB_NORMAL);     
-                const float *albedo = (float*)ospMapFrameBuffer(final_framebuffer, OSP_FB_ALBEDO);     
-
-                writeFramebufferEXR(fname, final_framebuffer_width, final_framebuffer_height, framebuffer_compression, color, nullptr, normal, albedo);
-                
-                ospUnmapFrameBuffer(color, final_framebuffer);
-                ospUnmapFrameBuffer(normal, final_framebuffer);
-                ospUnmapFrameBuffer(albedo, final_framebuffer);
-#else
-                const float *color = (float*)ospMapFrameBuffer(final_framebuffer, OSP_FB_COLOR);   
-                writeFramebufferEXR(fname, final_framebuffer_width, final_framebuffer_height, framebuffer_compression, color);
-                ospUnmapFrameBuffer(color, final_framebuffer);
-#endif
-
-                stat(fname, &st);
-
-                gettimeofday(&now, NULL);
-                printf("| Save FB %6.3f s | EXR file %.1f MB\n", time_diff(frame_end_time, now), st.st_size/1000000.0f);
-
-                render_result.set_file_name(fname);
-                render_result.set_file_size(st.st_size);
-
-                send_protobuf(sock, render_result);
-
-                sock->sendfile(fname);
-
-                // Remove local framebuffer file
-                if (!keep_framebuffer_files)
-                    unlink(fname);
+                job->send_pixels = true;
+                job->width = final_framebuffer_width;
+                job->height = final_framebuffer_height;
             }
             else
             {
                 // Signal to the client that there is no framebuffer data for this sample
                 render_result.set_file_name("<skipped>");
                 render_result.set_file_size(0);
-                
-                printf("| Skipped FB\n");
-                
-                send_protobuf(sock, render_result);
             }
         }
         else if (render_mode == RM_INTERACTIVE)
         {
-            // Send framebuffer directly, instead of as a file
-
             render_result.set_reduction_factor(framebuffer_reduction_factor);
             render_result.set_width(reduced_framebuffer_width);
             render_result.set_height(reduced_framebuffer_height);    
 
-            // XXX could be different pixel type?
-            const float *fb = (float*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+            job->sock = render_output_socket != nullptr ? render_output_socket : sock;
+            job->final = false;
+            job->format = interactive_framebuffer_format;
+            job->encoding = interactive_framebuffer_encoding;
+            job->tile_threshold = interactive_framebuffer_tile_threshold;
+            // Always send the first and last frame completely
+            job->full_frame = send_full_framebuffer 
+                || (current_sample == render_samples && framebuffer_reduction_factor == 1);
+            send_full_framebuffer = false;
+            job->send_pixels = true;
+            job->width = reduced_framebuffer_width;
+            job->height = reduced_framebuffer_height;
+        }
 
-            const int bufsize = reduced_framebuffer_width*reduced_framebuffer_height*4*sizeof(float);
+        if (job->send_pixels && job->final && shm_ptr != nullptr)
+        {
+            // No need for a staging copy
+            ScopedTimer timer(timings, "framebuffer copy");
+            job->shm_slot = shm_transport_write(framebuffer, job->width, job->height, current_sample);
+            render_result.set_framebuffer_copy_time(timer.stop());
 
-            render_result.set_file_name("<memory>");
-            render_result.set_file_size(bufsize);
+            gettimeofday(&now, NULL);
+            printf("| Copy FB (shm) %6.3f s\n", time_diff(frame_end_time, now));
+        }
 
-            if (render_output_socket != nullptr)
-            {
-                send_protobuf(render_output_socket, render_result);
-                render_output_socket->sendall((const uint8_t*)fb, bufsize);
-            }
-            else
-            {
-                send_protobuf(sock, render_result);
-                sock->sendall((const uint8_t*)fb, bufsize);
-            }
+        // Staging copy, when not written to shared memory
+        if (job->send_pixels && job->shm_slot < 0)
+        {
+            ScopedTimer timer(timings, "framebuffer copy");
 
-            if (keep_framebuffer_files)
-            {
-                sprintf(fname, "/dev/shm/blospray-interactive-%04d-%d.exr", current_sample, framebuffer_reduction_factor);                    
-                writeFramebufferEXR(fname, reduced_framebuffer_width, reduced_framebuffer_height, framebuffer_compression, fb);
-            }
-            
-            ospUnmapFrameBuffer(fb, framebuffer);        
+            const size_t n = job->width*job->height*framebuffer_pixel_size(job->format);
+            const uint8_t *fb = (const uint8_t*)ospMapFrameBuffer(framebuffer, OSP_FB_COLOR);
+
+            job->pixels.resize(n);
+            memcpy(job->pixels.data(), fb, n);
+
+            ospUnmapFrameBuffer(fb, framebuffer);
+
+            render_result.set_framebuffer_copy_time(timer.stop());
 
             gettimeofday(&now, NULL);
-            if (render_output_socket != nullptr)
-                printf("| Send FB* %6.3f s | Pixels %6.1f MB\n", time_diff(frame_end_time, now), bufsize/1000000.0f);
-            else
-                printf("| Send FB %6.3f s | Pixels %6.1f MB\n", time_diff(frame_end_time, now), bufsize/1000000.0f);  
+            printf("| Copy FB %6.3f s | Last send %6.3f s (%.1f MB)%s\n", 
+                time_diff(frame_end_time, now), 
+                framebuffer_sender->last_send_time.load(), framebuffer_sender->last_send_size.load(),
+                job->sock == render_output_socket ? "*" : "");
         }
+        else
+            printf("| Skipped FB\n");
+
+        job->render_result = render_result;
+
+        framebuffer_sender->send_queue.push(job);
 
         // Check if we're done rendering
 
@@ -3524,6 +6840,8 @@ handle_connection(TCPSocket *sock)
         {
             // Rendering done!
 
+            wait_for_framebuffer_sends();
+
             mem_usage = memory_usage();
             peak_memory_usage = std::max(mem_usage, peak_memory_usage);
                         
@@ -3569,26 +6887,16 @@ handle_connection(TCPSocket *sock)
 
             printf("I:%d L:%d m:%d | ", ospray_scene_instances.size(), ospray_scene_lights.size(), scene_materials.size());
 
-            fflush(stdout);
-            
-            gettimeofday(&frame_start_time, NULL);
+            use_volume_lod(render_mode == RM_INTERACTIVE && framebuffer_reduction_factor > 1);
 
-            render_future = ospRenderFrame(framebuffer, ospray_renderer, ospray_camera, ospray_world);
+            fflush(stdout);
 
-            if (render_future == nullptr)
-                printf("ERROR: ospRenderFrame() returned NULL!\n");
+            render_frame(framebuffer);
         }
     }
 
     sock->close();
 
-    if (render_output_socket != nullptr)
-    {
-        printf("Closing render output connection\n");
-        render_output_socket->close();
-        render_output_socket = nullptr;
-    }
-
     return true;
 }
 
@@ -3597,8 +6905,19 @@ prepare_renderers()
 {
     OSPMaterial m;
 
-    renderers["scivis"] = ospNewRenderer("scivis");
-    renderers["pathtracer"] = ospNewRenderer("pathtracer");
+    if (mpi_size > 1)
+    {
+        // The distributed device has its own renderer, which we use for
+        // both renderer types
+        // XXX pathtracer settings don't apply
+        renderers["scivis"] = ospNewRenderer("mpi_raycast");
+        renderers["pathtracer"] = ospNewRenderer("mpi_raycast");
+    }
+    else
+    {
+        renderers["scivis"] = ospNewRenderer("scivis");
+        renderers["pathtracer"] = ospNewRenderer("pathtracer");
+    }
 
     m = default_materials["scivis"] = ospNewMaterial("scivis", "obj");
        ospSetVec3f(m, "kd", 0.8f, 0.8f, 0.8f);
@@ -3612,6 +6931,232 @@ prepare_renderers()
     ospray_scene_ambient_light = ospNewLight("ambient");
 }
 
+// Sessions
+
+// Releases the session's (thread_local) state. Called with server_mutex
+// held, by the session thread when the session ends.
+void
+end_session()
+{
+    ensure_idle_render_mode();
+
+    if (render_wait_thread.joinable())
+        render_wait_thread.join();
+
+    stop_framebuffer_send_thread();
+
+    if (render_output_socket != nullptr)
+    {
+        render_output_socket->close();
+        delete render_output_socket;
+        render_output_socket = nullptr;
+    }
+
+    // Plugin states shared with other sessions are kept by them
+    clear_scene("all");
+
+    ospRelease(ospray_world);
+    ospray_world = nullptr;
+
+    ospray_scene_lights.clear();
+    ospRelease(ospray_scene_ambient_light);
+    ospray_scene_ambient_light = nullptr;
+
+    if (ospray_camera != nullptr)
+    {
+        ospRelease(ospray_camera);
+        ospray_camera = nullptr;
+    }
+
+    framebuffers.clear();
+    framebuffer_reduction_factors.clear();
+
+    if (final_framebuffer != nullptr)
+    {
+        ospRelease(final_framebuffer);
+        final_framebuffer = nullptr;
+    }
+
+    for (auto& kv : renderers)
+        ospRelease(kv.second);
+    renderers.clear();
+    ospray_renderer = nullptr;
+
+    for (auto& kv : default_materials)
+        ospRelease(kv.second);
+    default_materials.clear();
+
+    close(render_done_pipe[0]);
+    close(render_done_pipe[1]);
+    render_done_pipe[0] = render_done_pipe[1] = -1;
+}
+
+void
+session_thread_func(Session *s)
+{
+    server_mutex.lock();
+
+    session = s;
+
+    // Set up the session's (thread_local) state
+    prepare_renderers();
+
+    if (pipe(render_done_pipe) == -1)
+    {
+        perror("pipe() failed");
+        exit(-1);
+    }
+    fcntl(render_done_pipe[0], F_SETFL, O_NONBLOCK);
+
+    start_framebuffer_send_thread();
+
+    PendingConnection *pc = nullptr;
+
+    while (true)
+    {
+        server_mutex.unlock();
+
+        bool have_connection;
+
+        // The other ranks mirror this (single) session, so keep it
+        if (mpi_size > 1)
+        {
+            pc = session->connections.pop();
+            have_connection = true;
+        }
+        else
+            have_connection = session->connections.pop(pc, session_timeout);
+
+        server_mutex.lock();
+
+        if (!have_connection)
+        {
+            // A connection might have been handed to us in the meantime, 
+            // which is done holding sessions_mutex
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+
+            if (session->connections.size() > 0)
+                continue;
+
+            sessions.erase(session->name);
+            ended_sessions.push_back(session);
+            break;
+        }
+
+        printf("Session '%s': handling connection\n", session->name.c_str());
+
+        if (!handle_connection(pc->sock, pc->hello))
+            printf("Error handling connection!\n");
+
+        // A render output connection is kept for the connection that
+        // follows it. Otherwise the connection is gone (possibly halfway
+        // a render), so don't leave its render state behind for the next.
+        if (pc->sock != render_output_socket)
+        {
+            // Between frames there's no render to cancel, but the mode
+            // would still make the next START_RENDERING get ignored
+            ensure_idle_render_mode();
+            render_mode = RM_IDLE;
+            cancel_rendering = false;
+            wait_for_framebuffer_sends();
+
+            if (render_output_socket != nullptr)
+            {
+                printf("Closing render output connection\n");
+                render_output_socket->close();
+                delete render_output_socket;
+                render_output_socket = nullptr;
+            }
+
+            delete pc->sock;
+        }
+
+        // Shared memory transport is per connection
+        shm_transport_close();
+
+        if (trace_file != nullptr)
+        {
+            if (timings.write_trace(trace_file))
+                printf("Wrote trace to %s\n", trace_file);
+            else
+                printf("WARNING: could not write trace to %s\n", trace_file);
+        }
+
+        delete pc;
+
+        // Render queued animation jobs. New connections to the session 
+        // wait until these are done.
+        while (session->animation_jobs.size() > 0)
+            run_animation_job(session->animation_jobs.pop());
+    }
+
+    printf("Session '%s': no connection for %d seconds, ending it\n", session->name.c_str(), session_timeout);
+
+    end_session();
+
+    server_mutex.unlock();
+}
+
+// Receives the HELLO message of a new connection and hands the connection
+// to the thread of its session, which gets started for a new session.
+// Runs in a thread per connection, so a client that doesn't send anything
+// doesn't hold up other connections.
+void
+connection_thread_func(TCPSocket *sock)
+{
+    ClientMessage hello;
+    struct pollfd fd = { sock->get_fd(), POLLIN, 0 };
+
+    if (poll(&fd, 1, HELLO_TIMEOUT*1000) != 1 || !receive_protobuf(sock, hello) || hello.type() != ClientMessage::HELLO)
+    {
+        printf("ERROR: expected HELLO message on new connection, closing it\n");
+        sock->close();
+        delete sock;
+        return;
+    }
+
+    // When distributed the other ranks only mirror a single session
+    const std::string session_name = (hello.string_value2() == "" || mpi_size > 1) ? "default" : hello.string_value2();
+
+    PendingConnection *pc = new PendingConnection;
+    pc->sock = sock;
+    pc->hello = hello;
+
+    std::vector<Session*> ended;
+
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+
+        Session *s;
+        std::map<std::string, Session*>::iterator it = sessions.find(session_name);
+
+        if (it == sessions.end())
+        {
+            s = new Session;
+            s->name = session_name;
+            s->id = next_session_id++;
+            sessions[session_name] = s;
+
+            printf("New session '%s' (%d)\n", session_name.c_str(), s->id);
+
+            s->thread = std::thread(session_thread_func, s);
+        }
+        else
+            s = it->second;
+
+        s->connections.push(pc);
+
+        ended.swap(ended_sessions);
+    }
+
+    // Clean up after sessions that ended since the previous connection
+    for (Session *s : ended)
+    {
+        s->thread.join();
+        delete s;
+    }
+}
+
 // Error/status display
 
 void
@@ -3659,11 +7204,83 @@ main(int argc, const char **argv)
         exit(-1);
     }
 
+#ifdef DISTRIBUTED
+    // Rank 0 talks to the clients, all ranks render. The distributed 
+    // device itself uses MPI from multiple threads.
+    int mpi_thread_support;
+
+    MPI_Init_thread(&argc, (char***)&argv, MPI_THREAD_MULTIPLE, &mpi_thread_support);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mpi_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &mpi_size);
+
+    if (mpi_size > 1)
+    {
+        if (mpi_thread_support < MPI_THREAD_MULTIPLE)
+        {
+            printf("ERROR: MPI implementation doesn't support MPI_THREAD_MULTIPLE\n");
+            exit(-1);
+        }
+
+        MPI_Comm_dup(MPI_COMM_WORLD, &distributed_comm);
+
+        if (ospLoadModule("mpi") != OSP_NO_ERROR)
+        {
+            printf("ERROR: could not load OSPRay's MPI module\n");
+            exit(-1);
+        }
+
+        OSPDevice device = ospNewDevice("mpi_distributed");
+        ospDeviceCommit(device);
+        ospSetCurrentDevice(device);
+
+        printf("Distributed rendering, rank %d of %d\n", mpi_rank, mpi_size);
+    }
+#endif
+
     ospDeviceSetErrorFunc(ospGetCurrentDevice(), ospray_error);
     ospDeviceSetStatusFunc(ospGetCurrentDevice(), ospray_status);
 
-    // Prepare some things
-    prepare_renderers();
+    if (trace_file != nullptr)
+    {
+        printf("Recording trace events, written to %s\n", trace_file);
+        timings.set_trace(true);
+    }
+
+    if (!disable_denoiser)
+    {
+        // Only available when OSPRay was built with Open Image Denoise
+        if (ospLoadModule("denoiser") == OSP_NO_ERROR)
+        {
+            denoiser = ospNewImageOperation("denoiser");
+            ospCommit(denoiser);
+            printf("Denoiser available\n");
+        }
+        else
+            printf("Denoiser module not available, denoising disabled\n");
+    }
+
+    if (plugin_creation_threads > 0)
+    {
+        printf("Using %d thread(s) for creating plugin instances\n", plugin_creation_threads);
+
+        for (int i = 0; i < plugin_creation_threads; i++)
+        {
+            std::thread t(plugin_creation_thread_func);
+            t.detach();
+        }
+    }
+
+    if (plugin_cache_directory != "")
+    {
+        mkdir(plugin_cache_directory.c_str(), 0755);
+        printf("Using plugin cache directory %s\n", plugin_cache_directory.c_str());
+    }
+
+    if (mpi_rank > 0)
+    {
+        distributed_worker_loop();
+        return 0;
+    }
 
     // Server loop
 
@@ -3675,7 +7292,7 @@ main(int argc, const char **argv)
         printf("ERROR: could not bind to port %d, exiting\n", PORT);
         exit(-1);
     }
-    listen_sock->listen(1);
+    listen_sock->listen(16);
 
     printf("Listening on port %d\n", PORT);
 
@@ -3690,10 +7307,9 @@ main(int argc, const char **argv)
         printf("---------------------------------------------------------------\n");
         printf("Got new connection\n");
 
-        if (!handle_connection(sock))
-            printf("Error handling connection!\n");
-        //else
-        //    printf("Connection successfully handled\n");
+        // Ends once the connection is handed to its session
+        std::thread t(connection_thread_func, sock);
+        t.detach();
     }
 
     return 0;
@@ -0,0 +1,100 @@
+// Round trip of a call stream through RecordingWriter and RecordingReader
+// (faker/recording.h)
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "recording.h"
+
+#define CHECK(cond) \
+    if (!(cond)) \
+    { \
+        printf("FAILED: %s (line %d)\n", #cond, __LINE__); \
+        unlink(fname); \
+        return 1; \
+    }
+
+int main()
+{
+    char fname[] = "/tmp/t_recording_XXXXXX";
+
+    int fd = mkstemp(fname);
+    if (fd == -1)
+    {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    const float position[3] = { 1.0f, -2.5f, 3.0f };
+    void *geometry = (void*)0x1234abcd5678ULL;
+
+    RecordingWriter writer;
+
+    CHECK(writer.open(fname));
+
+    writer.call(REC_NEW_GEOMETRY);
+    writer.string("mesh");
+    writer.handle(geometry);
+
+    writer.call(REC_SET_PARAM);
+    writer.handle(geometry);
+    writer.string("vertex.position");
+    writer.u32(OSP_VEC3F);
+    writer.bytes(position, sizeof(position));
+
+    writer.call(REC_NEW_FRAMEBUFFER);
+    writer.u32(1920);
+    writer.u32(1080);
+    writer.u64(0xfffffffff0ULL);
+
+    writer.call(REC_COMMIT);
+    writer.handle(nullptr);
+
+    writer.close();
+
+    RecordingReader reader;
+    RecordedCall call;
+    std::vector<uint8_t> bytes;
+
+    CHECK(reader.open(fname));
+
+    CHECK(reader.call(call) && call == REC_NEW_GEOMETRY);
+    CHECK(reader.string() == "mesh");
+    CHECK(reader.handle() == (uint64_t)(uintptr_t)geometry);
+
+    CHECK(reader.call(call) && call == REC_SET_PARAM);
+    CHECK(reader.handle() == (uint64_t)(uintptr_t)geometry);
+    CHECK(reader.string() == "vertex.position");
+    CHECK(reader.u32() == OSP_VEC3F);
+    reader.bytes(bytes);
+    CHECK(bytes.size() == sizeof(position) && memcmp(bytes.data(), position, sizeof(position)) == 0);
+
+    CHECK(reader.call(call) && call == REC_NEW_FRAMEBUFFER);
+    CHECK(reader.u32() == 1920);
+    CHECK(reader.u32() == 1080);
+    CHECK(reader.u64() == 0xfffffffff0ULL);
+
+    CHECK(reader.call(call) && call == REC_COMMIT);
+    CHECK(reader.handle() == 0);
+
+    CHECK(reader.ok());
+    CHECK(!reader.call(call));
+
+    // Reading past the end marks the recording as truncated
+    reader.u32();
+    CHECK(!reader.ok());
+
+    // Not a recording
+    FILE *f = fopen(fname, "wb");
+    fwrite("NOTAREC!", 1, 8, f);
+    fclose(f);
+
+    RecordingReader reader2;
+    CHECK(!reader2.open(fname));
+
+    unlink(fname);
+
+    printf("OK\n");
+
+    return 0;
+}